@@ -0,0 +1,590 @@
+/*
+
+ CPU-only benchmarks for the helpers the demos lean on every frame or at load
+ time. No Vulkan instance or device is created, tinyvk.h is only included for
+ the image resizers, the channel and half precision conversions and the block
+ compressors, built with TINY_RENDERER_IMAGE_ONLY so Vulkan isn't linked. Every
+ result is written to stdout as one JSON object per line so runs can be diffed
+ across commits. Checks of those image helpers run after the benchmarks, their
+ results are written the same way and a failed check makes the exit status
+ nonzero.
+
+ Options:
+   --iterations N   Number of timed repeats per benchmark (default 10)
+   --objects N      Number of objects for the transform benchmarks (default 10000)
+   --assets DIR     Directory containing the ChessSet/models/ .obj files
+
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define TINY_RENDERER_IMPLEMENTATION
+#define TINY_RENDERER_IMAGE_ONLY
+#include "tinyvk.h"
+
+#include "cbuffer.h"
+#include "mesh.h"
+#include "transform.h"
+
+#if defined(__linux__)
+const std::string   k_default_asset_dir = "../demos/assets/";
+#elif defined(_WIN32)
+const std::string   k_default_asset_dir = "../../demos/assets/";
+#endif
+
+uint32_t            s_iterations = 10;
+uint32_t            s_object_count = 10000;
+std::string         s_asset_dir = k_default_asset_dir;
+
+// Keeps results observable so the optimizer can't drop the work being timed
+volatile float      s_sink = 0;
+
+#define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
+                    platform_log(ss.str().c_str()); }
+
+static void platform_log(const char* s)
+{
+    // stdout is reserved for results
+    fprintf(stderr, "%s", s);
+}
+
+static uint64_t file_size(const std::string& path)
+{
+    std::ifstream is;
+    is.open(path.c_str(), std::ios::in | std::ios::binary);
+    if (! is.is_open()) {
+        return 0;
+    }
+    is.seekg(0, std::ios::end);
+    return (uint64_t)is.tellg();
+}
+
+// -------------------------------------------------------------------------------------------------
+// Timing and output
+// -------------------------------------------------------------------------------------------------
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_ns(bench_clock::time_point start, bench_clock::time_point end)
+{
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns;
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return (n % 2) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+// Each repeat times a batch of ops_per_repeat operations, the reported ns_per_op
+// is the median batch divided by the batch size. bytes_per_op is optional.
+static void report(const char* name, const std::vector<double>& repeat_ns, uint64_t ops_per_repeat, uint64_t bytes_per_op, const std::string& extra = std::string())
+{
+    double min_ns = *std::min_element(repeat_ns.begin(), repeat_ns.end()) / (double)ops_per_repeat;
+    double ns_per_op = median(repeat_ns) / (double)ops_per_repeat;
+    std::stringstream ss;
+    ss << "{\"benchmark\":\"" << name << "\""
+       << ",\"repeats\":" << repeat_ns.size()
+       << ",\"ops_per_repeat\":" << ops_per_repeat
+       << ",\"ns_per_op\":" << ns_per_op
+       << ",\"min_ns_per_op\":" << min_ns;
+    if (bytes_per_op > 0) {
+        double mb_per_s = ((double)bytes_per_op / (1024.0 * 1024.0)) / (ns_per_op / 1000000000.0);
+        ss << ",\"bytes_per_op\":" << bytes_per_op << ",\"mb_per_s\":" << mb_per_s;
+    }
+    ss << extra << "}";
+    printf("%s\n", ss.str().c_str());
+    fflush(stdout);
+}
+
+// -------------------------------------------------------------------------------------------------
+// Benchmarks
+// -------------------------------------------------------------------------------------------------
+void bench_mesh_load()
+{
+    const char* k_models[] = { "board1.obj", "pieces1.obj" };
+    for (const char* model : k_models) {
+        std::string path = s_asset_dir + "ChessSet/models/" + model;
+        uint64_t size = file_size(path);
+        if (size == 0) {
+            LOG("Skipping Mesh::Load, could not open " << path);
+            continue;
+        }
+
+        uint32_t vertex_count = 0;
+        std::vector<double> repeat_ns;
+        for (uint32_t i = 0; i < s_iterations; ++i) {
+            tr::Mesh mesh;
+            auto start = bench_clock::now();
+            bool res = tr::Mesh::Load(path, &mesh);
+            repeat_ns.push_back(elapsed_ns(start, bench_clock::now()));
+            assert(res);
+            (void)res;
+            vertex_count = mesh.GetVertexCount();
+        }
+
+        std::string name = std::string("mesh_load_") + model;
+        report(name.c_str(), repeat_ns, 1, size, ",\"vertices\":" + std::to_string(vertex_count));
+    }
+}
+
+void bench_transform()
+{
+    std::vector<tr::Transform> transforms(s_object_count);
+    for (uint32_t i = 0; i < s_object_count; ++i) {
+        transforms[i].Translate(tr::float3((float)(i % 100), 0, (float)(i / 100)));
+        transforms[i].Scale(1.5f);
+    }
+
+    // Dirty rotation forces the full translate * rotate * scale rebuild
+    std::vector<double> dirty_ns;
+    std::vector<double> cached_ns;
+    for (uint32_t i = 0; i < s_iterations; ++i) {
+        float angle = 0.01f * (float)i;
+        float sum = 0;
+        auto start = bench_clock::now();
+        for (auto& transform : transforms) {
+            transform.Rotate(angle, angle * 0.5f, 0.0f);
+            sum += transform.GetModelMatrix()[3][0];
+        }
+        dirty_ns.push_back(elapsed_ns(start, bench_clock::now()));
+
+        start = bench_clock::now();
+        for (auto& transform : transforms) {
+            sum += transform.GetModelMatrix()[3][0];
+        }
+        cached_ns.push_back(elapsed_ns(start, bench_clock::now()));
+        s_sink = s_sink + sum;
+    }
+    report("transform_get_model_matrix_dirty", dirty_ns, s_object_count, 0);
+    report("transform_get_model_matrix_cached", cached_ns, s_object_count, 0);
+}
+
+void bench_view_transform_buffer()
+{
+    std::vector<tr::Transform> transforms(s_object_count);
+    for (uint32_t i = 0; i < s_object_count; ++i) {
+        transforms[i].Translate(tr::float3((float)(i % 100), 0, (float)(i / 100)));
+        transforms[i].Rotate(0.1f * (float)i, 0, 0);
+    }
+    tr::Camera camera(tr::float3(0, 5, 10), tr::float3(0, 0, 0), tr::float3(0, 1, 0), 65.0f, 16.0f / 9.0f);
+    std::vector<tr::ViewTransformBuffer> buffers(s_object_count);
+
+    std::vector<double> set_camera_ns;
+    std::vector<double> set_transform_ns;
+    for (uint32_t i = 0; i < s_iterations; ++i) {
+        camera.LookAt(tr::float3(0, 5, 10.0f + (float)i), tr::float3(0, 0, 0));
+        float sum = 0;
+        auto start = bench_clock::now();
+        for (auto& buffer : buffers) {
+            buffer.SetCamera(camera);
+            sum += buffer.data.model_view_projection_matrix[3][3];
+        }
+        set_camera_ns.push_back(elapsed_ns(start, bench_clock::now()));
+
+        start = bench_clock::now();
+        for (uint32_t j = 0; j < s_object_count; ++j) {
+            buffers[j].SetTransform(transforms[j]);
+            sum += buffers[j].data.model_view_projection_matrix[3][3];
+        }
+        set_transform_ns.push_back(elapsed_ns(start, bench_clock::now()));
+        s_sink = s_sink + sum;
+    }
+    uint64_t bytes = sizeof(tr::ViewTransformData);
+    report("view_transform_buffer_set_camera", set_camera_ns, s_object_count, bytes);
+    report("view_transform_buffer_set_transform", set_transform_ns, s_object_count, bytes);
+}
+
+void bench_image_resize()
+{
+    const uint32_t k_channel_count = 4;
+    const uint32_t k_src_sizes[] = { 256, 1024, 4096 };
+    for (uint32_t src_size : k_src_sizes) {
+        std::vector<uint8_t> src((size_t)src_size * src_size * k_channel_count);
+        for (size_t i = 0; i < src.size(); ++i) {
+            src[i] = (uint8_t)((i * 31) ^ (i >> 7));
+        }
+
+        // Half size is the mip chain case, 3/4 covers arbitrary resizes
+        const uint32_t dst_sizes[] = { src_size / 2, (src_size * 3) / 4 };
+        for (uint32_t dst_size : dst_sizes) {
+            std::vector<uint8_t> dst((size_t)dst_size * dst_size * k_channel_count);
+            std::vector<double> repeat_ns;
+            for (uint32_t i = 0; i < s_iterations; ++i) {
+                auto start = bench_clock::now();
+                tr_image_resize_uint8_t(src_size, src_size, src_size * k_channel_count, src.data(),
+                                        dst_size, dst_size, dst_size * k_channel_count, dst.data(),
+                                        k_channel_count, nullptr);
+                repeat_ns.push_back(elapsed_ns(start, bench_clock::now()));
+                s_sink = s_sink + (float)dst[dst.size() / 2];
+            }
+
+            std::stringstream extra;
+            extra << ",\"src_width\":" << src_size << ",\"src_height\":" << src_size
+                  << ",\"dst_width\":" << dst_size << ",\"dst_height\":" << dst_size
+                  << ",\"channels\":" << k_channel_count;
+            report("image_resize_uint8", repeat_ns, 1, (uint64_t)src.size(), extra.str());
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Checks
+// -------------------------------------------------------------------------------------------------
+uint32_t            s_failed_check_count = 0;
+
+// Writes {"check":..., "passed":..., ...extra} on a single line
+static void report_check(const char* name, bool passed, const std::string& extra = std::string())
+{
+    std::stringstream ss;
+    ss << "{\"check\":\"" << name << "\""
+       << ",\"passed\":" << (passed ? "true" : "false")
+       << extra << "}";
+    printf("%s\n", ss.str().c_str());
+    fflush(stdout);
+    if (! passed) {
+        ++s_failed_check_count;
+    }
+}
+
+// Exact 2x box reductions have to be the rounded 2x2 average, every filter has to keep a constant
+// image constant, and the result can't depend on the thread count.
+void check_image_resize()
+{
+    const tr_image_filter k_filters[] = {
+        tr_image_filter_point, tr_image_filter_box, tr_image_filter_mitchell, tr_image_filter_lanczos3,
+    };
+    const uint32_t k_channel_counts[] = { 1, 3, 4 };
+    const uint32_t k_src_width = 256;
+    const uint32_t k_src_height = 160;
+    // Half size, 3/4 size and sizes that don't divide evenly
+    const uint32_t k_dst_sizes[][2] = { { 128, 80 }, { 192, 120 }, { 101, 67 } };
+
+    uint32_t box_error = 0;
+    uint32_t constant_error = 0;
+    uint32_t thread_mismatch_count = 0;
+    for (uint32_t channel_count : k_channel_counts) {
+        const uint32_t src_row_stride = k_src_width * channel_count;
+        std::vector<uint8_t> src((size_t)src_row_stride * k_src_height);
+        for (size_t i = 0; i < src.size(); ++i) {
+            src[i] = (uint8_t)((i * 31) ^ (i >> 7));
+        }
+        std::vector<uint8_t> constant(src.size(), 200);
+
+        for (const auto& dst_size : k_dst_sizes) {
+            const uint32_t dst_row_stride = dst_size[0] * channel_count;
+            std::vector<uint8_t> dst((size_t)dst_row_stride * dst_size[1]);
+            std::vector<uint8_t> threaded_dst(dst.size());
+            for (tr_image_filter filter : k_filters) {
+                tr_image_resize_settings settings = { filter, 1 };
+                tr_image_resize_uint8_filtered(k_src_width, k_src_height, src_row_stride, constant.data(),
+                                               dst_size[0], dst_size[1], dst_row_stride, dst.data(), channel_count, &settings);
+                for (uint8_t value : dst) {
+                    constant_error = std::max<uint32_t>(constant_error, (uint32_t)std::abs((int)value - 200));
+                }
+
+                tr_image_resize_uint8_filtered(k_src_width, k_src_height, src_row_stride, src.data(),
+                                               dst_size[0], dst_size[1], dst_row_stride, dst.data(), channel_count, &settings);
+                settings.thread_count = 4;
+                tr_image_resize_uint8_filtered(k_src_width, k_src_height, src_row_stride, src.data(),
+                                               dst_size[0], dst_size[1], dst_row_stride, threaded_dst.data(), channel_count, &settings);
+                thread_mismatch_count += (dst != threaded_dst) ? 1 : 0;
+
+                if ((tr_image_filter_box == filter) && ((2 * dst_size[0]) == k_src_width)) {
+                    for (uint32_t y = 0; y < dst_size[1]; ++y) {
+                        for (uint32_t x = 0; x < dst_row_stride; ++x) {
+                            const uint8_t* p = src.data() + ((size_t)(2 * y) * src_row_stride) + (2 * (x / channel_count) * channel_count) + (x % channel_count);
+                            float expected = (p[0] + p[channel_count] + p[src_row_stride] + p[src_row_stride + channel_count]) / 4.0f;
+                            float error = std::abs((float)dst[(size_t)y * dst_row_stride + x] - expected);
+                            box_error = std::max<uint32_t>(box_error, (uint32_t)(error + 0.5f));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::stringstream extra;
+    extra << ",\"box_max_error\":" << box_error << ",\"constant_max_error\":" << constant_error
+          << ",\"thread_mismatches\":" << thread_mismatch_count;
+    report_check("image_resize_uint8", (box_error <= 1) && (0 == constant_error) && (0 == thread_mismatch_count), extra.str());
+}
+
+// The F16C and NEON row conversion has to match the scalar conversion bit for bit, including
+// rounding, denormals, overflow to inf and NaN payloads. The odd count runs the scalar tail too.
+void check_float_to_half()
+{
+    std::vector<float> src;
+    const uint32_t k_specials[] = {
+        0x00000000, 0x80000000, 0x3F800000, 0xBF800000, 0x477FE000, 0x477FEFFF, 0x477FF000, 0x7F7FFFFF,
+        0x7F800000, 0xFF800000, 0x7FC00000, 0xFFC12345, 0x7F800001, 0x38800000, 0x387FFFFF, 0x33000000,
+        0x33000001, 0x33800000, 0x3F801000, 0x3F803000, 0x3F800FFF, 0x00000001, 0x807FFFFF,
+    };
+    for (uint32_t bits : k_specials) {
+        float value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        src.push_back(value);
+    }
+    // Strides through every exponent and both signs
+    for (uint64_t bits = 0; bits <= UINT32_MAX; bits += 65521) {
+        uint32_t bits32 = (uint32_t)bits;
+        float value = 0;
+        memcpy(&value, &bits32, sizeof(value));
+        src.push_back(value);
+    }
+    if (0 == (src.size() % 2)) {
+        src.push_back(0.1f);
+    }
+
+    std::vector<uint16_t> dst(src.size());
+    tr_internal_float_to_half_row(dst.data(), src.data(), (uint32_t)src.size());
+    uint32_t mismatch_count = 0;
+    for (size_t i = 0; i < src.size(); ++i) {
+        if (dst[i] != tr_internal_float_to_half(src[i])) {
+            ++mismatch_count;
+        }
+    }
+    report_check("float_to_half_row", 0 == mismatch_count, ",\"values\":" + std::to_string(src.size()) + ",\"mismatches\":" + std::to_string(mismatch_count));
+}
+
+// Channel expansion tr_util_update_texture_uint8 does for RGB and grey sources. The SIMD paths
+// have to match a plain per channel copy with opaque fill for every row length, including the
+// tails, and can't write past the end of the row.
+void check_expand_channels()
+{
+    const uint32_t k_guard_size = 64;
+    const uint32_t k_channel_counts[][2] = { { 1, 4 }, { 2, 4 }, { 3, 4 }, { 1, 2 }, { 3, 3 } };
+    uint32_t mismatch_count = 0;
+    uint32_t row_count = 0;
+    for (const auto& channel_counts : k_channel_counts) {
+        const uint32_t src_channel_count = channel_counts[0];
+        const uint32_t dst_channel_count = channel_counts[1];
+        for (uint32_t pixel_count = 0; pixel_count <= 1031; pixel_count += ((pixel_count < 70) ? 1 : 137)) {
+            std::vector<uint8_t> src((size_t)pixel_count * src_channel_count);
+            for (size_t i = 0; i < src.size(); ++i) {
+                src[i] = (uint8_t)((i * 31) ^ (i >> 7));
+            }
+            std::vector<uint8_t> dst((size_t)pixel_count * dst_channel_count + k_guard_size, 0xA5);
+            tr_internal_expand_channels_row(dst.data(), src.data(), pixel_count, src_channel_count, dst_channel_count);
+
+            for (uint32_t x = 0; x < pixel_count; ++x) {
+                for (uint32_t c = 0; c < dst_channel_count; ++c) {
+                    uint8_t expected = (c < src_channel_count) ? src[x * src_channel_count + c] : 0xFF;
+                    mismatch_count += (dst[x * dst_channel_count + c] != expected) ? 1 : 0;
+                }
+            }
+            for (size_t i = (size_t)pixel_count * dst_channel_count; i < dst.size(); ++i) {
+                mismatch_count += (0xA5 != dst[i]) ? 1 : 0;
+            }
+            ++row_count;
+        }
+    }
+    report_check("expand_channels_row", 0 == mismatch_count, ",\"rows\":" + std::to_string(row_count) + ",\"mismatches\":" + std::to_string(mismatch_count));
+}
+
+// Reference decoders following the BC1, BC3, BC4 and BC5 block layouts, only used to check the encoder
+static void decode_bc1_block(const uint8_t* p_block, bool allow_transparent, uint8_t* p_rgba)
+{
+    uint16_t color_0 = (uint16_t)(p_block[0] | (p_block[1] << 8));
+    uint16_t color_1 = (uint16_t)(p_block[2] | (p_block[3] << 8));
+    int32_t palette[4][4];
+    const uint16_t colors[2] = { color_0, color_1 };
+    for (uint32_t i = 0; i < 2; ++i) {
+        int32_t r = (colors[i] >> 11) & 0x1F;
+        int32_t g = (colors[i] >> 5) & 0x3F;
+        int32_t b = colors[i] & 0x1F;
+        palette[i][0] = (r << 3) | (r >> 2);
+        palette[i][1] = (g << 2) | (g >> 4);
+        palette[i][2] = (b << 3) | (b >> 2);
+        palette[i][3] = 255;
+    }
+    const bool four_color = (color_0 > color_1) || (! allow_transparent);
+    for (uint32_t c = 0; c < 3; ++c) {
+        palette[2][c] = four_color ? (((2 * palette[0][c]) + palette[1][c] + 1) / 3) : ((palette[0][c] + palette[1][c] + 1) / 2);
+        palette[3][c] = four_color ? ((palette[0][c] + (2 * palette[1][c]) + 1) / 3) : 0;
+    }
+    palette[2][3] = 255;
+    palette[3][3] = four_color ? 255 : 0;
+
+    uint32_t indices = (uint32_t)(p_block[4] | (p_block[5] << 8) | (p_block[6] << 16) | ((uint32_t)p_block[7] << 24));
+    for (uint32_t i = 0; i < 16; ++i) {
+        const int32_t* p_color = palette[(indices >> (2 * i)) & 3];
+        for (uint32_t c = 0; c < 4; ++c) {
+            p_rgba[(4 * i) + c] = (uint8_t)p_color[c];
+        }
+    }
+}
+
+static void decode_bc4_block(const uint8_t* p_block, uint32_t channel, uint8_t* p_rgba)
+{
+    int32_t palette[8] = { p_block[0], p_block[1] };
+    for (int32_t i = 1; i < 7; ++i) {
+        if (palette[0] > palette[1]) {
+            palette[i + 1] = (((7 - i) * palette[0]) + (i * palette[1]) + 3) / 7;
+        }
+        else if (i < 5) {
+            palette[i + 1] = (((5 - i) * palette[0]) + (i * palette[1]) + 2) / 5;
+        }
+    }
+    if (palette[0] <= palette[1]) {
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 6; ++i) {
+        indices |= (uint64_t)p_block[2 + i] << (8 * i);
+    }
+    for (uint32_t i = 0; i < 16; ++i) {
+        p_rgba[(4 * i) + channel] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+// Encodes and decodes BC1, BC3, BC4 and BC5 and compares the result against the source. Errors are
+// bounded by the endpoint quantization and the palette spacing of the smooth test image, BC1
+// transparency has to survive exactly. Encoding with several threads has to give the same blocks.
+void check_bc_encode()
+{
+    // Not a multiple of 4 so the edge blocks are covered
+    const uint32_t k_width = 70;
+    const uint32_t k_height = 38;
+    std::vector<uint8_t> src((size_t)k_width * k_height * 4);
+    for (uint32_t y = 0; y < k_height; ++y) {
+        for (uint32_t x = 0; x < k_width; ++x) {
+            uint8_t* p_pixel = src.data() + (((size_t)y * k_width + x) * 4);
+            p_pixel[0] = (uint8_t)(3 * x);
+            p_pixel[1] = (uint8_t)(255 - (5 * y));
+            p_pixel[2] = (uint8_t)((2 * x) + (2 * y));
+            p_pixel[3] = (uint8_t)(255 - (3 * x));
+        }
+    }
+
+    struct EncodeConfig {
+        const char* name;
+        tr_format   format;
+        // Channels the format stores and the largest error allowed for them
+        uint32_t    channel_mask;
+        uint32_t    max_error;
+    };
+    const EncodeConfig k_configs[] = {
+        { "bc1", tr_format_bc1_rgba_unorm, 0x7, 16 },
+        { "bc3", tr_format_bc3_unorm,      0xF, 16 },
+        { "bc4", tr_format_bc4_unorm,      0x1, 2  },
+        { "bc5", tr_format_bc5_unorm,      0x3, 2  },
+    };
+
+    bool passed = true;
+    std::stringstream extra;
+    for (const auto& config : k_configs) {
+        // BC1 keeps 1 bit alpha, make the right half of the image transparent
+        std::vector<uint8_t> rgba = src;
+        if (tr_format_bc1_rgba_unorm == config.format) {
+            for (size_t i = 0; i < rgba.size(); i += 4) {
+                rgba[i + 3] = (((i / 4) % k_width) < (k_width / 2)) ? 255 : 0;
+            }
+        }
+
+        const uint32_t row_pitch = tr_util_format_row_pitch(config.format, k_width);
+        std::vector<uint8_t> blocks((size_t)tr_util_format_level_size(config.format, k_width, k_height));
+        std::vector<uint8_t> threaded_blocks(blocks.size());
+        bool encoded = tr_image_encode_bc_uint8(config.format, k_width, k_height, k_width * 4, rgba.data(), blocks.data(), 1);
+        encoded = encoded && tr_image_encode_bc_uint8(config.format, k_width, k_height, k_width * 4, rgba.data(), threaded_blocks.data(), 4);
+
+        uint32_t max_error = 0;
+        uint32_t alpha_mismatch_count = 0;
+        for (uint32_t block_y = 0; block_y < ((k_height + 3) / 4); ++block_y) {
+            for (uint32_t block_x = 0; block_x < ((k_width + 3) / 4); ++block_x) {
+                const uint8_t* p_block = blocks.data() + ((size_t)block_y * row_pitch) + (block_x * tr_util_format_stride(config.format));
+                uint8_t decoded[64] = {};
+                switch (config.format) {
+                    case tr_format_bc1_rgba_unorm: decode_bc1_block(p_block, true, decoded); break;
+                    case tr_format_bc3_unorm: decode_bc1_block(p_block + 8, false, decoded); decode_bc4_block(p_block, 3, decoded); break;
+                    case tr_format_bc4_unorm: decode_bc4_block(p_block, 0, decoded); break;
+                    case tr_format_bc5_unorm: decode_bc4_block(p_block, 0, decoded); decode_bc4_block(p_block + 8, 1, decoded); break;
+                    default: break;
+                }
+
+                for (uint32_t y = 0; y < 4; ++y) {
+                    for (uint32_t x = 0; x < 4; ++x) {
+                        uint32_t src_x = (4 * block_x) + x;
+                        uint32_t src_y = (4 * block_y) + y;
+                        if ((src_x >= k_width) || (src_y >= k_height)) {
+                            continue;
+                        }
+                        const uint8_t* p_src = rgba.data() + (((size_t)src_y * k_width + src_x) * 4);
+                        const uint8_t* p_decoded = decoded + (4 * ((4 * y) + x));
+                        if (tr_format_bc1_rgba_unorm == config.format) {
+                            bool transparent = (p_src[3] < 128);
+                            alpha_mismatch_count += (transparent != (0 == p_decoded[3])) ? 1 : 0;
+                            if (transparent) {
+                                continue;
+                            }
+                        }
+                        for (uint32_t c = 0; c < 4; ++c) {
+                            if (config.channel_mask & (1 << c)) {
+                                max_error = std::max<uint32_t>(max_error, (uint32_t)std::abs((int)p_decoded[c] - (int)p_src[c]));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        bool config_passed = encoded && (max_error <= config.max_error) && (0 == alpha_mismatch_count) && (blocks == threaded_blocks);
+        passed = passed && config_passed;
+        extra << ",\"" << config.name << "_max_error\":" << max_error;
+        if (tr_format_bc1_rgba_unorm == config.format) {
+            extra << ",\"bc1_alpha_mismatches\":" << alpha_mismatch_count;
+        }
+    }
+    report_check("bc_encode", passed, extra.str());
+}
+
+// -------------------------------------------------------------------------------------------------
+// main
+// -------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--iterations") && ((i + 1) < argc)) {
+            s_iterations = std::max(1, atoi(argv[++i]));
+        }
+        else if ((arg == "--objects") && ((i + 1) < argc)) {
+            s_object_count = std::max(1, atoi(argv[++i]));
+        }
+        else if ((arg == "--assets") && ((i + 1) < argc)) {
+            s_asset_dir = argv[++i];
+            if (! s_asset_dir.empty() && (s_asset_dir.back() != '/') && (s_asset_dir.back() != '\\')) {
+                s_asset_dir += "/";
+            }
+        }
+        else {
+            LOG("usage: " << argv[0] << " [--iterations N] [--objects N] [--assets DIR]");
+            return EXIT_FAILURE;
+        }
+    }
+
+    bench_mesh_load();
+    bench_transform();
+    bench_view_transform_buffer();
+    bench_image_resize();
+
+    check_image_resize();
+    check_float_to_half();
+    check_expand_channels();
+    check_bc_encode();
+
+    return (0 == s_failed_check_count) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,852 @@
+/*
+
+ Headless micro-benchmarks for the tinyvk API. Every result is written to
+ stdout as one JSON object per line so runs can be diffed across commits.
+ A few checks of the texture upload paths run after the benchmarks, their
+ results are written the same way and a failed check makes the exit status
+ nonzero.
+
+ Runs without a window or display. To run on a software rasterizer point the
+ loader at the ICD manifest, for example with Mesa's lavapipe:
+
+   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./RendererBenchmarks_VK
+
+ Options:
+   --iterations N   Number of timed iterations per benchmark (default 1000)
+   --assets DIR     Directory containing simple.vs.spv and simple.ps.spv
+
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TINY_RENDERER_IMPLEMENTATION
+#include "tinyvk.h"
+
+const char*         k_app_name = "RendererBenchmarks";
+const uint32_t      k_image_count = 1;
+const uint32_t      k_width = 256;
+const uint32_t      k_height = 256;
+const uint32_t      k_draw_count = 10000;
+#if defined(__linux__)
+const std::string   k_default_asset_dir = "../samples/assets/";
+#elif defined(_WIN32)
+const std::string   k_default_asset_dir = "../../samples/assets/";
+#endif
+
+tr_renderer*        m_renderer = nullptr;
+tr_cmd_pool*        m_cmd_pool = nullptr;
+tr_cmd*             m_cmd = nullptr;
+tr_shader_program*  m_shader = nullptr;
+tr_buffer*          m_vertex_buffer = nullptr;
+
+uint32_t            s_iterations = 1000;
+std::string         s_asset_dir = k_default_asset_dir;
+
+#define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
+                    platform_log(ss.str().c_str()); }
+
+static void platform_log(const char* s)
+{
+    // stdout is reserved for results
+    fprintf(stderr, "%s", s);
+}
+
+void renderer_log(tr_log_type type, const char* msg, const char* component)
+{
+  switch(type) {
+    case tr_log_type_info  : {LOG("[INFO]"  << "[" << component << "] : " << msg);} break;
+    case tr_log_type_warn  : {LOG("[WARN]"  << "[" << component << "] : " << msg);} break;
+    case tr_log_type_debug : {LOG("[DEBUG]" << "[" << component << "] : " << msg);} break;
+    case tr_log_type_error : {LOG("[ERORR]" << "[" << component << "] : " << msg);} break;
+    default: break;
+  }
+}
+
+std::vector<uint8_t> load_file(const std::string& path)
+{
+    std::ifstream is;
+    is.open(path.c_str(), std::ios::in | std::ios::binary);
+    assert(is.is_open());
+
+    is.seekg(0, std::ios::end);
+    std::vector<uint8_t> buffer(is.tellg());
+    assert(0 != buffer.size());
+
+    is.seekg(0, std::ios::beg);
+    is.read((char*)buffer.data(), buffer.size());
+
+    return buffer;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Timing and output
+// -------------------------------------------------------------------------------------------------
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_us(bench_clock::time_point start, bench_clock::time_point end)
+{
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+    return us;
+}
+
+struct Samples {
+    std::vector<double> us;
+
+    void Add(double value) { us.push_back(value); }
+
+    double Min() const    { return *std::min_element(us.begin(), us.end()); }
+    double Max() const    { return *std::max_element(us.begin(), us.end()); }
+    double Mean() const {
+        double sum = 0.0;
+        for (double value : us) { sum += value; }
+        return sum / (double)us.size();
+    }
+    double Median() const {
+        std::vector<double> sorted = us;
+        std::sort(sorted.begin(), sorted.end());
+        size_t n = sorted.size();
+        return (n % 2) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    }
+};
+
+// Writes {"benchmark":..., "iterations":..., "min_us":..., ...extra} on a single line
+static void report(const char* name, const Samples& samples, const std::string& extra = std::string())
+{
+    printf("{\"benchmark\":\"%s\",\"iterations\":%u,\"min_us\":%.3f,\"median_us\":%.3f,\"mean_us\":%.3f,\"max_us\":%.3f%s}\n",
+           name, (uint32_t)samples.us.size(), samples.Min(), samples.Median(), samples.Mean(), samples.Max(),
+           extra.c_str());
+    fflush(stdout);
+}
+
+// -------------------------------------------------------------------------------------------------
+// Setup
+// -------------------------------------------------------------------------------------------------
+void init_tiny_renderer()
+{
+    tr_renderer_settings settings = {0};
+    settings.width                          = k_width;
+    settings.height                         = k_height;
+    settings.swapchain.image_count          = k_image_count;
+    settings.swapchain.sample_count         = tr_sample_count_1;
+    settings.swapchain.color_format         = tr_format_b8g8r8a8_unorm;
+    settings.swapchain.depth_stencil_format = tr_format_undefined;
+    settings.log_fn                         = renderer_log;
+    settings.headless                       = true;
+    tr_create_renderer(k_app_name, &settings, &m_renderer);
+
+    tr_create_cmd_pool(m_renderer, m_renderer->graphics_queue, false, &m_cmd_pool);
+    tr_create_cmd(m_cmd_pool, false, &m_cmd);
+
+    auto vert = load_file(s_asset_dir + "simple.vs.spv");
+    auto frag = load_file(s_asset_dir + "simple.ps.spv");
+    tr_create_shader_program(m_renderer,
+                             (uint32_t)vert.size(), (uint32_t*)(vert.data()), "VSMain",
+                             (uint32_t)frag.size(), (uint32_t*)(frag.data()), "PSMain", &m_shader);
+
+    std::vector<float> vertexData = {
+         0.00f,  0.25f, 0.0f, 1.0f,
+        -0.25f, -0.25f, 0.0f, 1.0f,
+         0.25f, -0.25f, 0.0f, 1.0f,
+    };
+    uint64_t vertexDataSize = sizeof(float) * vertexData.size();
+    uint32_t vertexStride = sizeof(float) * 4;
+    tr_create_vertex_buffer(m_renderer, vertexDataSize, true, vertexStride, &m_vertex_buffer);
+    memcpy(m_vertex_buffer->cpu_mapped_address, vertexData.data(), vertexDataSize);
+}
+
+void destroy_tiny_renderer()
+{
+    tr_destroy_buffer(m_renderer, m_vertex_buffer);
+    tr_destroy_shader_program(m_renderer, m_shader);
+    tr_destroy_cmd(m_cmd_pool, m_cmd);
+    tr_destroy_cmd_pool(m_renderer, m_cmd_pool);
+    tr_destroy_renderer(m_renderer);
+}
+
+static tr_vertex_layout simple_vertex_layout()
+{
+    tr_vertex_layout vertex_layout = {};
+    vertex_layout.attrib_count = 1;
+    vertex_layout.attribs[0].semantic = tr_semantic_position;
+    vertex_layout.attribs[0].format   = tr_format_r32g32b32a32_float;
+    vertex_layout.attribs[0].binding  = 0;
+    vertex_layout.attribs[0].location = 0;
+    vertex_layout.attribs[0].offset   = 0;
+    return vertex_layout;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Benchmarks
+// -------------------------------------------------------------------------------------------------
+void bench_buffer_create_destroy()
+{
+    const uint64_t k_size = 64 * 1024;
+    Samples device_local;
+    Samples host_visible;
+    for (uint32_t i = 0; i < s_iterations; ++i) {
+        tr_buffer* buffer = nullptr;
+        auto start = bench_clock::now();
+        tr_create_buffer(m_renderer, tr_buffer_usage_storage_srv, k_size, false, &buffer);
+        tr_destroy_buffer(m_renderer, buffer);
+        device_local.Add(elapsed_us(start, bench_clock::now()));
+
+        start = bench_clock::now();
+        tr_create_buffer(m_renderer, tr_buffer_usage_storage_srv, k_size, true, &buffer);
+        tr_destroy_buffer(m_renderer, buffer);
+        host_visible.Add(elapsed_us(start, bench_clock::now()));
+    }
+    report("buffer_create_destroy_device_local", device_local, ",\"bytes\":" + std::to_string(k_size));
+    report("buffer_create_destroy_host_visible", host_visible, ",\"bytes\":" + std::to_string(k_size));
+}
+
+void bench_texture_create_destroy()
+{
+    const uint32_t k_size = 512;
+    Samples samples;
+    for (uint32_t i = 0; i < s_iterations; ++i) {
+        tr_texture* texture = nullptr;
+        auto start = bench_clock::now();
+        tr_create_texture_2d(m_renderer, k_size, k_size, tr_sample_count_1, tr_format_r8g8b8a8_unorm, 1, nullptr, false, tr_texture_usage_sampled_image, &texture);
+        tr_destroy_texture(m_renderer, texture);
+        samples.Add(elapsed_us(start, bench_clock::now()));
+    }
+    report("texture_create_destroy", samples, ",\"width\":" + std::to_string(k_size) + ",\"height\":" + std::to_string(k_size));
+}
+
+void bench_update_buffer()
+{
+    const uint64_t k_sizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+    for (uint64_t size : k_sizes) {
+        std::vector<uint8_t> data((size_t)size, 0xA5);
+        tr_buffer* buffer = nullptr;
+        tr_create_buffer(m_renderer, tr_buffer_usage_storage_srv, size, false, &buffer);
+
+        // Large uploads are slow on software ICDs, scale the count down by size
+        uint32_t iterations = std::max<uint32_t>(1, (uint32_t)std::min<uint64_t>(s_iterations, (64 * 1024 * 1024) / size));
+        Samples samples;
+        for (uint32_t i = 0; i < iterations; ++i) {
+            auto start = bench_clock::now();
+            tr_util_update_buffer(m_renderer->graphics_queue, size, data.data(), buffer);
+            samples.Add(elapsed_us(start, bench_clock::now()));
+        }
+
+        double mb_per_s = ((double)size / (1024.0 * 1024.0)) / (samples.Median() / 1000000.0);
+        std::stringstream extra;
+        extra << ",\"bytes\":" << size << ",\"mb_per_s\":" << mb_per_s;
+        report("util_update_buffer", samples, extra.str());
+
+        tr_destroy_buffer(m_renderer, buffer);
+    }
+}
+
+// A small dirty rectangle against re-uploading the whole level, as a dynamic texture would do every frame
+void bench_update_descriptor_set()
+{
+    tr_buffer* uniform_buffer = nullptr;
+    tr_create_uniform_buffer(m_renderer, 256, true, &uniform_buffer);
+
+    std::vector<tr_descriptor> descriptors(1);
+    descriptors[0].type          = tr_descriptor_type_uniform_buffer_cbv;
+    descriptors[0].count         = 1;
+    descriptors[0].binding       = 0;
+    descriptors[0].shader_stages = tr_shader_stage_vert;
+    tr_descriptor_set* desc_set = nullptr;
+    tr_create_descriptor_set(m_renderer, (uint32_t)descriptors.size(), descriptors.data(), &desc_set);
+    desc_set->descriptors[0].uniform_buffers[0] = uniform_buffer;
+
+    Samples samples;
+    for (uint32_t i = 0; i < s_iterations; ++i) {
+        auto start = bench_clock::now();
+        tr_update_descriptor_set(m_renderer, desc_set);
+        samples.Add(elapsed_us(start, bench_clock::now()));
+    }
+    report("update_descriptor_set", samples, ",\"descriptors\":1");
+
+    tr_destroy_descriptor_set(m_renderer, desc_set);
+    tr_destroy_buffer(m_renderer, uniform_buffer);
+}
+
+void bench_create_pipeline()
+{
+    tr_vertex_layout vertex_layout = simple_vertex_layout();
+    tr_pipeline_settings pipeline_settings = {tr_primitive_topo_tri_list};
+    tr_render_target* render_target = m_renderer->swapchain_render_targets[0];
+
+    // The first pipeline pays for shader compilation inside the driver, later ones
+    // only hit whatever caching the driver does internally.
+    Samples cold;
+    {
+        tr_pipeline* pipeline = nullptr;
+        auto start = bench_clock::now();
+        tr_create_pipeline(m_renderer, m_shader, &vertex_layout, nullptr, render_target, &pipeline_settings, &pipeline);
+        cold.Add(elapsed_us(start, bench_clock::now()));
+        tr_destroy_pipeline(m_renderer, pipeline);
+    }
+    report("create_pipeline_cold", cold);
+
+    // Pipeline creation is expensive on every driver, cap the count
+    uint32_t iterations = std::min<uint32_t>(s_iterations, 100);
+    Samples warm;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        tr_pipeline* pipeline = nullptr;
+        auto start = bench_clock::now();
+        tr_create_pipeline(m_renderer, m_shader, &vertex_layout, nullptr, render_target, &pipeline_settings, &pipeline);
+        warm.Add(elapsed_us(start, bench_clock::now()));
+        tr_destroy_pipeline(m_renderer, pipeline);
+    }
+    report("create_pipeline_warm", warm);
+}
+
+void bench_draw_overhead()
+{
+    tr_vertex_layout vertex_layout = simple_vertex_layout();
+    tr_pipeline_settings pipeline_settings = {tr_primitive_topo_tri_list};
+    tr_render_target* render_target = m_renderer->swapchain_render_targets[0];
+    tr_pipeline* pipeline = nullptr;
+    tr_create_pipeline(m_renderer, m_shader, &vertex_layout, nullptr, render_target, &pipeline_settings, &pipeline);
+
+    uint32_t iterations = std::min<uint32_t>(s_iterations, 100);
+    Samples record_draw;
+    Samples record_bind_draw;
+    Samples submit;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        // Draws only
+        auto start = bench_clock::now();
+        tr_begin_cmd(m_cmd);
+        tr_cmd_render_target_transition_to(m_cmd, render_target, tr_texture_usage_color_attachment);
+        tr_cmd_begin_render(m_cmd, render_target);
+        tr_cmd_set_viewport(m_cmd, 0, 0, (float)k_width, (float)k_height, 0.0f, 1.0f);
+        tr_cmd_set_scissor(m_cmd, 0, 0, k_width, k_height);
+        tr_cmd_bind_pipeline(m_cmd, pipeline);
+        tr_cmd_bind_vertex_buffers(m_cmd, 1, &m_vertex_buffer);
+        for (uint32_t j = 0; j < k_draw_count; ++j) {
+            tr_cmd_draw(m_cmd, 3, 0);
+        }
+        tr_cmd_end_render(m_cmd);
+        tr_end_cmd(m_cmd);
+        record_draw.Add(elapsed_us(start, bench_clock::now()));
+
+        start = bench_clock::now();
+        tr_queue_submit(m_renderer->graphics_queue, 1, &m_cmd, 0, nullptr, 0, nullptr);
+        tr_queue_wait_idle(m_renderer->graphics_queue);
+        submit.Add(elapsed_us(start, bench_clock::now()));
+
+        // Pipeline and vertex buffer rebound for every draw
+        start = bench_clock::now();
+        tr_begin_cmd(m_cmd);
+        tr_cmd_begin_render(m_cmd, render_target);
+        tr_cmd_set_viewport(m_cmd, 0, 0, (float)k_width, (float)k_height, 0.0f, 1.0f);
+        tr_cmd_set_scissor(m_cmd, 0, 0, k_width, k_height);
+        for (uint32_t j = 0; j < k_draw_count; ++j) {
+            tr_cmd_bind_pipeline(m_cmd, pipeline);
+            tr_cmd_bind_vertex_buffers(m_cmd, 1, &m_vertex_buffer);
+            tr_cmd_draw(m_cmd, 3, 0);
+        }
+        tr_cmd_end_render(m_cmd);
+        tr_end_cmd(m_cmd);
+        record_bind_draw.Add(elapsed_us(start, bench_clock::now()));
+
+        tr_queue_submit(m_renderer->graphics_queue, 1, &m_cmd, 0, nullptr, 0, nullptr);
+        tr_queue_wait_idle(m_renderer->graphics_queue);
+    }
+
+    std::string extra = ",\"draws\":" + std::to_string(k_draw_count);
+    report("record_draws", record_draw, extra);
+    report("record_bind_draws", record_bind_draw, extra);
+    report("submit_wait_draws", submit, extra);
+
+    tr_destroy_pipeline(m_renderer, pipeline);
+}
+
+// -------------------------------------------------------------------------------------------------
+// Checks
+// -------------------------------------------------------------------------------------------------
+uint32_t            s_failed_check_count = 0;
+
+// Writes {"check":..., "passed":..., ...extra} on a single line
+static void report_check(const char* name, bool passed, const std::string& extra = std::string())
+{
+    printf("{\"check\":\"%s\",\"passed\":%s%s}\n", name, passed ? "true" : "false", extra.c_str());
+    fflush(stdout);
+    if (! passed) {
+        ++s_failed_check_count;
+    }
+}
+
+// Returns a mip level of p_texture with its rows tightly packed
+static std::vector<uint8_t> readback_level(tr_texture* p_texture, uint32_t mip_level)
+{
+    uint32_t width = std::max<uint32_t>(p_texture->width >> mip_level, 1);
+    uint32_t height = std::max<uint32_t>(p_texture->height >> mip_level, 1);
+    uint64_t size = tr_util_format_level_size(p_texture->format, width, height);
+    tr_readback* readback = nullptr;
+    tr_create_readback(m_renderer, m_renderer->graphics_queue, size, &readback);
+    tr_readback_texture(readback, p_texture, mip_level);
+    const uint8_t* p_data = (const uint8_t*)tr_readback_map(readback);
+    std::vector<uint8_t> data(p_data, p_data + size);
+    tr_destroy_readback(m_renderer, readback);
+    return data;
+}
+
+// Each GPU generated level has to be the 2x2 average of the level above it, which is what a
+// linear blit to exactly half the size samples. Levels are compared against their readback
+// parent so rounding in earlier levels doesn't accumulate.
+void check_update_texture_gpu_mips()
+{
+    const uint32_t k_size = 64;
+    const uint32_t k_src_channel_count = 3;
+    std::vector<uint8_t> data((size_t)k_size * k_size * k_src_channel_count);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (uint8_t)((i * 31) ^ (i >> 7));
+    }
+
+    uint32_t mip_levels = tr_util_calc_mip_levels(k_size, k_size);
+    tr_texture* texture = nullptr;
+    tr_create_texture_2d(m_renderer, k_size, k_size, tr_sample_count_1, tr_format_r8g8b8a8_unorm, mip_levels, nullptr, false, tr_texture_usage_sampled_image, &texture);
+    if (! tr_util_texture_supports_gpu_mips(texture)) {
+        LOG("check_update_texture_gpu_mips: linear blits aren't supported for r8g8b8a8_unorm, skipped");
+        tr_destroy_texture(m_renderer, texture);
+        return;
+    }
+    tr_util_update_texture_uint8_gpu_mips(m_renderer->graphics_queue, k_size, k_size, k_size * k_src_channel_count, data.data(), k_src_channel_count, texture);
+
+    uint32_t max_error = 0;
+    std::vector<uint8_t> parent = readback_level(texture, 0);
+    for (uint32_t i = 0; i < (k_size * k_size); ++i) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            uint32_t expected = (c < k_src_channel_count) ? data[i * k_src_channel_count + c] : 255;
+            max_error = std::max<uint32_t>(max_error, (uint32_t)std::abs((int)parent[i * 4 + c] - (int)expected));
+        }
+    }
+    for (uint32_t mip_level = 1; mip_level < mip_levels; ++mip_level) {
+        uint32_t size = k_size >> mip_level;
+        std::vector<uint8_t> level = readback_level(texture, mip_level);
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                for (uint32_t c = 0; c < 4; ++c) {
+                    const uint8_t* p = parent.data() + ((2 * y * 2 * size) + (2 * x)) * 4 + c;
+                    float expected = (p[0] + p[4] + p[2 * size * 4] + p[2 * size * 4 + 4]) / 4.0f;
+                    float error = std::abs((float)level[(y * size + x) * 4 + c] - expected);
+                    max_error = std::max<uint32_t>(max_error, (uint32_t)(error + 0.5f));
+                }
+            }
+        }
+        parent.swap(level);
+    }
+    tr_destroy_texture(m_renderer, texture);
+
+    report_check("update_texture_gpu_mips", max_error <= 1, ",\"mip_levels\":" + std::to_string(mip_levels) + ",\"max_error\":" + std::to_string(max_error));
+}
+
+// Builds a DDS file with a full mip chain of arbitrary texel data. A fourcc of DX10 adds the
+// DDS_HEADER_DXT10 with dxgi_format.
+static std::vector<uint8_t> make_dds(tr_format format, uint32_t width, uint32_t height, const char* fourcc, uint32_t dxgi_format)
+{
+    uint32_t mip_levels = tr_util_calc_mip_levels(width, height);
+    uint32_t header[32] = {};
+    memcpy(header, "DDS ", 4);
+    header[1]  = 124;
+    header[2]  = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+    header[3]  = height;
+    header[4]  = width;
+    header[5]  = (uint32_t)tr_util_format_level_size(format, width, height);
+    header[7]  = mip_levels;
+    header[19] = 32;
+    header[20] = 0x4;
+    memcpy(&header[21], fourcc, 4);
+    header[27] = 0x1000 | 0x400000 | 0x8;
+
+    std::vector<uint8_t> file((const uint8_t*)header, (const uint8_t*)header + sizeof(header));
+    if (0 == memcmp(fourcc, "DX10", 4)) {
+        const uint32_t dx10[5] = { dxgi_format, 3, 0, 1, 0 };
+        file.insert(file.end(), (const uint8_t*)dx10, (const uint8_t*)dx10 + sizeof(dx10));
+    }
+    for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+        uint32_t level_width = std::max<uint32_t>(width >> mip_level, 1);
+        uint32_t level_height = std::max<uint32_t>(height >> mip_level, 1);
+        uint64_t level_size = tr_util_format_level_size(format, level_width, level_height);
+        for (uint64_t i = 0; i < level_size; ++i) {
+            file.push_back((uint8_t)((i * 31) ^ (i >> 7) ^ (mip_level * 17)));
+        }
+    }
+    return file;
+}
+
+// Loads DDS files with legacy and DX10 headers and reads back every level, which has to match the
+// file byte for byte. A truncated file has to be rejected.
+void check_load_texture_dds()
+{
+    struct DdsConfig {
+        tr_format   format;
+        const char* fourcc;
+        uint32_t    dxgi_format;
+    };
+    const DdsConfig k_configs[] = {
+        { tr_format_bc1_rgba_unorm, "DXT1", 0  },
+        { tr_format_bc5_unorm,      "DX10", 83 },
+        { tr_format_r8g8b8a8_unorm, "DX10", 28 },
+    };
+    // Not a power of two so level sizes round down and partial blocks are covered
+    const uint32_t k_width = 40;
+    const uint32_t k_height = 24;
+    const char* k_file_path = "tinyrenderers_check.dds";
+
+    uint32_t mismatch_count = 0;
+    bool passed = true;
+    for (const auto& config : k_configs) {
+        std::vector<uint8_t> file = make_dds(config.format, k_width, k_height, config.fourcc, config.dxgi_format);
+        std::ofstream os(k_file_path, std::ios::binary);
+        os.write((const char*)file.data(), (std::streamsize)file.size());
+        os.close();
+
+        tr_texture* texture = nullptr;
+        bool loaded = tr_util_load_texture_dds(m_renderer->graphics_queue, k_file_path, tr_texture_usage_sampled_image, &texture);
+        uint32_t mip_levels = tr_util_calc_mip_levels(k_width, k_height);
+        passed = passed && loaded && (k_width == texture->width) && (k_height == texture->height) &&
+                 (config.format == texture->format) && (mip_levels == texture->mip_levels);
+        if (loaded) {
+            size_t offset = file.size();
+            for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+                offset -= (size_t)tr_util_format_level_size(config.format, std::max<uint32_t>(k_width >> mip_level, 1), std::max<uint32_t>(k_height >> mip_level, 1));
+            }
+            for (uint32_t mip_level = 0; mip_level < texture->mip_levels; ++mip_level) {
+                std::vector<uint8_t> level = readback_level(texture, mip_level);
+                mismatch_count += (0 == memcmp(level.data(), file.data() + offset, level.size())) ? 0 : 1;
+                offset += level.size();
+            }
+            tr_destroy_texture(m_renderer, texture);
+        }
+
+        texture = nullptr;
+        bool truncated_loaded = tr_util_create_texture_dds(m_renderer->graphics_queue, file.data(), file.size() - 1, tr_texture_usage_sampled_image, &texture);
+        passed = passed && (! truncated_loaded);
+        if (truncated_loaded) {
+            tr_destroy_texture(m_renderer, texture);
+        }
+    }
+    remove(k_file_path);
+
+    report_check("load_texture_dds", passed && (0 == mismatch_count), ",\"level_mismatches\":" + std::to_string(mismatch_count));
+}
+
+// Updates rectangles of a filled level with source rows wider than the rectangles. The rectangles
+// have to hold the new texels and everything around them has to be unchanged. Recorded updates are
+// chained at the returned offsets, with 12 byte texels and 8 byte blocks. Formats the GPU can't
+// sample are skipped.
+void check_update_texture_region()
+{
+    struct RegionRect {
+        uint32_t    x;
+        uint32_t    y;
+        uint32_t    width;
+        uint32_t    height;
+    };
+    struct RegionConfig {
+        tr_format   format;
+        uint32_t    width;
+        uint32_t    height;
+        bool        recorded;
+        RegionRect  rects[3];
+    };
+    const RegionConfig k_configs[] = {
+        { tr_format_r8g8b8a8_unorm,     64, 64, false, { { 8, 12, 20, 10 }, { 0, 0, 1, 1 }, { 40, 50, 24, 14 } } },
+        { tr_format_r32g32b32_float,    16, 16, true,  { { 1, 2, 1, 1 }, { 5, 3, 3, 1 }, { 9, 9, 2, 3 } } },
+        { tr_format_bc1_rgba_unorm,     32, 32, true,  { { 4, 8, 8, 4 }, { 16, 16, 12, 8 }, { 28, 0, 4, 4 } } },
+    };
+
+    tr_buffer* staging = nullptr;
+    tr_create_buffer(m_renderer, tr_buffer_usage_transfer_src, 4096, true, &staging);
+
+    uint32_t format_count = 0;
+    uint32_t mismatch_count = 0;
+    for (const auto& config : k_configs) {
+        VkFormatProperties format_props = {};
+        vkGetPhysicalDeviceFormatProperties(m_renderer->vk_active_gpu, tr_util_to_vk_format(config.format), &format_props);
+        if (0 == (format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+            continue;
+        }
+        ++format_count;
+
+        std::vector<uint8_t> expected((size_t)tr_util_format_level_size(config.format, config.width, config.height));
+        for (size_t i = 0; i < expected.size(); ++i) {
+            expected[i] = (uint8_t)((i * 31) ^ (i >> 7));
+        }
+        tr_texture* texture = nullptr;
+        tr_create_texture_2d(m_renderer, config.width, config.height, tr_sample_count_1, config.format, 1, nullptr, false, tr_texture_usage_sampled_image, &texture);
+        tr_util_update_texture_mips(m_renderer->graphics_queue, expected.data(), 1, texture);
+
+        // Rows of blocks for compressed formats
+        const uint32_t block_size = tr_util_format_is_compressed(config.format) ? 4 : 1;
+        const uint32_t level_row_pitch = tr_util_format_row_pitch(config.format, config.width);
+        uint64_t staging_offset = 0;
+        if (config.recorded) {
+            tr_begin_cmd(m_cmd);
+        }
+        for (uint32_t i = 0; i < 3; ++i) {
+            const RegionRect& rect = config.rects[i];
+            const uint32_t row_size = tr_util_format_row_pitch(config.format, rect.width);
+            const uint32_t row_count = (rect.height + block_size - 1) / block_size;
+            const uint32_t src_row_stride = row_size + 8;
+            std::vector<uint8_t> src((size_t)src_row_stride * row_count);
+            for (size_t j = 0; j < src.size(); ++j) {
+                src[j] = (uint8_t)((j * 7) + (i * 13) + 101);
+            }
+            for (uint32_t row = 0; row < row_count; ++row) {
+                size_t dst_offset = ((size_t)((rect.y / block_size) + row) * level_row_pitch) + tr_util_format_row_pitch(config.format, rect.x);
+                memcpy(expected.data() + dst_offset, src.data() + ((size_t)row * src_row_stride), row_size);
+            }
+
+            if (config.recorded) {
+                staging_offset = tr_cmd_update_texture_region(m_cmd, staging, staging_offset, 0, 0, rect.x, rect.y, rect.width, rect.height, src_row_stride, src.data(), texture);
+            }
+            else {
+                tr_util_update_texture_region(m_renderer->graphics_queue, 0, 0, rect.x, rect.y, rect.width, rect.height, src_row_stride, src.data(), texture);
+            }
+        }
+        if (config.recorded) {
+            tr_end_cmd(m_cmd);
+            tr_queue_submit(m_renderer->graphics_queue, 1, &m_cmd, 0, nullptr, 0, nullptr);
+            tr_queue_wait_idle(m_renderer->graphics_queue);
+        }
+
+        std::vector<uint8_t> level = readback_level(texture, 0);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            mismatch_count += (level[i] == expected[i]) ? 0 : 1;
+        }
+        tr_destroy_texture(m_renderer, texture);
+    }
+    tr_destroy_buffer(m_renderer, staging);
+
+    report_check("update_texture_region", (format_count > 0) && (0 == mismatch_count), ",\"formats\":" + std::to_string(format_count) + ",\"byte_mismatches\":" + std::to_string(mismatch_count));
+}
+
+// Streams textures with a small frame budget. Added textures expose only their resident levels,
+// streaming finishes with min_lod at 0 and every level matching its source. A resident budget
+// stops streaming at the finest level that still fits.
+void check_texture_streaming()
+{
+    struct StreamConfig {
+        tr_format   format;
+        uint32_t    width;
+        uint32_t    height;
+    };
+    const StreamConfig k_configs[] = {
+        { tr_format_r8g8b8a8_unorm, 64, 64 },
+        { tr_format_bc1_rgba_unorm, 40, 24 },
+    };
+    const uint32_t k_resident_mip_count = 2;
+    const uint64_t k_frame_byte_budget = 4096;
+    const uint32_t k_max_frames = 1000;
+
+    std::vector<std::vector<uint8_t>> data;
+    for (const auto& config : k_configs) {
+        uint32_t mip_levels = tr_util_calc_mip_levels(config.width, config.height);
+        uint64_t data_size = 0;
+        for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+            data_size += tr_util_format_level_size(config.format, std::max<uint32_t>(config.width >> mip_level, 1), std::max<uint32_t>(config.height >> mip_level, 1));
+        }
+        data.push_back(std::vector<uint8_t>((size_t)data_size));
+        for (size_t i = 0; i < data.back().size(); ++i) {
+            data.back()[i] = (uint8_t)((i * 31) ^ (i >> 7));
+        }
+    }
+
+    // Reads back levels from min_lod on and compares them with their part of the source
+    uint32_t mismatch_count = 0;
+    auto compare_levels = [&](tr_texture* texture, const std::vector<uint8_t>& src) {
+        size_t offset = 0;
+        for (uint32_t mip_level = 0; mip_level < texture->mip_levels; ++mip_level) {
+            size_t level_size = (size_t)tr_util_format_level_size(texture->format, std::max<uint32_t>(texture->width >> mip_level, 1), std::max<uint32_t>(texture->height >> mip_level, 1));
+            if (mip_level >= texture->min_lod) {
+                std::vector<uint8_t> level = readback_level(texture, mip_level);
+                mismatch_count += (0 == memcmp(level.data(), src.data() + offset, level_size)) ? 0 : 1;
+            }
+            offset += level_size;
+        }
+    };
+
+    bool passed = true;
+    uint32_t frame_count = 0;
+    std::vector<tr_texture*> textures(sizeof(k_configs) / sizeof(k_configs[0]));
+    tr_texture_streamer* streamer = nullptr;
+    tr_create_texture_streamer(m_renderer, m_renderer->graphics_queue, k_frame_byte_budget, 0, &streamer);
+    for (size_t i = 0; i < textures.size(); ++i) {
+        const auto& config = k_configs[i];
+        tr_create_texture_2d(m_renderer, config.width, config.height, tr_sample_count_1, config.format, tr_max_mip_levels, nullptr, false, tr_texture_usage_sampled_image, &textures[i]);
+        tr_texture_streamer_add(streamer, textures[i], data[i].data(), k_resident_mip_count);
+        passed = passed && (textures[i]->min_lod == (textures[i]->mip_levels - k_resident_mip_count));
+        compare_levels(textures[i], data[i]);
+    }
+    // Frames are a millisecond apart so the GPU gets time to finish batches
+    while ((! tr_texture_streamer_is_done(streamer)) && (frame_count < k_max_frames)) {
+        tr_texture_streamer_update(streamer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++frame_count;
+    }
+    for (size_t i = 0; i < textures.size(); ++i) {
+        passed = passed && (0 == textures[i]->min_lod);
+        compare_levels(textures[i], data[i]);
+    }
+    tr_destroy_texture_streamer(m_renderer, streamer);
+    for (tr_texture* texture : textures) {
+        tr_destroy_texture(m_renderer, texture);
+    }
+
+    // The two coarsest levels of the 64x64 texture are resident, 2048 bytes fit the next three
+    const uint64_t k_resident_byte_budget = 2048;
+    tr_texture* texture = nullptr;
+    tr_create_texture_2d(m_renderer, 64, 64, tr_sample_count_1, tr_format_r8g8b8a8_unorm, tr_max_mip_levels, nullptr, false, tr_texture_usage_sampled_image, &texture);
+    tr_create_texture_streamer(m_renderer, m_renderer->graphics_queue, k_frame_byte_budget, k_resident_byte_budget, &streamer);
+    tr_texture_streamer_add(streamer, texture, data[0].data(), k_resident_mip_count);
+    for (uint32_t frame = 0; (! tr_texture_streamer_is_done(streamer)) && (frame < k_max_frames); ++frame) {
+        tr_texture_streamer_update(streamer);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    passed = passed && tr_texture_streamer_is_done(streamer) && (2 == texture->min_lod);
+    compare_levels(texture, data[0]);
+    tr_destroy_texture_streamer(m_renderer, streamer);
+    tr_destroy_texture(m_renderer, texture);
+
+    report_check("texture_streaming", passed && (frame_count < k_max_frames) && (0 == mismatch_count), ",\"frames\":" + std::to_string(frame_count) + ",\"level_mismatches\":" + std::to_string(mismatch_count));
+}
+
+// Texels of the images check_texture_loader decodes, 3 channels
+static uint8_t loader_image_texel(uint32_t width, uint32_t height, uint32_t i)
+{
+    return (uint8_t)(((i * 0x9E3779B1u) ^ (width * 131) ^ (height * 17)) >> 8);
+}
+
+// Paths are "<width>x<height>", anything else fails to decode. p_user_data counts the images
+// that haven't been freed yet.
+static uint8_t* loader_decode_image(const char* file_path, uint32_t* p_width, uint32_t* p_height, uint32_t* p_channel_count, void* p_user_data)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if ((2 != sscanf(file_path, "%ux%u", &width, &height)) || (0 == width) || (0 == height)) {
+        return nullptr;
+    }
+    uint8_t* p_data = (uint8_t*)malloc((size_t)width * height * 3);
+    for (uint32_t i = 0; i < (width * height * 3); ++i) {
+        p_data[i] = loader_image_texel(width, height, i);
+    }
+    ++(*(std::atomic<int32_t>*)p_user_data);
+    *p_width = width;
+    *p_height = height;
+    *p_channel_count = 3;
+    return p_data;
+}
+
+static void loader_free_image(uint8_t* p_data, void* p_user_data)
+{
+    --(*(std::atomic<int32_t>*)p_user_data);
+    free(p_data);
+}
+
+// Loads a few images through batches and one that's too large for a batch. Every load has to
+// become ready with a full mip chain and level 0 has to be its image expanded to RGBA with opaque
+// alpha. Paths that fail to decode fail without a texture, and every decoded image gets freed.
+void check_texture_loader()
+{
+    const char* k_paths[] = { "16x16", "37x20", "5x9", "1x1", "64x48" };
+    const uint64_t k_batch_byte_budget = 8192;
+    const uint32_t k_max_frames = 1000;
+
+    std::atomic<int32_t> live_image_count(0);
+    tr_texture_loader* loader = nullptr;
+    tr_create_texture_loader(m_renderer, m_renderer->graphics_queue, 0, k_batch_byte_budget, loader_decode_image, loader_free_image, &live_image_count, &loader);
+    std::vector<tr_texture_load*> loads;
+    for (const char* path : k_paths) {
+        loads.push_back(tr_texture_loader_load(loader, path, tr_format_r8g8b8a8_unorm, tr_texture_usage_sampled_image, true));
+    }
+    tr_texture_load* failed_load = tr_texture_loader_load(loader, "missing", tr_format_r8g8b8a8_unorm, tr_texture_usage_sampled_image, true);
+    uint32_t frame_count = 0;
+    // Frames are a millisecond apart so workers and the GPU get time to finish
+    while ((! tr_texture_loader_is_done(loader)) && (frame_count < k_max_frames)) {
+        tr_texture_loader_update(loader);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++frame_count;
+    }
+
+    bool passed = (frame_count < k_max_frames) && (tr_texture_load_state_failed == failed_load->state) && (nullptr == failed_load->texture);
+    uint32_t mismatch_count = 0;
+    for (tr_texture_load* load : loads) {
+        if ((tr_texture_load_state_ready != load->state) || (nullptr == load->texture)) {
+            passed = false;
+            continue;
+        }
+        tr_texture* texture = load->texture;
+        passed = passed && (texture->mip_levels == tr_util_calc_mip_levels(texture->width, texture->height));
+        std::vector<uint8_t> level = readback_level(texture, 0);
+        for (uint32_t i = 0; i < (texture->width * texture->height); ++i) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                uint8_t expected = (c < 3) ? loader_image_texel(texture->width, texture->height, (i * 3) + c) : 255;
+                mismatch_count += (level[(i * 4) + c] == expected) ? 0 : 1;
+            }
+        }
+        tr_destroy_texture(m_renderer, texture);
+    }
+    tr_destroy_texture_loader(m_renderer, loader);
+
+    report_check("texture_loader", passed && (0 == mismatch_count) && (0 == live_image_count), ",\"frames\":" + std::to_string(frame_count) + ",\"byte_mismatches\":" + std::to_string(mismatch_count));
+}
+
+// -------------------------------------------------------------------------------------------------
+// main
+// -------------------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--iterations") && ((i + 1) < argc)) {
+            s_iterations = std::max(1, atoi(argv[++i]));
+        }
+        else if ((arg == "--assets") && ((i + 1) < argc)) {
+            s_asset_dir = argv[++i];
+            if (! s_asset_dir.empty() && (s_asset_dir.back() != '/') && (s_asset_dir.back() != '\\')) {
+                s_asset_dir += "/";
+            }
+        }
+        else {
+            LOG("usage: " << argv[0] << " [--iterations N] [--assets DIR]");
+            return EXIT_FAILURE;
+        }
+    }
+
+    init_tiny_renderer();
+
+    printf("{\"device\":\"%s\",\"api_version\":\"%u.%u.%u\",\"driver_version\":%u}\n",
+           m_renderer->vk_active_gpu_properties.deviceName,
+           VK_VERSION_MAJOR(m_renderer->vk_active_gpu_properties.apiVersion),
+           VK_VERSION_MINOR(m_renderer->vk_active_gpu_properties.apiVersion),
+           VK_VERSION_PATCH(m_renderer->vk_active_gpu_properties.apiVersion),
+           m_renderer->vk_active_gpu_properties.driverVersion);
+
+    bench_buffer_create_destroy();
+    bench_texture_create_destroy();
+    bench_update_buffer();
+    bench_update_descriptor_set();
+    bench_create_pipeline();
+    bench_draw_overhead();
+
+    check_update_texture_gpu_mips();
+    check_load_texture_dds();
+    check_texture_streaming();
+    check_update_texture_region();
+    check_texture_loader();
+
+    destroy_tiny_renderer();
+
+    return (0 == s_failed_check_count) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
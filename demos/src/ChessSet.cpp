@@ -52,6 +52,13 @@ const std::string   k_asset_dir = "../../demos/assets/";
 tr_renderer*        m_renderer = nullptr;
 tr_cmd_pool*        m_cmd_pool = nullptr;
 tr_cmd**            m_cmds = nullptr;
+#if defined(TINY_RENDERER_VK)
+// One per command buffer, timer 0 is the phong pass and timer 1 is the normal wireframe pass
+tr_query_pool*      m_timer_query_pools[k_image_count] = {};
+const uint32_t      k_timer_count = 2;
+// Writes a Chrome trace of the API calls and GPU timers on exit
+const bool          k_trace = false;
+#endif
 
 tr_pipeline*        m_chess_board_1_pipeline = nullptr;
 tr_pipeline*        m_chess_board_2_pipeline = nullptr;
@@ -203,11 +210,19 @@ void init_tiny_renderer(GLFWwindow* window)
     settings.vk_debug_fn                    = vulkan_debug;
     settings.instance_layers.count          = (uint32_t)instance_layers.size();
     settings.instance_layers.names          = instance_layers.empty() ? nullptr : instance_layers.data();
+    settings.trace                          = k_trace;
 #endif
     tr_create_renderer(k_app_name, &settings, &m_renderer);
 
     tr_create_cmd_pool(m_renderer, m_renderer->graphics_queue, false, &m_cmd_pool);
     tr_create_cmd_n(m_cmd_pool, false, k_image_count, &m_cmds);
+#if defined(TINY_RENDERER_VK)
+    for (uint32_t i = 0; i < k_image_count; ++i) {
+      tr_create_query_pool(m_renderer, tr_query_type_timestamp, 2 * k_timer_count, &m_timer_query_pools[i]);
+      tr_set_timer_name(m_timer_query_pools[i], 0, "Phong");
+      tr_set_timer_name(m_timer_query_pools[i], 1, "Normal wireframe");
+    }
+#endif
     
 #if defined(TINY_RENDERER_VK)
     auto vert = load_file(k_asset_dir + "ChessSet/shaders/phong.vs.spv");
@@ -305,29 +320,25 @@ void init_tiny_renderer(GLFWwindow* window)
       tr::Mesh mesh;
       bool mesh_load_res = tr::Mesh::Load(k_asset_dir + "ChessSet/models/board1.obj", &mesh);
       assert(mesh_load_res);
-      tr_create_vertex_buffer(m_renderer, mesh.GetVertexDataSize(), true, mesh.GetVertexStride(), &m_chess_board_1_vertex_buffer);
-      memcpy(m_chess_board_1_vertex_buffer->cpu_mapped_address, mesh.GetVertexData(), mesh.GetVertexDataSize());
+      tr_create_vertex_buffer_with_data(m_renderer, mesh.GetVertexDataSize(), mesh.GetVertexData(), mesh.GetVertexStride(), &m_chess_board_1_vertex_buffer);
       m_chess_board_1_vertex_count = mesh.GetVertexCount();
       
       // Chess board 2
       mesh_load_res = tr::Mesh::Load(k_asset_dir + "ChessSet/models/board2.obj", &mesh);
       assert(mesh_load_res);
-      tr_create_vertex_buffer(m_renderer, mesh.GetVertexDataSize(), true, mesh.GetVertexStride(), &m_chess_board_2_vertex_buffer);
-      memcpy(m_chess_board_2_vertex_buffer->cpu_mapped_address, mesh.GetVertexData(), mesh.GetVertexDataSize());
+      tr_create_vertex_buffer_with_data(m_renderer, mesh.GetVertexDataSize(), mesh.GetVertexData(), mesh.GetVertexStride(), &m_chess_board_2_vertex_buffer);
       m_chess_board_2_vertex_count = mesh.GetVertexCount();
       
       // Chest pieces 1
       mesh_load_res = tr::Mesh::Load(k_asset_dir + "ChessSet/models/pieces1.obj", &mesh);
       assert(mesh_load_res);
-      tr_create_vertex_buffer(m_renderer, mesh.GetVertexDataSize(), true, mesh.GetVertexStride(), &m_chess_pieces_1_vertex_buffer);
-      memcpy(m_chess_pieces_1_vertex_buffer->cpu_mapped_address, mesh.GetVertexData(), mesh.GetVertexDataSize());
+      tr_create_vertex_buffer_with_data(m_renderer, mesh.GetVertexDataSize(), mesh.GetVertexData(), mesh.GetVertexStride(), &m_chess_pieces_1_vertex_buffer);
       m_chess_pieces_1_vertex_count = mesh.GetVertexCount();
      
       // Chest pieces 2
       mesh_load_res = tr::Mesh::Load(k_asset_dir + "ChessSet/models/pieces2.obj", &mesh);
       assert(mesh_load_res);
-      tr_create_vertex_buffer(m_renderer, mesh.GetVertexDataSize(), true, mesh.GetVertexStride(), &m_chess_pieces_2_vertex_buffer);
-      memcpy(m_chess_pieces_2_vertex_buffer->cpu_mapped_address, mesh.GetVertexData(), mesh.GetVertexDataSize());
+      tr_create_vertex_buffer_with_data(m_renderer, mesh.GetVertexDataSize(), mesh.GetVertexData(), mesh.GetVertexStride(), &m_chess_pieces_2_vertex_buffer);
       m_chess_pieces_2_vertex_count = mesh.GetVertexCount();
     }
 
@@ -364,6 +375,16 @@ void init_tiny_renderer(GLFWwindow* window)
 
 void destroy_tiny_renderer()
 {
+#if defined(TINY_RENDERER_VK)
+    tr_queue_wait_idle(m_renderer->graphics_queue);
+    for (uint32_t i = 0; i < k_image_count; ++i) {
+      tr_destroy_query_pool(m_renderer, m_timer_query_pools[i]);
+    }
+    if (k_trace) {
+      std::string trace_file = std::string(k_app_name) + ".trace.json";
+      tr_write_trace(m_renderer, trace_file.c_str());
+    }
+#endif
     tr_destroy_renderer(m_renderer);
 }
 
@@ -421,7 +442,18 @@ void draw_frame()
     }
 
     tr_cmd* cmd = m_cmds[frameIdx];
+#if defined(TINY_RENDERER_VK)
+    // Results are from the last time this command buffer was submitted
+    tr_query_pool* timer_query_pool = m_timer_query_pools[frameIdx];
+    double timer_ms[k_timer_count] = {};
+    if (tr_get_timer_results(timer_query_pool, k_timer_count, timer_ms) && ((s_frame_count % 300) == 0)) {
+      LOG("GPU phong: " << timer_ms[0] << " ms, normal wireframe: " << timer_ms[1] << " ms");
+    }
+#endif
     tr_begin_cmd(cmd);
+#if defined(TINY_RENDERER_VK)
+    tr_cmd_reset_query_pool(cmd, timer_query_pool);
+#endif
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_sampled_image, tr_texture_usage_depth_stencil_attachment);
     tr_cmd_set_viewport(cmd, 0, 0, (float)s_window_width, (float)s_window_height, 0.0f, 1.0f);
@@ -434,6 +466,9 @@ void draw_frame()
     depth_stencil_clear_value.stencil = 255;
     tr_cmd_clear_depth_stencil_attachment(cmd, &depth_stencil_clear_value);
     // Draw phong
+#if defined(TINY_RENDERER_VK)
+    tr_cmd_begin_timer(cmd, timer_query_pool, 0);
+#endif
     {
       // Draw board 1
       tr_cmd_bind_pipeline(cmd, m_chess_board_1_pipeline);
@@ -456,7 +491,13 @@ void draw_frame()
       tr_cmd_bind_vertex_buffers(cmd, 1, &m_chess_pieces_2_vertex_buffer);
       tr_cmd_draw(cmd, m_chess_pieces_2_vertex_count, 0);
     }
+#if defined(TINY_RENDERER_VK)
+    tr_cmd_end_timer(cmd, timer_query_pool, 0);
+#endif
     // Draw normal wireframe 
+#if defined(TINY_RENDERER_VK)
+    tr_cmd_begin_timer(cmd, timer_query_pool, 1);
+#endif
     {
       // Draw pieces 2
       tr_cmd_bind_pipeline(cmd, m_normal_wireframe_pipeline);
@@ -470,6 +511,9 @@ void draw_frame()
       tr_cmd_bind_vertex_buffers(cmd, 1, &m_chess_pieces_2_vertex_buffer);
       tr_cmd_draw(cmd, m_chess_pieces_2_vertex_count, 0);
     }
+#if defined(TINY_RENDERER_VK)
+    tr_cmd_end_timer(cmd, timer_query_pool, 1);
+#endif
     tr_cmd_end_render(cmd);
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_depth_stencil_attachment, tr_texture_usage_sampled_image);
@@ -479,6 +523,18 @@ void draw_frame()
     tr_queue_present(m_renderer->present_queue, 1, &render_complete_semaphores);
 
     tr_queue_wait_idle(m_renderer->graphics_queue);
+
+#if defined(TINY_RENDERER_VK)
+    if ((s_frame_count % 300) == 0) {
+      const tr_frame_stats& stats = m_renderer->frame_stats;
+      LOG("CPU draws: " << stats.draw_count << ", pipeline binds: " << stats.pipeline_bind_count
+          << ", descriptor set binds: " << stats.descriptor_set_bind_count << ", barriers: " << stats.barrier_count
+          << ", upload bytes: " << stats.upload_bytes << ", allocations: " << stats.memory_allocation_count);
+    }
+    tr_reset_frame_stats(m_renderer);
+#endif
+
+    ++s_frame_count;
 }
 
 int main(int argc, char **argv)
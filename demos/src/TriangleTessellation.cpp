@@ -50,6 +50,11 @@ const std::string   k_asset_dir = "../../demos/assets/";
 tr_renderer*        m_renderer = nullptr;
 tr_cmd_pool*        m_cmd_pool = nullptr;
 tr_cmd**            m_cmds = nullptr;
+#if defined(TINY_RENDERER_VK)
+// One per command buffer, query 0 is the base pass and query 1 is the tess phong pass
+tr_query_pool*      m_stats_query_pools[k_image_count] = {};
+const uint32_t      k_stats_query_count = 2;
+#endif
 
 tr_pipeline*        m_base_pipeline = nullptr;
 tr_shader_program*  m_base_shader = nullptr;
@@ -203,6 +208,11 @@ void init_tiny_renderer(GLFWwindow* window)
 
     tr_create_cmd_pool(m_renderer, m_renderer->graphics_queue, false, &m_cmd_pool);
     tr_create_cmd_n(m_cmd_pool, false, k_image_count, &m_cmds);
+#if defined(TINY_RENDERER_VK)
+    for (uint32_t i = 0; i < k_image_count; ++i) {
+      tr_create_query_pool(m_renderer, tr_query_type_pipeline_statistics, k_stats_query_count, &m_stats_query_pools[i]);
+    }
+#endif
     
 #if defined(TINY_RENDERER_VK)
     auto vert = load_file(k_asset_dir + "TriangleTessellation/shaders/base.vs.spv");
@@ -363,6 +373,12 @@ void init_tiny_renderer(GLFWwindow* window)
 
 void destroy_tiny_renderer()
 {
+#if defined(TINY_RENDERER_VK)
+    tr_queue_wait_idle(m_renderer->graphics_queue);
+    for (uint32_t i = 0; i < k_image_count; ++i) {
+      tr_destroy_query_pool(m_renderer, m_stats_query_pools[i]);
+    }
+#endif
     tr_destroy_renderer(m_renderer);
 }
 
@@ -437,7 +453,25 @@ void draw_frame()
     }
 
     tr_cmd* cmd = m_cmds[frameIdx];
+#if defined(TINY_RENDERER_VK)
+    // Results are from the last time this command buffer was submitted
+    tr_query_pool* stats_query_pool = m_stats_query_pools[frameIdx];
+    tr_pipeline_statistics stats[k_stats_query_count] = {};
+    if (((s_frame_count % 300) == 0) && tr_get_pipeline_statistics_results(stats_query_pool, k_stats_query_count, stats)) {
+      LOG("Base: " << stats[0].vertex_shader_invocations << " vertex invocations, "
+                   << stats[0].clipping_primitives << " clipped primitives, "
+                   << stats[0].fragment_shader_invocations << " fragment invocations");
+      LOG("Tess phong: " << stats[1].vertex_shader_invocations << " vertex invocations, "
+                         << stats[1].tessellation_control_shader_patches << " patches, "
+                         << stats[1].tessellation_evaluation_shader_invocations << " evaluation invocations, "
+                         << stats[1].clipping_primitives << " clipped primitives, "
+                         << stats[1].fragment_shader_invocations << " fragment invocations");
+    }
+#endif
     tr_begin_cmd(cmd);
+#if defined(TINY_RENDERER_VK)
+    tr_cmd_reset_query_pool(cmd, stats_query_pool);
+#endif
     tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
     tr_cmd_depth_stencil_transition(cmd, render_target, tr_texture_usage_sampled_image, tr_texture_usage_depth_stencil_attachment);
     tr_cmd_set_viewport(cmd, 0, 0, (float)s_window_width, (float)s_window_height, 0.0f, 1.0f);
@@ -451,10 +485,16 @@ void draw_frame()
     tr_cmd_clear_depth_stencil_attachment(cmd, &depth_stencil_clear_value);
     // Draw base
     {
+#if defined(TINY_RENDERER_VK)
+      tr_cmd_begin_query(cmd, stats_query_pool, 0);
+#endif
       tr_cmd_bind_pipeline(cmd, m_base_pipeline);
       tr_cmd_bind_descriptor_sets(cmd, m_base_pipeline, m_base_desc_set);
       tr_cmd_bind_vertex_buffers(cmd, 1, &m_chess_pieces_vertex_buffer);
       tr_cmd_draw(cmd, m_chess_pieces_vertex_count, 0);
+#if defined(TINY_RENDERER_VK)
+      tr_cmd_end_query(cmd, stats_query_pool, 0);
+#endif
     }
     // Draw base wireframe
     {
@@ -465,10 +505,16 @@ void draw_frame()
     }
     // Draw tess phong
     {
+#if defined(TINY_RENDERER_VK)
+      tr_cmd_begin_query(cmd, stats_query_pool, 1);
+#endif
       tr_cmd_bind_pipeline(cmd, m_tess_phong_pipeline);
       tr_cmd_bind_descriptor_sets(cmd, m_tess_phong_pipeline, m_tess_phong_desc_set);
       tr_cmd_bind_vertex_buffers(cmd, 1, &m_chess_pieces_vertex_buffer);
       tr_cmd_draw(cmd, m_chess_pieces_vertex_count, 0);
+#if defined(TINY_RENDERER_VK)
+      tr_cmd_end_query(cmd, stats_query_pool, 1);
+#endif
     }
     // Draw tess phong wireframe
     {
@@ -486,6 +532,8 @@ void draw_frame()
     tr_queue_present(m_renderer->present_queue, 1, &render_complete_semaphores);
 
     tr_queue_wait_idle(m_renderer->graphics_queue);
+
+    ++s_frame_count;
 }
 
 int main(int argc, char **argv)
@@ -0,0 +1,786 @@
+#ifndef __cplusplus
+  #error "C++ is required"
+#endif
+
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+//
+// Include tinyvk.h or tinydx.h before this file. The graph only uses the
+// tr_* API so it works with either renderer.
+//
+
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tr {
+
+typedef uint32_t RenderGraphResource;
+
+const RenderGraphResource k_invalid_render_graph_resource = UINT32_MAX;
+
+/*! @struct RenderGraphTextureDesc
+
+ Describes a transient 2D texture. The usage flags of every access declared
+ on the texture are added to usage when the graph is compiled.
+
+*/
+struct RenderGraphTextureDesc {
+  uint32_t                width   = 0;
+  uint32_t                height  = 0;
+  tr_format               format  = tr_format_undefined;
+  tr_texture_usage_flags  usage   = 0;
+};
+
+/*! @struct RenderGraphRenderTargetDesc
+
+ Describes a transient render target. Clear values aren't part of the
+ render target's identity, render targets that only differ in clear
+ values can share the same memory and each pass clears with the values
+ of the render target it declared.
+
+*/
+struct RenderGraphRenderTargetDesc {
+  uint32_t                width                     = 0;
+  uint32_t                height                    = 0;
+  tr_sample_count         sample_count              = tr_sample_count_1;
+  tr_format               color_format              = tr_format_undefined;
+  uint32_t                color_attachment_count    = 1;
+  tr_clear_value          color_clear_value         = {};
+  tr_format               depth_stencil_format      = tr_format_undefined;
+  tr_clear_value          depth_stencil_clear_value = {};
+};
+
+class RenderGraph;
+
+/*! @class RenderGraphBuilder
+
+ Handed to a pass' setup function to declare the resources the pass reads
+ and writes. The declarations determine the order passes depend on each
+ other, which passes get culled and which transitions the graph records.
+
+*/
+class RenderGraphBuilder {
+public:
+  // Render targets read as textures transition all of their color attachments
+  void ReadTexture(RenderGraphResource resource, tr_texture_usage usage = tr_texture_usage_sampled_image);
+  void WriteTexture(RenderGraphResource resource, tr_texture_usage usage = tr_texture_usage_storage_image);
+  void ReadBuffer(RenderGraphResource resource, tr_buffer_usage usage);
+  void WriteBuffer(RenderGraphResource resource, tr_buffer_usage usage);
+  // The graph begins and ends the render pass around the pass' execute function
+  void SetRenderTarget(RenderGraphResource resource);
+  // Passes with side effects are never culled
+  void SetSideEffects();
+
+private:
+  friend class RenderGraph;
+
+  RenderGraphBuilder(RenderGraph* p_graph, uint32_t pass_index)
+    : m_graph(p_graph), m_pass_index(pass_index) {}
+
+  RenderGraph*  m_graph;
+  uint32_t      m_pass_index;
+};
+
+/*! @class RenderGraph
+
+ Frame graph on top of the tr_* API. Each frame:
+
+   graph.Reset();
+   auto backbuffer = graph.ImportRenderTarget("backbuffer", rt, tr_texture_usage_present, tr_texture_usage_present);
+   auto blurred    = graph.CreateTexture("blurred", desc);
+   graph.AddPass("blur",
+     [&](RenderGraphBuilder& builder) { builder.WriteTexture(blurred); },
+     [&](tr_cmd* p_cmd) { ... });
+   graph.AddPass("composite",
+     [&](RenderGraphBuilder& builder) { builder.ReadTexture(blurred); builder.SetRenderTarget(backbuffer); },
+     [&](tr_cmd* p_cmd) { ... });
+   graph.Compile();
+   graph.Execute(cmd);
+
+ Compile() culls passes that don't contribute to an imported resource, a
+ resource marked with MarkOutput() or a pass with side effects, and sorts
+ the remaining passes from their declared reads and writes. A pass runs
+ after the last pass declared before it that writes a resource it accesses,
+ and a write runs after the reads of the previous contents. Among the passes
+ that are ready, the one consuming the most recently produced resources goes
+ first so transient lifetimes stay short. The transient resources are then
+ assigned to physical textures and render targets. Transient textures with
+ the same size and format, and transient render targets with the same
+ attachments, share a physical resource when their lifetimes don't overlap.
+ Physical resources are owned by the graph and are kept across Reset() so
+ the assignment is stable from frame to frame.
+
+ Execute() records the passes, transitioning every resource to the usage
+ declared by the pass. tinyvk.h tracks buffer and per mip texture usage and
+ skips transitions to the current usage, so the graph doesn't track usage
+ of its own there. tinydx.h doesn't, so for D3D12 the graph remembers the
+ usage it last transitioned to, starting from the current usage given on
+ import. Imported resources are transitioned to their final usage at the end.
+
+*/
+class RenderGraph {
+public:
+  typedef std::function<void(RenderGraphBuilder&)>  SetupFn;
+  typedef std::function<void(tr_cmd*)>             ExecuteFn;
+
+  RenderGraph(tr_renderer* p_renderer) : m_renderer(p_renderer) {}
+
+  ~RenderGraph() {
+    for (auto& physical : m_physical_textures) {
+      tr_destroy_texture(m_renderer, physical.texture);
+    }
+    for (auto& physical : m_physical_render_targets) {
+      tr_destroy_render_target(m_renderer, physical.render_target);
+    }
+  }
+
+  RenderGraph(const RenderGraph&) = delete;
+  RenderGraph& operator=(const RenderGraph&) = delete;
+
+  void Reset() {
+    m_resources.clear();
+    m_passes.clear();
+    m_execution_order.clear();
+    m_compiled = false;
+  }
+
+  RenderGraphResource ImportTexture(const std::string& name, tr_texture* p_texture, tr_texture_usage current_usage, tr_texture_usage final_usage) {
+    assert(nullptr != p_texture);
+    Resource resource = {};
+    resource.name = name;
+    resource.type = ResourceType::Texture;
+    resource.imported = true;
+    resource.texture = p_texture;
+    resource.state.usage = current_usage;
+    resource.final_usage = final_usage;
+    return AddResource(resource);
+  }
+
+  RenderGraphResource ImportBuffer(const std::string& name, tr_buffer* p_buffer, tr_buffer_usage current_usage, tr_buffer_usage final_usage) {
+    assert(nullptr != p_buffer);
+    Resource resource = {};
+    resource.name = name;
+    resource.type = ResourceType::Buffer;
+    resource.imported = true;
+    resource.buffer = p_buffer;
+    resource.state.usage = current_usage;
+    resource.final_usage = final_usage;
+    return AddResource(resource);
+  }
+
+  RenderGraphResource ImportRenderTarget(const std::string& name, tr_render_target* p_render_target, tr_texture_usage current_usage, tr_texture_usage final_usage) {
+    assert(nullptr != p_render_target);
+    Resource resource = {};
+    resource.name = name;
+    resource.type = ResourceType::RenderTarget;
+    resource.imported = true;
+    resource.render_target = p_render_target;
+    resource.state.usage = current_usage;
+    resource.state.depth_usage = InitialDepthUsage();
+    resource.final_usage = final_usage;
+    return AddResource(resource);
+  }
+
+  RenderGraphResource CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc) {
+    assert((desc.width > 0) && (desc.height > 0));
+    assert(tr_format_undefined != desc.format);
+    Resource resource = {};
+    resource.name = name;
+    resource.type = ResourceType::Texture;
+    resource.texture_desc = desc;
+    return AddResource(resource);
+  }
+
+  RenderGraphResource CreateRenderTarget(const std::string& name, const RenderGraphRenderTargetDesc& desc) {
+    assert((desc.width > 0) && (desc.height > 0));
+    assert(tr_format_undefined != desc.color_format);
+    assert(desc.color_attachment_count <= tr_max_render_target_attachments);
+    Resource resource = {};
+    resource.name = name;
+    resource.type = ResourceType::RenderTarget;
+    resource.render_target_desc = desc;
+    return AddResource(resource);
+  }
+
+  // Keeps the passes writing a transient resource alive, ie: when the
+  // resource is read back on the CPU after the graph is submitted.
+  void MarkOutput(RenderGraphResource resource) {
+    assert(resource < m_resources.size());
+    m_resources[resource].output = true;
+  }
+
+  void AddPass(const std::string& name, const SetupFn& setup, const ExecuteFn& execute) {
+    assert(! m_compiled);
+    Pass pass = {};
+    pass.name = name;
+    pass.render_target = k_invalid_render_graph_resource;
+    pass.execute = execute;
+    m_passes.push_back(pass);
+
+    RenderGraphBuilder builder(this, (uint32_t)(m_passes.size() - 1));
+    setup(builder);
+  }
+
+  void Compile() {
+    assert(! m_compiled);
+    CullPasses();
+    SortPasses();
+    AssignPhysicalResources();
+    m_compiled = true;
+  }
+
+  void Execute(tr_cmd* p_cmd) {
+    assert(m_compiled);
+
+    for (uint32_t pass_index : m_execution_order) {
+      const Pass& pass = m_passes[pass_index];
+      for (const Access& access : pass.accesses) {
+        Transition(p_cmd, access.resource, access.usage, access.write);
+      }
+
+      if (k_invalid_render_graph_resource != pass.render_target) {
+        tr_render_target* p_render_target = GetRenderTarget(pass.render_target);
+        tr_cmd_set_viewport(p_cmd, 0, 0, (float)p_render_target->width, (float)p_render_target->height, 0.0f, 1.0f);
+        tr_cmd_set_scissor(p_cmd, 0, 0, p_render_target->width, p_render_target->height);
+        SetClearValues(pass.render_target);
+        tr_cmd_begin_render(p_cmd, p_render_target);
+        pass.execute(p_cmd);
+        tr_cmd_end_render(p_cmd);
+      }
+      else {
+        pass.execute(p_cmd);
+      }
+    }
+
+    for (uint32_t i = 0; i < (uint32_t)m_resources.size(); ++i) {
+      const Resource& resource = m_resources[i];
+      if (! resource.imported) {
+        continue;
+      }
+      Transition(p_cmd, i, resource.final_usage, false);
+      if (ResourceType::RenderTarget == resource.type) {
+        TransitionDepthStencil(p_cmd, i, InitialDepthUsage());
+      }
+    }
+  }
+
+  tr_texture* GetTexture(RenderGraphResource resource) const {
+    assert(m_compiled);
+    assert(resource < m_resources.size());
+    const Resource& res = m_resources[resource];
+    assert(ResourceType::Texture == res.type);
+    tr_texture* p_texture = res.imported ? res.texture
+                          : ((k_invalid_physical != res.physical_index) ? m_physical_textures[res.physical_index].texture : nullptr);
+    return p_texture;
+  }
+
+  tr_buffer* GetBuffer(RenderGraphResource resource) const {
+    assert(resource < m_resources.size());
+    const Resource& res = m_resources[resource];
+    assert(ResourceType::Buffer == res.type);
+    return res.buffer;
+  }
+
+  tr_render_target* GetRenderTarget(RenderGraphResource resource) const {
+    assert(m_compiled);
+    assert(resource < m_resources.size());
+    const Resource& res = m_resources[resource];
+    assert(ResourceType::RenderTarget == res.type);
+    tr_render_target* p_render_target = res.imported ? res.render_target
+                                      : ((k_invalid_physical != res.physical_index) ? m_physical_render_targets[res.physical_index].render_target : nullptr);
+    return p_render_target;
+  }
+
+  bool IsPassCulled(const std::string& name) const {
+    for (const Pass& pass : m_passes) {
+      if (pass.name == name) {
+        return pass.culled;
+      }
+    }
+    return false;
+  }
+
+  uint32_t GetPhysicalTextureCount() const {
+    return (uint32_t)m_physical_textures.size();
+  }
+
+  uint32_t GetPhysicalRenderTargetCount() const {
+    return (uint32_t)m_physical_render_targets.size();
+  }
+
+private:
+  friend class RenderGraphBuilder;
+
+  static const uint32_t k_invalid_physical = UINT32_MAX;
+
+  enum class ResourceType {
+    Texture,
+    Buffer,
+    RenderTarget,
+  };
+
+  // Usage of a resource as of the last recorded transition, only used by
+  // the D3D12 build. usage holds a tr_texture_usage or a tr_buffer_usage
+  // depending on the resource.
+  struct State {
+    uint32_t          usage;
+    tr_texture_usage  depth_usage;
+    bool              written;
+  };
+
+  struct Resource {
+    std::string                 name;
+    ResourceType                type;
+    bool                        imported;
+    bool                        output;
+    tr_texture*                 texture;
+    tr_buffer*                  buffer;
+    tr_render_target*           render_target;
+    RenderGraphTextureDesc      texture_desc;
+    RenderGraphRenderTargetDesc render_target_desc;
+    // Imported resources only
+    State                       state;
+    uint32_t                    final_usage;
+    // Transient resources only
+    uint32_t                    physical_index;
+  };
+
+  struct Access {
+    RenderGraphResource         resource;
+    uint32_t                    usage;
+    bool                        write;
+  };
+
+  struct Pass {
+    std::string                 name;
+    std::vector<Access>         accesses;
+    RenderGraphResource         render_target;
+    bool                        side_effects;
+    bool                        culled;
+    ExecuteFn                   execute;
+  };
+
+  struct PhysicalTexture {
+    RenderGraphTextureDesc      desc;
+    tr_texture*                 texture;
+    State                       state;
+    int32_t                     busy_until;
+  };
+
+  struct PhysicalRenderTarget {
+    RenderGraphRenderTargetDesc desc;
+    tr_render_target*           render_target;
+    State                       state;
+    int32_t                     busy_until;
+  };
+
+  // Usage the renderer leaves depth/stencil attachments in after creation
+  static tr_texture_usage InitialDepthUsage() {
+#if defined(TINY_RENDERER_DX)
+    return tr_texture_usage_sampled_image;
+#else
+    return tr_texture_usage_undefined;
+#endif
+  }
+
+  // Usage the renderer leaves a texture in after creation
+  static tr_texture_usage InitialUsage(tr_texture_usage_flags usage) {
+#if defined(TINY_RENDERER_DX)
+    return (usage & tr_texture_usage_color_attachment) ? tr_texture_usage_color_attachment : tr_texture_usage_sampled_image;
+#else
+    (void)usage;
+    return tr_texture_usage_undefined;
+#endif
+  }
+
+  RenderGraphResource AddResource(const Resource& resource) {
+    assert(! m_compiled);
+    m_resources.push_back(resource);
+    m_resources.back().physical_index = k_invalid_physical;
+    return (RenderGraphResource)(m_resources.size() - 1);
+  }
+
+  void AddAccess(uint32_t pass_index, RenderGraphResource resource, uint32_t usage, bool write) {
+    assert(pass_index < m_passes.size());
+    assert(resource < m_resources.size());
+    Access access = {resource, usage, write};
+    m_passes[pass_index].accesses.push_back(access);
+  }
+
+  State& GetState(RenderGraphResource resource) {
+    Resource& res = m_resources[resource];
+    if (res.imported) {
+      return res.state;
+    }
+    assert(k_invalid_physical != res.physical_index);
+    return (ResourceType::RenderTarget == res.type) ? m_physical_render_targets[res.physical_index].state
+                                                   : m_physical_textures[res.physical_index].state;
+  }
+
+  static bool IsStorageUsage(ResourceType type, uint32_t usage) {
+    if (ResourceType::Buffer == type) {
+      return (tr_buffer_usage_storage_uav == usage) || (tr_buffer_usage_storage_texel_uav == usage);
+    }
+    return (tr_texture_usage_storage_image == usage);
+  }
+
+  void Transition(tr_cmd* p_cmd, RenderGraphResource resource, uint32_t new_usage, bool write) {
+    const Resource& res = m_resources[resource];
+#if defined(TINY_RENDERER_DX)
+    State& state = GetState(resource);
+
+    // Storage accesses need a barrier between them if either one writes
+    bool storage_hazard = IsStorageUsage(res.type, new_usage) && (write || state.written);
+    if ((state.usage != new_usage) || storage_hazard) {
+      switch (res.type) {
+        case ResourceType::Texture: {
+          tr_cmd_image_transition(p_cmd, GetTexture(resource), (tr_texture_usage)state.usage, (tr_texture_usage)new_usage);
+        }
+        break;
+
+        case ResourceType::Buffer: {
+          tr_cmd_buffer_transition(p_cmd, GetBuffer(resource), (tr_buffer_usage)state.usage, (tr_buffer_usage)new_usage);
+        }
+        break;
+
+        case ResourceType::RenderTarget: {
+          tr_cmd_render_target_transition(p_cmd, GetRenderTarget(resource), (tr_texture_usage)state.usage, (tr_texture_usage)new_usage);
+        }
+        break;
+      }
+      state.usage = new_usage;
+    }
+    state.written = write;
+#else
+    // The renderer skips transitions to the current usage and orders storage accesses itself
+    (void)write;
+    switch (res.type) {
+      case ResourceType::Texture: {
+        tr_cmd_image_transition_to(p_cmd, GetTexture(resource), (tr_texture_usage)new_usage);
+      }
+      break;
+
+      case ResourceType::Buffer: {
+        tr_cmd_buffer_transition_to(p_cmd, GetBuffer(resource), (tr_buffer_usage)new_usage);
+      }
+      break;
+
+      case ResourceType::RenderTarget: {
+        tr_cmd_render_target_transition_to(p_cmd, GetRenderTarget(resource), (tr_texture_usage)new_usage);
+      }
+      break;
+    }
+#endif
+
+    // Writing a render target also writes its depth/stencil attachment
+    if ((ResourceType::RenderTarget == res.type) && (tr_texture_usage_color_attachment == new_usage)) {
+      TransitionDepthStencil(p_cmd, resource, tr_texture_usage_depth_stencil_attachment);
+    }
+  }
+
+  void TransitionDepthStencil(tr_cmd* p_cmd, RenderGraphResource resource, tr_texture_usage new_usage) {
+    tr_render_target* p_render_target = GetRenderTarget(resource);
+    if (tr_format_undefined == p_render_target->depth_stencil_format) {
+      return;
+    }
+#if defined(TINY_RENDERER_DX)
+    State& state = GetState(resource);
+    if (state.depth_usage == new_usage) {
+      return;
+    }
+    tr_cmd_depth_stencil_transition(p_cmd, p_render_target, state.depth_usage, new_usage);
+    state.depth_usage = new_usage;
+#else
+    tr_cmd_depth_stencil_transition_to(p_cmd, p_render_target, new_usage);
+#endif
+  }
+
+  void CullPasses() {
+    // Walk the passes backwards, a pass is needed if it has side effects or
+    // writes a resource that's imported, an output or read by a needed pass.
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t i = 0; i < m_resources.size(); ++i) {
+      needed[i] = m_resources[i].imported || m_resources[i].output;
+    }
+
+    for (size_t i = m_passes.size(); i > 0; --i) {
+      Pass& pass = m_passes[i - 1];
+      bool keep = pass.side_effects;
+      for (const Access& access : pass.accesses) {
+        keep |= (access.write && needed[access.resource]);
+      }
+      pass.culled = ! keep;
+      if (pass.culled) {
+        continue;
+      }
+      for (const Access& access : pass.accesses) {
+        if (! access.write) {
+          needed[access.resource] = true;
+        }
+      }
+    }
+
+  }
+
+  void SortPasses() {
+    // Dependencies only point from a pass to passes declared after it, so
+    // there's always an order that satisfies them.
+    const uint32_t k_no_pass = UINT32_MAX;
+    const uint32_t pass_count = (uint32_t)m_passes.size();
+    std::vector<std::vector<uint32_t>> dependents(pass_count);
+    std::vector<uint32_t> dependency_count(pass_count, 0);
+    auto add_dependency = [&](uint32_t before, uint32_t after) {
+      std::vector<uint32_t>& list = dependents[before];
+      if ((before != after) && (std::find(list.begin(), list.end(), after) == list.end())) {
+        list.push_back(after);
+        ++dependency_count[after];
+      }
+    };
+
+    std::vector<uint32_t> last_writer(m_resources.size(), k_no_pass);
+    std::vector<std::vector<uint32_t>> readers(m_resources.size());
+    for (uint32_t i = 0; i < pass_count; ++i) {
+      if (m_passes[i].culled) {
+        continue;
+      }
+      for (const Access& access : m_passes[i].accesses) {
+        if (k_no_pass != last_writer[access.resource]) {
+          add_dependency(last_writer[access.resource], i);
+        }
+        if (access.write) {
+          for (uint32_t reader : readers[access.resource]) {
+            add_dependency(reader, i);
+          }
+          readers[access.resource].clear();
+          last_writer[access.resource] = i;
+        }
+        else {
+          readers[access.resource].push_back(i);
+        }
+      }
+    }
+
+    // Ready passes whose latest dependency ran most recently go first, ties
+    // keep declaration order
+    const int32_t k_no_dependency = -1;
+    std::vector<int32_t> latest_dependency(pass_count, k_no_dependency);
+    std::vector<uint32_t> ready;
+    for (uint32_t i = 0; i < pass_count; ++i) {
+      if ((! m_passes[i].culled) && (0 == dependency_count[i])) {
+        ready.push_back(i);
+      }
+    }
+
+    m_execution_order.clear();
+    while (! ready.empty()) {
+      size_t best = 0;
+      for (size_t i = 1; i < ready.size(); ++i) {
+        int32_t a = latest_dependency[ready[i]];
+        int32_t b = latest_dependency[ready[best]];
+        if ((a > b) || ((a == b) && (ready[i] < ready[best]))) {
+          best = i;
+        }
+      }
+      uint32_t pass_index = ready[best];
+      ready.erase(ready.begin() + best);
+
+      int32_t position = (int32_t)m_execution_order.size();
+      m_execution_order.push_back(pass_index);
+      for (uint32_t dependent : dependents[pass_index]) {
+        latest_dependency[dependent] = position;
+        if (0 == --dependency_count[dependent]) {
+          ready.push_back(dependent);
+        }
+      }
+    }
+  }
+
+  static bool SameShape(const RenderGraphTextureDesc& a, const RenderGraphTextureDesc& b) {
+    return (a.width == b.width) && (a.height == b.height) && (a.format == b.format);
+  }
+
+  // Physical textures can stand in for any transient whose usage they cover
+  static bool Matches(const RenderGraphTextureDesc& physical, const RenderGraphTextureDesc& desc) {
+    return SameShape(physical, desc) && ((physical.usage & desc.usage) == desc.usage);
+  }
+
+  static bool Matches(const RenderGraphRenderTargetDesc& a, const RenderGraphRenderTargetDesc& b) {
+    return (a.width == b.width) && (a.height == b.height) && (a.sample_count == b.sample_count) &&
+           (a.color_format == b.color_format) && (a.color_attachment_count == b.color_attachment_count) &&
+           (a.depth_stencil_format == b.depth_stencil_format);
+  }
+
+  void AssignPhysicalResources() {
+    // Lifetime of each transient resource in execution order
+    const int32_t k_unused = -1;
+    std::vector<int32_t> first_use(m_resources.size(), k_unused);
+    std::vector<int32_t> last_use(m_resources.size(), k_unused);
+    for (int32_t position = 0; position < (int32_t)m_execution_order.size(); ++position) {
+      const Pass& pass = m_passes[m_execution_order[position]];
+      for (const Access& access : pass.accesses) {
+        Resource& res = m_resources[access.resource];
+        if (res.imported) {
+          continue;
+        }
+        if (k_unused == first_use[access.resource]) {
+          first_use[access.resource] = position;
+        }
+        last_use[access.resource] = position;
+        if (ResourceType::Texture == res.type) {
+          res.texture_desc.usage |= access.usage;
+        }
+      }
+    }
+
+    std::vector<RenderGraphResource> transients;
+    for (uint32_t i = 0; i < (uint32_t)m_resources.size(); ++i) {
+      if ((! m_resources[i].imported) && (k_unused != first_use[i])) {
+        transients.push_back(i);
+      }
+    }
+
+    // Transient textures of the same shape get the union of their usages, so
+    // one physical texture can serve all of them regardless of how each is used
+    for (RenderGraphResource a : transients) {
+      Resource& res_a = m_resources[a];
+      if (ResourceType::Texture != res_a.type) {
+        continue;
+      }
+      for (RenderGraphResource b : transients) {
+        const Resource& res_b = m_resources[b];
+        if ((ResourceType::Texture == res_b.type) && SameShape(res_a.texture_desc, res_b.texture_desc)) {
+          res_a.texture_desc.usage |= res_b.texture_desc.usage;
+        }
+      }
+    }
+    std::stable_sort(transients.begin(), transients.end(),
+      [&first_use](RenderGraphResource a, RenderGraphResource b) { return first_use[a] < first_use[b]; });
+
+    for (auto& physical : m_physical_textures) {
+      physical.busy_until = k_unused;
+    }
+    for (auto& physical : m_physical_render_targets) {
+      physical.busy_until = k_unused;
+    }
+
+    for (RenderGraphResource resource : transients) {
+      Resource& res = m_resources[resource];
+      if (ResourceType::Texture == res.type) {
+        res.physical_index = AcquirePhysicalTexture(res.texture_desc, first_use[resource], last_use[resource]);
+      }
+      else if (ResourceType::RenderTarget == res.type) {
+        res.physical_index = AcquirePhysicalRenderTarget(res.render_target_desc, first_use[resource], last_use[resource]);
+      }
+    }
+  }
+
+  uint32_t AcquirePhysicalTexture(const RenderGraphTextureDesc& desc, int32_t first_use, int32_t last_use) {
+    for (uint32_t i = 0; i < (uint32_t)m_physical_textures.size(); ++i) {
+      PhysicalTexture& physical = m_physical_textures[i];
+      if ((physical.busy_until < first_use) && Matches(physical.desc, desc)) {
+        physical.busy_until = last_use;
+        return i;
+      }
+    }
+
+    PhysicalTexture physical = {};
+    physical.desc = desc;
+    tr_create_texture_2d(m_renderer, desc.width, desc.height, tr_sample_count_1, desc.format, 1, NULL, false, desc.usage, &physical.texture);
+    physical.state.usage = InitialUsage(desc.usage);
+    physical.busy_until = last_use;
+    m_physical_textures.push_back(physical);
+    return (uint32_t)(m_physical_textures.size() - 1);
+  }
+
+  uint32_t AcquirePhysicalRenderTarget(const RenderGraphRenderTargetDesc& desc, int32_t first_use, int32_t last_use) {
+    uint32_t index = k_invalid_physical;
+    for (uint32_t i = 0; i < (uint32_t)m_physical_render_targets.size(); ++i) {
+      PhysicalRenderTarget& physical = m_physical_render_targets[i];
+      if ((physical.busy_until < first_use) && Matches(physical.desc, desc)) {
+        index = i;
+        break;
+      }
+    }
+
+    if (k_invalid_physical == index) {
+      std::vector<tr_clear_value> color_clear_values(desc.color_attachment_count, desc.color_clear_value);
+      PhysicalRenderTarget physical = {};
+      physical.desc = desc;
+      tr_create_render_target(m_renderer, desc.width, desc.height, desc.sample_count,
+                              desc.color_format, desc.color_attachment_count, color_clear_values.data(),
+                              desc.depth_stencil_format, &desc.depth_stencil_clear_value,
+                              &physical.render_target);
+      physical.state.usage = InitialUsage(tr_texture_usage_color_attachment);
+      physical.state.depth_usage = InitialDepthUsage();
+      m_physical_render_targets.push_back(physical);
+      index = (uint32_t)(m_physical_render_targets.size() - 1);
+    }
+
+    m_physical_render_targets[index].busy_until = last_use;
+    return index;
+  }
+
+  // Transients sharing a physical render target each keep their own clear
+  // values, so they're set on the physical render target right before the
+  // pass using the transient begins rendering.
+  void SetClearValues(RenderGraphResource resource) {
+    const Resource& res = m_resources[resource];
+    if (res.imported) {
+      return;
+    }
+    const RenderGraphRenderTargetDesc& desc = res.render_target_desc;
+    tr_render_target* p_render_target = GetRenderTarget(resource);
+    for (uint32_t i = 0; i < desc.color_attachment_count; ++i) {
+      const tr_clear_value& value = desc.color_clear_value;
+      tr_render_target_set_color_clear_value(p_render_target, i, value.r, value.g, value.b, value.a);
+    }
+    if (tr_format_undefined != desc.depth_stencil_format) {
+      const tr_clear_value& value = desc.depth_stencil_clear_value;
+      tr_render_target_set_depth_stencil_clear_value(p_render_target, value.depth, (uint8_t)value.stencil);
+    }
+  }
+
+private:
+  tr_renderer*                      m_renderer = nullptr;
+  std::vector<Resource>             m_resources;
+  std::vector<Pass>                 m_passes;
+  std::vector<uint32_t>             m_execution_order;
+  std::vector<PhysicalTexture>      m_physical_textures;
+  std::vector<PhysicalRenderTarget> m_physical_render_targets;
+  bool                              m_compiled = false;
+};
+
+inline void RenderGraphBuilder::ReadTexture(RenderGraphResource resource, tr_texture_usage usage) {
+  m_graph->AddAccess(m_pass_index, resource, usage, false);
+}
+
+inline void RenderGraphBuilder::WriteTexture(RenderGraphResource resource, tr_texture_usage usage) {
+  m_graph->AddAccess(m_pass_index, resource, usage, true);
+}
+
+inline void RenderGraphBuilder::ReadBuffer(RenderGraphResource resource, tr_buffer_usage usage) {
+  m_graph->AddAccess(m_pass_index, resource, usage, false);
+}
+
+inline void RenderGraphBuilder::WriteBuffer(RenderGraphResource resource, tr_buffer_usage usage) {
+  m_graph->AddAccess(m_pass_index, resource, usage, true);
+}
+
+inline void RenderGraphBuilder::SetRenderTarget(RenderGraphResource resource) {
+  assert(k_invalid_render_graph_resource == m_graph->m_passes[m_pass_index].render_target);
+  m_graph->AddAccess(m_pass_index, resource, tr_texture_usage_color_attachment, true);
+  m_graph->m_passes[m_pass_index].render_target = resource;
+}
+
+inline void RenderGraphBuilder::SetSideEffects() {
+  m_graph->m_passes[m_pass_index].side_effects = true;
+}
+
+} // namespace tr
+
+#endif // RENDERGRAPH_H
@@ -17,6 +17,7 @@
 #elif defined(TINY_RENDERER_VK)
     #include "tinyvk.h"
 #endif
+#include "rendergraph.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -51,9 +52,12 @@ tr_texture*         g_texture = nullptr;
 tr_texture*         g_texture_compute_output_hblur = nullptr;
 tr_texture*         g_texture_compute_output_vblur = nullptr;
 tr_sampler*         g_sampler = nullptr;
+tr::RenderGraph*    g_render_graph = nullptr;
 
 uint32_t            g_window_width;
 uint32_t            g_window_height;
+uint32_t            g_image_width;
+uint32_t            g_image_height;
 uint64_t            g_frame_count = 0;
 
 #define LOG(STR)  { std::stringstream ss; ss << STR << std::endl; \
@@ -295,12 +299,10 @@ void init_tiny_renderer(GLFWwindow* window)
     tr_util_update_texture_uint8(g_renderer->graphics_queue, image_width, image_height, image_row_stride, image_data, required_channels, g_texture, NULL, NULL);
     stbi_image_free(image_data);
 
-    // hblur
-    tr_create_texture_2d(g_renderer, image_width, image_height, tr_sample_count_1, tr_format_r8g8b8a8_unorm, 1, NULL, false, tr_texture_usage_sampled_image | tr_texture_usage_storage_image, &g_texture_compute_output_hblur); 
-    tr_util_transition_image(g_renderer->graphics_queue, g_texture_compute_output_hblur, tr_texture_usage_undefined, tr_texture_usage_sampled_image);
-    // vblur
-    tr_create_texture_2d(g_renderer, image_width, image_height, tr_sample_count_1, tr_format_r8g8b8a8_unorm, 1, NULL, false, tr_texture_usage_sampled_image | tr_texture_usage_storage_image, &g_texture_compute_output_vblur); 
-    tr_util_transition_image(g_renderer->graphics_queue, g_texture_compute_output_vblur, tr_texture_usage_undefined, tr_texture_usage_sampled_image);
+    // The blur outputs are transient textures owned by the render graph
+    g_image_width = (uint32_t)image_width;
+    g_image_height = (uint32_t)image_height;
+    g_render_graph = new tr::RenderGraph(g_renderer);
   }
 
   // Samplers
@@ -308,25 +310,35 @@ void init_tiny_renderer(GLFWwindow* window)
     tr_create_sampler(g_renderer, &g_sampler);
   }
 
-  // Update descriptor sets
-  {
-    g_desc_set->descriptors[0].textures[0] = g_texture_compute_output_vblur;
-    g_desc_set->descriptors[1].samplers[0] = g_sampler;
-    tr_update_descriptor_set(g_renderer, g_desc_set);
-
-    // hblur
-    g_compute_desc_set_hblur->descriptors[0].textures[0] = g_texture;
-    g_compute_desc_set_hblur->descriptors[1].textures[0] = g_texture_compute_output_hblur;
-    tr_update_descriptor_set(g_renderer, g_compute_desc_set_hblur);
-    // vblur
-    g_compute_desc_set_vblur->descriptors[0].textures[0] = g_texture_compute_output_hblur;
-    g_compute_desc_set_vblur->descriptors[1].textures[0] = g_texture_compute_output_vblur;
-    tr_update_descriptor_set(g_renderer, g_compute_desc_set_vblur);
+  // Descriptor sets are updated in update_descriptor_sets once the render graph 
+  // has assigned the blur outputs.
+}
+
+void update_descriptor_sets(tr_texture* p_hblur, tr_texture* p_vblur)
+{
+  if ((p_hblur == g_texture_compute_output_hblur) && (p_vblur == g_texture_compute_output_vblur)) {
+    return;
   }
+  g_texture_compute_output_hblur = p_hblur;
+  g_texture_compute_output_vblur = p_vblur;
+
+  g_desc_set->descriptors[0].textures[0] = g_texture_compute_output_vblur;
+  g_desc_set->descriptors[1].samplers[0] = g_sampler;
+  tr_update_descriptor_set(g_renderer, g_desc_set);
+
+  // hblur
+  g_compute_desc_set_hblur->descriptors[0].textures[0] = g_texture;
+  g_compute_desc_set_hblur->descriptors[1].textures[0] = g_texture_compute_output_hblur;
+  tr_update_descriptor_set(g_renderer, g_compute_desc_set_hblur);
+  // vblur
+  g_compute_desc_set_vblur->descriptors[0].textures[0] = g_texture_compute_output_hblur;
+  g_compute_desc_set_vblur->descriptors[1].textures[0] = g_texture_compute_output_vblur;
+  tr_update_descriptor_set(g_renderer, g_compute_desc_set_vblur);
 }
 
 void destroy_tiny_renderer()
 {
+    delete g_render_graph;
     tr_destroy_renderer(g_renderer);
 }
 
@@ -345,43 +357,69 @@ void draw_frame()
 
   tr_cmd* cmd = g_cmds[frameIdx];
 
-  tr_begin_cmd(cmd);
+  // Build the frame's render graph, the graph records every transition
+  tr::RenderGraph& graph = *g_render_graph;
+  graph.Reset();
+
+  tr::RenderGraphResource source = graph.ImportTexture("source", g_texture, tr_texture_usage_sampled_image, tr_texture_usage_sampled_image);
+  tr::RenderGraphResource backbuffer = graph.ImportRenderTarget("backbuffer", render_target, tr_texture_usage_present, tr_texture_usage_present);
+
+  tr::RenderGraphTextureDesc blur_desc;
+  blur_desc.width  = g_image_width;
+  blur_desc.height = g_image_height;
+  blur_desc.format = tr_format_r8g8b8a8_unorm;
+  tr::RenderGraphResource hblur = graph.CreateTexture("hblur", blur_desc);
+  tr::RenderGraphResource vblur = graph.CreateTexture("vblur", blur_desc);
+
   // hblur
-  {
-    tr_cmd_image_transition(cmd, g_texture_compute_output_hblur, tr_texture_usage_sampled_image, tr_texture_usage_storage_image);
-    tr_cmd_bind_pipeline(cmd, g_compute_pipeline_hblur);
-    tr_cmd_bind_descriptor_sets(cmd, g_compute_pipeline_hblur, g_compute_desc_set_hblur);
-    const int num_groups_x = 1;
-    const int num_groups_y = g_texture_compute_output_hblur->height;
-    const int num_groups_z = 1;
-    tr_cmd_dispatch(cmd, num_groups_x, num_groups_y, num_groups_z);
-    tr_cmd_image_transition(cmd, g_texture_compute_output_hblur, tr_texture_usage_storage_image, tr_texture_usage_sampled_image);
-  }
-  // vbblur
-  {
-    tr_cmd_image_transition(cmd, g_texture_compute_output_vblur, tr_texture_usage_sampled_image, tr_texture_usage_storage_image);
-    tr_cmd_bind_pipeline(cmd, g_compute_pipeline_vblur);
-    tr_cmd_bind_descriptor_sets(cmd, g_compute_pipeline_vblur, g_compute_desc_set_vblur);
-    const int num_groups_x = g_texture_compute_output_vblur->width;
-    const int num_groups_y = 1;
-    const int num_groups_z = 1;
-    tr_cmd_dispatch(cmd, num_groups_x, num_groups_y, num_groups_z);
-    tr_cmd_image_transition(cmd, g_texture_compute_output_vblur, tr_texture_usage_storage_image, tr_texture_usage_sampled_image);
-  }
+  graph.AddPass("hblur",
+    [&](tr::RenderGraphBuilder& builder) {
+      builder.ReadTexture(source);
+      builder.WriteTexture(hblur);
+    },
+    [&](tr_cmd* p_cmd) {
+      tr_cmd_bind_pipeline(p_cmd, g_compute_pipeline_hblur);
+      tr_cmd_bind_descriptor_sets(p_cmd, g_compute_pipeline_hblur, g_compute_desc_set_hblur);
+      const int num_groups_x = 1;
+      const int num_groups_y = g_image_height;
+      const int num_groups_z = 1;
+      tr_cmd_dispatch(p_cmd, num_groups_x, num_groups_y, num_groups_z);
+    });
+  // vblur
+  graph.AddPass("vblur",
+    [&](tr::RenderGraphBuilder& builder) {
+      builder.ReadTexture(hblur);
+      builder.WriteTexture(vblur);
+    },
+    [&](tr_cmd* p_cmd) {
+      tr_cmd_bind_pipeline(p_cmd, g_compute_pipeline_vblur);
+      tr_cmd_bind_descriptor_sets(p_cmd, g_compute_pipeline_vblur, g_compute_desc_set_vblur);
+      const int num_groups_x = g_image_width;
+      const int num_groups_y = 1;
+      const int num_groups_z = 1;
+      tr_cmd_dispatch(p_cmd, num_groups_x, num_groups_y, num_groups_z);
+    });
   // Draw compute result to screen
-  tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_present, tr_texture_usage_color_attachment); 
-  tr_cmd_set_viewport(cmd, 0, 0, (float)g_window_width, (float)g_window_height, 0.0f, 1.0f);
-  tr_cmd_set_scissor(cmd, 0, 0, g_window_width, g_window_height);
-  tr_cmd_begin_render(cmd, render_target);
-  tr_clear_value clear_value = {0.0f, 0.0f, 0.0f, 0.0f};
-  tr_cmd_clear_color_attachment(cmd, 0, &clear_value);
-  tr_cmd_bind_pipeline(cmd, g_pipeline);
-  tr_cmd_bind_index_buffer(cmd, g_rect_index_buffer);
-  tr_cmd_bind_vertex_buffers(cmd, 1, &g_rect_vertex_buffer);
-  tr_cmd_bind_descriptor_sets(cmd, g_pipeline, g_desc_set);
-  tr_cmd_draw_indexed(cmd, 6, 0);
-  tr_cmd_end_render(cmd);
-  tr_cmd_render_target_transition(cmd, render_target, tr_texture_usage_color_attachment, tr_texture_usage_present); 
+  graph.AddPass("composite",
+    [&](tr::RenderGraphBuilder& builder) {
+      builder.ReadTexture(vblur);
+      builder.SetRenderTarget(backbuffer);
+    },
+    [&](tr_cmd* p_cmd) {
+      tr_clear_value clear_value = {0.0f, 0.0f, 0.0f, 0.0f};
+      tr_cmd_clear_color_attachment(p_cmd, 0, &clear_value);
+      tr_cmd_bind_pipeline(p_cmd, g_pipeline);
+      tr_cmd_bind_index_buffer(p_cmd, g_rect_index_buffer);
+      tr_cmd_bind_vertex_buffers(p_cmd, 1, &g_rect_vertex_buffer);
+      tr_cmd_bind_descriptor_sets(p_cmd, g_pipeline, g_desc_set);
+      tr_cmd_draw_indexed(p_cmd, 6, 0);
+    });
+
+  graph.Compile();
+  update_descriptor_sets(graph.GetTexture(hblur), graph.GetTexture(vblur));
+
+  tr_begin_cmd(cmd);
+  graph.Execute(cmd);
   tr_end_cmd(cmd);
 
   tr_queue_submit(g_renderer->graphics_queue, 1, &cmd, 1, &image_acquired_semaphore, 1, &render_complete_semaphores);
@@ -204,10 +204,24 @@ typedef enum tr_texture_usage {
     tr_texture_usage_resolve_src                = 0x00000040,
     tr_texture_usage_resolve_dst                = 0x00000080,
     tr_texture_usage_present                    = 0x00000100,
+    // Attachment contents never leave the render pass, can't be combined with
+    // sampled, storage or transfer usages.
+    tr_texture_usage_transient_attachment       = 0x00000200,
 } tr_texture_usage;
 
 typedef uint32_t tr_texture_usage_flags;
 
+typedef enum tr_attachment_load_op {
+    tr_attachment_load_op_clear = 0,
+    tr_attachment_load_op_load,
+    tr_attachment_load_op_dont_care,
+} tr_attachment_load_op;
+
+typedef enum tr_attachment_store_op {
+    tr_attachment_store_op_store = 0,
+    tr_attachment_store_op_dont_care,
+} tr_attachment_store_op;
+
 typedef enum tr_format {
     tr_format_undefined = 0,
     // 1 channel
@@ -566,6 +580,13 @@ typedef struct tr_render_target {
     tr_format                           depth_stencil_format;
     tr_texture*                         depth_stencil_attachment;
     tr_texture*                         depth_stencil_attachment_multisample;
+    // Load/store ops default to tr_attachment_load_op_clear and tr_attachment_store_op_store
+    tr_attachment_load_op               color_load_ops[tr_max_render_target_attachments];
+    tr_attachment_store_op              color_store_ops[tr_max_render_target_attachments];
+    tr_attachment_load_op               depth_load_op;
+    tr_attachment_store_op              depth_store_op;
+    tr_attachment_load_op               stencil_load_op;
+    tr_attachment_store_op              stencil_store_op;
     ID3D12DescriptorHeap*               dx_rtv_heap;
     ID3D12DescriptorHeap*               dx_dsv_heap;
 } tr_render_target;
@@ -613,6 +634,9 @@ tr_api_export void tr_create_buffer(tr_renderer* p_renderer, tr_buffer_usage usa
 tr_api_export void tr_create_index_buffer(tr_renderer*p_renderer, uint64_t size, bool host_visible, tr_index_type index_type, tr_buffer** pp_buffer);
 tr_api_export void tr_create_uniform_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, tr_buffer** pp_buffer);
 tr_api_export void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, uint32_t vertex_stride, tr_buffer** pp_buffer);
+// Device local buffers for static geometry, p_data is uploaded on the graphics queue and the queue is waited on
+tr_api_export void tr_create_index_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, tr_index_type index_type, tr_buffer** pp_buffer);
+tr_api_export void tr_create_vertex_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, uint32_t vertex_stride, tr_buffer** pp_buffer);
 tr_api_export void tr_create_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_buffer);
 tr_api_export void tr_create_rw_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_counter_buffer, tr_buffer** pp_buffer);
 tr_api_export void tr_destroy_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer);
@@ -670,6 +694,15 @@ tr_api_export void tr_queue_wait_idle(tr_queue* p_queue);
 
 tr_api_export void tr_render_target_set_color_clear_value(tr_render_target* p_render_target, uint32_t attachment_index, float r, float g, float b, float a);
 tr_api_export void tr_render_target_set_depth_stencil_clear_value(tr_render_target* p_render_target, float depth, uint8_t stencil);
+/*
+
+Load/store ops are only recorded on D3D12 to keep the API in sync with Vulkan, render targets 
+are bound with OMSetRenderTargets which has no load/store semantics. Clears still need to be
+done with tr_cmd_clear_color_attachment and tr_cmd_clear_depth_stencil_attachment.
+
+*/
+tr_api_export void tr_render_target_set_color_load_store_ops(tr_render_target* p_render_target, uint32_t attachment_index, tr_attachment_load_op load_op, tr_attachment_store_op store_op);
+tr_api_export void tr_render_target_set_depth_stencil_load_store_ops(tr_render_target* p_render_target, tr_attachment_load_op depth_load_op, tr_attachment_store_op depth_store_op, tr_attachment_load_op stencil_load_op, tr_attachment_store_op stencil_store_op);
 
 tr_api_export bool      tr_vertex_layout_support_format(tr_format format);
 tr_api_export uint32_t  tr_vertex_layout_stride(const tr_vertex_layout* p_vertex_layout);
@@ -1361,6 +1394,22 @@ void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_v
     (*pp_buffer)->dx_vertex_buffer_view.StrideInBytes = vertex_stride;
 }
 
+void tr_create_index_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, tr_index_type index_type, tr_buffer** pp_buffer)
+{
+    assert(NULL != p_data);
+
+    tr_create_index_buffer(p_renderer, size, false, index_type, pp_buffer);
+    tr_util_update_buffer(p_renderer->graphics_queue, size, p_data, *pp_buffer);
+}
+
+void tr_create_vertex_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, uint32_t vertex_stride, tr_buffer** pp_buffer)
+{
+    assert(NULL != p_data);
+
+    tr_create_vertex_buffer(p_renderer, size, false, vertex_stride, pp_buffer);
+    tr_util_update_buffer(p_renderer->graphics_queue, size, p_data, *pp_buffer);
+}
+
 void tr_create_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_buffer)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -2044,6 +2093,26 @@ void tr_render_target_set_depth_stencil_clear_value(tr_render_target* p_render_t
     p_render_target->depth_stencil_attachment->clear_value.stencil = stencil;
 }
 
+void tr_render_target_set_color_load_store_ops(tr_render_target* p_render_target, uint32_t attachment_index, tr_attachment_load_op load_op, tr_attachment_store_op store_op)
+{
+    assert(NULL != p_render_target);
+    assert(attachment_index < p_render_target->color_attachment_count);
+
+    p_render_target->color_load_ops[attachment_index] = load_op;
+    p_render_target->color_store_ops[attachment_index] = store_op;
+}
+
+void tr_render_target_set_depth_stencil_load_store_ops(tr_render_target* p_render_target, tr_attachment_load_op depth_load_op, tr_attachment_store_op depth_store_op, tr_attachment_load_op stencil_load_op, tr_attachment_store_op stencil_store_op)
+{
+    assert(NULL != p_render_target);
+    assert(tr_format_undefined != p_render_target->depth_stencil_format);
+
+    p_render_target->depth_load_op = depth_load_op;
+    p_render_target->depth_store_op = depth_store_op;
+    p_render_target->stencil_load_op = stencil_load_op;
+    p_render_target->stencil_store_op = stencil_store_op;
+}
+
 bool tr_vertex_layout_support_format(tr_format format)
 {
     bool result = false;
@@ -2590,7 +2659,14 @@ void tr_util_update_texture_float(tr_queue* p_queue, uint32_t src_width, uint32_
 // -------------------------------------------------------------------------------------------------
 D3D12_RESOURCE_STATES tr_util_to_dx_resource_state_buffer(tr_buffer_usage usage)
 {
+    // Matches the states tr_internal_dx_create_buffer creates device local buffers in
     D3D12_RESOURCE_STATES result = D3D12_RESOURCE_STATE_COMMON;
+    if (tr_buffer_usage_index == (usage & tr_buffer_usage_index)) {
+        result |= D3D12_RESOURCE_STATE_INDEX_BUFFER;
+    }
+    if ((tr_buffer_usage_vertex == (usage & tr_buffer_usage_vertex)) || (tr_buffer_usage_uniform_cbv == (usage & tr_buffer_usage_uniform_cbv))) {
+        result |= D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+    }
     if (tr_buffer_usage_transfer_src == (usage & tr_buffer_usage_transfer_src)) {
         result |= D3D12_RESOURCE_STATE_COPY_SOURCE;
     }
@@ -56,6 +56,10 @@ COMPILING & LINKING
       #define TINY_RENDERER_IMPLEMENTATION
    before the #include. That will create the implementation in that file.
 
+   Also defining TINY_RENDERER_IMAGE_ONLY limits the implementation to the CPU
+   image functions (format helpers, resizers, block compressors, DDS parsing).
+   Those don't call into Vulkan, so the program doesn't need to link it.
+
 */
 
 #pragma once
@@ -63,6 +67,7 @@ COMPILING & LINKING
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -70,6 +75,7 @@ COMPILING & LINKING
     #define TINY_RENDERER_LINUX
     #define VK_USE_PLATFORM_XCB_KHR
     #include <X11/Xlib-xcb.h>
+    #include <time.h>
 #endif
 
 #if defined(_WIN32)
@@ -114,6 +120,7 @@ enum {
     tr_max_semantic_name_length      = 128,
     tr_max_descriptor_entries        = 256,
     tr_max_mip_levels                = 0xFFFFFFFF,
+    tr_max_trace_event_name_length   = 64,
 };
 #endif
 
@@ -202,10 +209,30 @@ typedef enum tr_texture_usage {
     tr_texture_usage_resolve_src                = 0x00000040,
     tr_texture_usage_resolve_dst                = 0x00000080,
     tr_texture_usage_present                    = 0x00000100,
+    // Attachment contents never leave the render pass, can't be combined with
+    // sampled, storage or transfer usages.
+    tr_texture_usage_transient_attachment       = 0x00000200,
 } tr_texture_usage;
 
 typedef uint32_t tr_texture_usage_flags;
 
+typedef enum tr_attachment_load_op {
+    tr_attachment_load_op_clear = 0,
+    tr_attachment_load_op_load,
+    tr_attachment_load_op_dont_care,
+} tr_attachment_load_op;
+
+typedef enum tr_attachment_store_op {
+    tr_attachment_store_op_store = 0,
+    tr_attachment_store_op_dont_care,
+} tr_attachment_store_op;
+
+typedef enum tr_query_type {
+    tr_query_type_timestamp = 0,
+    tr_query_type_pipeline_statistics,
+    tr_query_type_occlusion,
+} tr_query_type;
+
 typedef enum tr_format {
     tr_format_undefined = 0,
     // 1 channel
@@ -241,6 +268,12 @@ typedef enum tr_format {
     tr_format_d16_unorm_s8_uint,
     tr_format_d24_unorm_s8_uint,
     tr_format_d32_float_s8_uint,
+    // Block compressed, 4x4 texel blocks
+    tr_format_bc1_rgba_unorm,
+    tr_format_bc3_unorm,
+    tr_format_bc4_unorm,
+    tr_format_bc5_unorm,
+    tr_format_bc7_unorm,
 } tr_format;
 
 typedef enum tr_descriptor_type {
@@ -335,6 +368,7 @@ typedef struct tr_render_target tr_render_target;
 typedef struct tr_buffer tr_buffer;
 typedef struct tr_texture tr_texture;
 typedef struct tr_sampler tr_sampler;
+typedef struct tr_fence tr_fence;
 
 typedef struct tr_clear_value {
     union {
@@ -382,6 +416,11 @@ typedef struct tr_renderer_settings {
     uint32_t                            height;
     tr_swapchain_settings               swapchain;
     tr_log_fn                           log_fn;
+    // No surface or swapchain, handle is ignored and swapchain_render_targets 
+    // become a ring of offscreen render targets. Present only waits on semaphores.
+    bool                                headless;
+    // Record a timeline of API calls and GPU timers, see tr_write_trace
+    bool                                trace;
     // Vulkan specific options
     tr_string_list                      instance_layers;
     tr_string_list                      instance_extensions;
@@ -404,6 +443,76 @@ typedef struct tr_queue {
     uint32_t                            vk_queue_family_index;
 } tr_queue;
 
+// Render passes are shared by render targets with the same formats, sample count and 
+// load/store ops. Framebuffers are shared by render targets with the same attachments.
+typedef struct tr_vk_render_pass_key {
+    tr_format                           color_format;
+    uint32_t                            color_attachment_count;
+    tr_sample_count                     sample_count;
+    tr_format                           depth_stencil_format;
+    uint32_t                            is_swapchain;
+    tr_attachment_load_op               color_load_ops[tr_max_render_target_attachments];
+    tr_attachment_store_op              color_store_ops[tr_max_render_target_attachments];
+    tr_attachment_load_op               depth_load_op;
+    tr_attachment_store_op              depth_store_op;
+    tr_attachment_load_op               stencil_load_op;
+    tr_attachment_store_op              stencil_store_op;
+} tr_vk_render_pass_key;
+
+typedef struct tr_vk_render_pass_cache_entry {
+    uint64_t                            hash;
+    tr_vk_render_pass_key               key;
+    VkRenderPass                        vk_render_pass;
+} tr_vk_render_pass_cache_entry;
+
+typedef struct tr_vk_framebuffer_key {
+    VkRenderPass                        vk_render_pass;
+    uint32_t                            width;
+    uint32_t                            height;
+    uint32_t                            attachment_count;
+    VkImageView                         attachments[(2 * tr_max_render_target_attachments) + 1];
+} tr_vk_framebuffer_key;
+
+typedef struct tr_vk_framebuffer_cache_entry {
+    uint64_t                            hash;
+    tr_vk_framebuffer_key               key;
+    VkFramebuffer                       vk_framebuffer;
+} tr_vk_framebuffer_cache_entry;
+
+typedef enum tr_trace_thread {
+    tr_trace_thread_cpu = 1,
+    tr_trace_thread_gpu = 2,
+} tr_trace_thread;
+
+typedef struct tr_trace_event {
+    char                                name[tr_max_trace_event_name_length];
+    tr_trace_thread                     thread;
+    // Microseconds since the trace started
+    double                              begin_us;
+    double                              duration_us;
+} tr_trace_event;
+
+typedef struct tr_trace {
+    uint64_t                            start_us;
+    uint32_t                            event_count;
+    uint32_t                            event_capacity;
+    tr_trace_event*                     events;
+    // GPU timestamp = (CPU time - gpu_offset_us) / gpu_us_per_tick
+    double                              gpu_us_per_tick;
+    double                              gpu_offset_us;
+} tr_trace;
+
+typedef struct tr_frame_stats {
+    uint64_t                            draw_count;
+    uint64_t                            dispatch_count;
+    uint64_t                            pipeline_bind_count;
+    uint64_t                            descriptor_set_bind_count;
+    uint64_t                            barrier_count;
+    uint64_t                            upload_bytes;
+    uint64_t                            memory_allocation_count;
+    uint64_t                            descriptor_pool_count;
+} tr_frame_stats;
+
 typedef struct tr_renderer {
     tr_api                              api;
     tr_renderer_settings                settings;
@@ -426,6 +535,15 @@ typedef struct tr_renderer {
     VkSwapchainKHR                      vk_swapchain;
     VkDebugReportCallbackEXT            vk_debug_report;
     bool                                vk_device_ext_VK_AMD_negative_viewport_height;
+    uint32_t                            vk_render_pass_cache_count;
+    tr_vk_render_pass_cache_entry*      vk_render_pass_cache;
+    uint32_t                            vk_framebuffer_cache_count;
+    tr_vk_framebuffer_cache_entry*      vk_framebuffer_cache;
+    tr_frame_stats                      frame_stats;
+    // Staging for tr_util_update_buffer and tr_util_update_texture_region, which wait for their queue to go idle. Grows to fit the largest upload.
+    tr_buffer*                          upload_staging;
+    // NULL unless settings.trace is set
+    tr_trace*                           trace;
 } tr_renderer;
 
 typedef struct tr_descriptor {
@@ -460,8 +578,12 @@ typedef struct tr_cmd {
 typedef struct tr_buffer {
     tr_renderer*                        renderer;
     tr_buffer_usage                     usage;
+    // Usage as of the last recorded transition
+    tr_buffer_usage                     current_usage;
     uint64_t                            size;
     bool                                host_visible;
+    // Prefer host cached memory for host visible buffers the CPU reads from
+    bool                                host_cached;
     tr_index_type                       index_type;
     uint32_t                            vertex_stride;
     tr_format                           format;
@@ -480,6 +602,15 @@ typedef struct tr_buffer {
     tr_buffer*                          counter_buffer;
 } tr_buffer;
 
+// Byte offsets are relative to tr_texture::cpu_mapped_address
+typedef struct tr_subresource_layout {
+    uint64_t                            offset;
+    uint64_t                            size;
+    uint64_t                            row_pitch;
+    uint64_t                            array_pitch;
+    uint64_t                            depth_pitch;
+} tr_subresource_layout;
+
 typedef struct tr_texture {
     tr_renderer*                        renderer;
     tr_texture_type                     type;
@@ -487,16 +618,24 @@ typedef struct tr_texture {
     uint32_t                            width;
     uint32_t                            height;
     uint32_t                            depth;
+    // Cube textures have 6 layers per cube, faces are in +X, -X, +Y, -Y, +Z, -Z order
+    uint32_t                            array_layers;
     tr_format                           format;
     uint32_t                            mip_levels;
+    // Usage of each mip level as of the last recorded transition, shared by all array layers
+    tr_texture_usage*                   current_mip_usages;
     tr_sample_count                     sample_count;
     uint32_t                            sample_quality;
     tr_clear_value                      clear_value;
     bool                                host_visible;
     void*                               cpu_mapped_address;
+    // Host visible textures only, indexed by (array_layer * mip_levels + mip_level)
+    tr_subresource_layout*              subresource_layouts;
     uint32_t                            owns_image;
     VkImage                             vk_image;
     VkDeviceMemory                      vk_memory;
+    // First mip level vk_image_view exposes, streamed textures raise it until their finer levels are resident
+    uint32_t                            min_lod;
     VkImageView                         vk_image_view;
     VkImageAspectFlags                  vk_aspect_mask;
     VkDescriptorImageInfo               vk_texture_view;
@@ -567,6 +706,14 @@ typedef struct tr_render_target {
     tr_format                           depth_stencil_format;
     tr_texture*                         depth_stencil_attachment;
     tr_texture*                         depth_stencil_attachment_multisample;
+    // Load/store ops default to tr_attachment_load_op_clear and tr_attachment_store_op_store
+    tr_attachment_load_op               color_load_ops[tr_max_render_target_attachments];
+    tr_attachment_store_op              color_store_ops[tr_max_render_target_attachments];
+    tr_attachment_load_op               depth_load_op;
+    tr_attachment_store_op              depth_store_op;
+    tr_attachment_load_op               stencil_load_op;
+    tr_attachment_store_op              stencil_store_op;
+    // Owned by the renderer's render pass and framebuffer caches
     VkRenderPass                        vk_render_pass;
     VkFramebuffer                       vk_framebuffer;
 } tr_render_target;
@@ -580,6 +727,93 @@ typedef struct tr_mesh {
     tr_pipeline*                        pipeline;
 } tr_mesh;
 
+typedef struct tr_readback {
+    tr_renderer*                        renderer;
+    tr_queue*                           queue;
+    uint64_t                            size;
+    // Host visible, host cached if the GPU has it
+    tr_buffer*                          buffer;
+    tr_fence*                           fence;
+    tr_cmd_pool*                        cmd_pool;
+    tr_cmd*                             cmd;
+    bool                                pending;
+    // Row pitch of the last texture that was read back
+    uint32_t                            row_pitch;
+} tr_readback;
+
+typedef struct tr_streamed_texture {
+    tr_texture*                         texture;
+    // Mip levels stored back to back, must stay valid while the texture streams
+    const uint8_t*                      p_src_data;
+    // Finest mip level with a copy recorded, levels stream in from the coarsest
+    uint32_t                            streamed_mip;
+} tr_streamed_texture;
+
+typedef struct tr_texture_stream_batch {
+    tr_cmd_pool*                        cmd_pool;
+    tr_cmd*                             cmd;
+    tr_fence*                           fence;
+    tr_buffer*                          staging;
+    bool                                pending;
+    // Streamed texture index and mip level of each copy in the batch
+    uint32_t                            copy_count;
+    uint32_t                            copy_capacity;
+    uint32_t*                           copy_textures;
+    uint32_t*                           copy_mips;
+    // Views replaced while this batch was current, destroyed when it's current again
+    uint32_t                            retired_view_count;
+    uint32_t                            retired_view_capacity;
+    VkImageView*                        retired_views;
+} tr_texture_stream_batch;
+
+typedef struct tr_texture_streamer {
+    tr_renderer*                        renderer;
+    tr_queue*                           queue;
+    uint64_t                            frame_byte_budget;
+    uint64_t                            resident_byte_budget;
+    uint64_t                            resident_bytes;
+    uint32_t                            texture_count;
+    uint32_t                            texture_capacity;
+    tr_streamed_texture*                textures;
+    // One batch per frame in flight
+    uint32_t                            batch_count;
+    uint32_t                            batch_index;
+    tr_texture_stream_batch*            batches;
+} tr_texture_streamer;
+
+typedef struct tr_query_pool {
+    tr_renderer*                        renderer;
+    tr_query_type                       type;
+    uint32_t                            query_count;
+    // Number of uint64_t values each query writes
+    uint32_t                            value_count;
+    // Valid bits of the graphics queue's timestamps
+    uint64_t                            timestamp_mask;
+    bool                                reset;
+    // Timer names for traces, the strings aren't copied
+    const char**                        timer_names;
+    bool                                traced;
+    VkQueryPool                         vk_query_pool;
+    VkQueryControlFlags                 vk_query_control_flags;
+    // Statistics the pool collects, values are written in bit order
+    VkQueryPipelineStatisticFlags       vk_pipeline_statistics;
+} tr_query_pool;
+
+// Same order as the VkQueryPipelineStatisticFlagBits
+typedef struct tr_pipeline_statistics {
+    uint64_t                            input_assembly_vertices;
+    uint64_t                            input_assembly_primitives;
+    uint64_t                            vertex_shader_invocations;
+    uint64_t                            geometry_shader_invocations;
+    uint64_t                            geometry_shader_primitives;
+    uint64_t                            clipping_invocations;
+    uint64_t                            clipping_primitives;
+    uint64_t                            fragment_shader_invocations;
+    uint64_t                            tessellation_control_shader_patches;
+    uint64_t                            tessellation_evaluation_shader_invocations;
+    uint64_t                            compute_shader_invocations;
+} tr_pipeline_statistics;
+
 typedef bool(*tr_image_resize_uint8_fn)(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, 
                                         uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* p_dst_data,
                                         uint32_t channel_cout, void* p_user_data);
@@ -588,13 +822,129 @@ typedef bool(*tr_image_resize_float_fn)(uint32_t src_width, uint32_t src_height,
                                         uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, float* p_dst_data,
                                         uint32_t channel_cout, void* p_user_data);
 
+typedef enum tr_image_filter {
+    tr_image_filter_auto = 0,   // Box for exact 2x reductions, Lanczos3 for everything else
+    tr_image_filter_point,
+    tr_image_filter_box,
+    tr_image_filter_mitchell,
+    tr_image_filter_lanczos3,
+} tr_image_filter;
+
+// Pass as p_user_data to tr_image_resize_uint8_filtered or tr_image_resize_float_filtered, NULL uses the defaults
+typedef struct tr_image_resize_settings {
+    tr_image_filter                     filter;
+    // 0 uses one thread per CPU for images large enough to benefit
+    uint32_t                            thread_count;
+} tr_image_resize_settings;
+
+// Decodes an image file into 8 bit texels with rows tightly packed, returns NULL if it can't. Called from worker threads.
+typedef uint8_t*(*tr_image_decode_uint8_fn)(const char* file_path, uint32_t* p_width, uint32_t* p_height, uint32_t* p_channel_count, void* p_user_data);
+// Releases the texels returned by tr_image_decode_uint8_fn
+typedef void(*tr_image_free_uint8_fn)(uint8_t* p_data, void* p_user_data);
+
+typedef enum tr_texture_load_state {
+    tr_texture_load_state_pending = 0,
+    tr_texture_load_state_ready,
+    tr_texture_load_state_failed,
+} tr_texture_load_state;
+
+typedef struct tr_texture_load {
+    // Only changes in tr_texture_loader_update, texture is set and owned by the caller once ready
+    tr_texture_load_state               state;
+    tr_texture*                         texture;
+    char*                               file_path;
+    tr_format                           format;
+    tr_texture_usage_flags              usage;
+    bool                                generate_mips;
+    // Filled in by the worker that decodes the file
+    bool                                decode_failed;
+    uint32_t                            width;
+    uint32_t                            height;
+    uint32_t                            mip_levels;
+    uint64_t                            staging_offset;
+    uint64_t                            staging_size;
+    // Kept for loads that don't fit a batch's staging buffer, they're uploaded on their own
+    uint8_t*                            p_decoded_data;
+    uint32_t                            decoded_channel_count;
+    // Links the loader's job and unbatched lists
+    struct tr_texture_load*             next;
+} tr_texture_load;
+
+typedef struct tr_texture_load_batch {
+    tr_cmd_pool*                        cmd_pool;
+    tr_cmd*                             cmd;
+    tr_fence*                           fence;
+    tr_buffer*                          staging;
+    uint64_t                            staging_used;
+    // Workers still writing into staging, a closed batch is submitted once this is 0
+    uint32_t                            writer_count;
+    bool                                closed;
+    bool                                pending;
+    uint32_t                            load_count;
+    uint32_t                            load_capacity;
+    tr_texture_load**                   loads;
+} tr_texture_load_batch;
+
+typedef struct tr_internal_texture_loader_sync tr_internal_texture_loader_sync;
+
+typedef struct tr_texture_loader {
+    tr_renderer*                        renderer;
+    tr_queue*                           queue;
+    tr_image_decode_uint8_fn            decode_fn;
+    tr_image_free_uint8_fn              free_fn;
+    void*                               p_user_data;
+    uint32_t                            thread_count;
+    // Every load handle, they're freed with the loader
+    uint32_t                            load_count;
+    uint32_t                            load_capacity;
+    tr_texture_load**                   loads;
+    uint32_t                            pending_count;
+    // Everything below is guarded by the loader's mutex
+    tr_texture_load*                    job_head;
+    tr_texture_load*                    job_tail;
+    tr_texture_load*                    unbatched_head;
+    // Workers allocate staging from batches[batch_index] until the render thread closes it
+    uint32_t                            batch_count;
+    uint32_t                            batch_index;
+    tr_texture_load_batch*              batches;
+    bool                                quit;
+    tr_internal_texture_loader_sync*    sync;
+} tr_texture_loader;
+
 // API functions
 tr_api_export void tr_create_renderer(const char* app_name, const tr_renderer_settings* p_settings, tr_renderer** pp_renderer);
 tr_api_export void tr_destroy_renderer(tr_renderer* p_renderer);
 
+/*
+
+The renderer counts the work it does in frame_stats: commands as they're recorded, barriers 
+emitted by the transition functions and copies (render pass layout changes aren't counted),
+bytes copied by the tr_util_update_* functions and device memory allocations and descriptor 
+pools as they're created. The counters add up until tr_reset_frame_stats is called, read 
+them and reset them once per frame to get per frame numbers.
+
+*/
+tr_api_export void tr_reset_frame_stats(tr_renderer* p_renderer);
+/*
+
+Traces are recorded when settings.trace is set: the API functions that create objects, 
+upload data or can wait (tr_create_*, tr_update_descriptor_set, tr_util_update_*, 
+tr_acquire_next_image, tr_queue_*, tr_wait_for_fences) add a CPU scope, and each set of 
+timer results from tr_get_timer_results adds GPU scopes once. GPU timestamps are placed 
+on the CPU timeline using an offset measured when the renderer is created. 
+tr_write_trace writes everything recorded so far as Chrome trace event JSON, which 
+chrome://tracing and Perfetto can open.
+
+*/
+tr_api_export bool tr_write_trace(tr_renderer* p_renderer, const char* file_path);
+
 tr_api_export void tr_create_fence(tr_renderer* p_renderer, tr_fence** pp_fence);
 tr_api_export void tr_destroy_fence(tr_renderer* p_renderer, tr_fence* p_fence);
 
+tr_api_export bool tr_get_fence_status(tr_renderer* p_renderer, tr_fence* p_fence);
+tr_api_export void tr_wait_for_fences(tr_renderer* p_renderer, uint32_t fence_count, tr_fence** pp_fences);
+tr_api_export void tr_reset_fences(tr_renderer* p_renderer, uint32_t fence_count, tr_fence** pp_fences);
+
 tr_api_export void tr_create_semaphore(tr_renderer* p_renderer, tr_semaphore** pp_semaphore);
 tr_api_export void tr_destroy_semaphore(tr_renderer* p_renderer, tr_semaphore* p_semaphore);
 
@@ -614,6 +964,9 @@ tr_api_export void tr_create_buffer(tr_renderer* p_renderer, tr_buffer_usage usa
 tr_api_export void tr_create_index_buffer(tr_renderer*p_renderer, uint64_t size, bool host_visible, tr_index_type index_type, tr_buffer** pp_buffer);
 tr_api_export void tr_create_uniform_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, tr_buffer** pp_buffer);
 tr_api_export void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, uint32_t vertex_stride, tr_buffer** pp_buffer);
+// Device local buffers for static geometry, p_data is copied through the shared upload staging buffer and the graphics queue is waited on
+tr_api_export void tr_create_index_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, tr_index_type index_type, tr_buffer** pp_buffer);
+tr_api_export void tr_create_vertex_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, uint32_t vertex_stride, tr_buffer** pp_buffer);
 tr_api_export void tr_create_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_buffer);
 tr_api_export void tr_create_rw_structured_buffer(tr_renderer* p_renderer, uint64_t size, uint64_t first_element, uint64_t element_count, uint64_t struct_stride, bool raw, tr_buffer** pp_counter_buffer, tr_buffer** pp_buffer);
 tr_api_export void tr_destroy_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer);
@@ -622,6 +975,10 @@ tr_api_export void tr_create_texture(tr_renderer* p_renderer, tr_texture_type ty
 tr_api_export void tr_create_texture_1d(tr_renderer* p_renderer, uint32_t width, tr_sample_count sample_count, tr_format format, bool host_visible, tr_texture_usage_flags usage, tr_texture** pp_texture);
 tr_api_export void tr_create_texture_2d(tr_renderer* p_renderer, uint32_t width, uint32_t height, tr_sample_count sample_count, tr_format format, uint32_t mip_levels, const tr_clear_value* p_clear_value, bool host_visible, tr_texture_usage_flags usage, tr_texture** pp_texture);
 tr_api_export void tr_create_texture_3d(tr_renderer* p_renderer, uint32_t width, uint32_t height, uint32_t depth, tr_sample_count sample_count, tr_format format, bool host_visible, tr_texture_usage_flags usage, tr_texture** pp_texture);
+// Views are 2D arrays when array_layers is more than 1
+tr_api_export void tr_create_texture_2d_array(tr_renderer* p_renderer, uint32_t width, uint32_t height, uint32_t array_layers, tr_sample_count sample_count, tr_format format, uint32_t mip_levels, const tr_clear_value* p_clear_value, bool host_visible, tr_texture_usage_flags usage, tr_texture** pp_texture);
+// Views are cube arrays when cube_count is more than 1
+tr_api_export void tr_create_texture_cube(tr_renderer* p_renderer, uint32_t size, uint32_t cube_count, tr_format format, uint32_t mip_levels, tr_texture_usage_flags usage, tr_texture** pp_texture);
 tr_api_export void tr_destroy_texture(tr_renderer* p_renderer, tr_texture*p_texture);
 
 tr_api_export void tr_create_sampler(tr_renderer* p_renderer, tr_sampler** pp_sampler);
@@ -657,20 +1014,149 @@ tr_api_export void tr_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_cou
 tr_api_export void tr_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex);
 tr_api_export void tr_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index);
 tr_api_export void tr_cmd_draw_mesh(tr_cmd* p_cmd, const tr_mesh* p_mesh);
+/*
+
+Buffers and textures track their current usage (per mip level for textures) in the order
+commands are recorded. The transition functions compare new_usage against the tracked usage
+and emit a barrier only when one is needed, so transitioning to the current usage is a no-op.
+Storage (UAV) usages are the exception: a storage to storage transition still emits a barrier
+so that successive writes are ordered. The old_usage parameter is kept for source compatibility
+and is ignored. The *_to variants take just the new usage. Render passes update the tracked
+usage of their attachments.
+
+*/
 tr_api_export void tr_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
 tr_api_export void tr_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
 tr_api_export void tr_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage);
 tr_api_export void tr_cmd_depth_stencil_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage);
+tr_api_export void tr_cmd_buffer_transition_to(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage new_usage);
+tr_api_export void tr_cmd_image_transition_to(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage);
+tr_api_export void tr_cmd_render_target_transition_to(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage);
+tr_api_export void tr_cmd_depth_stencil_transition_to(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage);
 tr_api_export void tr_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
 tr_api_export void tr_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture);
+// Copies into a rectangle of one mip level and array layer, buffer_row_length is in texels and 0 means tightly packed. The mip level has to be in tr_texture_usage_transfer_dst.
+tr_api_export void tr_cmd_copy_buffer_to_texture_region(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t buffer_offset, uint32_t buffer_row_length, tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+// Writes a rectangle into a host visible staging buffer at staging_offset and records its copy like tr_util_update_texture_region,
+// returns the offset after it rounded up to a multiple of 4 and of the texel or block size. staging_offset has to be aligned
+// the same way. The staging range can't be reused until p_cmd has completed.
+tr_api_export uint64_t tr_cmd_update_texture_region(tr_cmd* p_cmd, tr_buffer* p_staging, uint64_t staging_offset, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t src_row_stride, const void* p_src_data, tr_texture* p_texture);
+// Copies are tightly packed and leave the source in its previous usage
+tr_api_export void tr_cmd_copy_texture_to_buffer(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t mip_level, uint64_t buffer_offset, tr_buffer* p_buffer);
+tr_api_export void tr_cmd_copy_buffer(tr_cmd* p_cmd, tr_buffer* p_src_buffer, uint64_t src_offset, tr_buffer* p_dst_buffer, uint64_t dst_offset, uint64_t size);
+// Fills mip levels 1..n-1 from level 0 with linear blits, every level is left in new_usage
+tr_api_export void tr_cmd_generate_mipmaps(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage);
 
 tr_api_export void tr_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence);
 tr_api_export void tr_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores);
 tr_api_export void tr_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores);
 tr_api_export void tr_queue_wait_idle(tr_queue* p_queue);
 
+/*
+
+Readbacks copy a buffer or a texture mip level into host memory without waiting on the 
+queue: tr_readback_buffer/tr_readback_texture submit the copy with a fence, 
+tr_readback_is_ready polls the fence and tr_readback_map waits on it and returns the 
+data. Starting a readback while another one is pending waits for the pending one.
+
+*/
+tr_api_export void        tr_create_readback(tr_renderer* p_renderer, tr_queue* p_queue, uint64_t size, tr_readback** pp_readback);
+tr_api_export void        tr_destroy_readback(tr_renderer* p_renderer, tr_readback* p_readback);
+tr_api_export void        tr_readback_buffer(tr_readback* p_readback, tr_buffer* p_buffer);
+tr_api_export void        tr_readback_texture(tr_readback* p_readback, tr_texture* p_texture, uint32_t mip_level);
+tr_api_export bool        tr_readback_is_ready(tr_readback* p_readback);
+tr_api_export const void* tr_readback_map(tr_readback* p_readback);
+
+/*
+
+Texture streamers make large texture sets usable before all of their data is on the GPU. 
+tr_texture_streamer_add uploads the coarsest mip levels of a texture right away and sets 
+its min_lod so vk_image_view only exposes those levels. tr_texture_streamer_update copies 
+finer levels in the background, up to frame_byte_budget bytes per call, and lowers min_lod 
+as the copies complete. Call it once per frame: when it returns true the views of some 
+streamed textures changed and descriptor sets using them need tr_update_descriptor_set. 
+Replaced views are destroyed once every frame in flight has moved on. Streaming stops at 
+resident_byte_budget bytes if it isn't 0, memory for every level is still allocated when 
+the texture is created. Destroy the streamer before the textures it streams and after the 
+frames using replaced views are done: it waits for pending copies, each texture keeps the 
+vk_image_view of every level it holds and all replaced views are destroyed.
+
+*/
+tr_api_export void tr_create_texture_streamer(tr_renderer* p_renderer, tr_queue* p_queue, uint64_t frame_byte_budget, uint64_t resident_byte_budget, tr_texture_streamer** pp_streamer);
+tr_api_export void tr_destroy_texture_streamer(tr_renderer* p_renderer, tr_texture_streamer* p_streamer);
+// Mip levels are stored back to back like tr_util_update_texture_mips, add textures before they're used in descriptor sets
+tr_api_export void tr_texture_streamer_add(tr_texture_streamer* p_streamer, tr_texture* p_texture, const void* p_src_data, uint32_t resident_mip_count);
+tr_api_export bool tr_texture_streamer_update(tr_texture_streamer* p_streamer);
+// True when every level within the budget is resident
+tr_api_export bool tr_texture_streamer_is_done(tr_texture_streamer* p_streamer);
+
+/*
+
+Texture loaders decode image files on a pool of worker threads and upload them without
+blocking the render thread. The decoder is supplied by the caller, e.g. a wrapper around
+stbi_load and stbi_image_free. Workers write level 0 and the CPU built mip levels straight
+into a batch's staging buffer, tr_texture_loader_update creates the textures, records
+every finished load in the batch into one command buffer and submits it without waiting.
+Call it once per frame: loads become ready when their batch's fence signals, and it
+returns true when any load became ready or failed. Files larger than batch_byte_budget
+after expansion are uploaded on their own by tr_texture_loader_update, which blocks until
+the queue is idle after each of them. A thread_count of
+0 uses one thread per CPU, platforms without threads decode in tr_texture_loader_update.
+Only uncompressed 8 bit formats are supported. Ready textures belong to the caller, the
+load handles belong to the loader.
+
+*/
+tr_api_export void             tr_create_texture_loader(tr_renderer* p_renderer, tr_queue* p_queue, uint32_t thread_count, uint64_t batch_byte_budget, tr_image_decode_uint8_fn decode_fn, tr_image_free_uint8_fn free_fn, void* p_user_data, tr_texture_loader** pp_loader);
+tr_api_export void             tr_destroy_texture_loader(tr_renderer* p_renderer, tr_texture_loader* p_loader);
+// The file path is copied, usage always gets tr_texture_usage_sampled_image
+tr_api_export tr_texture_load* tr_texture_loader_load(tr_texture_loader* p_loader, const char* file_path, tr_format format, tr_texture_usage_flags usage, bool generate_mips);
+tr_api_export bool             tr_texture_loader_update(tr_texture_loader* p_loader);
+// True when there are no pending loads
+tr_api_export bool             tr_texture_loader_is_done(tr_texture_loader* p_loader);
+
+/*
+
+Timers write a timestamp at the top of the pipe when they begin and one at the bottom of 
+the pipe when they end, timer i uses queries 2i and 2i + 1 of a timestamp query pool. 
+Reset the pool outside of a render pass before writing timers into it. Results never 
+wait on the GPU: tr_get_timer_results returns false until every requested timer is 
+available. Use one pool per frame in flight and read a pool's results just before it's 
+reset again, one frame late.
+
+Pipeline statistics and occlusion queries are bracketed with tr_cmd_begin_query and 
+tr_cmd_end_query. Pipeline statistics pools return one tr_pipeline_statistics per query, 
+geometry and tessellation statistics stay 0 if the GPU doesn't support those stages. 
+Occlusion pools return the number of samples that passed the depth and stencil tests as a 
+uint64_t per query, it's exact if the GPU supports precise occlusion queries and non-zero 
+when anything passed otherwise. Both are read back with the same frame of latency as timers.
+
+*/
+tr_api_export void tr_create_query_pool(tr_renderer* p_renderer, tr_query_type type, uint32_t query_count, tr_query_pool** pp_query_pool);
+tr_api_export void tr_destroy_query_pool(tr_renderer* p_renderer, tr_query_pool* p_query_pool);
+tr_api_export bool tr_get_query_pool_results(tr_query_pool* p_query_pool, uint32_t first_query, uint32_t query_count, uint64_t* p_results);
+tr_api_export bool tr_get_timer_results(tr_query_pool* p_query_pool, uint32_t timer_count, double* p_timer_ms);
+tr_api_export void tr_set_timer_name(tr_query_pool* p_query_pool, uint32_t timer_index, const char* name);
+tr_api_export bool tr_get_pipeline_statistics_results(tr_query_pool* p_query_pool, uint32_t query_count, tr_pipeline_statistics* p_statistics);
+tr_api_export void tr_cmd_reset_query_pool(tr_cmd* p_cmd, tr_query_pool* p_query_pool);
+tr_api_export void tr_cmd_begin_timer(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t timer_index);
+tr_api_export void tr_cmd_end_timer(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t timer_index);
+tr_api_export void tr_cmd_begin_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index);
+tr_api_export void tr_cmd_end_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index);
+
 tr_api_export void tr_render_target_set_color_clear_value(tr_render_target* p_render_target, uint32_t attachment_index, float r, float g, float b, float a);
 tr_api_export void tr_render_target_set_depth_stencil_clear_value(tr_render_target* p_render_target, float depth, uint8_t stencil);
+/*
+
+Load/store ops apply to the single sample color attachments and to the depth/stencil attachment 
+the render pass uses. Multisample color attachments are always resolved into the single sample 
+attachments: they're only stored if they're loaded, since nothing else can read them. Changing 
+the ops switches the render target to a matching render pass from the renderer's cache, so don't 
+change them while a command buffer using the render target is being recorded. Pipelines don't 
+need to be recreated since load/store ops don't affect render pass compatibility.
+
+*/
+tr_api_export void tr_render_target_set_color_load_store_ops(tr_render_target* p_render_target, uint32_t attachment_index, tr_attachment_load_op load_op, tr_attachment_store_op store_op);
+tr_api_export void tr_render_target_set_depth_stencil_load_store_ops(tr_render_target* p_render_target, tr_attachment_load_op depth_load_op, tr_attachment_store_op depth_store_op, tr_attachment_load_op stencil_load_op, tr_attachment_store_op stencil_store_op);
 
 tr_api_export bool      tr_vertex_layout_support_format(tr_format format);
 tr_api_export uint32_t  tr_vertex_layout_stride(const tr_vertex_layout* p_vertex_layout);
@@ -679,8 +1165,13 @@ tr_api_export uint32_t  tr_vertex_layout_stride(const tr_vertex_layout* p_vertex
 tr_api_export uint32_t           tr_util_calc_mip_levels(uint32_t width, uint32_t height);
 tr_api_export VkFormat           tr_util_to_vk_format(tr_format format);
 tr_api_export tr_format          tr_util_from_vk_format(VkFormat fomat);
+// Bytes per texel, or per 4x4 block for compressed formats
 tr_api_export uint32_t           tr_util_format_stride(tr_format format);
 tr_api_export uint32_t           tr_util_format_channel_count(tr_format format);
+tr_api_export bool               tr_util_format_is_compressed(tr_format format);
+// Bytes per row of texels, or per row of blocks for compressed formats
+tr_api_export uint32_t           tr_util_format_row_pitch(tr_format format, uint32_t width);
+tr_api_export uint64_t           tr_util_format_level_size(tr_format format, uint32_t width, uint32_t height);
 tr_api_export VkShaderStageFlags tr_util_to_vk_shader_stages(tr_shader_stage shader_stages);
 tr_api_export void               tr_util_transition_buffer(tr_queue* p_queue, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
 tr_api_export void               tr_util_transition_image(tr_queue* p_queue, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
@@ -688,7 +1179,36 @@ tr_api_export void               tr_util_set_storage_buffer_count(tr_queue* p_qu
 tr_api_export void               tr_util_clear_buffer(tr_queue* p_queue, tr_buffer* p_buffer);
 tr_api_export void               tr_util_update_buffer(tr_queue* p_queue, uint64_t size, const void* p_src_data, tr_buffer* p_buffer);
 tr_api_export void               tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data);
+// Updates one layer of an array or cube texture with CPU built mips, cube faces are layers (6 * cube + face)
+tr_api_export void               tr_util_update_texture_layer_uint8(tr_queue* p_queue, uint32_t array_layer, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data);
+// Uploads level 0 only and generates the other mip levels on the GPU, formats that can't be blitted and textures with more than one layer fall back to the CPU resizer
+tr_api_export void               tr_util_update_texture_uint8_gpu_mips(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture);
+tr_api_export bool               tr_util_texture_supports_gpu_mips(const tr_texture* p_texture);
+tr_api_export bool               tr_image_resize_uint8_t(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* p_dst_data, uint32_t channel_cout, void* p_user_data);
+// Default resize_fn, builds each mip level from the previous one when used by tr_util_update_texture_uint8
+tr_api_export bool               tr_image_resize_uint8_filtered(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* p_dst_data, uint32_t channel_count, void* p_user_data);
+// Float sources with src_row_stride in floats, converted to half precision for r16*_float textures
 tr_api_export void               tr_util_update_texture_float(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data, uint32_t channels, tr_texture* p_texture, tr_image_resize_float_fn resize_fn, void* p_user_data);
+tr_api_export bool               tr_image_resize_float_t(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data, uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, float* p_dst_data, uint32_t channel_count, void* p_user_data);
+// Default resize_fn for tr_util_update_texture_float, row strides are in floats and results are not clamped
+tr_api_export bool               tr_image_resize_float_filtered(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data, uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, float* p_dst_data, uint32_t channel_count, void* p_user_data);
+// Encodes RGBA8 pixels into tightly packed 4x4 blocks, 0 threads picks a count. Returns false for formats without an encoder (BC7).
+tr_api_export bool               tr_image_encode_bc_uint8(tr_format format, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint8_t* p_dst_data, uint32_t thread_count);
+// Uploads pre-built mip levels stored back to back (tr_util_format_level_size bytes each) without decoding or resampling
+tr_api_export void               tr_util_update_texture_mips(tr_queue* p_queue, const void* p_src_data, uint32_t mip_level_count, tr_texture* p_texture);
+tr_api_export void               tr_util_update_texture_layer_mips(tr_queue* p_queue, uint32_t array_layer, const void* p_src_data, uint32_t mip_level_count, tr_texture* p_texture);
+// Uploads a rectangle of one mip level and array layer in the texture's format, src_row_stride is in bytes (rows of blocks for
+// compressed formats). Only the rectangle is staged and only its mip level changes usage. Waits for the copy, per frame updates
+// and batches of rectangles should record tr_cmd_update_texture_region into one command buffer instead.
+tr_api_export void               tr_util_update_texture_region(tr_queue* p_queue, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t src_row_stride, const void* p_src_data, tr_texture* p_texture);
+tr_api_export const tr_subresource_layout* tr_util_texture_subresource_layout(const tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer);
+// Writes a rectangle straight into a host visible texture's mapped memory, there is no staging buffer and no copy command.
+// The GPU can't be using the texture, e.g. write after waiting on the fence of the last frame that sampled it.
+tr_api_export void               tr_util_write_texture_region(uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t src_row_stride, const void* p_src_data, tr_texture* p_texture);
+// Creates a 2D texture from DDS data in memory, usage must include tr_texture_usage_sampled_image. Returns false for unsupported files.
+tr_api_export bool               tr_util_create_texture_dds(tr_queue* p_queue, const void* p_data, uint64_t size, tr_texture_usage_flags usage, tr_texture** pp_texture);
+// Same as tr_util_create_texture_dds but reads the file through a memory mapping
+tr_api_export bool               tr_util_load_texture_dds(tr_queue* p_queue, const char* file_path, tr_texture_usage_flags usage, tr_texture** pp_texture);
 
 // =================================================================================================
 // IMPLEMENTATION
@@ -698,6 +1218,44 @@ tr_api_export void               tr_util_update_texture_float(tr_queue* p_queue,
 
 #pragma comment(lib, "vulkan-1.lib")
 
+#include <float.h>
+#include <math.h>
+
+#if defined(TINY_RENDERER_LINUX)
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Define TINY_RENDERER_NO_SIMD to force the scalar image resize paths
+#if ! defined(TINY_RENDERER_NO_SIMD)
+    #if defined(__AVX2__)
+        #define TINY_RENDERER_AVX2
+        #include <immintrin.h>
+    #endif
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+        #define TINY_RENDERER_SSE2
+        #include <emmintrin.h>
+        // MSVC has no __SSSE3__, AVX implies it
+        #if defined(__SSSE3__) || defined(__AVX__)
+            #define TINY_RENDERER_SSSE3
+            #include <tmmintrin.h>
+        #endif
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define TINY_RENDERER_NEON
+        #include <arm_neon.h>
+    #endif
+    // Half precision conversions, GCC and Clang don't enable F16C with -mavx2 alone
+    #if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+        #define TINY_RENDERER_F16C
+        #include <immintrin.h>
+    #elif defined(TINY_RENDERER_NEON) && (defined(__aarch64__) || (defined(__ARM_FP) && (__ARM_FP & 2)))
+        #define TINY_RENDERER_NEON_FP16
+    #endif
+#endif
+
 #define TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer) \
     assert(NULL != s_tr_internal);                   \
     assert(NULL != s_tr_internal->renderer);         \
@@ -710,6 +1268,14 @@ tr_api_export void               tr_util_update_texture_float(tr_queue* p_queue,
        p_var = NULL;                   \
     }
 
+#define TINY_RENDERER_TRACE_BEGIN(p_renderer) \
+    uint64_t trace_begin_us = (NULL != (p_renderer)->trace) ? tr_internal_trace_now_us() : 0;
+
+#define TINY_RENDERER_TRACE_END(p_renderer)                                             \
+    if (NULL != (p_renderer)->trace) {                                                  \
+        tr_internal_trace_add_cpu_scope((p_renderer)->trace, __func__, trace_begin_us); \
+    }
+
 #if defined(__cplusplus)  
     #define TINY_RENDERER_DECLARE_ZERO(type, var) \
             type var = {};                        
@@ -739,9 +1305,192 @@ VkSampleCountFlagBits tr_util_to_vk_sample_count(tr_sample_count sample_count);
 VkBufferUsageFlags    tr_util_to_vk_buffer_usage(tr_buffer_usage usage);
 VkImageUsageFlags     tr_util_to_vk_image_usage(tr_texture_usage usage);
 VkImageLayout         tr_util_to_vk_image_layout(tr_texture_usage usage);
+VkImageLayout         tr_util_to_vk_texture_layout(const tr_texture* p_texture, tr_texture_usage usage);
+VkAttachmentLoadOp    tr_util_to_vk_load_op(tr_attachment_load_op load_op);
+VkAttachmentStoreOp   tr_util_to_vk_store_op(tr_attachment_store_op store_op);
+VkPipelineStageFlags  tr_util_to_vk_texture_stages(tr_texture_usage usage);
 VkImageAspectFlags    tr_util_vk_determine_aspect_mask(VkFormat format);
+void                  tr_util_set_texture_usage(tr_texture* p_texture, tr_texture_usage usage);
+uint64_t              tr_util_hash_bytes(const void* p_data, size_t size);
 bool                  tr_util_vk_get_memory_type(const VkPhysicalDeviceMemoryProperties* mem_props,  uint32_t type_bits, VkMemoryPropertyFlags flags, uint32_t* p_index);
 VkFormatFeatureFlags  tr_util_vk_image_usage_to_format_features(VkImageUsageFlags usage);
+void                  tr_util_vk_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, uint32_t array_layer, tr_image_resize_uint8_fn resize_fn, void* p_user_data, bool gpu_mips);
+void                  tr_util_vk_update_texture_uint8_compressed(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, uint32_t array_layer, tr_image_resize_uint8_fn resize_fn, void* p_user_data);
+void                  tr_util_vk_update_texture_mip_range(tr_queue* p_queue, const void* p_src_data, uint32_t first_mip_level, uint32_t mip_level_count, uint32_t array_layer, tr_texture* p_texture);
+VkBufferImageCopy     tr_util_vk_mip_copy_region(const tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer, uint64_t buffer_offset);
+tr_buffer*            tr_util_vk_upload_staging(tr_renderer* p_renderer, uint64_t size);
+void                  tr_util_vk_copy_staging_to_texture(tr_queue* p_queue, tr_buffer* p_staging, uint32_t region_count, const VkBufferImageCopy* p_regions, uint64_t upload_bytes, tr_texture* p_texture, bool gpu_mips);
+
+// Internal trace functions
+uint64_t tr_internal_trace_now_us();
+void tr_internal_trace_add_event(tr_trace* p_trace, const char* name, tr_trace_thread thread, double begin_us, double duration_us);
+void tr_internal_trace_add_cpu_scope(tr_trace* p_trace, const char* name, uint64_t begin_us);
+void tr_internal_vk_calibrate_trace(tr_renderer* p_renderer);
+
+// Internal image resize functions
+typedef struct tr_internal_resize_job {
+    tr_image_filter                     filter;
+    uint32_t                            channel_count;
+    // Source and destination hold floats instead of uint8_t, row strides are always in bytes
+    bool                                float_data;
+    uint32_t                            src_width;
+    uint32_t                            src_height;
+    uint32_t                            src_row_stride;
+    const uint8_t*                      p_src_data;
+    uint32_t                            dst_width;
+    uint32_t                            dst_height;
+    uint32_t                            dst_row_stride;
+    uint8_t*                            p_dst_data;
+    // Separable filter taps, tap_count weights for every destination column/row
+    uint32_t                            h_tap_count;
+    uint32_t*                           h_first;
+    float*                              h_weights;
+    uint32_t                            v_tap_count;
+    uint32_t*                           v_first;
+    float*                              v_weights;
+} tr_internal_resize_job;
+
+// Row band workers shared by the resizers and the block compressors
+typedef void(*tr_internal_rows_fn)(const void* p_job, uint32_t row_begin, uint32_t row_end);
+
+typedef struct tr_internal_rows_worker {
+    tr_internal_rows_fn                 rows_fn;
+    const void*                         job;
+    uint32_t                            row_begin;
+    uint32_t                            row_end;
+} tr_internal_rows_worker;
+
+// Builds a whole mip chain with one set of threads. Each level is filtered from the previous one
+// held in cached scratch memory and only ever written to its destination, which can be staging.
+typedef struct tr_internal_mip_chain_level {
+    uint32_t                            width;
+    uint32_t                            height;
+    uint32_t                            row_stride;
+    uint8_t*                            p_data;
+} tr_internal_mip_chain_level;
+
+typedef struct tr_internal_mip_chain {
+    uint32_t                            level_count;
+    const tr_internal_mip_chain_level*  levels;
+    // One resize per level, point filtered levels and straight copies have no taps
+    tr_internal_resize_job*             jobs;
+    bool*                               copies;
+    uint32_t*                           level_thread_counts;
+    uint32_t                            thread_count;
+    // Generation barrier between levels
+#if defined(TINY_RENDERER_LINUX)
+    pthread_mutex_t                     mutex;
+    pthread_cond_t                      cond;
+#elif defined(TINY_RENDERER_MSW)
+    CRITICAL_SECTION                    mutex;
+    CONDITION_VARIABLE                  cond;
+#endif
+    uint32_t                            arrived;
+    uint32_t                            generation;
+} tr_internal_mip_chain;
+
+typedef struct tr_internal_mip_chain_worker {
+    tr_internal_mip_chain*              chain;
+    uint32_t                            index;
+} tr_internal_mip_chain_worker;
+
+float    tr_internal_resize_filter_support(tr_image_filter filter);
+float    tr_internal_resize_filter_weight(tr_image_filter filter, float x);
+void     tr_internal_resize_build_taps(tr_image_filter filter, uint32_t src_size, uint32_t dst_size, uint32_t* p_tap_count, uint32_t** pp_first, float** pp_weights);
+void     tr_internal_resize_accumulate_row(float* p_dst, const uint8_t* p_src, uint32_t count, float weight);
+void     tr_internal_resize_box_2x_rows(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end);
+void     tr_internal_resize_separable_rows(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end);
+void     tr_internal_resize_accumulate_row_float(float* p_dst, const float* p_src, uint32_t count, float weight);
+void     tr_internal_resize_box_2x_rows_float(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end);
+void     tr_internal_resize_separable_rows_float(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end);
+void     tr_internal_resize_rows(const void* p_job, uint32_t row_begin, uint32_t row_end);
+uint32_t tr_internal_cpu_count();
+void     tr_internal_run_rows(tr_internal_rows_fn rows_fn, const void* p_job, uint32_t row_count, uint32_t thread_count);
+void     tr_internal_resize_run(tr_internal_resize_job* p_job, uint32_t thread_count);
+void     tr_internal_mip_chain_barrier(tr_internal_mip_chain* p_chain);
+void     tr_internal_mip_chain_work(tr_internal_mip_chain* p_chain, uint32_t worker_index);
+void     tr_internal_resize_mip_chain_uint8(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t channel_count, uint32_t level_count, const tr_internal_mip_chain_level* p_levels, const tr_image_resize_settings* p_settings);
+uint16_t tr_internal_float_to_half(float value);
+void     tr_internal_float_to_half_row(uint16_t* p_dst, const float* p_src, uint32_t count);
+void     tr_internal_expand_channels_row(uint8_t* p_dst, const uint8_t* p_src, uint32_t pixel_count, uint32_t src_channel_count, uint32_t dst_channel_count);
+
+// Internal block compression functions
+typedef struct tr_internal_bc_job {
+    tr_format                           format;
+    uint32_t                            width;
+    uint32_t                            height;
+    uint32_t                            src_row_stride;
+    const uint8_t*                      p_src_data;
+    uint32_t                            dst_row_pitch;
+    uint8_t*                            p_dst_data;
+} tr_internal_bc_job;
+
+void     tr_internal_bc_load_block(const tr_internal_bc_job* p_job, uint32_t block_x, uint32_t block_y, uint8_t* p_rgba);
+uint16_t tr_internal_bc_pack_565(const float* p_rgb);
+void     tr_internal_bc_unpack_565(uint16_t color, int32_t* p_rgb);
+uint32_t tr_internal_bc1_indices(const uint8_t* p_rgba, uint16_t color_0, uint16_t color_1, bool three_color, uint32_t* p_indices);
+void     tr_internal_bc1_encode_block(const uint8_t* p_rgba, bool allow_transparent, uint8_t* p_dst);
+void     tr_internal_bc4_encode_block(const uint8_t* p_rgba, uint32_t channel, uint8_t* p_dst);
+void     tr_internal_bc_encode_rows(const void* p_job, uint32_t row_begin, uint32_t row_end);
+
+// Internal texture file functions
+typedef struct tr_internal_mapped_file {
+    const uint8_t*                      p_data;
+    uint64_t                            size;
+#if defined(TINY_RENDERER_MSW)
+    HANDLE                              file;
+    HANDLE                              mapping;
+#endif
+} tr_internal_mapped_file;
+
+typedef struct tr_internal_dds_image {
+    tr_format                           format;
+    uint32_t                            width;
+    uint32_t                            height;
+    uint32_t                            mip_levels;
+    const uint8_t*                      p_data;
+    uint64_t                            data_size;
+} tr_internal_dds_image;
+
+bool      tr_internal_map_file(const char* file_path, tr_internal_mapped_file* p_file);
+void      tr_internal_unmap_file(tr_internal_mapped_file* p_file);
+tr_format tr_internal_dds_dxgi_format(uint32_t dxgi_format);
+bool      tr_internal_dds_parse(const uint8_t* p_data, uint64_t size, tr_internal_dds_image* p_image);
+
+// Internal texture loader functions
+struct tr_internal_texture_loader_sync {
+#if defined(TINY_RENDERER_LINUX)
+    pthread_mutex_t                     mutex;
+    pthread_cond_t                      job_cond;
+    pthread_cond_t                      staging_cond;
+    pthread_t*                          threads;
+#elif defined(TINY_RENDERER_MSW)
+    CRITICAL_SECTION                    mutex;
+    CONDITION_VARIABLE                  job_cond;
+    CONDITION_VARIABLE                  staging_cond;
+    HANDLE*                             threads;
+#else
+    uint32_t                            unused;
+#endif
+};
+
+void             tr_internal_texture_loader_lock(tr_texture_loader* p_loader);
+void             tr_internal_texture_loader_unlock(tr_texture_loader* p_loader);
+void             tr_internal_texture_loader_wait(tr_texture_loader* p_loader, bool staging);
+void             tr_internal_texture_loader_wake(tr_texture_loader* p_loader, bool staging);
+tr_texture_load* tr_internal_texture_loader_pop_job(tr_texture_loader* p_loader);
+void             tr_internal_texture_loader_work(tr_texture_loader* p_loader);
+void             tr_internal_texture_loader_decode(tr_texture_loader* p_loader, tr_texture_load* p_load, bool wait_for_staging);
+void             tr_internal_fill_load_staging(const tr_texture_load* p_load, const uint8_t* p_src_data, uint32_t src_channel_count, uint8_t* p_dst_data);
+bool             tr_internal_complete_load_batch(tr_texture_loader* p_loader, tr_texture_load_batch* p_batch, bool wait);
+void             tr_internal_submit_load_batch(tr_texture_loader* p_loader, tr_texture_load_batch* p_batch);
+#if ! defined(TINY_RENDERER_IMAGE_ONLY)
+  #if defined(TINY_RENDERER_LINUX)
+static void*     tr_internal_texture_loader_thread_proc(void* p_param);
+  #elif defined(TINY_RENDERER_MSW)
+static DWORD WINAPI tr_internal_texture_loader_thread_proc(LPVOID p_param);
+  #endif
+#endif
 
 // Internal init functions
 void tr_internal_vk_create_instance(const char* app_name, tr_renderer* p_renderer);
@@ -768,8 +1517,10 @@ void tr_internal_vk_create_cmd(tr_cmd_pool *p_cmd_pool, bool secondary, tr_cmd*
 void tr_internal_vk_destroy_cmd(tr_cmd_pool *p_cmd_pool, tr_cmd* p_cmd);
 void tr_internal_vk_create_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer);
 void tr_internal_vk_destroy_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer);
+void tr_internal_create_texture(tr_renderer* p_renderer, tr_texture_type type, uint32_t width, uint32_t height, uint32_t depth, uint32_t array_layers, tr_sample_count sample_count, tr_format format, uint32_t mip_levels, const tr_clear_value* p_clear_value, bool host_visible, tr_texture_usage_flags usage, tr_texture** pp_texture);
 void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_texture);
 void tr_internal_vk_destroy_texture(tr_renderer* p_renderer, tr_texture* p_texture);
+VkImageView tr_internal_vk_create_texture_view(tr_renderer* p_renderer, tr_texture* p_texture, uint32_t base_mip_level);
 void tr_internal_vk_create_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler);
 void tr_internal_vk_destroy_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler);
 void tr_internal_vk_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, const tr_vertex_layout* p_vertex_layout, tr_descriptor_set* pp_descriptor_set, tr_render_target* p_render_target, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline* p_pipeline);
@@ -779,6 +1530,10 @@ void tr_internal_vk_create_shader_program(tr_renderer* p_renderer, uint32_t vert
 void tr_internal_vk_destroy_shader_program(tr_renderer* p_renderer, tr_shader_program* p_shader_program);
 void tr_internal_vk_create_render_target(tr_renderer* p_renderer, bool is_swapchain, tr_render_target* p_render_target);
 void tr_internal_vk_destroy_render_target(tr_renderer* p_renderer, tr_render_target* p_render_target);
+void tr_internal_vk_evict_framebuffers(tr_renderer* p_renderer, VkImageView image_view);
+void tr_internal_vk_destroy_render_target_caches(tr_renderer* p_renderer);
+void tr_internal_vk_create_query_pool(tr_renderer* p_renderer, tr_query_pool* p_query_pool);
+void tr_internal_vk_destroy_query_pool(tr_renderer* p_renderer, tr_query_pool* p_query_pool);
 
 // Internal descriptor set functions
 void tr_internal_vk_update_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set);
@@ -800,15 +1555,31 @@ void tr_internal_vk_cmd_bind_vertex_buffers(tr_cmd* p_cmd, uint32_t buffer_count
 void tr_internal_vk_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex);
 void tr_internal_vk_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index);
 void tr_internal_vk_cmd_draw_mesh(tr_cmd* p_cmd, const tr_mesh* p_mesh);
-void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
-void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage);
-void tr_internal_vk_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage);
+void tr_internal_vk_cmd_buffer_barrier(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage);
+void tr_internal_vk_cmd_image_barrier(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t base_mip_level, uint32_t mip_level_count, tr_texture_usage old_usage, tr_texture_usage new_usage);
+void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage new_usage);
+void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t base_mip_level, uint32_t mip_level_count, tr_texture_usage new_usage);
+void tr_internal_vk_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage);
+void tr_internal_vk_cmd_depth_stencil_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage);
 void tr_internal_vk_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
 void tr_internal_vk_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture);
+void tr_internal_vk_cmd_copy_buffer_to_texture_region(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t buffer_offset, uint32_t buffer_row_length, tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+void tr_internal_vk_cmd_copy_texture_to_buffer(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t mip_level, uint64_t buffer_offset, tr_buffer* p_buffer);
+void tr_internal_vk_cmd_copy_buffer(tr_cmd* p_cmd, tr_buffer* p_src_buffer, uint64_t src_offset, tr_buffer* p_dst_buffer, uint64_t dst_offset, uint64_t size);
+void tr_internal_vk_cmd_generate_mipmaps(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage);
+void tr_internal_vk_cmd_host_read_barrier(tr_cmd* p_cmd, tr_buffer* p_buffer);
+void tr_internal_vk_cmd_reset_query_pool(tr_cmd* p_cmd, tr_query_pool* p_query_pool);
+void tr_internal_vk_cmd_write_timestamp(tr_cmd* p_cmd, tr_query_pool* p_query_pool, VkPipelineStageFlagBits stage, uint32_t query_index);
+void tr_internal_vk_cmd_begin_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index);
+void tr_internal_vk_cmd_end_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index);
 
 // Internal queue/swapchain functions
 void tr_internal_vk_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence);
-void tr_internal_vk_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores);
+void tr_internal_begin_readback(tr_readback* p_readback);
+void tr_internal_end_readback(tr_readback* p_readback);
+bool tr_internal_complete_stream_batch(tr_texture_streamer* p_streamer, tr_texture_stream_batch* p_batch, bool wait);
+bool tr_internal_fill_stream_batch(tr_texture_streamer* p_streamer, tr_texture_stream_batch* p_batch);
+void tr_internal_vk_queue_submit(tr_queue* p_queue, uint32_t cmd_count, tr_cmd** pp_cmds, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores, uint32_t signal_semaphore_count, tr_semaphore** pp_signal_semaphores, tr_fence* p_fence);
 void tr_internal_vk_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores);
 void tr_internal_vk_queue_wait_idle(tr_queue* p_queue);
 
@@ -1038,6 +1809,7 @@ bool ptr_vector_destroy(ptr_vector* p_vector)
 // ptr_vector (end)
 // -------------------------------------------------------------------------------------------------
 
+#if ! defined(TINY_RENDERER_IMAGE_ONLY)
 // Internal singleton 
 typedef struct tr_internal_data {
     tr_renderer*        renderer;   
@@ -1105,6 +1877,13 @@ void tr_create_renderer(const char *app_name, const tr_renderer_settings* settin
         // Copy settings
         memcpy(&(p_renderer->settings), settings, sizeof(*settings));
 
+        if (p_renderer->settings.trace) {
+            p_renderer->trace = (tr_trace*)calloc(1, sizeof(*(p_renderer->trace)));
+            assert(NULL != p_renderer->trace);
+            p_renderer->trace->start_us = tr_internal_trace_now_us();
+        }
+        TINY_RENDERER_TRACE_BEGIN(p_renderer);
+
         // Allocate storage for queues
         p_renderer->graphics_queue = (tr_queue*)calloc(1, sizeof(*p_renderer->graphics_queue));
         assert(NULL != p_renderer->graphics_queue);
@@ -1115,7 +1894,21 @@ void tr_create_renderer(const char *app_name, const tr_renderer_settings* settin
         p_renderer->present_queue->renderer = p_renderer;
 
         // Initialize the Vulkan bits
-        {
+        if (p_renderer->settings.headless) {
+            tr_internal_vk_create_instance(app_name, p_renderer);
+            tr_internal_vk_create_device(p_renderer);
+
+            // Offscreen render targets stand in for the swapchain images
+            assert(0 != (p_renderer->vk_active_gpu_properties.limits.framebufferColorSampleCounts & p_renderer->settings.swapchain.sample_count));
+            if (0 == p_renderer->settings.swapchain.image_count) {
+                p_renderer->settings.swapchain.image_count = 2;
+            }
+            // Same fallback as the surface format
+            if (tr_format_undefined == p_renderer->settings.swapchain.color_format) {
+                p_renderer->settings.swapchain.color_format = tr_format_b8g8r8a8_unorm;
+            }
+        }
+        else {
             tr_internal_vk_create_instance(app_name, p_renderer);
             tr_internal_vk_create_surface(p_renderer);
             tr_internal_vk_create_device(p_renderer);
@@ -1188,6 +1981,11 @@ void tr_create_renderer(const char *app_name, const tr_renderer_settings* settin
         //    }
         //}
 
+        if (NULL != p_renderer->trace) {
+            tr_internal_vk_calibrate_trace(p_renderer);
+        }
+        TINY_RENDERER_TRACE_END(p_renderer);
+
         // Renderer is good! Assign it to result!
         *(pp_renderer) = p_renderer;
     }
@@ -1201,7 +1999,14 @@ void tr_destroy_renderer(tr_renderer* p_renderer)
     // Destroy the swapchain render targets
     if (NULL != p_renderer->swapchain_render_targets) {
         for (size_t i = 0; i < p_renderer->settings.swapchain.image_count; ++i) {
-            tr_destroy_render_target(p_renderer, p_renderer->swapchain_render_targets[i]);
+            tr_render_target* render_target = p_renderer->swapchain_render_targets[i];
+            // Multisample and depth/stencil attachments are shared, the first render target destroys them
+            if (i > 0) {
+                render_target->color_attachments_multisample[0] = NULL;
+                render_target->depth_stencil_attachment = NULL;
+                render_target->depth_stencil_attachment_multisample = NULL;
+            }
+            tr_destroy_render_target(p_renderer, render_target);
         }
                     
     }
@@ -1223,9 +2028,17 @@ void tr_destroy_renderer(tr_renderer* p_renderer)
         }
     }
 
+    if (NULL != p_renderer->upload_staging) {
+        tr_destroy_buffer(p_renderer, p_renderer->upload_staging);
+        p_renderer->upload_staging = NULL;
+    }
+
     // Destroy the Vulkan bits
-    tr_internal_vk_destroy_swapchain(p_renderer);
-    tr_internal_vk_destroy_surface(p_renderer);
+    tr_internal_vk_destroy_render_target_caches(p_renderer);
+    if (! p_renderer->settings.headless) {
+        tr_internal_vk_destroy_swapchain(p_renderer);
+        tr_internal_vk_destroy_surface(p_renderer);
+    }
     tr_internal_vk_destroy_device(p_renderer);
     tr_internal_vk_destroy_instance(p_renderer);
 
@@ -1236,10 +2049,51 @@ void tr_destroy_renderer(tr_renderer* p_renderer)
     TINY_RENDERER_SAFE_FREE(s_tr_internal->renderer->render_complete_semaphores);
     TINY_RENDERER_SAFE_FREE(s_tr_internal->renderer->present_queue);
     TINY_RENDERER_SAFE_FREE(s_tr_internal->renderer->graphics_queue);
+    if (NULL != p_renderer->trace) {
+        TINY_RENDERER_SAFE_FREE(p_renderer->trace->events);
+        TINY_RENDERER_SAFE_FREE(p_renderer->trace);
+    }
     TINY_RENDERER_SAFE_FREE(s_tr_internal->renderer);
     TINY_RENDERER_SAFE_FREE(s_tr_internal);
 }
 
+void tr_reset_frame_stats(tr_renderer* p_renderer)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+
+    memset(&(p_renderer->frame_stats), 0, sizeof(p_renderer->frame_stats));
+}
+
+bool tr_write_trace(tr_renderer* p_renderer, const char* file_path)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != file_path);
+
+    const tr_trace* p_trace = p_renderer->trace;
+    if (NULL == p_trace) {
+        return false;
+    }
+
+    FILE* fp = fopen(file_path, "w");
+    if (NULL == fp) {
+        return false;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"CPU\"}},\n", (int)tr_trace_thread_cpu);
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", (int)tr_trace_thread_gpu);
+    for (uint32_t i = 0; i < p_trace->event_count; ++i) {
+        const tr_trace_event* p_event = &(p_trace->events[i]);
+        fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                p_event->name, (int)p_event->thread, p_event->begin_us, p_event->duration_us);
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    bool result = (0 == ferror(fp));
+    fclose(fp);
+    return result;
+}
+
 void tr_create_fence(tr_renderer *p_renderer, tr_fence** pp_fence)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -1262,6 +2116,50 @@ void tr_destroy_fence(tr_renderer *p_renderer, tr_fence* p_fence)
     TINY_RENDERER_SAFE_FREE(p_fence);
 }
 
+bool tr_get_fence_status(tr_renderer* p_renderer, tr_fence* p_fence)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_fence);
+
+    VkResult vk_res = vkGetFenceStatus(p_renderer->vk_device, p_fence->vk_fence);
+    assert((VK_SUCCESS == vk_res) || (VK_NOT_READY == vk_res));
+    return (VK_SUCCESS == vk_res);
+}
+
+void tr_wait_for_fences(tr_renderer* p_renderer, uint32_t fence_count, tr_fence** pp_fences)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(fence_count > 0);
+    assert(NULL != pp_fences);
+
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
+    TINY_RENDERER_DECLARE_ZERO(VkFence, fences[tr_max_submit_cmds]);
+    fence_count = fence_count > tr_max_submit_cmds ? tr_max_submit_cmds : fence_count;
+    for (uint32_t i = 0; i < fence_count; ++i) {
+        fences[i] = pp_fences[i]->vk_fence;
+    }
+
+    VkResult vk_res = vkWaitForFences(p_renderer->vk_device, fence_count, fences, VK_TRUE, UINT64_MAX);
+    assert(VK_SUCCESS == vk_res);
+    TINY_RENDERER_TRACE_END(p_renderer);
+}
+
+void tr_reset_fences(tr_renderer* p_renderer, uint32_t fence_count, tr_fence** pp_fences)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(fence_count > 0);
+    assert(NULL != pp_fences);
+
+    TINY_RENDERER_DECLARE_ZERO(VkFence, fences[tr_max_submit_cmds]);
+    fence_count = fence_count > tr_max_submit_cmds ? tr_max_submit_cmds : fence_count;
+    for (uint32_t i = 0; i < fence_count; ++i) {
+        fences[i] = pp_fences[i]->vk_fence;
+    }
+
+    VkResult vk_res = vkResetFences(p_renderer->vk_device, fence_count, fences);
+    assert(VK_SUCCESS == vk_res);
+}
+
 void tr_create_semaphore(tr_renderer *p_renderer, tr_semaphore** pp_semaphore)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -1288,6 +2186,7 @@ void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_descriptor_set* p_descriptor_set = (tr_descriptor_set*)calloc(1, sizeof(*p_descriptor_set));
     assert(NULL != p_descriptor_set);
 
@@ -1300,6 +2199,7 @@ void tr_create_descriptor_set(tr_renderer* p_renderer, uint32_t descriptor_count
     tr_internal_vk_create_descriptor_set(p_renderer, p_descriptor_set);
 
     *pp_descriptor_set = p_descriptor_set;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_destroy_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_descriptor_set)
@@ -1393,6 +2293,7 @@ void tr_create_buffer(tr_renderer* p_renderer, tr_buffer_usage usage, uint64_t s
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(size > 0 );
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_buffer* p_buffer = (tr_buffer*)calloc(1, sizeof(*p_buffer));
     assert(NULL != p_buffer);
 
@@ -1404,6 +2305,7 @@ void tr_create_buffer(tr_renderer* p_renderer, tr_buffer_usage usage, uint64_t s
     tr_internal_vk_create_buffer(p_renderer, p_buffer);
 
     *pp_buffer = p_buffer;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_create_index_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, tr_index_type index_type, tr_buffer** pp_buffer)
@@ -1417,6 +2319,22 @@ void tr_create_uniform_buffer(tr_renderer* p_renderer, uint64_t size, bool host_
     tr_create_buffer(p_renderer, tr_buffer_usage_uniform_cbv, size, host_visible, pp_buffer);
 }
 
+void tr_create_index_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, tr_index_type index_type, tr_buffer** pp_buffer)
+{
+    assert(NULL != p_data);
+
+    tr_create_index_buffer(p_renderer, size, false, index_type, pp_buffer);
+    tr_util_update_buffer(p_renderer->graphics_queue, size, p_data, *pp_buffer);
+}
+
+void tr_create_vertex_buffer_with_data(tr_renderer* p_renderer, uint64_t size, const void* p_data, uint32_t vertex_stride, tr_buffer** pp_buffer)
+{
+    assert(NULL != p_data);
+
+    tr_create_vertex_buffer(p_renderer, size, false, vertex_stride, pp_buffer);
+    tr_util_update_buffer(p_renderer->graphics_queue, size, p_data, *pp_buffer);
+}
+
 void tr_create_vertex_buffer(tr_renderer* p_renderer, uint64_t size, bool host_visible, uint32_t vertex_stride, tr_buffer** pp_buffer)
 {
     tr_create_buffer(p_renderer, tr_buffer_usage_vertex, size, host_visible, pp_buffer);
@@ -1518,10 +2436,31 @@ void tr_create_texture(
     tr_texture_usage_flags   usage, 
     tr_texture**             pp_texture
 )
+{
+    uint32_t array_layers = (tr_texture_type_cube == type) ? 6 : 1;
+    tr_internal_create_texture(p_renderer, type, width, height, depth, array_layers, sample_count, format, mip_levels, p_clear_value, host_visible, usage, pp_texture);
+}
+
+void tr_internal_create_texture(
+    tr_renderer*             p_renderer, 
+    tr_texture_type          type, 
+    uint32_t                 width, 
+    uint32_t                 height, 
+    uint32_t                 depth, 
+    uint32_t                 array_layers,
+    tr_sample_count          sample_count,
+    tr_format                format, 
+    uint32_t                 mip_levels,
+    const tr_clear_value*    p_clear_value, 
+    bool                     host_visible, 
+    tr_texture_usage_flags   usage, 
+    tr_texture**             pp_texture
+)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
-    assert((width > 0) && (height > 0) && (depth > 0));
+    assert((width > 0) && (height > 0) && (depth > 0) && (array_layers > 0));
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_texture* p_texture = (tr_texture*)calloc(1, sizeof(*p_texture));
     assert(NULL != p_texture);
 
@@ -1531,6 +2470,7 @@ void tr_create_texture(
     p_texture->width              = width;
     p_texture->height             = height;
     p_texture->depth              = depth;
+    p_texture->array_layers       = array_layers;
     p_texture->format             = format;
     p_texture->mip_levels         = mip_levels;
     p_texture->sample_count       = sample_count;
@@ -1553,6 +2493,7 @@ void tr_create_texture(
     tr_internal_vk_create_texture(p_renderer, p_texture);
 
     *pp_texture = p_texture;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_create_texture_1d(
@@ -1603,6 +2544,46 @@ void tr_create_texture_3d(
     tr_create_texture(p_renderer, tr_texture_type_3d, width, height, depth, sample_count, format, 1, NULL, host_visible, usage, pp_texture);
 }
 
+void tr_create_texture_2d_array(
+    tr_renderer*              p_renderer, 
+    uint32_t                  width, 
+    uint32_t                  height, 
+    uint32_t                  array_layers,
+    tr_sample_count           sample_count, 
+    tr_format                 format,
+    uint32_t                  mip_levels,
+    const tr_clear_value*     clear_value, 
+    bool                      host_visible,
+    tr_texture_usage_flags    usage, 
+    tr_texture**              pp_texture
+)
+{
+    if (tr_max_mip_levels == mip_levels) {
+        mip_levels = tr_util_calc_mip_levels(width, height);
+    }
+
+    tr_internal_create_texture(p_renderer, tr_texture_type_2d, width, height, 1, array_layers, sample_count, format, mip_levels, clear_value, host_visible, usage, pp_texture);
+}
+
+void tr_create_texture_cube(
+    tr_renderer*              p_renderer, 
+    uint32_t                  size, 
+    uint32_t                  cube_count,
+    tr_format                 format,
+    uint32_t                  mip_levels,
+    tr_texture_usage_flags    usage, 
+    tr_texture**              pp_texture
+)
+{
+    assert(cube_count > 0);
+
+    if (tr_max_mip_levels == mip_levels) {
+        mip_levels = tr_util_calc_mip_levels(size, size);
+    }
+
+    tr_internal_create_texture(p_renderer, tr_texture_type_cube, size, size, 1, 6 * cube_count, tr_sample_count_1, format, mip_levels, NULL, false, usage, pp_texture);
+}
+
 void tr_destroy_texture(tr_renderer* p_renderer, tr_texture* p_texture)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
@@ -1617,6 +2598,7 @@ void tr_create_sampler(tr_renderer* p_renderer, tr_sampler** pp_sampler)
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_sampler* p_sampler = (tr_sampler*)calloc(1, sizeof(*p_sampler));
     assert(NULL != p_sampler);
 
@@ -1625,6 +2607,7 @@ void tr_create_sampler(tr_renderer* p_renderer, tr_sampler** pp_sampler)
     tr_internal_vk_create_sampler(p_renderer, p_sampler);
 
     *pp_sampler = p_sampler;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_destroy_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler)
@@ -1659,6 +2642,7 @@ void tr_create_shader_program_n(tr_renderer* p_renderer, uint32_t vert_size, con
         assert(NULL != comp_code);
     }
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_shader_program* p_shader_program = (tr_shader_program*)calloc(1, sizeof(*p_shader_program));
     assert(NULL != p_shader_program);
     
@@ -1709,6 +2693,7 @@ void tr_create_shader_program_n(tr_renderer* p_renderer, uint32_t vert_size, con
     }
 
     *pp_shader_program = p_shader_program;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_create_shader_program(tr_renderer* p_renderer, uint32_t vert_size, const uint32_t* vert_code, const char* vert_enpt, uint32_t frag_size, const uint32_t* frag_code, const char* frag_enpt, tr_shader_program** pp_shader_program)
@@ -1734,6 +2719,7 @@ void tr_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_pro
     assert(NULL != p_render_target);
     assert(NULL != p_pipeline_settings);
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_pipeline* p_pipeline = (tr_pipeline*)calloc(1, sizeof(*p_pipeline));
     assert(NULL != p_pipeline);
 
@@ -1743,6 +2729,7 @@ void tr_create_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_pro
     p_pipeline->type = tr_pipeline_type_graphics;
 
     *pp_pipeline = p_pipeline;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader_program* p_shader_program, tr_descriptor_set* p_descriptor_set, const tr_pipeline_settings* p_pipeline_settings, tr_pipeline** pp_pipeline)
@@ -1751,6 +2738,7 @@ tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader
     assert(NULL != p_shader_program);
     assert(NULL != p_pipeline_settings);
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_pipeline* p_pipeline = (tr_pipeline*)calloc(1, sizeof(*p_pipeline));
     assert(NULL != p_pipeline);
 
@@ -1760,6 +2748,7 @@ tr_api_export void tr_create_compute_pipeline(tr_renderer* p_renderer, tr_shader
     p_pipeline->type = tr_pipeline_type_compute;
 
     *pp_pipeline = p_pipeline;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_destroy_pipeline(tr_renderer* p_renderer, tr_pipeline* p_pipeline)
@@ -1787,6 +2776,7 @@ void tr_create_render_target(
 {
     TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_render_target* p_render_target = (tr_render_target*)calloc(1, sizeof(*p_render_target));
     assert(NULL != p_render_target);
 
@@ -1848,6 +2838,7 @@ void tr_create_render_target(
     tr_internal_vk_create_render_target(p_renderer, false, p_render_target);
 
     *pp_render_target = p_render_target;
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_destroy_render_target(tr_renderer* p_renderer, tr_render_target* p_render_target)
@@ -1868,17 +2859,15 @@ void tr_destroy_render_target(tr_renderer* p_renderer, tr_render_target* p_rende
         if (NULL != p_render_target->depth_stencil_attachment) {
             tr_destroy_texture(p_renderer, p_render_target->depth_stencil_attachment);
         }
-
-        // Destroy VkRenderPass object
-        if (VK_NULL_HANDLE != p_render_target->vk_render_pass) {
-            vkDestroyRenderPass(p_renderer->vk_device, p_render_target->vk_render_pass, NULL);
-        }
-
-        // Destroy VkFramebuffer object
-        if (VK_NULL_HANDLE != p_render_target->vk_framebuffer) {
-            vkDestroyFramebuffer(p_renderer->vk_device, p_render_target->vk_framebuffer, NULL);
+        if ((NULL != p_render_target->depth_stencil_attachment_multisample) && 
+            (p_render_target->depth_stencil_attachment_multisample != p_render_target->depth_stencil_attachment)) 
+        {
+            tr_destroy_texture(p_renderer, p_render_target->depth_stencil_attachment_multisample);
         }
 
+        // The VkRenderPass stays in the renderer's cache, the VkFramebuffer
+        // was evicted when the attachments were destroyed.
+        tr_internal_vk_destroy_render_target(p_renderer, p_render_target);
     }
 
     TINY_RENDERER_SAFE_FREE(p_render_target);
@@ -1892,7 +2881,9 @@ void tr_update_descriptor_set(tr_renderer* p_renderer, tr_descriptor_set* p_desc
     assert(NULL != p_renderer);
     assert(NULL != p_descriptor_set);
 
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_internal_vk_update_descriptor_set(p_renderer, p_descriptor_set);
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -2015,35 +3006,55 @@ void tr_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_ind
 }
 
 void tr_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
+{
+    tr_cmd_buffer_transition_to(p_cmd, p_buffer, new_usage);
+}
+
+void tr_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+{
+    tr_cmd_image_transition_to(p_cmd, p_texture, new_usage);
+}
+
+void tr_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
+{
+    tr_cmd_render_target_transition_to(p_cmd, p_render_target, new_usage);
+}
+
+void tr_cmd_depth_stencil_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
+{
+    tr_cmd_depth_stencil_transition_to(p_cmd, p_render_target, new_usage);
+}
+
+void tr_cmd_buffer_transition_to(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage new_usage)
 {
     assert(NULL != p_cmd);
     assert(NULL != p_buffer);
 
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, old_usage, new_usage);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, new_usage);
 }
 
-void tr_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+void tr_cmd_image_transition_to(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage)
 {
     assert(NULL != p_cmd);
     assert(NULL != p_texture);
 
-    // Vulkan doesn't have an VkImageLayout corresponding to tr_texture_usage_storage, so
-    // just ignore transitions into or out of tr_texture_usage_storage.
-    if ((old_usage == tr_texture_usage_storage_image) || (new_usage == tr_texture_usage_storage_image)) {
-      return;
-    }
-
-    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, old_usage, new_usage);
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, 0, p_texture->mip_levels, new_usage);
 }
 
-void tr_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
+void tr_cmd_render_target_transition_to(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage)
 {
-    // Vulkan render passes take care of transitions, so just ignore this for now...
+    assert(NULL != p_cmd);
+    assert(NULL != p_render_target);
+
+    tr_internal_vk_cmd_render_target_transition(p_cmd, p_render_target, new_usage);
 }
 
-void tr_cmd_depth_stencil_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
+void tr_cmd_depth_stencil_transition_to(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage)
 {
-  // Vulkan render passes take care of transitions, so just ignore this for now...
+    assert(NULL != p_cmd);
+    assert(NULL != p_render_target);
+
+    tr_internal_vk_cmd_depth_stencil_transition(p_cmd, p_render_target, new_usage);
 }
 
 void tr_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
@@ -2061,11 +3072,159 @@ void tr_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t hei
     tr_internal_vk_cmd_copy_buffer_to_texture2d(p_cmd, width, height, row_pitch, buffer_offset, mip_level, p_buffer, p_texture);
 }
 
-void tr_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence)
+void tr_cmd_copy_buffer_to_texture_region(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t buffer_offset, uint32_t buffer_row_length, tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
 {
-    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(p_cmd != NULL);
+    assert(p_buffer != NULL);
+    assert(p_texture != NULL);
+    assert(mip_level < p_texture->mip_levels);
+    assert(array_layer < p_texture->array_layers);
+    assert((width > 0) && (height > 0));
+    assert((x + width) <= tr_max(p_texture->width >> mip_level, 1));
+    assert((y + height) <= tr_max(p_texture->height >> mip_level, 1));
 
+    tr_internal_vk_cmd_copy_buffer_to_texture_region(p_cmd, p_buffer, buffer_offset, buffer_row_length, p_texture, mip_level, array_layer, x, y, width, height);
+}
+
+uint64_t tr_cmd_update_texture_region(tr_cmd* p_cmd, tr_buffer* p_staging, uint64_t staging_offset, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t src_row_stride, const void* p_src_data, tr_texture* p_texture)
+{
+    assert(p_cmd != NULL);
+    assert(p_staging != NULL);
+    assert(p_staging->cpu_mapped_address != NULL);
+    assert(p_src_data != NULL);
+    assert(p_texture != NULL);
+    assert(mip_level < p_texture->mip_levels);
+    assert(array_layer < p_texture->array_layers);
+    assert((width > 0) && (height > 0));
+    assert((x + width) <= tr_max(p_texture->width >> mip_level, 1));
+    assert((y + height) <= tr_max(p_texture->height >> mip_level, 1));
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    // Buffer offsets of copies have to be multiples of 4 and of the texel or block size
+    const uint32_t format_stride = tr_util_format_stride(p_texture->format);
+    const uint64_t offset_alignment = (0 == (format_stride % 4)) ? format_stride
+                                    : ((0 == (format_stride % 2)) ? (2 * format_stride) : (4 * format_stride));
+    assert(0 == (staging_offset % offset_alignment));
+
+    // Rows of blocks for compressed formats
+    const uint32_t row_size = tr_util_format_row_pitch(p_texture->format, width);
+    const uint32_t row_count = tr_util_format_is_compressed(p_texture->format) ? ((height + 3) / 4) : height;
+    assert(src_row_stride >= row_size);
+    const uint64_t staging_size = (uint64_t)row_size * row_count;
+    assert((staging_offset + staging_size) <= p_staging->size);
+
+    uint8_t* p_staging_data = (uint8_t*)p_staging->cpu_mapped_address + staging_offset;
+    const uint8_t* p_row_src_data = (const uint8_t*)p_src_data;
+    if (src_row_stride == row_size) {
+        memcpy(p_staging_data, p_row_src_data, (size_t)staging_size);
+    }
+    else {
+        for (uint32_t row = 0; row < row_count; ++row) {
+            memcpy(p_staging_data + ((size_t)row * row_size), p_row_src_data + ((size_t)row * src_row_stride), row_size);
+        }
+    }
+
+    // Only the updated mip level is transitioned, it goes back to its previous usage
+    tr_texture_usage restore_usage = p_texture->current_mip_usages[mip_level];
+    if (tr_texture_usage_undefined == restore_usage) {
+        restore_usage = tr_texture_usage_sampled_image;
+    }
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, mip_level, 1, tr_texture_usage_transfer_dst);
+    tr_internal_vk_cmd_copy_buffer_to_texture_region(p_cmd, p_staging, staging_offset, 0, p_texture, mip_level, array_layer, x, y, width, height);
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, mip_level, 1, restore_usage);
+    p_texture->renderer->frame_stats.upload_bytes += staging_size;
+
+    return ((staging_offset + staging_size + offset_alignment - 1) / offset_alignment) * offset_alignment;
+}
+
+void tr_cmd_copy_texture_to_buffer(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t mip_level, uint64_t buffer_offset, tr_buffer* p_buffer)
+{
+    assert(p_cmd != NULL);
+    assert(p_texture != NULL);
+    assert(p_buffer != NULL);
+    assert(mip_level < p_texture->mip_levels);
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    tr_internal_vk_cmd_copy_texture_to_buffer(p_cmd, p_texture, mip_level, buffer_offset, p_buffer);
+}
+
+void tr_cmd_copy_buffer(tr_cmd* p_cmd, tr_buffer* p_src_buffer, uint64_t src_offset, tr_buffer* p_dst_buffer, uint64_t dst_offset, uint64_t size)
+{
+    assert(p_cmd != NULL);
+    assert(p_src_buffer != NULL);
+    assert(p_dst_buffer != NULL);
+    assert((src_offset + size) <= p_src_buffer->size);
+    assert((dst_offset + size) <= p_dst_buffer->size);
+
+    tr_internal_vk_cmd_copy_buffer(p_cmd, p_src_buffer, src_offset, p_dst_buffer, dst_offset, size);
+}
+
+void tr_cmd_generate_mipmaps(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage)
+{
+    assert(p_cmd != NULL);
+    assert(p_texture != NULL);
+    assert(tr_texture_type_2d == p_texture->type);
+    assert(tr_sample_count_1 == p_texture->sample_count);
+    assert(tr_util_texture_supports_gpu_mips(p_texture) && "Format can't be blitted with linear filtering");
+
+    tr_internal_vk_cmd_generate_mipmaps(p_cmd, p_texture, new_usage);
+}
+
+void tr_cmd_reset_query_pool(tr_cmd* p_cmd, tr_query_pool* p_query_pool)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_query_pool);
+
+    tr_internal_vk_cmd_reset_query_pool(p_cmd, p_query_pool);
+}
+
+void tr_cmd_begin_timer(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t timer_index)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_query_pool);
+    assert(tr_query_type_timestamp == p_query_pool->type);
+    assert((2 * timer_index + 1) < p_query_pool->query_count);
+
+    tr_internal_vk_cmd_write_timestamp(p_cmd, p_query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 2 * timer_index);
+}
+
+void tr_cmd_end_timer(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t timer_index)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_query_pool);
+    assert(tr_query_type_timestamp == p_query_pool->type);
+    assert((2 * timer_index + 1) < p_query_pool->query_count);
+
+    tr_internal_vk_cmd_write_timestamp(p_cmd, p_query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2 * timer_index + 1);
+}
+
+void tr_cmd_begin_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_query_pool);
+    assert(tr_query_type_timestamp != p_query_pool->type);
+    assert(query_index < p_query_pool->query_count);
+
+    tr_internal_vk_cmd_begin_query(p_cmd, p_query_pool, query_index);
+}
+
+void tr_cmd_end_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_query_pool);
+    assert(tr_query_type_timestamp != p_query_pool->type);
+    assert(query_index < p_query_pool->query_count);
+
+    tr_internal_vk_cmd_end_query(p_cmd, p_query_pool, query_index);
+}
+
+void tr_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+
+    TINY_RENDERER_TRACE_BEGIN(p_renderer);
     tr_internal_vk_acquire_next_image(p_renderer, p_signal_semaphore, p_fence);
+    TINY_RENDERER_TRACE_END(p_renderer);
 }
 
 void tr_queue_submit(
@@ -2088,13 +3247,16 @@ void tr_queue_submit(
         assert(NULL != pp_signal_semaphores);
     }
 
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
     tr_internal_vk_queue_submit(p_queue, 
                                 cmd_count, 
                                 pp_cmds, 
                                 wait_semaphore_count, 
                                 pp_wait_semaphores, 
                                 signal_semaphore_count, 
-                                pp_signal_semaphores);
+                                pp_signal_semaphores,
+                                NULL);
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
 }
 
 void tr_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semaphore** pp_wait_semaphores)
@@ -2104,794 +3266,4219 @@ void tr_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_count, tr_semap
         assert(NULL != pp_wait_semaphores);
     }
 
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
     tr_internal_vk_queue_present(p_queue, wait_semaphore_count, pp_wait_semaphores);
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
 }
 
 void tr_queue_wait_idle(tr_queue* p_queue)
 {
     assert(NULL != p_queue);
 
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
     tr_internal_vk_queue_wait_idle(p_queue);
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
 }
 
-void tr_render_target_set_color_clear_value(tr_render_target* p_render_target, uint32_t attachment_index, float r, float g, float b, float a)
+void tr_create_readback(tr_renderer* p_renderer, tr_queue* p_queue, uint64_t size, tr_readback** pp_readback)
 {
-    assert(NULL != p_render_target);
-    assert(attachment_index < p_render_target->color_attachment_count);
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_queue);
+    assert(size > 0);
 
-    p_render_target->color_attachments[attachment_index]->clear_value.r = r;
-    p_render_target->color_attachments[attachment_index]->clear_value.g = g;
-    p_render_target->color_attachments[attachment_index]->clear_value.b = b;
-    p_render_target->color_attachments[attachment_index]->clear_value.a = a;
+    tr_readback* p_readback = (tr_readback*)calloc(1, sizeof(*p_readback));
+    assert(NULL != p_readback);
+
+    p_readback->renderer = p_renderer;
+    p_readback->queue    = p_queue;
+    p_readback->size     = size;
+
+    p_readback->buffer = (tr_buffer*)calloc(1, sizeof(*(p_readback->buffer)));
+    assert(NULL != p_readback->buffer);
+    p_readback->buffer->renderer     = p_renderer;
+    p_readback->buffer->usage        = tr_buffer_usage_transfer_dst;
+    p_readback->buffer->size         = size;
+    p_readback->buffer->host_visible = true;
+    p_readback->buffer->host_cached  = true;
+    tr_internal_vk_create_buffer(p_renderer, p_readback->buffer);
+
+    tr_create_fence(p_renderer, &(p_readback->fence));
+    tr_create_cmd_pool(p_renderer, p_queue, false, &(p_readback->cmd_pool));
+    tr_create_cmd(p_readback->cmd_pool, false, &(p_readback->cmd));
+
+    *pp_readback = p_readback;
 }
 
-void tr_render_target_set_depth_stencil_clear_value(tr_render_target* p_render_target, float depth, uint8_t stencil)
+void tr_destroy_readback(tr_renderer* p_renderer, tr_readback* p_readback)
 {
-    assert(NULL != p_render_target);
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_readback);
 
-    p_render_target->depth_stencil_attachment->clear_value.depth = depth;
-    p_render_target->depth_stencil_attachment->clear_value.stencil = stencil;
+    if (p_readback->pending) {
+        tr_wait_for_fences(p_renderer, 1, &(p_readback->fence));
+    }
+
+    tr_destroy_cmd(p_readback->cmd_pool, p_readback->cmd);
+    tr_destroy_cmd_pool(p_renderer, p_readback->cmd_pool);
+    tr_destroy_fence(p_renderer, p_readback->fence);
+    tr_destroy_buffer(p_renderer, p_readback->buffer);
+
+    TINY_RENDERER_SAFE_FREE(p_readback);
 }
 
-bool tr_vertex_layout_support_format(tr_format format)
+void tr_internal_begin_readback(tr_readback* p_readback)
 {
-    bool result = false;
-    switch (format) {
-        // 1 channel
-        case tr_format_r8_unorm            : result = true; break;
-        case tr_format_r16_unorm           : result = true; break;
-        case tr_format_r16_float           : result = true; break;
-        case tr_format_r32_uint            : result = true; break;
-        case tr_format_r32_float           : result = true; break;
-        // 2 channel
-        case tr_format_r8g8_unorm          : result = true; break;
-        case tr_format_r16g16_unorm        : result = true; break;
-        case tr_format_r16g16_float        : result = true; break;
-        case tr_format_r32g32_uint         : result = true; break;
-        case tr_format_r32g32_float        : result = true; break;
-        // 3 channel
-        case tr_format_r8g8b8_unorm        : result = true; break;
-        case tr_format_r16g16b16_unorm     : result = true; break;
-        case tr_format_r16g16b16_float     : result = true; break;
-        case tr_format_r32g32b32_uint      : result = true; break;
-        case tr_format_r32g32b32_float     : result = true; break;
-        // 4 channel
-        case tr_format_r8g8b8a8_unorm      : result = true; break;
-        case tr_format_r16g16b16a16_unorm  : result = true; break;
-        case tr_format_r16g16b16a16_float  : result = true; break;
-        case tr_format_r32g32b32a32_uint   : result = true; break;
-        case tr_format_r32g32b32a32_float  : result = true; break;
+    // Reusing the command buffer and fence requires the previous readback to be done
+    if (p_readback->pending) {
+        tr_wait_for_fences(p_readback->renderer, 1, &(p_readback->fence));
+        p_readback->pending = false;
     }
-    return result;
+    tr_reset_fences(p_readback->renderer, 1, &(p_readback->fence));
+
+    tr_begin_cmd(p_readback->cmd);
 }
 
-uint32_t tr_vertex_layout_stride(const tr_vertex_layout* p_vertex_layout)
+void tr_internal_end_readback(tr_readback* p_readback)
 {
-    assert(NULL != p_vertex_layout);
+    tr_internal_vk_cmd_host_read_barrier(p_readback->cmd, p_readback->buffer);
+    tr_end_cmd(p_readback->cmd);
 
-    uint32_t result = 0;
-    for (uint32_t i = 0; i < p_vertex_layout->attrib_count; ++i) {
-        result += tr_util_format_stride(p_vertex_layout->attribs[i].format);
-    }
-    return result;
+    tr_internal_vk_queue_submit(p_readback->queue, 1, &(p_readback->cmd), 0, NULL, 0, NULL, p_readback->fence);
+    p_readback->pending = true;
 }
 
-// -------------------------------------------------------------------------------------------------
-// Utility functions
-// -------------------------------------------------------------------------------------------------
+void tr_readback_buffer(tr_readback* p_readback, tr_buffer* p_buffer)
+{
+    assert(NULL != p_readback);
+    assert(NULL != p_buffer);
+    assert(p_buffer->size <= p_readback->size);
 
-// This function always returns zero for Vulkan for now because
-// of how the counter are configured.
-uint64_t tr_util_calc_storage_counter_offset(uint64_t buffer_size)
+    tr_internal_begin_readback(p_readback);
+    tr_internal_vk_cmd_copy_buffer(p_readback->cmd, p_buffer, 0, p_readback->buffer, 0, p_buffer->size);
+    tr_internal_end_readback(p_readback);
+
+    p_readback->row_pitch = 0;
+}
+
+void tr_readback_texture(tr_readback* p_readback, tr_texture* p_texture, uint32_t mip_level)
 {
-    uint64_t result = 0;
-    return result;
+    assert(NULL != p_readback);
+    assert(NULL != p_texture);
+    assert(mip_level < p_texture->mip_levels);
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    uint32_t width = tr_max(p_texture->width >> mip_level, 1);
+    uint32_t height = tr_max(p_texture->height >> mip_level, 1);
+    uint32_t row_pitch = tr_util_format_row_pitch(p_texture->format, width);
+    assert(tr_util_format_level_size(p_texture->format, width, height) <= p_readback->size);
+
+    tr_internal_begin_readback(p_readback);
+    tr_internal_vk_cmd_copy_texture_to_buffer(p_readback->cmd, p_texture, mip_level, 0, p_readback->buffer);
+    tr_internal_end_readback(p_readback);
+
+    p_readback->row_pitch = row_pitch;
 }
 
-uint32_t tr_util_calc_mip_levels(uint32_t width, uint32_t height)
+bool tr_readback_is_ready(tr_readback* p_readback)
 {
-    if (width == 0 || height == 0)
-        return 0;
+    assert(NULL != p_readback);
 
-    uint32_t result = 1;
-    while (width > 1 || height > 1)
-    {
-        width >>= 1;
-        height >>= 1;
-        result++;
-    }
-    return result;
+    bool ready = (! p_readback->pending) || tr_get_fence_status(p_readback->renderer, p_readback->fence);
+    return ready;
 }
 
-tr_api_export VkFormat tr_util_to_vk_format(tr_format format)
+const void* tr_readback_map(tr_readback* p_readback)
 {
-    VkFormat result = VK_FORMAT_UNDEFINED;
-    switch (format) {
-        // 1 channel
-        case tr_format_r8_unorm            : result = VK_FORMAT_R8_UNORM; break;
-        case tr_format_r16_unorm           : result = VK_FORMAT_R16_UNORM; break;
-        case tr_format_r16_float           : result = VK_FORMAT_R16_SFLOAT; break;
-        case tr_format_r32_uint            : result = VK_FORMAT_R32_UINT; break;
-        case tr_format_r32_float           : result = VK_FORMAT_R32_SFLOAT; break;
-        // 2 channel
-        case tr_format_r8g8_unorm          : result = VK_FORMAT_R8G8_UNORM; break;
-        case tr_format_r16g16_unorm        : result = VK_FORMAT_R16G16_UNORM; break;
-        case tr_format_r16g16_float        : result = VK_FORMAT_R16G16_SFLOAT; break;
-        case tr_format_r32g32_uint         : result = VK_FORMAT_R32G32_UINT; break;
-        case tr_format_r32g32_float        : result = VK_FORMAT_R32G32_SFLOAT; break;
-        // 3 channel
-        case tr_format_r8g8b8_unorm        : result = VK_FORMAT_R8G8B8_UNORM; break;
-        case tr_format_r16g16b16_unorm     : result = VK_FORMAT_R16G16B16_UNORM; break;
-        case tr_format_r16g16b16_float     : result = VK_FORMAT_R16G16B16_SFLOAT; break;
-        case tr_format_r32g32b32_uint      : result = VK_FORMAT_R32G32B32_UINT; break;
-        case tr_format_r32g32b32_float     : result = VK_FORMAT_R32G32B32_SFLOAT; break;
-        // 4 channel
-        case tr_format_b8g8r8a8_unorm      : result = VK_FORMAT_B8G8R8A8_UNORM; break;
-        case tr_format_r8g8b8a8_unorm      : result = VK_FORMAT_R8G8B8A8_UNORM; break;
-        case tr_format_r16g16b16a16_unorm  : result = VK_FORMAT_R16G16B16A16_UNORM; break;
-        case tr_format_r16g16b16a16_float  : result = VK_FORMAT_R16G16B16A16_SFLOAT; break;
-        case tr_format_r32g32b32a32_uint   : result = VK_FORMAT_R32G32B32A32_UINT; break;
-        case tr_format_r32g32b32a32_float  : result = VK_FORMAT_R32G32B32A32_SFLOAT; break;
-        // Depth/stencil
-        case tr_format_d16_unorm           : result = VK_FORMAT_D16_UNORM; break;
-        case tr_format_x8_d24_unorm_pack32 : result = VK_FORMAT_X8_D24_UNORM_PACK32; break;
-        case tr_format_d32_float           : result = VK_FORMAT_D32_SFLOAT; break;
-        case tr_format_s8_uint             : result = VK_FORMAT_S8_UINT; break;
-        case tr_format_d16_unorm_s8_uint   : result = VK_FORMAT_D16_UNORM_S8_UINT; break;
-        case tr_format_d24_unorm_s8_uint   : result = VK_FORMAT_D24_UNORM_S8_UINT; break;
-        case tr_format_d32_float_s8_uint   : result = VK_FORMAT_D32_SFLOAT_S8_UINT; break;
+    assert(NULL != p_readback);
+
+    if (p_readback->pending) {
+        tr_wait_for_fences(p_readback->renderer, 1, &(p_readback->fence));
+        p_readback->pending = false;
     }
-    return result;
+
+    // Host cached memory isn't necessarily coherent
+    TINY_RENDERER_DECLARE_ZERO(VkMappedMemoryRange, range);
+    range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.pNext  = NULL;
+    range.memory = p_readback->buffer->vk_memory;
+    range.offset = 0;
+    range.size   = VK_WHOLE_SIZE;
+    VkResult vk_res = vkInvalidateMappedMemoryRanges(p_readback->renderer->vk_device, 1, &range);
+    assert(VK_SUCCESS == vk_res);
+
+    return p_readback->buffer->cpu_mapped_address;
 }
 
-tr_format tr_util_from_vk_format(VkFormat format)
+void tr_create_texture_streamer(tr_renderer* p_renderer, tr_queue* p_queue, uint64_t frame_byte_budget, uint64_t resident_byte_budget, tr_texture_streamer** pp_streamer)
 {
-    tr_format result = tr_format_undefined;
-    switch (format) {
-        // 1 channel
-        case VK_FORMAT_R8_UNORM            : result = tr_format_r8_unorm; break;
-        case VK_FORMAT_R16_UNORM           : result = tr_format_r16_unorm; break;
-        case VK_FORMAT_R16_SFLOAT          : result = tr_format_r16_float; break;
-        case VK_FORMAT_R32_UINT            : result = tr_format_r32_uint; break;
-        case VK_FORMAT_R32_SFLOAT          : result = tr_format_r32_float; break;
-        // 2 channel
-        case VK_FORMAT_R8G8_UNORM          : result = tr_format_r8g8_unorm; break;
-        case VK_FORMAT_R16G16_UNORM        : result = tr_format_r16g16_unorm; break;
-        case VK_FORMAT_R16G16_SFLOAT       : result = tr_format_r16g16_float; break;
-        case VK_FORMAT_R32G32_UINT         : result = tr_format_r32g32_uint; break;
-        case VK_FORMAT_R32G32_SFLOAT       : result = tr_format_r32g32_float; break;
-        // 3 channel
-        case VK_FORMAT_R8G8B8_UNORM        : result = tr_format_r8g8b8_unorm; break;
-        case VK_FORMAT_R16G16B16_UNORM     : result = tr_format_r16g16b16_unorm; break;
-        case VK_FORMAT_R16G16B16_SFLOAT    : result = tr_format_r16g16b16_float; break;
-        case VK_FORMAT_R32G32B32_UINT      : result = tr_format_r32g32b32_uint; break;
-        case VK_FORMAT_R32G32B32_SFLOAT    : result = tr_format_r32g32b32_float; break;
-        // 4 channel
-        case VK_FORMAT_B8G8R8A8_UNORM      : result = tr_format_b8g8r8a8_unorm; break;
-        case VK_FORMAT_R8G8B8A8_UNORM      : result = tr_format_r8g8b8a8_unorm; break;
-        case VK_FORMAT_R16G16B16A16_UNORM  : result = tr_format_r16g16b16a16_unorm; break;
-        case VK_FORMAT_R16G16B16A16_SFLOAT : result = tr_format_r16g16b16a16_float; break;
-        case VK_FORMAT_R32G32B32A32_UINT   : result = tr_format_r32g32b32a32_uint; break;
-        case VK_FORMAT_R32G32B32A32_SFLOAT : result = tr_format_r32g32b32a32_float; break;
-        // Depth/stencil
-        case VK_FORMAT_D16_UNORM           : result = tr_format_d16_unorm; break;
-        case VK_FORMAT_X8_D24_UNORM_PACK32 : result = tr_format_x8_d24_unorm_pack32; break;
-        case VK_FORMAT_D32_SFLOAT          : result = tr_format_d32_float; break;
-        case VK_FORMAT_S8_UINT             : result = tr_format_s8_uint; break;
-        case VK_FORMAT_D16_UNORM_S8_UINT   : result = tr_format_d16_unorm_s8_uint; break;
-        case VK_FORMAT_D24_UNORM_S8_UINT   : result = tr_format_d24_unorm_s8_uint; break;
-        case VK_FORMAT_D32_SFLOAT_S8_UINT  : result = tr_format_d32_float_s8_uint; break;
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_queue);
+    assert(frame_byte_budget > 0);
+
+    tr_texture_streamer* p_streamer = (tr_texture_streamer*)calloc(1, sizeof(*p_streamer));
+    assert(NULL != p_streamer);
+
+    p_streamer->renderer             = p_renderer;
+    p_streamer->queue                = p_queue;
+    p_streamer->frame_byte_budget    = frame_byte_budget;
+    p_streamer->resident_byte_budget = resident_byte_budget;
+
+    // Staging buffers are created on first use since they depend on the level sizes
+    p_streamer->batch_count = tr_max(p_renderer->settings.swapchain.image_count, 2);
+    p_streamer->batches = (tr_texture_stream_batch*)calloc(p_streamer->batch_count, sizeof(*(p_streamer->batches)));
+    assert(NULL != p_streamer->batches);
+    for (uint32_t i = 0; i < p_streamer->batch_count; ++i) {
+        tr_texture_stream_batch* p_batch = &(p_streamer->batches[i]);
+        tr_create_fence(p_renderer, &(p_batch->fence));
+        tr_create_cmd_pool(p_renderer, p_queue, false, &(p_batch->cmd_pool));
+        tr_create_cmd(p_batch->cmd_pool, false, &(p_batch->cmd));
     }
-    return result;
+
+    *pp_streamer = p_streamer;
 }
 
-VkShaderStageFlags tr_util_to_vk_shader_stages(tr_shader_stage shader_stages)
+void tr_destroy_texture_streamer(tr_renderer* p_renderer, tr_texture_streamer* p_streamer)
 {
-    VkShaderStageFlags result = 0;
-    if (tr_shader_stage_all_graphics == (shader_stages & tr_shader_stage_all_graphics)) {
-        result = VK_SHADER_STAGE_ALL_GRAPHICS;
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_streamer);
+
+    // Pending copies finish so every texture's view covers the levels it holds,
+    // the views they replace retire with the others and are destroyed below.
+    for (uint32_t i = 0; i < p_streamer->batch_count; ++i) {
+        uint32_t batch_index = (p_streamer->batch_index + 1 + i) % p_streamer->batch_count;
+        tr_internal_complete_stream_batch(p_streamer, &(p_streamer->batches[batch_index]), true);
     }
-    else {
-        if (tr_shader_stage_vert == (shader_stages & tr_shader_stage_vert)) {
-            result |= VK_SHADER_STAGE_VERTEX_BIT;
-        }
-        if (tr_shader_stage_tesc == (shader_stages & tr_shader_stage_tesc)) {
-            result |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
-        }
-        if (tr_shader_stage_tese == (shader_stages & tr_shader_stage_tese)) {
-            result |= VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+
+    for (uint32_t i = 0; i < p_streamer->batch_count; ++i) {
+        tr_texture_stream_batch* p_batch = &(p_streamer->batches[i]);
+        for (uint32_t j = 0; j < p_batch->retired_view_count; ++j) {
+            vkDestroyImageView(p_renderer->vk_device, p_batch->retired_views[j], NULL);
         }
-        if (tr_shader_stage_geom == (shader_stages & tr_shader_stage_geom)) {
-            result |= VK_SHADER_STAGE_GEOMETRY_BIT;
-        }
-        if (tr_shader_stage_frag == (shader_stages & tr_shader_stage_frag)) {
-            result |= VK_SHADER_STAGE_FRAGMENT_BIT;
-        }
-        if (tr_shader_stage_comp == (shader_stages & tr_shader_stage_comp)) {
-            result |= VK_SHADER_STAGE_COMPUTE_BIT;
+        if (NULL != p_batch->staging) {
+            tr_destroy_buffer(p_renderer, p_batch->staging);
         }
+        tr_destroy_cmd(p_batch->cmd_pool, p_batch->cmd);
+        tr_destroy_cmd_pool(p_renderer, p_batch->cmd_pool);
+        tr_destroy_fence(p_renderer, p_batch->fence);
+        TINY_RENDERER_SAFE_FREE(p_batch->copy_textures);
+        TINY_RENDERER_SAFE_FREE(p_batch->copy_mips);
+        TINY_RENDERER_SAFE_FREE(p_batch->retired_views);
     }
-    return result;
-}
 
-uint32_t tr_util_format_stride(tr_format format)
-{
-    uint32_t result = 0;
-    switch (format) {
-        // 1 channel
-        case tr_format_r8_unorm            : result = 1; break;
-        case tr_format_r16_unorm           : result = 2; break;
-        case tr_format_r16_float           : result = 2; break;
-        case tr_format_r32_uint            : result = 4; break;
-        case tr_format_r32_float           : result = 4; break;
-        // 2 channel
-        case tr_format_r8g8_unorm          : result = 2; break;
-        case tr_format_r16g16_unorm        : result = 4; break;
-        case tr_format_r16g16_float        : result = 4; break;
-        case tr_format_r32g32_uint         : result = 8; break;
-        case tr_format_r32g32_float        : result = 8; break;
-        // 3 channel
-        case tr_format_r8g8b8_unorm        : result = 3; break;
-        case tr_format_r16g16b16_unorm     : result = 6; break;
-        case tr_format_r16g16b16_float     : result = 6; break;
-        case tr_format_r32g32b32_uint      : result = 12; break;
-        case tr_format_r32g32b32_float     : result = 12; break;
-        // 4 channel
-        case tr_format_b8g8r8a8_unorm      : result = 4; break;
-        case tr_format_r8g8b8a8_unorm      : result = 4; break;
-        case tr_format_r16g16b16a16_unorm  : result = 8; break;
-        case tr_format_r16g16b16a16_float  : result = 8; break;
-        case tr_format_r32g32b32a32_uint   : result = 16; break;
-        case tr_format_r32g32b32a32_float  : result = 16; break;
-        // Depth/stencil
-        case tr_format_d16_unorm           : result = 0; break;
-        case tr_format_x8_d24_unorm_pack32 : result = 0; break;
-        case tr_format_d32_float           : result = 0; break;
-        case tr_format_s8_uint             : result = 0; break;
-        case tr_format_d16_unorm_s8_uint   : result = 0; break;
-        case tr_format_d24_unorm_s8_uint   : result = 0; break;
-        case tr_format_d32_float_s8_uint   : result = 0; break;
-    }
-    return result;
+    TINY_RENDERER_SAFE_FREE(p_streamer->batches);
+    TINY_RENDERER_SAFE_FREE(p_streamer->textures);
+    TINY_RENDERER_SAFE_FREE(p_streamer);
 }
 
-uint32_t tr_util_format_channel_count(tr_format format)
+void tr_texture_streamer_add(tr_texture_streamer* p_streamer, tr_texture* p_texture, const void* p_src_data, uint32_t resident_mip_count)
 {
-    uint32_t result = 0;
-    switch (format) {
-        // 1 channel
-        case tr_format_r8_unorm            : result = 1; break;
-        case tr_format_r16_unorm           : result = 1; break;
-        case tr_format_r16_float           : result = 1; break;
-        case tr_format_r32_uint            : result = 1; break;
-        case tr_format_r32_float           : result = 1; break;
-        // 2 channel
-        case tr_format_r8g8_unorm          : result = 2; break;
-        case tr_format_r16g16_unorm        : result = 2; break;
-        case tr_format_r16g16_float        : result = 2; break;
-        case tr_format_r32g32_uint         : result = 2; break;
-        case tr_format_r32g32_float        : result = 2; break;
-        // 3 channel
-        case tr_format_r8g8b8_unorm        : result = 3; break;
-        case tr_format_r16g16b16_unorm     : result = 3; break;
-        case tr_format_r16g16b16_float     : result = 3; break;
-        case tr_format_r32g32b32_uint      : result = 3; break;
-        case tr_format_r32g32b32_float     : result = 3; break;
-        // 4 channel
-        case tr_format_b8g8r8a8_unorm      : result = 4; break;
-        case tr_format_r8g8b8a8_unorm      : result = 4; break;
-        case tr_format_r16g16b16a16_unorm  : result = 4; break;
-        case tr_format_r16g16b16a16_float  : result = 4; break;
-        case tr_format_r32g32b32a32_uint   : result = 4; break;
-        case tr_format_r32g32b32a32_float  : result = 4; break;
-        // Depth/stencil
-        case tr_format_d16_unorm           : result = 0; break;
-        case tr_format_x8_d24_unorm_pack32 : result = 0; break;
-        case tr_format_d32_float           : result = 0; break;
-        case tr_format_s8_uint             : result = 0; break;
-        case tr_format_d16_unorm_s8_uint   : result = 0; break;
-        case tr_format_d24_unorm_s8_uint   : result = 0; break;
-        case tr_format_d32_float_s8_uint   : result = 0; break;
-    }
-    return result;
-}
+    assert(NULL != p_streamer);
+    assert(NULL != p_texture);
+    assert(NULL != p_src_data);
+    assert(tr_texture_type_2d == p_texture->type);
+    assert(1 == p_texture->array_layers);
+    assert(tr_sample_count_1 == p_texture->sample_count);
 
-void tr_util_transition_buffer(tr_queue* p_queue, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
-{
-    assert(NULL != p_queue);
-    assert(NULL != p_buffer);
+    TINY_RENDERER_TRACE_BEGIN(p_streamer->renderer);
 
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+    if (p_streamer->texture_count == p_streamer->texture_capacity) {
+        p_streamer->texture_capacity = tr_max(2 * p_streamer->texture_capacity, 16);
+        p_streamer->textures = (tr_streamed_texture*)realloc(p_streamer->textures, p_streamer->texture_capacity * sizeof(*(p_streamer->textures)));
+        assert(NULL != p_streamer->textures);
+    }
 
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
-    
-    tr_begin_cmd(p_cmd);
-    tr_cmd_buffer_transition(p_cmd, p_buffer, old_usage, new_usage);
-    tr_end_cmd(p_cmd);
+    // The coarsest levels are uploaded right away, every level ends up sampled
+    resident_mip_count = tr_max(tr_min(resident_mip_count, p_texture->mip_levels), 1);
+    const uint32_t first_mip_level = p_texture->mip_levels - resident_mip_count;
+    tr_util_vk_update_texture_mip_range(p_streamer->queue, p_src_data, first_mip_level, resident_mip_count, 0, p_texture);
+    for (uint32_t mip_level = first_mip_level; mip_level < p_texture->mip_levels; ++mip_level) {
+        p_streamer->resident_bytes += tr_util_format_level_size(p_texture->format, tr_max(p_texture->width >> mip_level, 1), tr_max(p_texture->height >> mip_level, 1));
+    }
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
+    // The texture isn't in any descriptor set yet so its view can be replaced right away
+    if (first_mip_level != p_texture->min_lod) {
+        vkDestroyImageView(p_streamer->renderer->vk_device, p_texture->vk_image_view, NULL);
+        p_texture->min_lod = first_mip_level;
+        p_texture->vk_image_view = tr_internal_vk_create_texture_view(p_streamer->renderer, p_texture, first_mip_level);
+        p_texture->vk_texture_view.imageView = p_texture->vk_image_view;
+    }
 
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    tr_streamed_texture* p_streamed = &(p_streamer->textures[p_streamer->texture_count]);
+    p_streamed->texture      = p_texture;
+    p_streamed->p_src_data   = (const uint8_t*)p_src_data;
+    p_streamed->streamed_mip = first_mip_level;
+    ++p_streamer->texture_count;
+
+    TINY_RENDERER_TRACE_END(p_streamer->renderer);
 }
 
-void tr_util_transition_image(tr_queue* p_queue, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+bool tr_texture_streamer_update(tr_texture_streamer* p_streamer)
 {
-    assert(NULL != p_queue);
-    assert(NULL != p_texture);
+    assert(NULL != p_streamer);
 
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+    TINY_RENDERER_TRACE_BEGIN(p_streamer->renderer);
 
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
-    
-    tr_begin_cmd(p_cmd);
-    tr_cmd_image_transition(p_cmd, p_texture, old_usage, new_usage);
-    tr_end_cmd(p_cmd);
+    tr_texture_stream_batch* p_batch = &(p_streamer->batches[p_streamer->batch_index]);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
+    // Views retired batch_count updates ago are no longer used by frames in flight
+    for (uint32_t i = 0; i < p_batch->retired_view_count; ++i) {
+        vkDestroyImageView(p_streamer->renderer->vk_device, p_batch->retired_views[i], NULL);
+    }
+    p_batch->retired_view_count = 0;
 
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    // Completed copies lower min_lod, views they replace retire into the current batch
+    bool views_changed = false;
+    for (uint32_t i = 0; i < p_streamer->batch_count; ++i) {
+        uint32_t batch_index = (p_streamer->batch_index + 1 + i) % p_streamer->batch_count;
+        views_changed |= tr_internal_complete_stream_batch(p_streamer, &(p_streamer->batches[batch_index]), false);
+    }
+
+    // A batch that's still in flight means the GPU is behind, skip this frame's copies
+    if (! p_batch->pending) {
+        tr_internal_fill_stream_batch(p_streamer, p_batch);
+    }
+    p_streamer->batch_index = (p_streamer->batch_index + 1) % p_streamer->batch_count;
+
+    TINY_RENDERER_TRACE_END(p_streamer->renderer);
+
+    return views_changed;
 }
 
-bool tr_image_resize_uint8_t(
-    uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* src_data,
-    uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* dst_data,
-    uint32_t channel_cout, void* user_data
-)
+bool tr_texture_streamer_is_done(tr_texture_streamer* p_streamer)
 {
-    float dx = (float)src_width / (float)dst_width;
-    float dy = (float)src_height / (float)dst_height;
+    assert(NULL != p_streamer);
 
-    const uint8_t src_pixel_stride = channel_cout;
-    const uint8_t dst_pixel_stride = channel_cout;
+    for (uint32_t i = 0; i < p_streamer->batch_count; ++i) {
+        if (p_streamer->batches[i].pending) {
+            return false;
+        }
+    }
 
-    uint8_t* dst_row = dst_data;
-    for (uint32_t y = 0; y < dst_height; ++y) {
-        float src_x = 0;
-        float src_y = (float)y * dy;
-        uint8_t* dst_pixel = dst_row;
-        for (uint32_t x = 0; x < dst_width; ++x) {
-            const uint32_t src_offset = ((uint32_t)src_y * src_row_stride) + ((uint32_t)src_x * src_pixel_stride);
-            const uint8_t* src_pixel = src_data + src_offset;           
-            for (uint32_t c = 0; c < channel_cout; ++c) {
-                *(dst_pixel + c) = *(src_pixel + c);
+    for (uint32_t i = 0; i < p_streamer->texture_count; ++i) {
+        const tr_streamed_texture* p_streamed = &(p_streamer->textures[i]);
+        if (p_streamed->streamed_mip > 0) {
+            const tr_texture* p_texture = p_streamed->texture;
+            uint32_t mip_level = p_streamed->streamed_mip - 1;
+            uint64_t level_size = tr_util_format_level_size(p_texture->format, tr_max(p_texture->width >> mip_level, 1), tr_max(p_texture->height >> mip_level, 1));
+            if ((0 == p_streamer->resident_byte_budget) || ((p_streamer->resident_bytes + level_size) <= p_streamer->resident_byte_budget)) {
+                return false;
             }
-            src_x += dx;
-            dst_pixel += dst_pixel_stride;
         }
-        dst_row += dst_row_stride;
     }
 
     return true;
 }
 
-void tr_util_set_storage_buffer_count(tr_queue* p_queue, uint64_t count_offset, uint32_t count, tr_buffer* p_counter_buffer)
+bool tr_internal_complete_stream_batch(tr_texture_streamer* p_streamer, tr_texture_stream_batch* p_batch, bool wait)
 {
-    assert(NULL != p_queue);
-    assert(NULL != p_counter_buffer);
-    assert(NULL != p_counter_buffer->vk_buffer);
-
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_counter_buffer->renderer, tr_buffer_usage_transfer_src, p_counter_buffer->size, true, &buffer);
-    uint32_t* mapped_ptr = (uint32_t*)buffer->cpu_mapped_address;
-    *(mapped_ptr) = count;
-    
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+    if (! p_batch->pending) {
+        return false;
+    }
 
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+    if (wait) {
+        tr_wait_for_fences(p_streamer->renderer, 1, &(p_batch->fence));
+    }
+    else if (! tr_get_fence_status(p_streamer->renderer, p_batch->fence)) {
+        return false;
+    }
+    p_batch->pending = false;
 
-    tr_begin_cmd(p_cmd);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, tr_buffer_usage_storage_uav, tr_buffer_usage_transfer_dst);
-    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
-    region.srcOffset = 0;
-    region.dstOffset = 0;
-    region.size      = (VkDeviceSize)4;
-    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_counter_buffer->vk_buffer, 1, &region);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, tr_buffer_usage_transfer_dst, tr_buffer_usage_storage_uav);
-    tr_end_cmd(p_cmd);
+    // Levels are copied coarsest first, walking back from the last copy 
+    // replaces each texture's view once with its finest new level.
+    tr_texture_stream_batch* p_current = &(p_streamer->batches[p_streamer->batch_index]);
+    bool views_changed = false;
+    for (uint32_t i = p_batch->copy_count; i > 0; --i) {
+        tr_texture* p_texture = p_streamer->textures[p_batch->copy_textures[i - 1]].texture;
+        uint32_t mip_level = p_batch->copy_mips[i - 1];
+        if (mip_level >= p_texture->min_lod) {
+            continue;
+        }
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
+        if (p_current->retired_view_count == p_current->retired_view_capacity) {
+            p_current->retired_view_capacity = tr_max(2 * p_current->retired_view_capacity, 16);
+            p_current->retired_views = (VkImageView*)realloc(p_current->retired_views, p_current->retired_view_capacity * sizeof(*(p_current->retired_views)));
+            assert(NULL != p_current->retired_views);
+        }
+        p_current->retired_views[p_current->retired_view_count++] = p_texture->vk_image_view;
 
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+        p_texture->min_lod = mip_level;
+        p_texture->vk_image_view = tr_internal_vk_create_texture_view(p_streamer->renderer, p_texture, mip_level);
+        p_texture->vk_texture_view.imageView = p_texture->vk_image_view;
+        views_changed = true;
+    }
+    p_batch->copy_count = 0;
 
-    tr_destroy_buffer(p_counter_buffer->renderer, buffer);
+    return views_changed;
 }
 
-void tr_util_clear_buffer(tr_queue* p_queue, tr_buffer* p_buffer)
+bool tr_internal_fill_stream_batch(tr_texture_streamer* p_streamer, tr_texture_stream_batch* p_batch)
 {
-    assert(NULL != p_queue);
-    assert(NULL != p_buffer);
-    assert(NULL != p_buffer->vk_buffer);
+    // Each pass takes at most one level per texture so that textures sharpen evenly,
+    // a level larger than the budget still goes out on its own in an empty batch.
+    uint64_t batch_bytes = 0;
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (uint32_t i = 0; i < p_streamer->texture_count; ++i) {
+            tr_streamed_texture* p_streamed = &(p_streamer->textures[i]);
+            if (0 == p_streamed->streamed_mip) {
+                continue;
+            }
 
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_buffer->renderer, tr_buffer_usage_transfer_src, p_buffer->size, true, &buffer);
-    memset(buffer->cpu_mapped_address, 0, buffer->size);
-    
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+            tr_texture* p_texture = p_streamed->texture;
+            uint32_t mip_level = p_streamed->streamed_mip - 1;
+            uint64_t level_size = tr_util_format_level_size(p_texture->format, tr_max(p_texture->width >> mip_level, 1), tr_max(p_texture->height >> mip_level, 1));
+            if ((0 != p_streamer->resident_byte_budget) && ((p_streamer->resident_bytes + level_size) > p_streamer->resident_byte_budget)) {
+                continue;
+            }
+            uint64_t offset = (batch_bytes + 15) & ~((uint64_t)15);
+            if ((p_batch->copy_count > 0) && ((offset + level_size) > p_streamer->frame_byte_budget)) {
+                continue;
+            }
 
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+            if (0 == p_batch->copy_count) {
+                uint64_t staging_size = (level_size > p_streamer->frame_byte_budget) ? level_size : p_streamer->frame_byte_budget;
+                if ((NULL != p_batch->staging) && (p_batch->staging->size < staging_size)) {
+                    tr_destroy_buffer(p_streamer->renderer, p_batch->staging);
+                    p_batch->staging = NULL;
+                }
+                if (NULL == p_batch->staging) {
+                    tr_create_buffer(p_streamer->renderer, tr_buffer_usage_transfer_src, staging_size, true, &(p_batch->staging));
+                }
+                tr_reset_fences(p_streamer->renderer, 1, &(p_batch->fence));
+                tr_begin_cmd(p_batch->cmd);
+            }
 
-    tr_begin_cmd(p_cmd);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->usage, tr_buffer_usage_transfer_dst);
-    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
-    region.srcOffset = 0;
-    region.dstOffset = 0;
-    region.size      = (VkDeviceSize)p_buffer->size;
-    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_buffer->vk_buffer, 1, &region);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
-    tr_end_cmd(p_cmd);
+            if (p_batch->copy_count == p_batch->copy_capacity) {
+                p_batch->copy_capacity = tr_max(2 * p_batch->copy_capacity, 16);
+                p_batch->copy_textures = (uint32_t*)realloc(p_batch->copy_textures, p_batch->copy_capacity * sizeof(*(p_batch->copy_textures)));
+                p_batch->copy_mips = (uint32_t*)realloc(p_batch->copy_mips, p_batch->copy_capacity * sizeof(*(p_batch->copy_mips)));
+                assert((NULL != p_batch->copy_textures) && (NULL != p_batch->copy_mips));
+            }
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-    tr_queue_wait_idle(p_queue);
+            const uint8_t* p_level_src_data = p_streamed->p_src_data;
+            for (uint32_t level = 0; level < mip_level; ++level) {
+                p_level_src_data += tr_util_format_level_size(p_texture->format, tr_max(p_texture->width >> level, 1), tr_max(p_texture->height >> level, 1));
+            }
+            memcpy((uint8_t*)p_batch->staging->cpu_mapped_address + offset, p_level_src_data, (size_t)level_size);
 
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+            VkBufferImageCopy region = tr_util_vk_mip_copy_region(p_texture, mip_level, 0, offset);
+            tr_internal_vk_cmd_image_transition(p_batch->cmd, p_texture, mip_level, 1, tr_texture_usage_transfer_dst);
+            vkCmdCopyBufferToImage(p_batch->cmd->vk_cmd_buf, p_batch->staging->vk_buffer, p_texture->vk_image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            tr_internal_vk_cmd_image_transition(p_batch->cmd, p_texture, mip_level, 1, tr_texture_usage_sampled_image);
 
-    tr_destroy_buffer(p_buffer->renderer, buffer);
+            p_batch->copy_textures[p_batch->copy_count] = i;
+            p_batch->copy_mips[p_batch->copy_count] = mip_level;
+            ++p_batch->copy_count;
+            p_streamed->streamed_mip = mip_level;
+            p_streamer->resident_bytes += level_size;
+            batch_bytes = offset + level_size;
+            progress = true;
+        }
+    }
+
+    if (0 == p_batch->copy_count) {
+        return false;
+    }
+
+    p_streamer->renderer->frame_stats.upload_bytes += batch_bytes;
+    tr_end_cmd(p_batch->cmd);
+    tr_internal_vk_queue_submit(p_streamer->queue, 1, &(p_batch->cmd), 0, NULL, 0, NULL, p_batch->fence);
+    p_batch->pending = true;
+    return true;
 }
 
-void tr_util_update_buffer(tr_queue* p_queue, uint64_t size, const void* p_src_data, tr_buffer* p_buffer)
+void tr_create_texture_loader(tr_renderer* p_renderer, tr_queue* p_queue, uint32_t thread_count, uint64_t batch_byte_budget, tr_image_decode_uint8_fn decode_fn, tr_image_free_uint8_fn free_fn, void* p_user_data, tr_texture_loader** pp_loader)
 {
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
     assert(NULL != p_queue);
-    assert(NULL != p_src_data);
-    assert(NULL != p_buffer);
-    assert(NULL != p_buffer->vk_buffer);
-    assert(p_buffer->size >= size);
+    assert(batch_byte_budget > 0);
+    assert(NULL != decode_fn);
+    assert(NULL != free_fn);
+
+    tr_texture_loader* p_loader = (tr_texture_loader*)calloc(1, sizeof(*p_loader));
+    assert(NULL != p_loader);
+
+    p_loader->renderer    = p_renderer;
+    p_loader->queue       = p_queue;
+    p_loader->decode_fn   = decode_fn;
+    p_loader->free_fn     = free_fn;
+    p_loader->p_user_data = p_user_data;
+
+    // Workers fill the open batch while the others are in flight
+    p_loader->batch_count = tr_max(p_renderer->settings.swapchain.image_count, 2);
+    p_loader->batches = (tr_texture_load_batch*)calloc(p_loader->batch_count, sizeof(*(p_loader->batches)));
+    assert(NULL != p_loader->batches);
+    for (uint32_t i = 0; i < p_loader->batch_count; ++i) {
+        tr_texture_load_batch* p_batch = &(p_loader->batches[i]);
+        tr_create_fence(p_renderer, &(p_batch->fence));
+        tr_create_cmd_pool(p_renderer, p_queue, false, &(p_batch->cmd_pool));
+        tr_create_cmd(p_batch->cmd_pool, false, &(p_batch->cmd));
+        tr_create_buffer(p_renderer, tr_buffer_usage_transfer_src, batch_byte_budget, true, &(p_batch->staging));
+    }
+
+    p_loader->sync = (tr_internal_texture_loader_sync*)calloc(1, sizeof(*(p_loader->sync)));
+    assert(NULL != p_loader->sync);
+#if defined(TINY_RENDERER_LINUX) || defined(TINY_RENDERER_MSW)
+    p_loader->thread_count = (0 != thread_count) ? thread_count : tr_internal_cpu_count();
+  #if defined(TINY_RENDERER_LINUX)
+    pthread_mutex_init(&(p_loader->sync->mutex), NULL);
+    pthread_cond_init(&(p_loader->sync->job_cond), NULL);
+    pthread_cond_init(&(p_loader->sync->staging_cond), NULL);
+    p_loader->sync->threads = (pthread_t*)calloc(p_loader->thread_count, sizeof(*(p_loader->sync->threads)));
+  #else
+    InitializeCriticalSection(&(p_loader->sync->mutex));
+    InitializeConditionVariable(&(p_loader->sync->job_cond));
+    InitializeConditionVariable(&(p_loader->sync->staging_cond));
+    p_loader->sync->threads = (HANDLE*)calloc(p_loader->thread_count, sizeof(*(p_loader->sync->threads)));
+  #endif
+    assert(NULL != p_loader->sync->threads);
+    for (uint32_t i = 0; i < p_loader->thread_count; ++i) {
+  #if defined(TINY_RENDERER_LINUX)
+        int res = pthread_create(&(p_loader->sync->threads[i]), NULL, tr_internal_texture_loader_thread_proc, p_loader);
+        assert(0 == res);
+  #else
+        p_loader->sync->threads[i] = CreateThread(NULL, 0, tr_internal_texture_loader_thread_proc, p_loader, 0, NULL);
+        assert(NULL != p_loader->sync->threads[i]);
+  #endif
+    }
+#else
+    (void)thread_count;
+#endif
 
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_buffer->renderer, tr_buffer_usage_transfer_src, size, true, &buffer);
-    memcpy(buffer->cpu_mapped_address, p_src_data, size);
-    
-    tr_cmd_pool* p_cmd_pool = NULL;
-    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+    *pp_loader = p_loader;
+}
 
-    tr_cmd* p_cmd = NULL;
-    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+void tr_destroy_texture_loader(tr_renderer* p_renderer, tr_texture_loader* p_loader)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_loader);
 
-    tr_begin_cmd(p_cmd);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->usage, tr_buffer_usage_transfer_dst);
-    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
-    region.srcOffset = 0;
-    region.dstOffset = 0;
-    region.size      = (VkDeviceSize)size;
-    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_buffer->vk_buffer, 1, &region);
-    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst, p_buffer->usage);
-    tr_end_cmd(p_cmd);
+    tr_internal_texture_loader_lock(p_loader);
+    p_loader->quit = true;
+    tr_internal_texture_loader_wake(p_loader, false);
+    tr_internal_texture_loader_wake(p_loader, true);
+    tr_internal_texture_loader_unlock(p_loader);
 
-    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    for (uint32_t i = 0; i < p_loader->thread_count; ++i) {
+#if defined(TINY_RENDERER_LINUX)
+        pthread_join(p_loader->sync->threads[i], NULL);
+#elif defined(TINY_RENDERER_MSW)
+        WaitForSingleObject(p_loader->sync->threads[i], INFINITE);
+        CloseHandle(p_loader->sync->threads[i]);
+#endif
+    }
+
+    // Textures of loads that never became ready were never handed out
+    for (uint32_t i = 0; i < p_loader->batch_count; ++i) {
+        tr_texture_load_batch* p_batch = &(p_loader->batches[i]);
+        if (p_batch->pending) {
+            tr_wait_for_fences(p_renderer, 1, &(p_batch->fence));
+            for (uint32_t j = 0; j < p_batch->load_count; ++j) {
+                tr_destroy_texture(p_renderer, p_batch->loads[j]->texture);
+                p_batch->loads[j]->texture = NULL;
+            }
+        }
+        tr_destroy_buffer(p_renderer, p_batch->staging);
+        tr_destroy_cmd(p_batch->cmd_pool, p_batch->cmd);
+        tr_destroy_cmd_pool(p_renderer, p_batch->cmd_pool);
+        tr_destroy_fence(p_renderer, p_batch->fence);
+        TINY_RENDERER_SAFE_FREE(p_batch->loads);
+    }
+
+    for (uint32_t i = 0; i < p_loader->load_count; ++i) {
+        tr_texture_load* p_load = p_loader->loads[i];
+        if (NULL != p_load->p_decoded_data) {
+            p_loader->free_fn(p_load->p_decoded_data, p_loader->p_user_data);
+        }
+        TINY_RENDERER_SAFE_FREE(p_load->file_path);
+        TINY_RENDERER_SAFE_FREE(p_load);
+    }
+
+#if defined(TINY_RENDERER_LINUX)
+    pthread_cond_destroy(&(p_loader->sync->staging_cond));
+    pthread_cond_destroy(&(p_loader->sync->job_cond));
+    pthread_mutex_destroy(&(p_loader->sync->mutex));
+    TINY_RENDERER_SAFE_FREE(p_loader->sync->threads);
+#elif defined(TINY_RENDERER_MSW)
+    DeleteCriticalSection(&(p_loader->sync->mutex));
+    TINY_RENDERER_SAFE_FREE(p_loader->sync->threads);
+#endif
+    TINY_RENDERER_SAFE_FREE(p_loader->sync);
+    TINY_RENDERER_SAFE_FREE(p_loader->batches);
+    TINY_RENDERER_SAFE_FREE(p_loader->loads);
+    TINY_RENDERER_SAFE_FREE(p_loader);
+}
+
+tr_texture_load* tr_texture_loader_load(tr_texture_loader* p_loader, const char* file_path, tr_format format, tr_texture_usage_flags usage, bool generate_mips)
+{
+    assert(NULL != p_loader);
+    assert(NULL != file_path);
+    assert((! tr_util_format_is_compressed(format)) && (tr_util_format_stride(format) == tr_util_format_channel_count(format)));
+
+    tr_texture_load* p_load = (tr_texture_load*)calloc(1, sizeof(*p_load));
+    assert(NULL != p_load);
+
+    size_t file_path_size = strlen(file_path) + 1;
+    p_load->file_path = (char*)malloc(file_path_size);
+    assert(NULL != p_load->file_path);
+    memcpy(p_load->file_path, file_path, file_path_size);
+    p_load->state         = tr_texture_load_state_pending;
+    p_load->format        = format;
+    p_load->usage         = usage | tr_texture_usage_sampled_image;
+    p_load->generate_mips = generate_mips;
+
+    if (p_loader->load_count == p_loader->load_capacity) {
+        p_loader->load_capacity = tr_max(2 * p_loader->load_capacity, 16);
+        p_loader->loads = (tr_texture_load**)realloc(p_loader->loads, p_loader->load_capacity * sizeof(*(p_loader->loads)));
+        assert(NULL != p_loader->loads);
+    }
+    p_loader->loads[p_loader->load_count++] = p_load;
+    ++p_loader->pending_count;
+
+    tr_internal_texture_loader_lock(p_loader);
+    if (NULL == p_loader->job_tail) {
+        p_loader->job_head = p_load;
+    }
+    else {
+        p_loader->job_tail->next = p_load;
+    }
+    p_loader->job_tail = p_load;
+    tr_internal_texture_loader_wake(p_loader, false);
+    tr_internal_texture_loader_unlock(p_loader);
+
+    return p_load;
+}
+
+bool tr_texture_loader_update(tr_texture_loader* p_loader)
+{
+    assert(NULL != p_loader);
+
+    TINY_RENDERER_TRACE_BEGIN(p_loader->renderer);
+
+    // Without workers everything that's queued is decoded here
+    if (0 == p_loader->thread_count) {
+        while (NULL != p_loader->job_head) {
+            tr_texture_load* p_load = tr_internal_texture_loader_pop_job(p_loader);
+            tr_internal_texture_loader_decode(p_loader, p_load, false);
+        }
+    }
+
+    tr_internal_texture_loader_lock(p_loader);
+
+    bool loads_changed = false;
+    for (uint32_t i = 0; i < p_loader->batch_count; ++i) {
+        loads_changed |= tr_internal_complete_load_batch(p_loader, &(p_loader->batches[i]), false);
+    }
+
+    // Closing the open batch moves workers on to the next one, it's
+    // submitted as soon as the workers still writing into it are done.
+    tr_texture_load_batch* p_open = &(p_loader->batches[p_loader->batch_index]);
+    if ((p_open->load_count > 0) && (! p_open->closed) && (! p_open->pending)) {
+        p_open->closed = true;
+        p_loader->batch_index = (p_loader->batch_index + 1) % p_loader->batch_count;
+        tr_internal_texture_loader_wake(p_loader, true);
+    }
+    for (uint32_t i = 0; i < p_loader->batch_count; ++i) {
+        tr_texture_load_batch* p_batch = &(p_loader->batches[i]);
+        if (p_batch->closed && (0 == p_batch->writer_count)) {
+            tr_internal_submit_load_batch(p_loader, p_batch);
+        }
+    }
+
+    tr_texture_load* p_unbatched = p_loader->unbatched_head;
+    p_loader->unbatched_head = NULL;
+
+    tr_internal_texture_loader_unlock(p_loader);
+
+    // Failures and loads too large for a batch's staging buffer, the large ones block
+    while (NULL != p_unbatched) {
+        tr_texture_load* p_load = p_unbatched;
+        p_unbatched = p_load->next;
+        if (p_load->decode_failed) {
+            p_load->state = tr_texture_load_state_failed;
+        }
+        else {
+            tr_create_texture_2d(p_loader->renderer, p_load->width, p_load->height, tr_sample_count_1, p_load->format, p_load->mip_levels, NULL, false, p_load->usage, &(p_load->texture));
+            tr_util_update_texture_uint8(p_loader->queue, p_load->width, p_load->height, p_load->width * p_load->decoded_channel_count, p_load->p_decoded_data, p_load->decoded_channel_count, p_load->texture, NULL, NULL);
+            p_loader->free_fn(p_load->p_decoded_data, p_loader->p_user_data);
+            p_load->p_decoded_data = NULL;
+            p_load->state = tr_texture_load_state_ready;
+        }
+        --p_loader->pending_count;
+        loads_changed = true;
+    }
+
+    TINY_RENDERER_TRACE_END(p_loader->renderer);
+
+    return loads_changed;
+}
+
+bool tr_texture_loader_is_done(tr_texture_loader* p_loader)
+{
+    assert(NULL != p_loader);
+
+    return (0 == p_loader->pending_count);
+}
+
+#if defined(TINY_RENDERER_LINUX)
+static void* tr_internal_texture_loader_thread_proc(void* p_param)
+{
+    tr_internal_texture_loader_work((tr_texture_loader*)p_param);
+    return NULL;
+}
+#elif defined(TINY_RENDERER_MSW)
+static DWORD WINAPI tr_internal_texture_loader_thread_proc(LPVOID p_param)
+{
+    tr_internal_texture_loader_work((tr_texture_loader*)p_param);
+    return 0;
+}
+#endif
+
+void tr_internal_texture_loader_lock(tr_texture_loader* p_loader)
+{
+#if defined(TINY_RENDERER_LINUX)
+    pthread_mutex_lock(&(p_loader->sync->mutex));
+#elif defined(TINY_RENDERER_MSW)
+    EnterCriticalSection(&(p_loader->sync->mutex));
+#else
+    (void)p_loader;
+#endif
+}
+
+void tr_internal_texture_loader_unlock(tr_texture_loader* p_loader)
+{
+#if defined(TINY_RENDERER_LINUX)
+    pthread_mutex_unlock(&(p_loader->sync->mutex));
+#elif defined(TINY_RENDERER_MSW)
+    LeaveCriticalSection(&(p_loader->sync->mutex));
+#else
+    (void)p_loader;
+#endif
+}
+
+void tr_internal_texture_loader_wait(tr_texture_loader* p_loader, bool staging)
+{
+#if defined(TINY_RENDERER_LINUX)
+    pthread_cond_wait(staging ? &(p_loader->sync->staging_cond) : &(p_loader->sync->job_cond), &(p_loader->sync->mutex));
+#elif defined(TINY_RENDERER_MSW)
+    SleepConditionVariableCS(staging ? &(p_loader->sync->staging_cond) : &(p_loader->sync->job_cond), &(p_loader->sync->mutex), INFINITE);
+#else
+    (void)p_loader;
+    (void)staging;
+#endif
+}
+
+void tr_internal_texture_loader_wake(tr_texture_loader* p_loader, bool staging)
+{
+#if defined(TINY_RENDERER_LINUX)
+    pthread_cond_broadcast(staging ? &(p_loader->sync->staging_cond) : &(p_loader->sync->job_cond));
+#elif defined(TINY_RENDERER_MSW)
+    WakeAllConditionVariable(staging ? &(p_loader->sync->staging_cond) : &(p_loader->sync->job_cond));
+#else
+    (void)p_loader;
+    (void)staging;
+#endif
+}
+
+tr_texture_load* tr_internal_texture_loader_pop_job(tr_texture_loader* p_loader)
+{
+    tr_internal_texture_loader_lock(p_loader);
+    tr_texture_load* p_load = p_loader->job_head;
+    if (NULL != p_load) {
+        p_loader->job_head = p_load->next;
+        if (NULL == p_loader->job_head) {
+            p_loader->job_tail = NULL;
+        }
+        p_load->next = NULL;
+    }
+    tr_internal_texture_loader_unlock(p_loader);
+    return p_load;
+}
+
+void tr_internal_texture_loader_work(tr_texture_loader* p_loader)
+{
+    tr_internal_texture_loader_lock(p_loader);
+    while (! p_loader->quit) {
+        if (NULL == p_loader->job_head) {
+            tr_internal_texture_loader_wait(p_loader, false);
+            continue;
+        }
+        tr_internal_texture_loader_unlock(p_loader);
+
+        tr_texture_load* p_load = tr_internal_texture_loader_pop_job(p_loader);
+        if (NULL != p_load) {
+            tr_internal_texture_loader_decode(p_loader, p_load, true);
+        }
+
+        tr_internal_texture_loader_lock(p_loader);
+    }
+    tr_internal_texture_loader_unlock(p_loader);
+}
+
+void tr_internal_texture_loader_decode(tr_texture_loader* p_loader, tr_texture_load* p_load, bool wait_for_staging)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t channel_count = 0;
+    uint8_t* p_texels = p_loader->decode_fn(p_load->file_path, &width, &height, &channel_count, p_loader->p_user_data);
+    const bool decoded = (NULL != p_texels) && (width > 0) && (height > 0) && (channel_count > 0) &&
+                         (channel_count <= tr_util_format_channel_count(p_load->format));
+    if ((! decoded) && (NULL != p_texels)) {
+        p_loader->free_fn(p_texels, p_loader->p_user_data);
+        p_texels = NULL;
+    }
+
+    // Levels are 16 byte aligned in staging, like the streamer's
+    if (decoded) {
+        p_load->width = width;
+        p_load->height = height;
+        p_load->mip_levels = p_load->generate_mips ? tr_util_calc_mip_levels(width, height) : 1;
+        p_load->staging_size = 0;
+        for (uint32_t mip_level = 0; mip_level < p_load->mip_levels; ++mip_level) {
+            uint64_t level_size = tr_util_format_level_size(p_load->format, tr_max(width >> mip_level, 1), tr_max(height >> mip_level, 1));
+            p_load->staging_size += (level_size + 15) & ~((uint64_t)15);
+        }
+    }
+
+    tr_internal_texture_loader_lock(p_loader);
+
+    // Every staging buffer is the same size, loads that fit wait for the open batch to have room
+    tr_texture_load_batch* p_batch = NULL;
+    while (decoded && (! p_loader->quit) && (p_load->staging_size <= p_loader->batches[0].staging->size)) {
+        tr_texture_load_batch* p_open = &(p_loader->batches[p_loader->batch_index]);
+        if ((! p_open->closed) && (! p_open->pending) && ((p_open->staging_used + p_load->staging_size) <= p_open->staging->size)) {
+            p_batch = p_open;
+            break;
+        }
+        if (! wait_for_staging) {
+            break;
+        }
+        tr_internal_texture_loader_wait(p_loader, true);
+    }
+
+    if (NULL == p_batch) {
+        if (decoded) {
+            p_load->p_decoded_data = p_texels;
+            p_load->decoded_channel_count = channel_count;
+        }
+        else {
+            p_load->decode_failed = true;
+        }
+        p_load->next = p_loader->unbatched_head;
+        p_loader->unbatched_head = p_load;
+        tr_internal_texture_loader_unlock(p_loader);
+        return;
+    }
+
+    if (p_batch->load_count == p_batch->load_capacity) {
+        p_batch->load_capacity = tr_max(2 * p_batch->load_capacity, 16);
+        p_batch->loads = (tr_texture_load**)realloc(p_batch->loads, p_batch->load_capacity * sizeof(*(p_batch->loads)));
+        assert(NULL != p_batch->loads);
+    }
+    p_batch->loads[p_batch->load_count++] = p_load;
+    p_load->staging_offset = p_batch->staging_used;
+    p_batch->staging_used += p_load->staging_size;
+    ++p_batch->writer_count;
+    uint8_t* p_staging_data = (uint8_t*)p_batch->staging->cpu_mapped_address + p_load->staging_offset;
+
+    tr_internal_texture_loader_unlock(p_loader);
+
+    tr_internal_fill_load_staging(p_load, p_texels, channel_count, p_staging_data);
+    p_loader->free_fn(p_texels, p_loader->p_user_data);
+
+    tr_internal_texture_loader_lock(p_loader);
+    --p_batch->writer_count;
+    tr_internal_texture_loader_unlock(p_loader);
+}
+
+void tr_internal_fill_load_staging(const tr_texture_load* p_load, const uint8_t* p_src_data, uint32_t src_channel_count, uint8_t* p_dst_data)
+{
+    const uint32_t channel_count = tr_util_format_channel_count(p_load->format);
+    const uint32_t width = p_load->width;
+    const uint32_t height = p_load->height;
+
+    // A single level is expanded straight into staging, otherwise the mip chain is built from a
+    // cached copy since staging memory is slow to read back.
+    uint8_t* p_expanded_data = NULL;
+    if (src_channel_count != channel_count) {
+        uint8_t* p_expanded_dst_data = p_dst_data;
+        if (p_load->mip_levels > 1) {
+            p_expanded_data = (uint8_t*)malloc((size_t)width * height * channel_count);
+            assert(NULL != p_expanded_data);
+            p_expanded_dst_data = p_expanded_data;
+        }
+        for (uint32_t y = 0; y < height; ++y) {
+            tr_internal_expand_channels_row(p_expanded_dst_data + ((size_t)y * width * channel_count), p_src_data + ((size_t)y * width * src_channel_count),
+                                            width, src_channel_count, channel_count);
+        }
+        if (NULL == p_expanded_data) {
+            return;
+        }
+        p_src_data = p_expanded_data;
+    }
+
+    // Levels are 16 byte aligned in staging
+    tr_internal_mip_chain_level* p_levels = (tr_internal_mip_chain_level*)calloc(p_load->mip_levels, sizeof(*p_levels));
+    assert(NULL != p_levels);
+    uint64_t offset = 0;
+    for (uint32_t mip_level = 0; mip_level < p_load->mip_levels; ++mip_level) {
+        p_levels[mip_level].width      = tr_max(width >> mip_level, 1);
+        p_levels[mip_level].height     = tr_max(height >> mip_level, 1);
+        p_levels[mip_level].row_stride = p_levels[mip_level].width * channel_count;
+        p_levels[mip_level].p_data     = p_dst_data + offset;
+        offset += (uint64_t)p_levels[mip_level].row_stride * p_levels[mip_level].height;
+        offset = (offset + 15) & ~((uint64_t)15);
+    }
+
+    // Each level is filtered from the previous one in cached scratch memory, single
+    // threaded since the workers already use every CPU.
+    TINY_RENDERER_DECLARE_ZERO(tr_image_resize_settings, settings);
+    settings.filter       = tr_image_filter_auto;
+    settings.thread_count = 1;
+    tr_internal_resize_mip_chain_uint8(width, height, width * channel_count, p_src_data, channel_count, p_load->mip_levels, p_levels, &settings);
+
+    TINY_RENDERER_SAFE_FREE(p_levels);
+    TINY_RENDERER_SAFE_FREE(p_expanded_data);
+}
+
+bool tr_internal_complete_load_batch(tr_texture_loader* p_loader, tr_texture_load_batch* p_batch, bool wait)
+{
+    if (! p_batch->pending) {
+        return false;
+    }
+
+    if (wait) {
+        tr_wait_for_fences(p_loader->renderer, 1, &(p_batch->fence));
+    }
+    else if (! tr_get_fence_status(p_loader->renderer, p_batch->fence)) {
+        return false;
+    }
+    p_batch->pending = false;
+
+    for (uint32_t i = 0; i < p_batch->load_count; ++i) {
+        p_batch->loads[i]->state = tr_texture_load_state_ready;
+        --p_loader->pending_count;
+    }
+    bool loads_changed = (p_batch->load_count > 0);
+    p_batch->load_count = 0;
+    p_batch->staging_used = 0;
+    tr_internal_texture_loader_wake(p_loader, true);
+
+    return loads_changed;
+}
+
+void tr_internal_submit_load_batch(tr_texture_loader* p_loader, tr_texture_load_batch* p_batch)
+{
+    tr_reset_fences(p_loader->renderer, 1, &(p_batch->fence));
+    tr_begin_cmd(p_batch->cmd);
+
+    for (uint32_t i = 0; i < p_batch->load_count; ++i) {
+        tr_texture_load* p_load = p_batch->loads[i];
+        tr_create_texture_2d(p_loader->renderer, p_load->width, p_load->height, tr_sample_count_1, p_load->format, p_load->mip_levels, NULL, false, p_load->usage, &(p_load->texture));
+
+        // Creation can clamp the mip levels, only the ones that exist are copied
+        tr_texture* p_texture = p_load->texture;
+        tr_internal_vk_cmd_image_transition(p_batch->cmd, p_texture, 0, p_texture->mip_levels, tr_texture_usage_transfer_dst);
+        uint64_t buffer_offset = p_load->staging_offset;
+        for (uint32_t mip_level = 0; mip_level < p_texture->mip_levels; ++mip_level) {
+            VkBufferImageCopy region = tr_util_vk_mip_copy_region(p_texture, mip_level, 0, buffer_offset);
+            vkCmdCopyBufferToImage(p_batch->cmd->vk_cmd_buf, p_batch->staging->vk_buffer, p_texture->vk_image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            uint64_t level_size = tr_util_format_level_size(p_texture->format, region.imageExtent.width, region.imageExtent.height);
+            buffer_offset += (level_size + 15) & ~((uint64_t)15);
+        }
+        tr_internal_vk_cmd_image_transition(p_batch->cmd, p_texture, 0, p_texture->mip_levels, tr_texture_usage_sampled_image);
+    }
+
+    p_loader->renderer->frame_stats.upload_bytes += p_batch->staging_used;
+    tr_end_cmd(p_batch->cmd);
+    tr_internal_vk_queue_submit(p_loader->queue, 1, &(p_batch->cmd), 0, NULL, 0, NULL, p_batch->fence);
+    p_batch->closed = false;
+    p_batch->pending = true;
+}
+
+void tr_create_query_pool(tr_renderer* p_renderer, tr_query_type type, uint32_t query_count, tr_query_pool** pp_query_pool)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(query_count > 0);
+
+    tr_query_pool* p_query_pool = (tr_query_pool*)calloc(1, sizeof(*p_query_pool));
+    assert(NULL != p_query_pool);
+
+    p_query_pool->renderer    = p_renderer;
+    p_query_pool->type        = type;
+    p_query_pool->query_count = query_count;
+
+    if (tr_query_type_timestamp == type) {
+        p_query_pool->timer_names = (const char**)calloc((query_count + 1) / 2, sizeof(*(p_query_pool->timer_names)));
+        assert(NULL != p_query_pool->timer_names);
+    }
+
+    tr_internal_vk_create_query_pool(p_renderer, p_query_pool);
+
+    *pp_query_pool = p_query_pool;
+}
+
+void tr_destroy_query_pool(tr_renderer* p_renderer, tr_query_pool* p_query_pool)
+{
+    TINY_RENDERER_RENDERER_PTR_CHECK(p_renderer);
+    assert(NULL != p_query_pool);
+
+    tr_internal_vk_destroy_query_pool(p_renderer, p_query_pool);
+
+    TINY_RENDERER_SAFE_FREE(p_query_pool->timer_names);
+    TINY_RENDERER_SAFE_FREE(p_query_pool);
+}
+
+bool tr_get_query_pool_results(tr_query_pool* p_query_pool, uint32_t first_query, uint32_t query_count, uint64_t* p_results)
+{
+    assert(NULL != p_query_pool);
+    assert(NULL != p_results);
+    assert((first_query + query_count) <= p_query_pool->query_count);
+
+    // Queries that were never reset have no results
+    if (! p_query_pool->reset) {
+        return false;
+    }
+
+    size_t stride = p_query_pool->value_count * sizeof(*p_results);
+    VkResult vk_res = vkGetQueryPoolResults(p_query_pool->renderer->vk_device, p_query_pool->vk_query_pool, 
+                                            first_query, query_count, query_count * stride, p_results, 
+                                            stride, VK_QUERY_RESULT_64_BIT);
+    assert((VK_SUCCESS == vk_res) || (VK_NOT_READY == vk_res));
+    return VK_SUCCESS == vk_res;
+}
+
+bool tr_get_timer_results(tr_query_pool* p_query_pool, uint32_t timer_count, double* p_timer_ms)
+{
+    assert(NULL != p_query_pool);
+    assert(tr_query_type_timestamp == p_query_pool->type);
+    assert(NULL != p_timer_ms);
+    assert((2 * timer_count) <= p_query_pool->query_count);
+
+    uint64_t* timestamps = (uint64_t*)calloc(2 * timer_count, sizeof(*timestamps));
+    assert(NULL != timestamps);
+
+    bool ready = tr_get_query_pool_results(p_query_pool, 0, 2 * timer_count, timestamps);
+    if (ready) {
+        // timestampPeriod is the number of nanoseconds per tick
+        double ms_per_tick = (double)p_query_pool->renderer->vk_active_gpu_properties.limits.timestampPeriod / 1000000.0;
+        for (uint32_t i = 0; i < timer_count; ++i) {
+            uint64_t ticks = (timestamps[2 * i + 1] - timestamps[2 * i]) & p_query_pool->timestamp_mask;
+            p_timer_ms[i] = (double)ticks * ms_per_tick;
+        }
+
+        // Each set of results goes into the trace once
+        tr_trace* p_trace = p_query_pool->renderer->trace;
+        if ((NULL != p_trace) && (! p_query_pool->traced)) {
+            for (uint32_t i = 0; i < timer_count; ++i) {
+                uint64_t begin_ticks = timestamps[2 * i] & p_query_pool->timestamp_mask;
+                double begin_us = ((double)begin_ticks * p_trace->gpu_us_per_tick) + p_trace->gpu_offset_us;
+                const char* name = (NULL != p_query_pool->timer_names[i]) ? p_query_pool->timer_names[i] : "GPU timer";
+                tr_internal_trace_add_event(p_trace, name, tr_trace_thread_gpu, begin_us, p_timer_ms[i] * 1000.0);
+            }
+            p_query_pool->traced = true;
+        }
+    }
+
+    TINY_RENDERER_SAFE_FREE(timestamps);
+
+    return ready;
+}
+
+void tr_set_timer_name(tr_query_pool* p_query_pool, uint32_t timer_index, const char* name)
+{
+    assert(NULL != p_query_pool);
+    assert(tr_query_type_timestamp == p_query_pool->type);
+    assert((2 * timer_index + 1) < p_query_pool->query_count);
+
+    p_query_pool->timer_names[timer_index] = name;
+}
+
+bool tr_get_pipeline_statistics_results(tr_query_pool* p_query_pool, uint32_t query_count, tr_pipeline_statistics* p_statistics)
+{
+    assert(NULL != p_query_pool);
+    assert(tr_query_type_pipeline_statistics == p_query_pool->type);
+    assert(NULL != p_statistics);
+
+    uint64_t* values = (uint64_t*)calloc((size_t)query_count * p_query_pool->value_count, sizeof(*values));
+    assert(NULL != values);
+
+    bool ready = tr_get_query_pool_results(p_query_pool, 0, query_count, values);
+    if (ready) {
+        // Statistics the pool doesn't collect are left out of the results, spread the rest into place
+        const uint32_t field_count = sizeof(tr_pipeline_statistics) / sizeof(uint64_t);
+        const uint64_t* p_values = values;
+        for (uint32_t i = 0; i < query_count; ++i) {
+            uint64_t* p_fields = (uint64_t*)&p_statistics[i];
+            for (uint32_t field = 0; field < field_count; ++field) {
+                p_fields[field] = (p_query_pool->vk_pipeline_statistics & (1u << field)) ? *(p_values++) : 0;
+            }
+        }
+    }
+
+    TINY_RENDERER_SAFE_FREE(values);
+
+    return ready;
+}
+
+void tr_render_target_set_color_clear_value(tr_render_target* p_render_target, uint32_t attachment_index, float r, float g, float b, float a)
+{
+    assert(NULL != p_render_target);
+    assert(attachment_index < p_render_target->color_attachment_count);
+
+    p_render_target->color_attachments[attachment_index]->clear_value.r = r;
+    p_render_target->color_attachments[attachment_index]->clear_value.g = g;
+    p_render_target->color_attachments[attachment_index]->clear_value.b = b;
+    p_render_target->color_attachments[attachment_index]->clear_value.a = a;
+}
+
+void tr_render_target_set_depth_stencil_clear_value(tr_render_target* p_render_target, float depth, uint8_t stencil)
+{
+    assert(NULL != p_render_target);
+
+    p_render_target->depth_stencil_attachment->clear_value.depth = depth;
+    p_render_target->depth_stencil_attachment->clear_value.stencil = stencil;
+}
+
+void tr_render_target_set_color_load_store_ops(tr_render_target* p_render_target, uint32_t attachment_index, tr_attachment_load_op load_op, tr_attachment_store_op store_op)
+{
+    assert(NULL != p_render_target);
+    assert(attachment_index < p_render_target->color_attachment_count);
+
+    p_render_target->color_load_ops[attachment_index] = load_op;
+    p_render_target->color_store_ops[attachment_index] = store_op;
+
+    bool is_swapchain = (tr_texture_usage_present == (p_render_target->color_attachments[0]->usage & tr_texture_usage_present));
+    tr_internal_vk_destroy_render_target(p_render_target->renderer, p_render_target);
+    tr_internal_vk_create_render_target(p_render_target->renderer, is_swapchain, p_render_target);
+}
+
+void tr_render_target_set_depth_stencil_load_store_ops(tr_render_target* p_render_target, tr_attachment_load_op depth_load_op, tr_attachment_store_op depth_store_op, tr_attachment_load_op stencil_load_op, tr_attachment_store_op stencil_store_op)
+{
+    assert(NULL != p_render_target);
+    assert(tr_format_undefined != p_render_target->depth_stencil_format);
+
+    p_render_target->depth_load_op = depth_load_op;
+    p_render_target->depth_store_op = depth_store_op;
+    p_render_target->stencil_load_op = stencil_load_op;
+    p_render_target->stencil_store_op = stencil_store_op;
+
+    bool is_swapchain = (p_render_target->color_attachment_count > 0) && 
+                        (tr_texture_usage_present == (p_render_target->color_attachments[0]->usage & tr_texture_usage_present));
+    tr_internal_vk_destroy_render_target(p_render_target->renderer, p_render_target);
+    tr_internal_vk_create_render_target(p_render_target->renderer, is_swapchain, p_render_target);
+}
+
+bool tr_vertex_layout_support_format(tr_format format)
+{
+    bool result = false;
+    switch (format) {
+        // 1 channel
+        case tr_format_r8_unorm            : result = true; break;
+        case tr_format_r16_unorm           : result = true; break;
+        case tr_format_r16_float           : result = true; break;
+        case tr_format_r32_uint            : result = true; break;
+        case tr_format_r32_float           : result = true; break;
+        // 2 channel
+        case tr_format_r8g8_unorm          : result = true; break;
+        case tr_format_r16g16_unorm        : result = true; break;
+        case tr_format_r16g16_float        : result = true; break;
+        case tr_format_r32g32_uint         : result = true; break;
+        case tr_format_r32g32_float        : result = true; break;
+        // 3 channel
+        case tr_format_r8g8b8_unorm        : result = true; break;
+        case tr_format_r16g16b16_unorm     : result = true; break;
+        case tr_format_r16g16b16_float     : result = true; break;
+        case tr_format_r32g32b32_uint      : result = true; break;
+        case tr_format_r32g32b32_float     : result = true; break;
+        // 4 channel
+        case tr_format_r8g8b8a8_unorm      : result = true; break;
+        case tr_format_r16g16b16a16_unorm  : result = true; break;
+        case tr_format_r16g16b16a16_float  : result = true; break;
+        case tr_format_r32g32b32a32_uint   : result = true; break;
+        case tr_format_r32g32b32a32_float  : result = true; break;
+    }
+    return result;
+}
+
+uint32_t tr_vertex_layout_stride(const tr_vertex_layout* p_vertex_layout)
+{
+    assert(NULL != p_vertex_layout);
+
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < p_vertex_layout->attrib_count; ++i) {
+        result += tr_util_format_stride(p_vertex_layout->attribs[i].format);
+    }
+    return result;
+}
+#endif // ! defined(TINY_RENDERER_IMAGE_ONLY)
+
+// -------------------------------------------------------------------------------------------------
+// Utility functions
+// -------------------------------------------------------------------------------------------------
+
+// This function always returns zero for Vulkan for now because
+// of how the counter are configured.
+uint64_t tr_util_calc_storage_counter_offset(uint64_t buffer_size)
+{
+    uint64_t result = 0;
+    return result;
+}
+
+uint32_t tr_util_calc_mip_levels(uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0)
+        return 0;
+
+    uint32_t result = 1;
+    while (width > 1 || height > 1)
+    {
+        width >>= 1;
+        height >>= 1;
+        result++;
+    }
+    return result;
+}
+
+tr_api_export VkFormat tr_util_to_vk_format(tr_format format)
+{
+    VkFormat result = VK_FORMAT_UNDEFINED;
+    switch (format) {
+        // 1 channel
+        case tr_format_r8_unorm            : result = VK_FORMAT_R8_UNORM; break;
+        case tr_format_r16_unorm           : result = VK_FORMAT_R16_UNORM; break;
+        case tr_format_r16_float           : result = VK_FORMAT_R16_SFLOAT; break;
+        case tr_format_r32_uint            : result = VK_FORMAT_R32_UINT; break;
+        case tr_format_r32_float           : result = VK_FORMAT_R32_SFLOAT; break;
+        // 2 channel
+        case tr_format_r8g8_unorm          : result = VK_FORMAT_R8G8_UNORM; break;
+        case tr_format_r16g16_unorm        : result = VK_FORMAT_R16G16_UNORM; break;
+        case tr_format_r16g16_float        : result = VK_FORMAT_R16G16_SFLOAT; break;
+        case tr_format_r32g32_uint         : result = VK_FORMAT_R32G32_UINT; break;
+        case tr_format_r32g32_float        : result = VK_FORMAT_R32G32_SFLOAT; break;
+        // 3 channel
+        case tr_format_r8g8b8_unorm        : result = VK_FORMAT_R8G8B8_UNORM; break;
+        case tr_format_r16g16b16_unorm     : result = VK_FORMAT_R16G16B16_UNORM; break;
+        case tr_format_r16g16b16_float     : result = VK_FORMAT_R16G16B16_SFLOAT; break;
+        case tr_format_r32g32b32_uint      : result = VK_FORMAT_R32G32B32_UINT; break;
+        case tr_format_r32g32b32_float     : result = VK_FORMAT_R32G32B32_SFLOAT; break;
+        // 4 channel
+        case tr_format_b8g8r8a8_unorm      : result = VK_FORMAT_B8G8R8A8_UNORM; break;
+        case tr_format_r8g8b8a8_unorm      : result = VK_FORMAT_R8G8B8A8_UNORM; break;
+        case tr_format_r16g16b16a16_unorm  : result = VK_FORMAT_R16G16B16A16_UNORM; break;
+        case tr_format_r16g16b16a16_float  : result = VK_FORMAT_R16G16B16A16_SFLOAT; break;
+        case tr_format_r32g32b32a32_uint   : result = VK_FORMAT_R32G32B32A32_UINT; break;
+        case tr_format_r32g32b32a32_float  : result = VK_FORMAT_R32G32B32A32_SFLOAT; break;
+        // Depth/stencil
+        case tr_format_d16_unorm           : result = VK_FORMAT_D16_UNORM; break;
+        case tr_format_x8_d24_unorm_pack32 : result = VK_FORMAT_X8_D24_UNORM_PACK32; break;
+        case tr_format_d32_float           : result = VK_FORMAT_D32_SFLOAT; break;
+        case tr_format_s8_uint             : result = VK_FORMAT_S8_UINT; break;
+        case tr_format_d16_unorm_s8_uint   : result = VK_FORMAT_D16_UNORM_S8_UINT; break;
+        case tr_format_d24_unorm_s8_uint   : result = VK_FORMAT_D24_UNORM_S8_UINT; break;
+        case tr_format_d32_float_s8_uint   : result = VK_FORMAT_D32_SFLOAT_S8_UINT; break;
+        // Block compressed
+        case tr_format_bc1_rgba_unorm      : result = VK_FORMAT_BC1_RGBA_UNORM_BLOCK; break;
+        case tr_format_bc3_unorm           : result = VK_FORMAT_BC3_UNORM_BLOCK; break;
+        case tr_format_bc4_unorm           : result = VK_FORMAT_BC4_UNORM_BLOCK; break;
+        case tr_format_bc5_unorm           : result = VK_FORMAT_BC5_UNORM_BLOCK; break;
+        case tr_format_bc7_unorm           : result = VK_FORMAT_BC7_UNORM_BLOCK; break;
+    }
+    return result;
+}
+
+tr_format tr_util_from_vk_format(VkFormat format)
+{
+    tr_format result = tr_format_undefined;
+    switch (format) {
+        // 1 channel
+        case VK_FORMAT_R8_UNORM            : result = tr_format_r8_unorm; break;
+        case VK_FORMAT_R16_UNORM           : result = tr_format_r16_unorm; break;
+        case VK_FORMAT_R16_SFLOAT          : result = tr_format_r16_float; break;
+        case VK_FORMAT_R32_UINT            : result = tr_format_r32_uint; break;
+        case VK_FORMAT_R32_SFLOAT          : result = tr_format_r32_float; break;
+        // 2 channel
+        case VK_FORMAT_R8G8_UNORM          : result = tr_format_r8g8_unorm; break;
+        case VK_FORMAT_R16G16_UNORM        : result = tr_format_r16g16_unorm; break;
+        case VK_FORMAT_R16G16_SFLOAT       : result = tr_format_r16g16_float; break;
+        case VK_FORMAT_R32G32_UINT         : result = tr_format_r32g32_uint; break;
+        case VK_FORMAT_R32G32_SFLOAT       : result = tr_format_r32g32_float; break;
+        // 3 channel
+        case VK_FORMAT_R8G8B8_UNORM        : result = tr_format_r8g8b8_unorm; break;
+        case VK_FORMAT_R16G16B16_UNORM     : result = tr_format_r16g16b16_unorm; break;
+        case VK_FORMAT_R16G16B16_SFLOAT    : result = tr_format_r16g16b16_float; break;
+        case VK_FORMAT_R32G32B32_UINT      : result = tr_format_r32g32b32_uint; break;
+        case VK_FORMAT_R32G32B32_SFLOAT    : result = tr_format_r32g32b32_float; break;
+        // 4 channel
+        case VK_FORMAT_B8G8R8A8_UNORM      : result = tr_format_b8g8r8a8_unorm; break;
+        case VK_FORMAT_R8G8B8A8_UNORM      : result = tr_format_r8g8b8a8_unorm; break;
+        case VK_FORMAT_R16G16B16A16_UNORM  : result = tr_format_r16g16b16a16_unorm; break;
+        case VK_FORMAT_R16G16B16A16_SFLOAT : result = tr_format_r16g16b16a16_float; break;
+        case VK_FORMAT_R32G32B32A32_UINT   : result = tr_format_r32g32b32a32_uint; break;
+        case VK_FORMAT_R32G32B32A32_SFLOAT : result = tr_format_r32g32b32a32_float; break;
+        // Depth/stencil
+        case VK_FORMAT_D16_UNORM           : result = tr_format_d16_unorm; break;
+        case VK_FORMAT_X8_D24_UNORM_PACK32 : result = tr_format_x8_d24_unorm_pack32; break;
+        case VK_FORMAT_D32_SFLOAT          : result = tr_format_d32_float; break;
+        case VK_FORMAT_S8_UINT             : result = tr_format_s8_uint; break;
+        case VK_FORMAT_D16_UNORM_S8_UINT   : result = tr_format_d16_unorm_s8_uint; break;
+        case VK_FORMAT_D24_UNORM_S8_UINT   : result = tr_format_d24_unorm_s8_uint; break;
+        case VK_FORMAT_D32_SFLOAT_S8_UINT  : result = tr_format_d32_float_s8_uint; break;
+        // Block compressed
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK : result = tr_format_bc1_rgba_unorm; break;
+        case VK_FORMAT_BC3_UNORM_BLOCK      : result = tr_format_bc3_unorm; break;
+        case VK_FORMAT_BC4_UNORM_BLOCK      : result = tr_format_bc4_unorm; break;
+        case VK_FORMAT_BC5_UNORM_BLOCK      : result = tr_format_bc5_unorm; break;
+        case VK_FORMAT_BC7_UNORM_BLOCK      : result = tr_format_bc7_unorm; break;
+    }
+    return result;
+}
+
+VkShaderStageFlags tr_util_to_vk_shader_stages(tr_shader_stage shader_stages)
+{
+    VkShaderStageFlags result = 0;
+    if (tr_shader_stage_all_graphics == (shader_stages & tr_shader_stage_all_graphics)) {
+        result = VK_SHADER_STAGE_ALL_GRAPHICS;
+    }
+    else {
+        if (tr_shader_stage_vert == (shader_stages & tr_shader_stage_vert)) {
+            result |= VK_SHADER_STAGE_VERTEX_BIT;
+        }
+        if (tr_shader_stage_tesc == (shader_stages & tr_shader_stage_tesc)) {
+            result |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        }
+        if (tr_shader_stage_tese == (shader_stages & tr_shader_stage_tese)) {
+            result |= VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        }
+        if (tr_shader_stage_geom == (shader_stages & tr_shader_stage_geom)) {
+            result |= VK_SHADER_STAGE_GEOMETRY_BIT;
+        }
+        if (tr_shader_stage_frag == (shader_stages & tr_shader_stage_frag)) {
+            result |= VK_SHADER_STAGE_FRAGMENT_BIT;
+        }
+        if (tr_shader_stage_comp == (shader_stages & tr_shader_stage_comp)) {
+            result |= VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+    }
+    return result;
+}
+
+uint32_t tr_util_format_stride(tr_format format)
+{
+    uint32_t result = 0;
+    switch (format) {
+        // 1 channel
+        case tr_format_r8_unorm            : result = 1; break;
+        case tr_format_r16_unorm           : result = 2; break;
+        case tr_format_r16_float           : result = 2; break;
+        case tr_format_r32_uint            : result = 4; break;
+        case tr_format_r32_float           : result = 4; break;
+        // 2 channel
+        case tr_format_r8g8_unorm          : result = 2; break;
+        case tr_format_r16g16_unorm        : result = 4; break;
+        case tr_format_r16g16_float        : result = 4; break;
+        case tr_format_r32g32_uint         : result = 8; break;
+        case tr_format_r32g32_float        : result = 8; break;
+        // 3 channel
+        case tr_format_r8g8b8_unorm        : result = 3; break;
+        case tr_format_r16g16b16_unorm     : result = 6; break;
+        case tr_format_r16g16b16_float     : result = 6; break;
+        case tr_format_r32g32b32_uint      : result = 12; break;
+        case tr_format_r32g32b32_float     : result = 12; break;
+        // 4 channel
+        case tr_format_b8g8r8a8_unorm      : result = 4; break;
+        case tr_format_r8g8b8a8_unorm      : result = 4; break;
+        case tr_format_r16g16b16a16_unorm  : result = 8; break;
+        case tr_format_r16g16b16a16_float  : result = 8; break;
+        case tr_format_r32g32b32a32_uint   : result = 16; break;
+        case tr_format_r32g32b32a32_float  : result = 16; break;
+        // Depth/stencil
+        case tr_format_d16_unorm           : result = 0; break;
+        case tr_format_x8_d24_unorm_pack32 : result = 0; break;
+        case tr_format_d32_float           : result = 0; break;
+        case tr_format_s8_uint             : result = 0; break;
+        case tr_format_d16_unorm_s8_uint   : result = 0; break;
+        case tr_format_d24_unorm_s8_uint   : result = 0; break;
+        case tr_format_d32_float_s8_uint   : result = 0; break;
+        // Block compressed, bytes per 4x4 block
+        case tr_format_bc1_rgba_unorm      : result = 8; break;
+        case tr_format_bc3_unorm           : result = 16; break;
+        case tr_format_bc4_unorm           : result = 8; break;
+        case tr_format_bc5_unorm           : result = 16; break;
+        case tr_format_bc7_unorm           : result = 16; break;
+    }
+    return result;
+}
+
+uint32_t tr_util_format_channel_count(tr_format format)
+{
+    uint32_t result = 0;
+    switch (format) {
+        // 1 channel
+        case tr_format_r8_unorm            : result = 1; break;
+        case tr_format_r16_unorm           : result = 1; break;
+        case tr_format_r16_float           : result = 1; break;
+        case tr_format_r32_uint            : result = 1; break;
+        case tr_format_r32_float           : result = 1; break;
+        // 2 channel
+        case tr_format_r8g8_unorm          : result = 2; break;
+        case tr_format_r16g16_unorm        : result = 2; break;
+        case tr_format_r16g16_float        : result = 2; break;
+        case tr_format_r32g32_uint         : result = 2; break;
+        case tr_format_r32g32_float        : result = 2; break;
+        // 3 channel
+        case tr_format_r8g8b8_unorm        : result = 3; break;
+        case tr_format_r16g16b16_unorm     : result = 3; break;
+        case tr_format_r16g16b16_float     : result = 3; break;
+        case tr_format_r32g32b32_uint      : result = 3; break;
+        case tr_format_r32g32b32_float     : result = 3; break;
+        // 4 channel
+        case tr_format_b8g8r8a8_unorm      : result = 4; break;
+        case tr_format_r8g8b8a8_unorm      : result = 4; break;
+        case tr_format_r16g16b16a16_unorm  : result = 4; break;
+        case tr_format_r16g16b16a16_float  : result = 4; break;
+        case tr_format_r32g32b32a32_uint   : result = 4; break;
+        case tr_format_r32g32b32a32_float  : result = 4; break;
+        // Depth/stencil
+        case tr_format_d16_unorm           : result = 0; break;
+        case tr_format_x8_d24_unorm_pack32 : result = 0; break;
+        case tr_format_d32_float           : result = 0; break;
+        case tr_format_s8_uint             : result = 0; break;
+        case tr_format_d16_unorm_s8_uint   : result = 0; break;
+        case tr_format_d24_unorm_s8_uint   : result = 0; break;
+        case tr_format_d32_float_s8_uint   : result = 0; break;
+        // Block compressed
+        case tr_format_bc1_rgba_unorm      : result = 4; break;
+        case tr_format_bc3_unorm           : result = 4; break;
+        case tr_format_bc4_unorm           : result = 1; break;
+        case tr_format_bc5_unorm           : result = 2; break;
+        case tr_format_bc7_unorm           : result = 4; break;
+    }
+    return result;
+}
+
+bool tr_util_format_is_compressed(tr_format format)
+{
+    bool result = false;
+    switch (format) {
+        case tr_format_bc1_rgba_unorm      : result = true; break;
+        case tr_format_bc3_unorm           : result = true; break;
+        case tr_format_bc4_unorm           : result = true; break;
+        case tr_format_bc5_unorm           : result = true; break;
+        case tr_format_bc7_unorm           : result = true; break;
+        default: break;
+    }
+    return result;
+}
+
+uint32_t tr_util_format_row_pitch(tr_format format, uint32_t width)
+{
+    uint32_t result = tr_util_format_is_compressed(format) ? (((width + 3) / 4) * tr_util_format_stride(format))
+                                                            : (width * tr_util_format_stride(format));
+    return result;
+}
+
+uint64_t tr_util_format_level_size(tr_format format, uint32_t width, uint32_t height)
+{
+    uint32_t row_count = tr_util_format_is_compressed(format) ? ((height + 3) / 4) : height;
+    uint64_t result = (uint64_t)tr_util_format_row_pitch(format, width) * row_count;
+    return result;
+}
+
+#if ! defined(TINY_RENDERER_IMAGE_ONLY)
+void tr_util_transition_buffer(tr_queue* p_queue, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_buffer);
+
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+    
+    tr_begin_cmd(p_cmd);
+    tr_cmd_buffer_transition(p_cmd, p_buffer, old_usage, new_usage);
+    tr_end_cmd(p_cmd);
+
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_wait_idle(p_queue);
+
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+}
+
+void tr_util_transition_image(tr_queue* p_queue, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_texture);
+
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+    
+    tr_begin_cmd(p_cmd);
+    tr_cmd_image_transition(p_cmd, p_texture, old_usage, new_usage);
+    tr_end_cmd(p_cmd);
+
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_wait_idle(p_queue);
+
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+}
+
+#endif // ! defined(TINY_RENDERER_IMAGE_ONLY)
+
+bool tr_image_resize_uint8_t(
+    uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* src_data,
+    uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* dst_data,
+    uint32_t channel_cout, void* user_data
+)
+{
+    float dx = (float)src_width / (float)dst_width;
+    float dy = (float)src_height / (float)dst_height;
+
+    const uint8_t src_pixel_stride = channel_cout;
+    const uint8_t dst_pixel_stride = channel_cout;
+
+    uint8_t* dst_row = dst_data;
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        float src_x = 0;
+        float src_y = (float)y * dy;
+        uint8_t* dst_pixel = dst_row;
+        for (uint32_t x = 0; x < dst_width; ++x) {
+            const uint32_t src_offset = ((uint32_t)src_y * src_row_stride) + ((uint32_t)src_x * src_pixel_stride);
+            const uint8_t* src_pixel = src_data + src_offset;           
+            for (uint32_t c = 0; c < channel_cout; ++c) {
+                *(dst_pixel + c) = *(src_pixel + c);
+            }
+            src_x += dx;
+            dst_pixel += dst_pixel_stride;
+        }
+        dst_row += dst_row_stride;
+    }
+
+    return true;
+}
+
+bool tr_image_resize_uint8_filtered(
+    uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data,
+    uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, uint8_t* p_dst_data,
+    uint32_t channel_count, void* p_user_data
+)
+{
+    assert(NULL != p_src_data);
+    assert(NULL != p_dst_data);
+    assert(channel_count > 0);
+
+    if ((0 == src_width) || (0 == src_height) || (0 == dst_width) || (0 == dst_height)) {
+        return false;
+    }
+
+    const tr_image_resize_settings* p_settings = (const tr_image_resize_settings*)p_user_data;
+    tr_image_filter filter = (NULL != p_settings) ? p_settings->filter : tr_image_filter_auto;
+    uint32_t thread_count = (NULL != p_settings) ? p_settings->thread_count : 0;
+
+    if ((src_width == dst_width) && (src_height == dst_height)) {
+        for (uint32_t y = 0; y < dst_height; ++y) {
+            memcpy(p_dst_data + (y * dst_row_stride), p_src_data + (y * src_row_stride), dst_width * channel_count);
+        }
+        return true;
+    }
+
+    const bool is_half = (src_width == (2 * dst_width)) && (src_height == (2 * dst_height));
+    if (tr_image_filter_auto == filter) {
+        filter = is_half ? tr_image_filter_box : tr_image_filter_lanczos3;
+    }
+    if (tr_image_filter_point == filter) {
+        return tr_image_resize_uint8_t(src_width, src_height, src_row_stride, p_src_data,
+                                       dst_width, dst_height, dst_row_stride, p_dst_data,
+                                       channel_count, NULL);
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(tr_internal_resize_job, job);
+    job.filter         = filter;
+    job.channel_count  = channel_count;
+    job.src_width      = src_width;
+    job.src_height     = src_height;
+    job.src_row_stride = src_row_stride;
+    job.p_src_data     = p_src_data;
+    job.dst_width      = dst_width;
+    job.dst_height     = dst_height;
+    job.dst_row_stride = dst_row_stride;
+    job.p_dst_data     = p_dst_data;
+    // Exact 2x box reductions have a dedicated path and don't need taps
+    if (! ((tr_image_filter_box == filter) && is_half)) {
+        tr_internal_resize_build_taps(filter, src_width, dst_width, &job.h_tap_count, &job.h_first, &job.h_weights);
+        tr_internal_resize_build_taps(filter, src_height, dst_height, &job.v_tap_count, &job.v_first, &job.v_weights);
+    }
+
+    if (0 == thread_count) {
+        // Thread start up isn't worth it for small mip levels
+        thread_count = ((dst_width * dst_height) >= (128 * 128)) ? tr_internal_cpu_count() : 1;
+    }
+    tr_internal_resize_run(&job, thread_count);
+
+    TINY_RENDERER_SAFE_FREE(job.h_first);
+    TINY_RENDERER_SAFE_FREE(job.h_weights);
+    TINY_RENDERER_SAFE_FREE(job.v_first);
+    TINY_RENDERER_SAFE_FREE(job.v_weights);
+
+    return true;
+}
+
+bool tr_image_resize_float_t(
+    uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data,
+    uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, float* p_dst_data,
+    uint32_t channel_count, void* p_user_data
+)
+{
+    float dx = (float)src_width / (float)dst_width;
+    float dy = (float)src_height / (float)dst_height;
+
+    float* dst_row = p_dst_data;
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        const float* src_row = p_src_data + ((size_t)((float)y * dy) * src_row_stride);
+        float* dst_pixel = dst_row;
+        for (uint32_t x = 0; x < dst_width; ++x) {
+            const float* src_pixel = src_row + ((uint32_t)((float)x * dx) * channel_count);
+            for (uint32_t c = 0; c < channel_count; ++c) {
+                *(dst_pixel + c) = *(src_pixel + c);
+            }
+            dst_pixel += channel_count;
+        }
+        dst_row += dst_row_stride;
+    }
+
+    return true;
+}
+
+bool tr_image_resize_float_filtered(
+    uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data,
+    uint32_t dst_width, uint32_t dst_height, uint32_t dst_row_stride, float* p_dst_data,
+    uint32_t channel_count, void* p_user_data
+)
+{
+    assert(NULL != p_src_data);
+    assert(NULL != p_dst_data);
+    assert(channel_count > 0);
+
+    if ((0 == src_width) || (0 == src_height) || (0 == dst_width) || (0 == dst_height)) {
+        return false;
+    }
+
+    const tr_image_resize_settings* p_settings = (const tr_image_resize_settings*)p_user_data;
+    tr_image_filter filter = (NULL != p_settings) ? p_settings->filter : tr_image_filter_auto;
+    uint32_t thread_count = (NULL != p_settings) ? p_settings->thread_count : 0;
+
+    if ((src_width == dst_width) && (src_height == dst_height)) {
+        for (uint32_t y = 0; y < dst_height; ++y) {
+            memcpy(p_dst_data + ((size_t)y * dst_row_stride), p_src_data + ((size_t)y * src_row_stride), dst_width * channel_count * sizeof(float));
+        }
+        return true;
+    }
+
+    const bool is_half = (src_width == (2 * dst_width)) && (src_height == (2 * dst_height));
+    if (tr_image_filter_auto == filter) {
+        filter = is_half ? tr_image_filter_box : tr_image_filter_lanczos3;
+    }
+    if (tr_image_filter_point == filter) {
+        return tr_image_resize_float_t(src_width, src_height, src_row_stride, p_src_data,
+                                       dst_width, dst_height, dst_row_stride, p_dst_data,
+                                       channel_count, NULL);
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(tr_internal_resize_job, job);
+    job.filter         = filter;
+    job.channel_count  = channel_count;
+    job.float_data     = true;
+    job.src_width      = src_width;
+    job.src_height     = src_height;
+    job.src_row_stride = src_row_stride * sizeof(float);
+    job.p_src_data     = (const uint8_t*)p_src_data;
+    job.dst_width      = dst_width;
+    job.dst_height     = dst_height;
+    job.dst_row_stride = dst_row_stride * sizeof(float);
+    job.p_dst_data     = (uint8_t*)p_dst_data;
+    if (! ((tr_image_filter_box == filter) && is_half)) {
+        tr_internal_resize_build_taps(filter, src_width, dst_width, &job.h_tap_count, &job.h_first, &job.h_weights);
+        tr_internal_resize_build_taps(filter, src_height, dst_height, &job.v_tap_count, &job.v_first, &job.v_weights);
+    }
+
+    if (0 == thread_count) {
+        thread_count = ((dst_width * dst_height) >= (128 * 128)) ? tr_internal_cpu_count() : 1;
+    }
+    tr_internal_resize_run(&job, thread_count);
+
+    TINY_RENDERER_SAFE_FREE(job.h_first);
+    TINY_RENDERER_SAFE_FREE(job.h_weights);
+    TINY_RENDERER_SAFE_FREE(job.v_first);
+    TINY_RENDERER_SAFE_FREE(job.v_weights);
+
+    return true;
+}
+
+bool tr_image_encode_bc_uint8(tr_format format, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint8_t* p_dst_data, uint32_t thread_count)
+{
+    assert(NULL != p_src_data);
+    assert(NULL != p_dst_data);
+
+    if ((! tr_util_format_is_compressed(format)) || (tr_format_bc7_unorm == format)) {
+        return false;
+    }
+    if ((0 == src_width) || (0 == src_height)) {
+        return false;
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(tr_internal_bc_job, job);
+    job.format         = format;
+    job.width          = src_width;
+    job.height         = src_height;
+    job.src_row_stride = src_row_stride;
+    job.p_src_data     = p_src_data;
+    job.dst_row_pitch  = tr_util_format_row_pitch(format, src_width);
+    job.p_dst_data     = p_dst_data;
+
+    if (0 == thread_count) {
+        thread_count = ((src_width * src_height) >= (256 * 256)) ? tr_internal_cpu_count() : 1;
+    }
+    tr_internal_run_rows(tr_internal_bc_encode_rows, &job, (src_height + 3) / 4, thread_count);
+
+    return true;
+}
+
+#if ! defined(TINY_RENDERER_IMAGE_ONLY)
+void tr_util_set_storage_buffer_count(tr_queue* p_queue, uint64_t count_offset, uint32_t count, tr_buffer* p_counter_buffer)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_counter_buffer);
+    assert(NULL != p_counter_buffer->vk_buffer);
+
+    tr_buffer* buffer = NULL;
+    tr_create_buffer(p_counter_buffer->renderer, tr_buffer_usage_transfer_src, p_counter_buffer->size, true, &buffer);
+    uint32_t* mapped_ptr = (uint32_t*)buffer->cpu_mapped_address;
+    *(mapped_ptr) = count;
+    
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+
+    tr_begin_cmd(p_cmd);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, tr_buffer_usage_transfer_dst);
+    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
+    region.srcOffset = 0;
+    region.dstOffset = 0;
+    region.size      = (VkDeviceSize)4;
+    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_counter_buffer->vk_buffer, 1, &region);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_counter_buffer, tr_buffer_usage_storage_uav);
+    tr_end_cmd(p_cmd);
+
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_wait_idle(p_queue);
+
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+
+    tr_destroy_buffer(p_counter_buffer->renderer, buffer);
+}
+
+void tr_util_clear_buffer(tr_queue* p_queue, tr_buffer* p_buffer)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_buffer);
+    assert(NULL != p_buffer->vk_buffer);
+
+    tr_buffer* buffer = NULL;
+    tr_create_buffer(p_buffer->renderer, tr_buffer_usage_transfer_src, p_buffer->size, true, &buffer);
+    memset(buffer->cpu_mapped_address, 0, buffer->size);
+    
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+
+    tr_begin_cmd(p_cmd);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst);
+    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
+    region.srcOffset = 0;
+    region.dstOffset = 0;
+    region.size      = (VkDeviceSize)p_buffer->size;
+    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_buffer->vk_buffer, 1, &region);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->usage);
+    tr_end_cmd(p_cmd);
+
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_wait_idle(p_queue);
+
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+
+    tr_destroy_buffer(p_buffer->renderer, buffer);
+}
+
+void tr_util_update_buffer(tr_queue* p_queue, uint64_t size, const void* p_src_data, tr_buffer* p_buffer)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_buffer);
+    assert(NULL != p_buffer->vk_buffer);
+    assert(p_buffer->size >= size);
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+    tr_buffer* buffer = tr_util_vk_upload_staging(p_buffer->renderer, size);
+    memcpy(buffer->cpu_mapped_address, p_src_data, size);
+
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+
+    tr_begin_cmd(p_cmd);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst);
+    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
+    region.srcOffset = 0;
+    region.dstOffset = 0;
+    region.size      = (VkDeviceSize)size;
+    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_buffer->vk_buffer, 1, &region);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, p_buffer->usage);
+    p_buffer->renderer->frame_stats.upload_bytes += size;
+    tr_end_cmd(p_cmd);
+
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_wait_idle(p_queue);
+
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->vk_image);
+    assert((src_width > 0) && (src_height > 0) && (src_row_stride > 0));
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+    tr_util_vk_update_texture_uint8(p_queue, src_width, src_height, src_row_stride, p_src_data, src_channel_count, p_texture, 0, resize_fn, p_user_data, false);
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+void tr_util_update_texture_layer_uint8(tr_queue* p_queue, uint32_t array_layer, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->vk_image);
+    assert(array_layer < p_texture->array_layers);
+    assert((src_width > 0) && (src_height > 0) && (src_row_stride > 0));
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+    tr_util_vk_update_texture_uint8(p_queue, src_width, src_height, src_row_stride, p_src_data, src_channel_count, p_texture, array_layer, resize_fn, p_user_data, false);
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+void tr_util_update_texture_uint8_gpu_mips(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->vk_image);
+    assert((src_width > 0) && (src_height > 0) && (src_row_stride > 0));
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+    // Only layer 0 is uploaded, mip generation blits every layer so it's limited to single layer textures
+    bool gpu_mips = (tr_texture_type_2d == p_texture->type) && (1 == p_texture->array_layers) && tr_util_texture_supports_gpu_mips(p_texture);
+    tr_util_vk_update_texture_uint8(p_queue, src_width, src_height, src_row_stride, p_src_data, src_channel_count, p_texture, 0, NULL, NULL, gpu_mips);
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+bool tr_util_texture_supports_gpu_mips(const tr_texture* p_texture)
+{
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->renderer);
+
+    // Blit sources need VK_IMAGE_USAGE_TRANSFER_SRC_BIT, which is only added for sampled textures
+    if (0 == (p_texture->usage & tr_texture_usage_sampled_image)) {
+        return false;
+    }
+    if (VK_IMAGE_ASPECT_COLOR_BIT != p_texture->vk_aspect_mask) {
+        return false;
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(VkFormatProperties, format_props);
+    vkGetPhysicalDeviceFormatProperties(p_texture->renderer->vk_active_gpu, tr_util_to_vk_format(p_texture->format), &format_props);
+    VkFormatFeatureFlags features = p_texture->host_visible ? format_props.linearTilingFeatures : format_props.optimalTilingFeatures;
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    bool result = (required == (features & required));
+    return result;
+}
+
+void tr_util_vk_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, uint32_t array_layer, tr_image_resize_uint8_fn resize_fn, void* p_user_data, bool gpu_mips)
+{
+    // Compressed formats can't be blitted, their mips always come from the CPU
+    if (tr_util_format_is_compressed(p_texture->format)) {
+        tr_util_vk_update_texture_uint8_compressed(p_queue, src_width, src_height, src_row_stride, p_src_data, src_channel_count, p_texture, array_layer, resize_fn, p_user_data);
+        return;
+    }
+
+    // Only level 0 is built on the CPU when the GPU generates the rest
+    const uint32_t cpu_mip_levels = gpu_mips ? 1 : p_texture->mip_levels;
+
+    uint8_t* p_expanded_src_data = NULL;
+    const uint32_t dst_channel_count = tr_util_format_channel_count(p_texture->format);
+    assert(src_channel_count <= dst_channel_count);
+
+    // Sources that don't need a resize for level 0 are expanded straight into the staging
+    // buffer when no other level is built from it on the CPU, since staging memory is
+    // uncached and slow to read back. Everything else goes through an expanded copy first.
+    const bool expand_channels = (src_channel_count < dst_channel_count);
+    const bool expand_into_staging = expand_channels && (1 == cpu_mip_levels) && (src_width == p_texture->width) && (src_height == p_texture->height);
+    if (expand_channels && (! expand_into_staging)) {
+        uint32_t expanded_row_stride = src_width * dst_channel_count;
+        uint32_t expanded_size = expanded_row_stride * src_height;
+        p_expanded_src_data = (uint8_t*)calloc(1, expanded_size);
+        assert(NULL != p_expanded_src_data);
+
+        for (uint32_t y = 0; y < src_height; ++y) {
+            tr_internal_expand_channels_row(p_expanded_src_data + ((size_t)y * expanded_row_stride), p_src_data + ((size_t)y * src_row_stride),
+                                            src_width, src_channel_count, dst_channel_count);
+        }
+        src_row_stride = expanded_row_stride;
+        src_channel_count = dst_channel_count;
+        p_src_data = p_expanded_src_data;
+    }
+
+    // Every level is staged with rows of its own width, whatever the source's row stride is, since
+    // that's what the copy regions read. Level offsets are multiples of 4 and of the texel size.
+    const uint32_t region_count = cpu_mip_levels;
+    VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(region_count, sizeof(*regions));
+    assert(NULL != regions);
+    VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_texture->format));
+    const uint32_t offset_alignment = (0 == (dst_channel_count % 4)) ? dst_channel_count
+                                    : ((0 == (dst_channel_count % 2)) ? (2 * dst_channel_count) : (4 * dst_channel_count));
+    VkDeviceSize staging_size = 0;
+    for (uint32_t mip_level = 0; mip_level < cpu_mip_levels; ++mip_level) {
+        uint32_t dst_width = tr_max(p_texture->width >> mip_level, 1);
+        uint32_t dst_height = tr_max(p_texture->height >> mip_level, 1);
+        regions[mip_level].bufferOffset                    = staging_size;
+        regions[mip_level].bufferRowLength                 = dst_width;
+        regions[mip_level].bufferImageHeight               = dst_height;
+        regions[mip_level].imageSubresource.aspectMask     = aspect_mask;
+        regions[mip_level].imageSubresource.mipLevel       = mip_level;
+        regions[mip_level].imageSubresource.baseArrayLayer = array_layer;
+        regions[mip_level].imageSubresource.layerCount     = 1;
+        regions[mip_level].imageExtent.width               = dst_width;
+        regions[mip_level].imageExtent.height              = dst_height;
+        regions[mip_level].imageExtent.depth               = 1;
+        staging_size += (VkDeviceSize)dst_width * dst_height * dst_channel_count;
+        staging_size = ((staging_size + offset_alignment - 1) / offset_alignment) * offset_alignment;
+    }
+
+    tr_buffer* buffer = NULL;
+    tr_create_buffer(p_texture->renderer, tr_buffer_usage_transfer_src, staging_size, true, &buffer);
+    if (expand_into_staging) {
+        uint8_t* p_staging_data = (uint8_t*)buffer->cpu_mapped_address;
+        const uint32_t staging_row_stride = src_width * dst_channel_count;
+        for (uint32_t y = 0; y < src_height; ++y) {
+            tr_internal_expand_channels_row(p_staging_data + ((size_t)y * staging_row_stride), p_src_data + ((size_t)y * src_row_stride),
+                                            src_width, src_channel_count, dst_channel_count);
+        }
+        src_row_stride = staging_row_stride;
+        src_channel_count = dst_channel_count;
+        p_src_data = p_staging_data;
+    }
+    //
+    // If you're coming from D3D12, you might want to do something like:
+    //
+    //   // Get resource layout for all mip levels
+    //   VkSubresourceLayout* subres_layouts = (VkSubresourceLayout*)calloc(p_texture->mip_levels, sizeof(*subres_layouts));
+    //   assert(NULL != subres_layouts);
+    //   VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_texture->format));
+    //   for (uint32_t i = 0; i < p_texture->mip_levels; ++i) {
+    //       TINY_RENDERER_DECLARE_ZERO(VkImageSubresource, img_sub_res);
+    //       img_sub_res.aspectMask = aspect_mask;
+    //       img_sub_res.mipLevel   = i;
+    //       img_sub_res.arrayLayer = 0;
+    //       vkGetImageSubresourceLayout(p_texture->renderer->vk_device, p_texture->vk_image, &img_sub_res, &(subres_layouts[i]));
+    //   } 
+    //
+    // ...unfortunately, in Vulkan this approach may be slightly 
+    // problematic, because you can only call vkGetImageSubresourceLayout on
+    // an image that was created with VK_IMAGE_TILING_LINEAR. The validation
+    // layers will issue an error if vkGetImageSubresourceLayout get called
+    // on an image created with VK_IMAGE_TILING_OPTIMAL. For now, since the
+    // total size of the memory is correct, we'll just calculate the row pitch
+    // and offset for each mip level manually.
+    // 
+    
+    // Level 0 is already in place when it was expanded into the staging buffer
+    if (! expand_into_staging) {
+        if (NULL == resize_fn) {
+            // The default filtered resize builds each mip level from the previous one, which
+            // turns power of two chains into 2x box reductions. The levels are chained in cached
+            // scratch memory since staging memory is slow to read back.
+            tr_internal_mip_chain_level* p_levels = (tr_internal_mip_chain_level*)calloc(cpu_mip_levels, sizeof(*p_levels));
+            assert(NULL != p_levels);
+            for (uint32_t mip_level = 0; mip_level < cpu_mip_levels; ++mip_level) {
+                p_levels[mip_level].width      = regions[mip_level].imageExtent.width;
+                p_levels[mip_level].height     = regions[mip_level].imageExtent.height;
+                p_levels[mip_level].row_stride = regions[mip_level].imageExtent.width * dst_channel_count;
+                p_levels[mip_level].p_data     = (uint8_t*)buffer->cpu_mapped_address + regions[mip_level].bufferOffset;
+            }
+            tr_internal_resize_mip_chain_uint8(src_width, src_height, src_row_stride, p_src_data, dst_channel_count, cpu_mip_levels, p_levels, (const tr_image_resize_settings*)p_user_data);
+            TINY_RENDERER_SAFE_FREE(p_levels);
+        }
+        else {
+            // Supplied functions always get level 0's source
+            for (uint32_t mip_level = 0; mip_level < cpu_mip_levels; ++mip_level) {
+                const uint32_t dst_width = regions[mip_level].imageExtent.width;
+                const uint32_t dst_height = regions[mip_level].imageExtent.height;
+                uint8_t* p_dst_data = (uint8_t*)buffer->cpu_mapped_address + regions[mip_level].bufferOffset;
+                resize_fn(src_width, src_height, src_row_stride, p_src_data, dst_width, dst_height, dst_width * dst_channel_count, p_dst_data, dst_channel_count, p_user_data);
+            }
+        }
+    }
+
+    // Copy buffer to texture
+    tr_util_vk_copy_staging_to_texture(p_queue, buffer, region_count, regions, staging_size, p_texture, gpu_mips);
+    tr_destroy_buffer(p_texture->renderer, buffer);
+
+    TINY_RENDERER_SAFE_FREE(regions);
+    TINY_RENDERER_SAFE_FREE(p_expanded_src_data);
+}
+
+void tr_util_vk_update_texture_uint8_compressed(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, uint32_t array_layer, tr_image_resize_uint8_fn resize_fn, void* p_user_data)
+{
+    // Every level is built as RGBA8 and then encoded, the encoders pick the channels they need
+    const uint32_t channel_count = 4;
+    assert(src_channel_count <= channel_count);
+
+    uint8_t* p_expanded_src_data = NULL;
+    if (src_channel_count < channel_count) {
+        uint32_t expanded_row_stride = src_width * channel_count;
+        p_expanded_src_data = (uint8_t*)calloc(1, (size_t)expanded_row_stride * src_height);
+        assert(NULL != p_expanded_src_data);
+
+        for (uint32_t y = 0; y < src_height; ++y) {
+            tr_internal_expand_channels_row(p_expanded_src_data + ((size_t)y * expanded_row_stride), p_src_data + ((size_t)y * src_row_stride),
+                                            src_width, src_channel_count, channel_count);
+        }
+        src_row_stride = expanded_row_stride;
+        p_src_data = p_expanded_src_data;
+    }
+
+    // Copies are in whole blocks, levels smaller than a block still use a full block
+    const uint32_t mip_levels = p_texture->mip_levels;
+    VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(mip_levels, sizeof(*regions));
+    assert(NULL != regions);
+    VkDeviceSize staging_size = 0;
+    for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+        uint32_t dst_width = tr_max(p_texture->width >> mip_level, 1);
+        uint32_t dst_height = tr_max(p_texture->height >> mip_level, 1);
+        regions[mip_level].bufferOffset                    = staging_size;
+        regions[mip_level].bufferRowLength                 = tr_round_up(dst_width, 4);
+        regions[mip_level].bufferImageHeight               = tr_round_up(dst_height, 4);
+        regions[mip_level].imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        regions[mip_level].imageSubresource.mipLevel       = mip_level;
+        regions[mip_level].imageSubresource.baseArrayLayer = array_layer;
+        regions[mip_level].imageSubresource.layerCount     = 1;
+        regions[mip_level].imageExtent.width               = dst_width;
+        regions[mip_level].imageExtent.height              = dst_height;
+        regions[mip_level].imageExtent.depth               = 1;
+        staging_size += tr_util_format_level_size(p_texture->format, dst_width, dst_height);
+    }
+
+    tr_buffer* buffer = NULL;
+    tr_create_buffer(p_texture->renderer, tr_buffer_usage_transfer_src, staging_size, true, &buffer);
+
+    // Uncompressed levels ping-pong between two scratch images, level 0 skips
+    // the scratch image when it can be encoded straight from the source.
+    const bool chain_mip_levels = (NULL == resize_fn);
+    if (NULL == resize_fn) {
+        resize_fn = &tr_image_resize_uint8_filtered;
+    }
+    const bool encode_src_data = chain_mip_levels && (src_width == p_texture->width) && (src_height == p_texture->height);
+    uint8_t* p_scratch[2] = { NULL, NULL };
+    for (uint32_t i = 0; i < 2; ++i) {
+        uint32_t level = (encode_src_data && (0 == i)) ? 2 : i;
+        if (level < mip_levels) {
+            size_t size = (size_t)tr_max(p_texture->width >> level, 1) * tr_max(p_texture->height >> level, 1) * channel_count;
+            p_scratch[i] = (uint8_t*)calloc(1, size);
+            assert(NULL != p_scratch[i]);
+        }
+    }
+
+    uint32_t level_src_width = src_width;
+    uint32_t level_src_height = src_height;
+    uint32_t level_src_row_stride = src_row_stride;
+    const uint8_t* p_level_src_data = p_src_data;
+    for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+        const uint32_t dst_width = regions[mip_level].imageExtent.width;
+        const uint32_t dst_height = regions[mip_level].imageExtent.height;
+        const uint32_t dst_row_stride = dst_width * channel_count;
+
+        const uint8_t* p_level_data = p_src_data;
+        uint32_t level_row_stride = src_row_stride;
+        if ((mip_level > 0) || (! encode_src_data)) {
+            uint8_t* p_dst_data = p_scratch[mip_level & 1];
+            resize_fn(level_src_width, level_src_height, level_src_row_stride, p_level_src_data, dst_width, dst_height, dst_row_stride, p_dst_data, channel_count, p_user_data);
+            p_level_data = p_dst_data;
+            level_row_stride = dst_row_stride;
+        }
+
+        uint8_t* p_staging_data = (uint8_t*)buffer->cpu_mapped_address + regions[mip_level].bufferOffset;
+        bool encoded = tr_image_encode_bc_uint8(p_texture->format, dst_width, dst_height, level_row_stride, p_level_data, p_staging_data, 0);
+        assert(encoded && "No CPU encoder for this format");
+        (void)encoded;
+
+        if (chain_mip_levels) {
+            level_src_width = dst_width;
+            level_src_height = dst_height;
+            level_src_row_stride = level_row_stride;
+            p_level_src_data = p_level_data;
+        }
+    }
+
+    tr_util_vk_copy_staging_to_texture(p_queue, buffer, mip_levels, regions, staging_size, p_texture, false);
+    tr_destroy_buffer(p_texture->renderer, buffer);
+
+    TINY_RENDERER_SAFE_FREE(p_scratch[0]);
+    TINY_RENDERER_SAFE_FREE(p_scratch[1]);
+    TINY_RENDERER_SAFE_FREE(regions);
+    TINY_RENDERER_SAFE_FREE(p_expanded_src_data);
+}
+
+VkBufferImageCopy tr_util_vk_mip_copy_region(const tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer, uint64_t buffer_offset)
+{
+    // Compressed levels are copied in whole blocks
+    const bool compressed = tr_util_format_is_compressed(p_texture->format);
+    uint32_t width = tr_max(p_texture->width >> mip_level, 1);
+    uint32_t height = tr_max(p_texture->height >> mip_level, 1);
+
+    TINY_RENDERER_DECLARE_ZERO(VkBufferImageCopy, region);
+    region.bufferOffset                    = buffer_offset;
+    region.bufferRowLength                 = compressed ? tr_round_up(width, 4) : width;
+    region.bufferImageHeight               = compressed ? tr_round_up(height, 4) : height;
+    region.imageSubresource.aspectMask     = p_texture->vk_aspect_mask;
+    region.imageSubresource.mipLevel       = mip_level;
+    region.imageSubresource.baseArrayLayer = array_layer;
+    region.imageSubresource.layerCount     = 1;
+    region.imageExtent.width               = width;
+    region.imageExtent.height              = height;
+    region.imageExtent.depth               = 1;
+    return region;
+}
+
+tr_buffer* tr_util_vk_upload_staging(tr_renderer* p_renderer, uint64_t size)
+{
+    // Callers wait for their copies to finish, so one buffer can serve every upload
+    tr_buffer* p_staging = p_renderer->upload_staging;
+    if ((NULL != p_staging) && (p_staging->size < size)) {
+        tr_destroy_buffer(p_renderer, p_staging);
+        p_staging = NULL;
+    }
+    if (NULL == p_staging) {
+        const uint64_t k_min_size = 64 * 1024;
+        uint64_t staging_size = (size + k_min_size - 1) & ~(k_min_size - 1);
+        tr_create_buffer(p_renderer, tr_buffer_usage_transfer_src, staging_size, true, &p_staging);
+        p_renderer->upload_staging = p_staging;
+    }
+    return p_staging;
+}
+
+void tr_util_vk_update_texture_mip_range(tr_queue* p_queue, const void* p_src_data, uint32_t first_mip_level, uint32_t mip_level_count, uint32_t array_layer, tr_texture* p_texture)
+{
+    assert((first_mip_level + mip_level_count) <= p_texture->mip_levels);
+    assert(array_layer < p_texture->array_layers);
+
+    // Source levels are tightly packed from level 0, staging offsets are 16 byte 
+    // aligned to satisfy both the block size and vkCmdCopyBufferToImage.
+    const uint8_t* p_level_src_data = (const uint8_t*)p_src_data;
+    for (uint32_t mip_level = 0; mip_level < first_mip_level; ++mip_level) {
+        p_level_src_data += tr_util_format_level_size(p_texture->format, tr_max(p_texture->width >> mip_level, 1), tr_max(p_texture->height >> mip_level, 1));
+    }
+
+    VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(mip_level_count, sizeof(*regions));
+    assert(NULL != regions);
+    VkDeviceSize staging_size = 0;
+    for (uint32_t i = 0; i < mip_level_count; ++i) {
+        regions[i] = tr_util_vk_mip_copy_region(p_texture, first_mip_level + i, array_layer, staging_size);
+        staging_size += tr_util_format_level_size(p_texture->format, regions[i].imageExtent.width, regions[i].imageExtent.height);
+        staging_size = (staging_size + 15) & ~((VkDeviceSize)15);
+    }
+
+    tr_buffer* buffer = NULL;
+    tr_create_buffer(p_texture->renderer, tr_buffer_usage_transfer_src, staging_size, true, &buffer);
+
+    for (uint32_t i = 0; i < mip_level_count; ++i) {
+        uint64_t level_size = tr_util_format_level_size(p_texture->format, regions[i].imageExtent.width, regions[i].imageExtent.height);
+        uint8_t* p_staging_data = (uint8_t*)buffer->cpu_mapped_address + regions[i].bufferOffset;
+        memcpy(p_staging_data, p_level_src_data, (size_t)level_size);
+        p_level_src_data += level_size;
+    }
+
+    tr_util_vk_copy_staging_to_texture(p_queue, buffer, mip_level_count, regions, staging_size, p_texture, false);
+    tr_destroy_buffer(p_texture->renderer, buffer);
+
+    TINY_RENDERER_SAFE_FREE(regions);
+}
+
+void tr_util_vk_copy_staging_to_texture(tr_queue* p_queue, tr_buffer* p_staging, uint32_t region_count, const VkBufferImageCopy* p_regions, uint64_t upload_bytes, tr_texture* p_texture, bool gpu_mips)
+{
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+
+    tr_begin_cmd(p_cmd);
+    //
+    // Vulkan textures are created with VK_IMAGE_LAYOUT_UNDEFFINED (tr_texture_usage_undefined),
+    // the tracked usage takes care of textures that have already been updated.
+    //
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, 0, p_texture->mip_levels, tr_texture_usage_transfer_dst);
+    vkCmdCopyBufferToImage(p_cmd->vk_cmd_buf, p_staging->vk_buffer, p_texture->vk_image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region_count, p_regions);
+    if (gpu_mips) {
+        tr_internal_vk_cmd_generate_mipmaps(p_cmd, p_texture, tr_texture_usage_sampled_image);
+    }
+    else {
+        tr_internal_vk_cmd_image_transition(p_cmd, p_texture, 0, p_texture->mip_levels, tr_texture_usage_sampled_image);
+    }
+    p_texture->renderer->frame_stats.upload_bytes += upload_bytes;
+    tr_end_cmd(p_cmd);
+
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
+    tr_queue_wait_idle(p_queue);
+
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+}
+
+void tr_util_update_texture_float(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data, uint32_t channels, tr_texture* p_texture, tr_image_resize_float_fn resize_fn, void* p_user_data)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->vk_image);
+    assert((src_width > 0) && (src_height > 0) && (channels > 0));
+    assert(src_row_stride >= (src_width * channels));
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+
+    const uint32_t dst_channel_count = tr_util_format_channel_count(p_texture->format);
+    const uint32_t dst_pixel_stride = tr_util_format_stride(p_texture->format);
+    // Only r16*_float and r32*_float textures are supported
+    const bool half_precision = (dst_pixel_stride == (2 * dst_channel_count));
+    assert(half_precision || (dst_pixel_stride == (4 * dst_channel_count)));
+
+    // Match the texture's channel layout, missing color channels are 0 and missing alpha is 1
+    float* p_expanded_src_data = NULL;
+    if (channels != dst_channel_count) {
+        const uint32_t expanded_row_stride = src_width * dst_channel_count;
+        p_expanded_src_data = (float*)calloc((size_t)expanded_row_stride * src_height, sizeof(*p_expanded_src_data));
+        assert(NULL != p_expanded_src_data);
+
+        const uint32_t copy_channel_count = tr_min(channels, dst_channel_count);
+        for (uint32_t y = 0; y < src_height; ++y) {
+            const float* src_pixel = p_src_data + ((size_t)y * src_row_stride);
+            float* expanded_pixel = p_expanded_src_data + ((size_t)y * expanded_row_stride);
+            for (uint32_t x = 0; x < src_width; ++x) {
+                uint32_t c = 0;
+                for (; c < copy_channel_count; ++c) {
+                    expanded_pixel[c] = src_pixel[c];
+                }
+                for (; c < dst_channel_count; ++c) {
+                    expanded_pixel[c] = (3 == c) ? 1.0f : 0.0f;
+                }
+                src_pixel += channels;
+                expanded_pixel += dst_channel_count;
+            }
+        }
+        src_row_stride = expanded_row_stride;
+        p_src_data = p_expanded_src_data;
+    }
+
+    // Levels are tightly packed in the staging buffer, vkCmdCopyBufferToImage needs their offsets
+    // to be multiples of 4 and of the texel size, which is 6 bytes for r16g16b16 formats
+    const uint32_t mip_levels = p_texture->mip_levels;
+    VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(mip_levels, sizeof(*regions));
+    assert(NULL != regions);
+    VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_texture->format));
+    const uint32_t offset_alignment = (0 == (dst_pixel_stride % 4)) ? dst_pixel_stride
+                                    : ((0 == (dst_pixel_stride % 2)) ? (2 * dst_pixel_stride) : (4 * dst_pixel_stride));
+    VkDeviceSize staging_size = 0;
+    for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+        uint32_t dst_width = tr_max(p_texture->width >> mip_level, 1);
+        uint32_t dst_height = tr_max(p_texture->height >> mip_level, 1);
+        regions[mip_level].bufferOffset                    = staging_size;
+        regions[mip_level].bufferRowLength                 = dst_width;
+        regions[mip_level].bufferImageHeight               = dst_height;
+        regions[mip_level].imageSubresource.aspectMask     = aspect_mask;
+        regions[mip_level].imageSubresource.mipLevel       = mip_level;
+        regions[mip_level].imageSubresource.baseArrayLayer = 0;
+        regions[mip_level].imageSubresource.layerCount     = 1;
+        regions[mip_level].imageExtent.width               = dst_width;
+        regions[mip_level].imageExtent.height              = dst_height;
+        regions[mip_level].imageExtent.depth               = 1;
+        staging_size += tr_round_up(dst_width * dst_height * dst_pixel_stride, offset_alignment);
+    }
+
+    tr_buffer* buffer = NULL;
+    tr_create_buffer(p_texture->renderer, tr_buffer_usage_transfer_src, staging_size, true, &buffer);
+
+    // Levels are resized in float scratch memory and converted or copied into the staging buffer, which
+    // is uncached and never read back. Ping-ponging between two scratch levels is enough when each level
+    // is built from the previous one.
+    float* p_scratch[2] = { NULL, NULL };
+    for (uint32_t i = 0; i < tr_min(mip_levels, 2); ++i) {
+        size_t element_count = (size_t)tr_max(p_texture->width >> i, 1) * tr_max(p_texture->height >> i, 1) * dst_channel_count;
+        p_scratch[i] = (float*)calloc(element_count, sizeof(float));
+        assert(NULL != p_scratch[i]);
+    }
+
+    const bool chain_mip_levels = (NULL == resize_fn);
+    if (NULL == resize_fn) {
+        resize_fn = &tr_image_resize_float_filtered;
+    }
+    uint32_t level_src_width = src_width;
+    uint32_t level_src_height = src_height;
+    uint32_t level_src_row_stride = src_row_stride;
+    const float* p_level_src_data = p_src_data;
+    for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+        const uint32_t dst_width = regions[mip_level].imageExtent.width;
+        const uint32_t dst_height = regions[mip_level].imageExtent.height;
+        const uint32_t dst_row_stride = dst_width * dst_channel_count;
+        uint8_t* p_staging_data = (uint8_t*)buffer->cpu_mapped_address + regions[mip_level].bufferOffset;
+
+        float* p_dst_data = p_scratch[mip_level & 1];
+        const float* p_level_data = p_dst_data;
+        uint32_t level_row_stride = dst_row_stride;
+        // Level 0 can be converted or copied straight from the source when no resize is needed
+        bool use_src_data = chain_mip_levels && (src_width == dst_width) && (src_height == dst_height);
+        if (use_src_data) {
+            p_level_data = p_level_src_data;
+            level_row_stride = level_src_row_stride;
+        }
+        else {
+            resize_fn(level_src_width, level_src_height, level_src_row_stride, p_level_src_data, dst_width, dst_height, dst_row_stride, p_dst_data, dst_channel_count, p_user_data);
+        }
+
+        if (half_precision) {
+            uint16_t* p_dst_half = (uint16_t*)p_staging_data;
+            for (uint32_t y = 0; y < dst_height; ++y) {
+                tr_internal_float_to_half_row(p_dst_half + ((size_t)y * dst_row_stride), p_level_data + ((size_t)y * level_row_stride), dst_row_stride);
+            }
+        }
+        else {
+            float* p_dst_float = (float*)p_staging_data;
+            for (uint32_t y = 0; y < dst_height; ++y) {
+                memcpy(p_dst_float + ((size_t)y * dst_row_stride), p_level_data + ((size_t)y * level_row_stride), dst_row_stride * sizeof(float));
+            }
+        }
+
+        if (chain_mip_levels) {
+            level_src_width = dst_width;
+            level_src_height = dst_height;
+            level_src_row_stride = level_row_stride;
+            p_level_src_data = p_level_data;
+        }
+    }
+
+    tr_util_vk_copy_staging_to_texture(p_queue, buffer, mip_levels, regions, staging_size, p_texture, false);
+    tr_destroy_buffer(p_texture->renderer, buffer);
+
+    TINY_RENDERER_SAFE_FREE(p_scratch[0]);
+    TINY_RENDERER_SAFE_FREE(p_scratch[1]);
+    TINY_RENDERER_SAFE_FREE(regions);
+    TINY_RENDERER_SAFE_FREE(p_expanded_src_data);
+
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+void tr_util_update_texture_mips(tr_queue* p_queue, const void* p_src_data, uint32_t mip_level_count, tr_texture* p_texture)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(mip_level_count > 0);
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+
+    tr_util_vk_update_texture_mip_range(p_queue, p_src_data, 0, tr_min(mip_level_count, p_texture->mip_levels), 0, p_texture);
+
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+void tr_util_update_texture_layer_mips(tr_queue* p_queue, uint32_t array_layer, const void* p_src_data, uint32_t mip_level_count, tr_texture* p_texture)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(array_layer < p_texture->array_layers);
+    assert(mip_level_count > 0);
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+
+    tr_util_vk_update_texture_mip_range(p_queue, p_src_data, 0, tr_min(mip_level_count, p_texture->mip_levels), array_layer, p_texture);
+
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+void tr_util_update_texture_region(tr_queue* p_queue, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t src_row_stride, const void* p_src_data, tr_texture* p_texture)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(mip_level < p_texture->mip_levels);
+    assert(array_layer < p_texture->array_layers);
+    assert((width > 0) && (height > 0));
+    assert(tr_sample_count_1 == p_texture->sample_count);
+
+    const uint32_t level_width = tr_max(p_texture->width >> mip_level, 1);
+    const uint32_t level_height = tr_max(p_texture->height >> mip_level, 1);
+    assert(((x + width) <= level_width) && ((y + height) <= level_height));
+    (void)level_width;
+    (void)level_height;
+
+    TINY_RENDERER_TRACE_BEGIN(p_queue->renderer);
+
+    // The copy is waited on, so the shared upload staging buffer can hold the rectangle
+    const uint64_t staging_size = tr_util_format_level_size(p_texture->format, width, height);
+    tr_buffer* buffer = tr_util_vk_upload_staging(p_texture->renderer, staging_size);
+
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+
+    tr_begin_cmd(p_cmd);
+    tr_cmd_update_texture_region(p_cmd, buffer, 0, mip_level, array_layer, x, y, width, height, src_row_stride, p_src_data, p_texture);
+    tr_end_cmd(p_cmd);
+
+    tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
     tr_queue_wait_idle(p_queue);
 
-    tr_destroy_cmd(p_cmd_pool, p_cmd);
-    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+
+    TINY_RENDERER_TRACE_END(p_queue->renderer);
+}
+
+const tr_subresource_layout* tr_util_texture_subresource_layout(const tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer)
+{
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->subresource_layouts);
+    assert(mip_level < p_texture->mip_levels);
+    assert(array_layer < p_texture->array_layers);
+
+    return &(p_texture->subresource_layouts[(array_layer * p_texture->mip_levels) + mip_level]);
+}
+
+void tr_util_write_texture_region(uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t src_row_stride, const void* p_src_data, tr_texture* p_texture)
+{
+    assert(NULL != p_src_data);
+    assert(NULL != p_texture);
+    assert(p_texture->host_visible && (NULL != p_texture->cpu_mapped_address));
+    assert((width > 0) && (height > 0));
+    assert((x + width) <= tr_max(p_texture->width >> mip_level, 1));
+    assert((y + height) <= tr_max(p_texture->height >> mip_level, 1));
+
+    const tr_subresource_layout* p_layout = tr_util_texture_subresource_layout(p_texture, mip_level, array_layer);
+
+    // Rows of blocks for compressed formats
+    const bool is_compressed = tr_util_format_is_compressed(p_texture->format);
+    assert((! is_compressed) || ((0 == (x % 4)) && (0 == (y % 4))));
+    const uint32_t block_size = is_compressed ? 4 : 1;
+    const uint32_t row_size = tr_util_format_row_pitch(p_texture->format, width);
+    const uint32_t row_count = (height + block_size - 1) / block_size;
+    const uint64_t x_offset = (uint64_t)tr_util_format_row_pitch(p_texture->format, x);
+    assert(src_row_stride >= row_size);
+
+    uint8_t* p_dst_data = (uint8_t*)p_texture->cpu_mapped_address + p_layout->offset + ((y / block_size) * p_layout->row_pitch) + x_offset;
+    const uint8_t* p_row_src_data = (const uint8_t*)p_src_data;
+    for (uint32_t row = 0; row < row_count; ++row) {
+        memcpy(p_dst_data, p_row_src_data, row_size);
+        p_dst_data += p_layout->row_pitch;
+        p_row_src_data += src_row_stride;
+    }
+}
+
+bool tr_util_create_texture_dds(tr_queue* p_queue, const void* p_data, uint64_t size, tr_texture_usage_flags usage, tr_texture** pp_texture)
+{
+    assert(NULL != p_queue);
+    assert(NULL != p_data);
+    assert(NULL != pp_texture);
+    assert(0 != (usage & tr_texture_usage_sampled_image));
+
+    tr_internal_dds_image image;
+    if (! tr_internal_dds_parse((const uint8_t*)p_data, size, &image)) {
+        return false;
+    }
+
+    tr_create_texture_2d(p_queue->renderer, image.width, image.height, tr_sample_count_1, image.format, image.mip_levels, NULL, false, usage, pp_texture);
+    tr_util_update_texture_mips(p_queue, image.p_data, image.mip_levels, *pp_texture);
+    return true;
+}
+
+bool tr_util_load_texture_dds(tr_queue* p_queue, const char* file_path, tr_texture_usage_flags usage, tr_texture** pp_texture)
+{
+    assert(NULL != file_path);
+
+    tr_internal_mapped_file file;
+    if (! tr_internal_map_file(file_path, &file)) {
+        return false;
+    }
+
+    bool result = tr_util_create_texture_dds(p_queue, file.p_data, file.size, usage, pp_texture);
+    tr_internal_unmap_file(&file);
+    return result;
+}
+#endif // ! defined(TINY_RENDERER_IMAGE_ONLY)
+
+// -------------------------------------------------------------------------------------------------
+// Internal utility functions
+// -------------------------------------------------------------------------------------------------
+VkSampleCountFlagBits tr_util_to_vk_sample_count(tr_sample_count sample_count) 
+{
+    VkSampleCountFlagBits result = VK_SAMPLE_COUNT_1_BIT;
+    switch (sample_count) {
+        case tr_sample_count_1  : result = VK_SAMPLE_COUNT_1_BIT;  break;
+        case tr_sample_count_2  : result = VK_SAMPLE_COUNT_2_BIT;  break;
+        case tr_sample_count_4  : result = VK_SAMPLE_COUNT_4_BIT;  break;
+        case tr_sample_count_8  : result = VK_SAMPLE_COUNT_8_BIT;  break;
+        case tr_sample_count_16 : result = VK_SAMPLE_COUNT_16_BIT; break;
+    }
+    return result;
+}
+
+VkBufferUsageFlags tr_util_to_vk_buffer_usage(tr_buffer_usage usage)
+{
+    VkBufferUsageFlags result = 0;
+    if (tr_buffer_usage_index == (usage & tr_buffer_usage_index)) {
+        result |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    }
+    if (tr_buffer_usage_vertex == (usage & tr_buffer_usage_vertex)) {
+        result |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    }
+    if (tr_buffer_usage_indirect == (usage & tr_buffer_usage_indirect)) {
+        result |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    }
+    if (tr_buffer_usage_transfer_src == (usage & tr_buffer_usage_transfer_src)) {
+        result |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    }
+    if (tr_buffer_usage_transfer_dst == (usage & tr_buffer_usage_transfer_dst)) {
+        result |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
+    if (tr_buffer_usage_uniform_cbv == (usage & tr_buffer_usage_uniform_cbv)) {
+        result |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    }
+    if (tr_buffer_usage_storage_srv == (usage & tr_buffer_usage_storage_srv)) {
+        result |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    }
+    if (tr_buffer_usage_storage_uav == (usage & tr_buffer_usage_storage_uav)) {
+        result |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    }
+    if (tr_buffer_usage_uniform_texel_srv == (usage & tr_buffer_usage_uniform_texel_srv)) {
+        result |= VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+    }
+    if (tr_buffer_usage_storage_texel_uav == (usage & tr_buffer_usage_storage_texel_uav)) {
+        result |= VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+    }
+    return result;
+}
+
+VkImageUsageFlags tr_util_to_vk_image_usage(tr_texture_usage_flags usage)
+{
+    VkImageUsageFlags result = 0;
+    if (tr_texture_usage_transfer_src == (usage & tr_texture_usage_transfer_src)) {
+        result |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    if (tr_texture_usage_transfer_dst == (usage & tr_texture_usage_transfer_dst)) {
+        result |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+    if (tr_texture_usage_sampled_image == (usage & tr_texture_usage_sampled_image)) {
+        result |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    }
+    if (tr_texture_usage_storage_image == (usage & tr_texture_usage_storage_image)) {
+        result |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
+    if (tr_texture_usage_color_attachment == (usage & tr_texture_usage_color_attachment)) {
+        result |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    }
+    if (tr_texture_usage_depth_stencil_attachment == (usage & tr_texture_usage_depth_stencil_attachment)) {
+        result |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    }
+    if (tr_texture_usage_transient_attachment == (usage & tr_texture_usage_transient_attachment)) {
+        result |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    }
+    return result;
+}
+
+
+VkImageLayout tr_util_to_vk_image_layout(tr_texture_usage usage)
+{
+    VkImageLayout result = VK_IMAGE_LAYOUT_UNDEFINED;
+    switch(usage) {
+        case tr_texture_usage_transfer_src             : result = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; break;
+        case tr_texture_usage_transfer_dst             : result = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL; break;
+        case tr_texture_usage_sampled_image            : result = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; break;
+        case tr_texture_usage_storage_image            : result = VK_IMAGE_LAYOUT_GENERAL; break;
+        case tr_texture_usage_color_attachment         : result = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; break;
+        case tr_texture_usage_depth_stencil_attachment : result = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; break;
+        case tr_texture_usage_present                  : result = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; break;
+    }
+    return result;
+}
+
+VkImageLayout tr_util_to_vk_texture_layout(const tr_texture* p_texture, tr_texture_usage usage)
+{
+    // Textures with storage usage are sampled in VK_IMAGE_LAYOUT_GENERAL, see
+    // vk_texture_view.imageLayout in tr_internal_vk_create_texture. Host visible
+    // textures are too since host access is only defined in GENERAL and
+    // PREINITIALIZED, which is where they start out.
+    if ((tr_texture_usage_sampled_image == usage) && ((p_texture->usage & tr_texture_usage_storage_image) || p_texture->host_visible)) {
+        return VK_IMAGE_LAYOUT_GENERAL;
+    }
+    if ((tr_texture_usage_undefined == usage) && p_texture->host_visible) {
+        return VK_IMAGE_LAYOUT_PREINITIALIZED;
+    }
+    return tr_util_to_vk_image_layout(usage);
+}
+
+VkAttachmentLoadOp tr_util_to_vk_load_op(tr_attachment_load_op load_op)
+{
+    VkAttachmentLoadOp result = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    switch (load_op) {
+        case tr_attachment_load_op_clear     : result = VK_ATTACHMENT_LOAD_OP_CLEAR; break;
+        case tr_attachment_load_op_load      : result = VK_ATTACHMENT_LOAD_OP_LOAD; break;
+        case tr_attachment_load_op_dont_care : result = VK_ATTACHMENT_LOAD_OP_DONT_CARE; break;
+    }
+    return result;
+}
+
+VkAttachmentStoreOp tr_util_to_vk_store_op(tr_attachment_store_op store_op)
+{
+    VkAttachmentStoreOp result = VK_ATTACHMENT_STORE_OP_STORE;
+    switch (store_op) {
+        case tr_attachment_store_op_store     : result = VK_ATTACHMENT_STORE_OP_STORE; break;
+        case tr_attachment_store_op_dont_care : result = VK_ATTACHMENT_STORE_OP_DONT_CARE; break;
+    }
+    return result;
+}
+
+VkPipelineStageFlags tr_util_to_vk_texture_stages(tr_texture_usage usage)
+{
+    VkPipelineStageFlags result = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    switch(usage) {
+        case tr_texture_usage_transfer_src             : result = VK_PIPELINE_STAGE_TRANSFER_BIT; break;
+        case tr_texture_usage_transfer_dst             : result = VK_PIPELINE_STAGE_TRANSFER_BIT; break;
+        case tr_texture_usage_sampled_image            : 
+        case tr_texture_usage_storage_image            : result = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT; break;
+        case tr_texture_usage_color_attachment         : result = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; break;
+        case tr_texture_usage_depth_stencil_attachment : result = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT; break;
+        // Matches the stage the acquire semaphore is waited on
+        case tr_texture_usage_present                  : result = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; break;
+    }
+    return result;
+}
+
+VkImageAspectFlags tr_util_vk_determine_aspect_mask(VkFormat format)
+{
+    VkImageAspectFlags result = 0;
+    switch( format ) {
+        // Depth
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            result = VK_IMAGE_ASPECT_DEPTH_BIT;
+        break;
+        // Stencil
+        case VK_FORMAT_S8_UINT:
+            result = VK_IMAGE_ASPECT_STENCIL_BIT;
+        break;
+        // Depth/stencil
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            result = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        break;
+        // Assume everything else is Color
+        default:
+            result = VK_IMAGE_ASPECT_COLOR_BIT;
+        break;
+    }
+    return result;
+}
+
+void tr_util_set_texture_usage(tr_texture* p_texture, tr_texture_usage usage)
+{
+    assert(NULL != p_texture->current_mip_usages);
+
+    for (uint32_t i = 0; i < p_texture->mip_levels; ++i) {
+        p_texture->current_mip_usages[i] = usage;
+    }
+}
+
+uint64_t tr_util_hash_bytes(const void* p_data, size_t size)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    const uint8_t* p_bytes = (const uint8_t*)p_data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= p_bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool tr_util_vk_get_memory_type(const VkPhysicalDeviceMemoryProperties* mem_props, uint32_t type_bits, VkMemoryPropertyFlags flags, uint32_t* p_index)
+{
+    bool found = false; 
+    for (uint32_t i = 0; i < mem_props->memoryTypeCount; ++i) {
+        if (type_bits & 1) {
+            if (flags == (mem_props->memoryTypes[i].propertyFlags & flags)) {
+                if (p_index) {
+                    *p_index = i;
+                }
+                found = true;
+                break;
+            }
+        }
+        type_bits >>= 1;
+    }
+    return found;
+}
+
+VkFormatFeatureFlags tr_util_vk_image_usage_to_format_features(VkImageUsageFlags usage)
+{
+    VkFormatFeatureFlags result = (VkFormatFeatureFlags)0;
+    if (VK_IMAGE_USAGE_SAMPLED_BIT== (usage & VK_IMAGE_USAGE_SAMPLED_BIT)) {
+        result |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    }
+    if (VK_IMAGE_USAGE_STORAGE_BIT== (usage & VK_IMAGE_USAGE_STORAGE_BIT)) {
+        result |= VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+    }
+    if (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT== (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)) {
+        result |= VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
+    }
+    if (VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT== (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) {
+        result |= VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    }
+    return result;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Internal trace functions
+// -------------------------------------------------------------------------------------------------
+uint64_t tr_internal_trace_now_us()
+{
+    uint64_t result = 0;
+#if defined(TINY_RENDERER_LINUX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    result = ((uint64_t)ts.tv_sec * 1000000) + ((uint64_t)ts.tv_nsec / 1000);
+#elif defined(TINY_RENDERER_MSW)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    // Split the conversion so the multiply doesn't overflow
+    uint64_t seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+    uint64_t remainder = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+    result = (seconds * 1000000) + ((remainder * 1000000) / (uint64_t)frequency.QuadPart);
+#endif
+    return result;
+}
+
+void tr_internal_trace_add_event(tr_trace* p_trace, const char* name, tr_trace_thread thread, double begin_us, double duration_us)
+{
+    if (p_trace->event_count == p_trace->event_capacity) {
+        p_trace->event_capacity = (0 == p_trace->event_capacity) ? 1024 : (2 * p_trace->event_capacity);
+        p_trace->events = (tr_trace_event*)realloc(p_trace->events, p_trace->event_capacity * sizeof(*(p_trace->events)));
+        assert(NULL != p_trace->events);
+    }
+
+    tr_trace_event* p_event = &(p_trace->events[p_trace->event_count]);
+    ++p_trace->event_count;
+
+    // Names are written into the JSON as is, drop anything that would need escaping
+    uint32_t length = 0;
+    for (; (NULL != name) && ('\0' != name[length]) && (length < (tr_max_trace_event_name_length - 1)); ++length) {
+        char c = name[length];
+        p_event->name[length] = (('"' == c) || ('\\' == c) || (c < ' ')) ? '_' : c;
+    }
+    p_event->name[length] = '\0';
+    p_event->thread       = thread;
+    p_event->begin_us     = begin_us;
+    p_event->duration_us  = duration_us;
+}
+
+void tr_internal_trace_add_cpu_scope(tr_trace* p_trace, const char* name, uint64_t begin_us)
+{
+    uint64_t end_us = tr_internal_trace_now_us();
+    tr_internal_trace_add_event(p_trace, name, tr_trace_thread_cpu, 
+                                (double)(begin_us - p_trace->start_us), (double)(end_us - begin_us));
+}
+
+#if ! defined(TINY_RENDERER_IMAGE_ONLY)
+void tr_internal_vk_calibrate_trace(tr_renderer* p_renderer)
+{
+    tr_trace* p_trace = p_renderer->trace;
+    p_trace->gpu_us_per_tick = (double)p_renderer->vk_active_gpu_properties.limits.timestampPeriod / 1000.0;
+    p_trace->gpu_offset_us = 0;
+    if (VK_TRUE != p_renderer->vk_active_gpu_properties.limits.timestampComputeAndGraphics) {
+        return;
+    }
+
+    tr_query_pool* p_query_pool = NULL;
+    tr_create_query_pool(p_renderer, tr_query_type_timestamp, 1, &p_query_pool);
+    tr_cmd_pool* p_cmd_pool = NULL;
+    tr_create_cmd_pool(p_renderer, p_renderer->graphics_queue, true, &p_cmd_pool);
+    tr_cmd* p_cmd = NULL;
+    tr_create_cmd(p_cmd_pool, false, &p_cmd);
+    tr_fence* p_fence = NULL;
+    tr_create_fence(p_renderer, &p_fence);
+
+    tr_begin_cmd(p_cmd);
+    tr_internal_vk_cmd_reset_query_pool(p_cmd, p_query_pool);
+    tr_internal_vk_cmd_write_timestamp(p_cmd, p_query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    tr_end_cmd(p_cmd);
+    tr_internal_vk_queue_submit(p_renderer->graphics_queue, 1, &p_cmd, 0, NULL, 0, NULL, p_fence);
+
+    // The timestamp was written just before the fence signaled, the wake up latency 
+    // shows up as GPU scopes being a little late.
+    VkResult vk_res = vkWaitForFences(p_renderer->vk_device, 1, &(p_fence->vk_fence), VK_TRUE, UINT64_MAX);
+    assert(VK_SUCCESS == vk_res);
+    uint64_t cpu_us = tr_internal_trace_now_us() - p_trace->start_us;
+
+    uint64_t gpu_ticks = 0;
+    bool ready = tr_get_query_pool_results(p_query_pool, 0, 1, &gpu_ticks);
+    assert(ready);
+    gpu_ticks &= p_query_pool->timestamp_mask;
+    p_trace->gpu_offset_us = (double)cpu_us - ((double)gpu_ticks * p_trace->gpu_us_per_tick);
+
+    tr_destroy_fence(p_renderer, p_fence);
+    tr_destroy_cmd(p_cmd_pool, p_cmd);
+    tr_destroy_cmd_pool(p_renderer, p_cmd_pool);
+    tr_destroy_query_pool(p_renderer, p_query_pool);
+}
+#endif // ! defined(TINY_RENDERER_IMAGE_ONLY)
+
+// -------------------------------------------------------------------------------------------------
+// Internal image resize functions
+// -------------------------------------------------------------------------------------------------
+float tr_internal_resize_filter_support(tr_image_filter filter)
+{
+    float result = 0.5f;
+    switch (filter) {
+        case tr_image_filter_mitchell : result = 2.0f; break;
+        case tr_image_filter_lanczos3 : result = 3.0f; break;
+        default: break;
+    }
+    return result;
+}
+
+float tr_internal_resize_filter_weight(tr_image_filter filter, float x)
+{
+    const float k_pi = 3.14159265358979f;
+    float result = 0.0f;
+    switch (filter) {
+        case tr_image_filter_mitchell: {
+            // B = C = 1/3
+            const float B = 1.0f / 3.0f;
+            const float C = 1.0f / 3.0f;
+            x = fabsf(x);
+            if (x < 1.0f) {
+                result = ((12.0f - 9.0f * B - 6.0f * C) * x * x * x + (-18.0f + 12.0f * B + 6.0f * C) * x * x + (6.0f - 2.0f * B)) / 6.0f;
+            }
+            else if (x < 2.0f) {
+                result = ((-B - 6.0f * C) * x * x * x + (6.0f * B + 30.0f * C) * x * x + (-12.0f * B - 48.0f * C) * x + (8.0f * B + 24.0f * C)) / 6.0f;
+            }
+        }
+        break;
+
+        case tr_image_filter_lanczos3: {
+            if (fabsf(x) < 1e-6f) {
+                result = 1.0f;
+            }
+            else if (fabsf(x) < 3.0f) {
+                float px = k_pi * x;
+                result = 3.0f * sinf(px) * sinf(px / 3.0f) / (px * px);
+            }
+        }
+        break;
 
-    tr_destroy_buffer(p_buffer->renderer, buffer);
+        default: {
+            result = ((x >= -0.5f) && (x < 0.5f)) ? 1.0f : 0.0f;
+        }
+        break;
+    }
+    return result;
 }
 
-void tr_util_update_texture_uint8(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t src_channel_count, tr_texture* p_texture, tr_image_resize_uint8_fn resize_fn, void* p_user_data)
+void tr_internal_resize_build_taps(tr_image_filter filter, uint32_t src_size, uint32_t dst_size, uint32_t* p_tap_count, uint32_t** pp_first, float** pp_weights)
+{
+    // Downsizing widens the filter so every source texel contributes
+    const float scale = (float)src_size / (float)dst_size;
+    const float filter_scale = (scale > 1.0f) ? scale : 1.0f;
+    const float support = tr_internal_resize_filter_support(filter) * filter_scale;
+    const uint32_t tap_count = tr_min((uint32_t)ceilf(2.0f * support) + 1, src_size);
+
+    uint32_t* p_first = (uint32_t*)calloc(dst_size, sizeof(*p_first));
+    float* p_weights = (float*)calloc((size_t)dst_size * tap_count, sizeof(*p_weights));
+    assert(NULL != p_first);
+    assert(NULL != p_weights);
+
+    for (uint32_t d = 0; d < dst_size; ++d) {
+        const float center = ((float)d + 0.5f) * scale;
+        const int32_t begin = (int32_t)ceilf(center - support - 0.5f);
+        const int32_t end = (int32_t)floorf(center + support - 0.5f);
+        // Keep the tap window inside the image, samples past the edges are
+        // clamped and their weights folded onto the edge texels.
+        int32_t first = begin;
+        if ((first + (int32_t)tap_count) > (int32_t)src_size) {
+            first = (int32_t)src_size - (int32_t)tap_count;
+        }
+        if (first < 0) {
+            first = 0;
+        }
+        p_first[d] = (uint32_t)first;
+
+        float* p_tap_weights = p_weights + ((size_t)d * tap_count);
+        float sum = 0.0f;
+        for (int32_t i = begin; i <= end; ++i) {
+            float weight = tr_internal_resize_filter_weight(filter, ((float)i + 0.5f - center) / filter_scale);
+            int32_t src_index = (i < 0) ? 0 : ((i >= (int32_t)src_size) ? ((int32_t)src_size - 1) : i);
+            int32_t tap = src_index - first;
+            if ((tap >= 0) && (tap < (int32_t)tap_count)) {
+                p_tap_weights[tap] += weight;
+                sum += weight;
+            }
+        }
+
+        if (fabsf(sum) > 1e-6f) {
+            for (uint32_t t = 0; t < tap_count; ++t) {
+                p_tap_weights[t] /= sum;
+            }
+        }
+        else {
+            uint32_t nearest = tr_min((uint32_t)center, src_size - 1);
+            p_tap_weights[tr_min(nearest - p_first[d], tap_count - 1)] = 1.0f;
+        }
+    }
+
+    *p_tap_count = tap_count;
+    *pp_first = p_first;
+    *pp_weights = p_weights;
+}
+
+void tr_internal_resize_accumulate_row(float* p_dst, const uint8_t* p_src, uint32_t count, float weight)
+{
+    uint32_t i = 0;
+#if defined(TINY_RENDERER_AVX2)
+    const __m256 weight_256 = _mm256_set1_ps(weight);
+    for (; (i + 8) <= count; i += 8) {
+        __m256i src_i32 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(p_src + i)));
+        __m256 dst = _mm256_loadu_ps(p_dst + i);
+        dst = _mm256_add_ps(dst, _mm256_mul_ps(_mm256_cvtepi32_ps(src_i32), weight_256));
+        _mm256_storeu_ps(p_dst + i, dst);
+    }
+#elif defined(TINY_RENDERER_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 weight_128 = _mm_set1_ps(weight);
+    for (; (i + 16) <= count; i += 16) {
+        __m128i src_u8 = _mm_loadu_si128((const __m128i*)(p_src + i));
+        __m128i src_lo = _mm_unpacklo_epi8(src_u8, zero);
+        __m128i src_hi = _mm_unpackhi_epi8(src_u8, zero);
+        __m128 src_f32[4];
+        src_f32[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(src_lo, zero));
+        src_f32[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(src_lo, zero));
+        src_f32[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(src_hi, zero));
+        src_f32[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(src_hi, zero));
+        for (uint32_t j = 0; j < 4; ++j) {
+            __m128 dst = _mm_loadu_ps(p_dst + i + (4 * j));
+            dst = _mm_add_ps(dst, _mm_mul_ps(src_f32[j], weight_128));
+            _mm_storeu_ps(p_dst + i + (4 * j), dst);
+        }
+    }
+#elif defined(TINY_RENDERER_NEON)
+    for (; (i + 16) <= count; i += 16) {
+        uint8x16_t src_u8 = vld1q_u8(p_src + i);
+        uint16x8_t src_lo = vmovl_u8(vget_low_u8(src_u8));
+        uint16x8_t src_hi = vmovl_u8(vget_high_u8(src_u8));
+        float32x4_t src_f32[4];
+        src_f32[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(src_lo)));
+        src_f32[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(src_lo)));
+        src_f32[2] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(src_hi)));
+        src_f32[3] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(src_hi)));
+        for (uint32_t j = 0; j < 4; ++j) {
+            float32x4_t dst = vld1q_f32(p_dst + i + (4 * j));
+            vst1q_f32(p_dst + i + (4 * j), vmlaq_n_f32(dst, src_f32[j], weight));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        p_dst[i] += weight * (float)p_src[i];
+    }
+}
+
+void tr_internal_resize_box_2x_rows(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end)
+{
+    const uint32_t channel_count = p_job->channel_count;
+    const uint32_t src_pixel_stride = 2 * channel_count;
+    for (uint32_t y = row_begin; y < row_end; ++y) {
+        const uint8_t* src_row_0 = p_job->p_src_data + ((2 * y) * p_job->src_row_stride);
+        const uint8_t* src_row_1 = src_row_0 + p_job->src_row_stride;
+        uint8_t* dst_row = p_job->p_dst_data + (y * p_job->dst_row_stride);
+
+        uint32_t x = 0;
+#if defined(TINY_RENDERER_SSE2)
+        // 4 RGBA destination pixels per iteration, the float shuffles only move bits
+        if (4 == channel_count) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i two = _mm_set1_epi16(2);
+            for (; (x + 4) <= p_job->dst_width; x += 4) {
+                __m128 a_0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(src_row_0 + (8 * x))));
+                __m128 b_0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(src_row_0 + (8 * x) + 16)));
+                __m128 a_1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(src_row_1 + (8 * x))));
+                __m128 b_1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(src_row_1 + (8 * x) + 16)));
+                __m128i even_0 = _mm_castps_si128(_mm_shuffle_ps(a_0, b_0, _MM_SHUFFLE(2, 0, 2, 0)));
+                __m128i odd_0  = _mm_castps_si128(_mm_shuffle_ps(a_0, b_0, _MM_SHUFFLE(3, 1, 3, 1)));
+                __m128i even_1 = _mm_castps_si128(_mm_shuffle_ps(a_1, b_1, _MM_SHUFFLE(2, 0, 2, 0)));
+                __m128i odd_1  = _mm_castps_si128(_mm_shuffle_ps(a_1, b_1, _MM_SHUFFLE(3, 1, 3, 1)));
+                __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(even_0, zero), _mm_unpacklo_epi8(odd_0, zero)),
+                                           _mm_add_epi16(_mm_unpacklo_epi8(even_1, zero), _mm_unpacklo_epi8(odd_1, zero)));
+                __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(even_0, zero), _mm_unpackhi_epi8(odd_0, zero)),
+                                           _mm_add_epi16(_mm_unpackhi_epi8(even_1, zero), _mm_unpackhi_epi8(odd_1, zero)));
+                lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+                hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+                _mm_storeu_si128((__m128i*)(dst_row + (4 * x)), _mm_packus_epi16(lo, hi));
+            }
+        }
+#elif defined(TINY_RENDERER_NEON)
+        if (4 == channel_count) {
+            for (; (x + 4) <= p_job->dst_width; x += 4) {
+                uint32x4x2_t pixels_0 = vld2q_u32((const uint32_t*)(src_row_0 + (8 * x)));
+                uint32x4x2_t pixels_1 = vld2q_u32((const uint32_t*)(src_row_1 + (8 * x)));
+                uint8x16_t even_0 = vreinterpretq_u8_u32(pixels_0.val[0]);
+                uint8x16_t odd_0  = vreinterpretq_u8_u32(pixels_0.val[1]);
+                uint8x16_t even_1 = vreinterpretq_u8_u32(pixels_1.val[0]);
+                uint8x16_t odd_1  = vreinterpretq_u8_u32(pixels_1.val[1]);
+                uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(even_0), vget_low_u8(odd_0)),
+                                          vaddl_u8(vget_low_u8(even_1), vget_low_u8(odd_1)));
+                uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(even_0), vget_high_u8(odd_0)),
+                                          vaddl_u8(vget_high_u8(even_1), vget_high_u8(odd_1)));
+                vst1q_u8(dst_row + (4 * x), vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+            }
+        }
+#endif
+        for (; x < p_job->dst_width; ++x) {
+            const uint8_t* src_pixel_0 = src_row_0 + (x * src_pixel_stride);
+            const uint8_t* src_pixel_1 = src_row_1 + (x * src_pixel_stride);
+            uint8_t* dst_pixel = dst_row + (x * channel_count);
+            for (uint32_t c = 0; c < channel_count; ++c) {
+                uint32_t sum = (uint32_t)src_pixel_0[c] + (uint32_t)src_pixel_0[channel_count + c] +
+                               (uint32_t)src_pixel_1[c] + (uint32_t)src_pixel_1[channel_count + c];
+                dst_pixel[c] = (uint8_t)((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+void tr_internal_resize_separable_rows(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end)
 {
-    assert(NULL != p_queue);
-    assert(NULL != p_src_data);
-    assert(NULL != p_texture);
-    assert(NULL != p_texture->vk_image);
-    assert((src_width > 0) && (src_height > 0) && (src_row_stride > 0));
-    assert(tr_sample_count_1 == p_texture->sample_count);
+    const uint32_t channel_count = p_job->channel_count;
+    const uint32_t row_element_count = p_job->src_width * channel_count;
+    // Vertical pass into a float row, then horizontal pass out of it
+    float* p_row = (float*)calloc(row_element_count, sizeof(*p_row));
+    assert(NULL != p_row);
 
-    uint8_t* p_expanded_src_data = NULL;
-    const uint32_t dst_channel_count = tr_util_format_channel_count(p_texture->format);
-    assert(src_channel_count < dst_channel_count);
+    for (uint32_t y = row_begin; y < row_end; ++y) {
+        memset(p_row, 0, row_element_count * sizeof(*p_row));
+        const float* p_v_weights = p_job->v_weights + ((size_t)y * p_job->v_tap_count);
+        for (uint32_t t = 0; t < p_job->v_tap_count; ++t) {
+            if (0.0f == p_v_weights[t]) {
+                continue;
+            }
+            const uint8_t* p_src_row = p_job->p_src_data + ((size_t)(p_job->v_first[y] + t) * p_job->src_row_stride);
+            tr_internal_resize_accumulate_row(p_row, p_src_row, row_element_count, p_v_weights[t]);
+        }
+
+        uint8_t* p_dst_row = p_job->p_dst_data + ((size_t)y * p_job->dst_row_stride);
+        for (uint32_t x = 0; x < p_job->dst_width; ++x) {
+            const float* p_h_weights = p_job->h_weights + ((size_t)x * p_job->h_tap_count);
+            const float* p_src = p_row + ((size_t)p_job->h_first[x] * channel_count);
+            uint8_t* p_dst_pixel = p_dst_row + (x * channel_count);
+#if defined(TINY_RENDERER_SSE2)
+            if (4 == channel_count) {
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t t = 0; t < p_job->h_tap_count; ++t) {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(p_h_weights[t]), _mm_loadu_ps(p_src + (4 * t))));
+                }
+                __m128i sum_i32 = _mm_cvtps_epi32(sum);
+                __m128i sum_i16 = _mm_packs_epi32(sum_i32, sum_i32);
+                int32_t pixel = _mm_cvtsi128_si32(_mm_packus_epi16(sum_i16, sum_i16));
+                memcpy(p_dst_pixel, &pixel, 4);
+                continue;
+            }
+#elif defined(TINY_RENDERER_NEON)
+            if (4 == channel_count) {
+                float32x4_t sum = vdupq_n_f32(0.0f);
+                for (uint32_t t = 0; t < p_job->h_tap_count; ++t) {
+                    sum = vmlaq_n_f32(sum, vld1q_f32(p_src + (4 * t)), p_h_weights[t]);
+                }
+                sum = vaddq_f32(vmaxq_f32(sum, vdupq_n_f32(0.0f)), vdupq_n_f32(0.5f));
+                uint16x4_t sum_u16 = vqmovn_u32(vcvtq_u32_f32(sum));
+                uint8x8_t sum_u8 = vqmovn_u16(vcombine_u16(sum_u16, sum_u16));
+                vst1_lane_u32((uint32_t*)p_dst_pixel, vreinterpret_u32_u8(sum_u8), 0);
+                continue;
+            }
+#endif
+            for (uint32_t c = 0; c < channel_count; ++c) {
+                float sum = 0.0f;
+                for (uint32_t t = 0; t < p_job->h_tap_count; ++t) {
+                    sum += p_h_weights[t] * p_src[(t * channel_count) + c];
+                }
+                sum = (sum < 0.0f) ? 0.0f : ((sum > 255.0f) ? 255.0f : sum);
+                p_dst_pixel[c] = (uint8_t)(sum + 0.5f);
+            }
+        }
+    }
 
-    if (src_channel_count < dst_channel_count) {
-        uint32_t expanded_row_stride = src_width * dst_channel_count;
-        uint32_t expanded_size = expanded_row_stride * src_height;
-        p_expanded_src_data = (uint8_t*)calloc(1, expanded_size);
-        assert(NULL != p_expanded_src_data);
+    TINY_RENDERER_SAFE_FREE(p_row);
+}
 
-        const uint32_t src_pixel_stride = src_channel_count;
-        const uint32_t expanded_pixel_stride = dst_channel_count;
-        const uint8_t* src_row = p_src_data;
-        uint8_t* expanded_row = p_expanded_src_data;
-        for (uint32_t y = 0; y < src_height; ++y) {
-            const uint8_t* src_pixel = src_row;
-            uint8_t* expanded_pixel = expanded_row;
-            for (uint32_t x = 0; x < src_width; ++x) {
-                uint32_t c = 0; 
-                for (; c < src_channel_count; ++c) {
-                    *(expanded_pixel + c) = *(src_pixel + c);
+void tr_internal_resize_accumulate_row_float(float* p_dst, const float* p_src, uint32_t count, float weight)
+{
+    uint32_t i = 0;
+#if defined(TINY_RENDERER_AVX2)
+    const __m256 weight_256 = _mm256_set1_ps(weight);
+    for (; (i + 8) <= count; i += 8) {
+        __m256 dst = _mm256_loadu_ps(p_dst + i);
+        dst = _mm256_add_ps(dst, _mm256_mul_ps(_mm256_loadu_ps(p_src + i), weight_256));
+        _mm256_storeu_ps(p_dst + i, dst);
+    }
+#elif defined(TINY_RENDERER_SSE2)
+    const __m128 weight_128 = _mm_set1_ps(weight);
+    for (; (i + 4) <= count; i += 4) {
+        __m128 dst = _mm_loadu_ps(p_dst + i);
+        dst = _mm_add_ps(dst, _mm_mul_ps(_mm_loadu_ps(p_src + i), weight_128));
+        _mm_storeu_ps(p_dst + i, dst);
+    }
+#elif defined(TINY_RENDERER_NEON)
+    for (; (i + 4) <= count; i += 4) {
+        vst1q_f32(p_dst + i, vmlaq_n_f32(vld1q_f32(p_dst + i), vld1q_f32(p_src + i), weight));
+    }
+#endif
+    for (; i < count; ++i) {
+        p_dst[i] += weight * p_src[i];
+    }
+}
+
+void tr_internal_resize_box_2x_rows_float(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end)
+{
+    const uint32_t channel_count = p_job->channel_count;
+    const uint32_t src_pixel_stride = 2 * channel_count;
+    for (uint32_t y = row_begin; y < row_end; ++y) {
+        const float* src_row_0 = (const float*)(p_job->p_src_data + ((size_t)(2 * y) * p_job->src_row_stride));
+        const float* src_row_1 = (const float*)((const uint8_t*)src_row_0 + p_job->src_row_stride);
+        float* dst_row = (float*)(p_job->p_dst_data + ((size_t)y * p_job->dst_row_stride));
+
+        uint32_t x = 0;
+#if defined(TINY_RENDERER_SSE2)
+        if (4 == channel_count) {
+            const __m128 quarter = _mm_set1_ps(0.25f);
+            for (; x < p_job->dst_width; ++x) {
+                __m128 sum_0 = _mm_add_ps(_mm_loadu_ps(src_row_0 + (8 * x)), _mm_loadu_ps(src_row_0 + (8 * x) + 4));
+                __m128 sum_1 = _mm_add_ps(_mm_loadu_ps(src_row_1 + (8 * x)), _mm_loadu_ps(src_row_1 + (8 * x) + 4));
+                _mm_storeu_ps(dst_row + (4 * x), _mm_mul_ps(_mm_add_ps(sum_0, sum_1), quarter));
+            }
+        }
+#elif defined(TINY_RENDERER_NEON)
+        if (4 == channel_count) {
+            for (; x < p_job->dst_width; ++x) {
+                float32x4_t sum_0 = vaddq_f32(vld1q_f32(src_row_0 + (8 * x)), vld1q_f32(src_row_0 + (8 * x) + 4));
+                float32x4_t sum_1 = vaddq_f32(vld1q_f32(src_row_1 + (8 * x)), vld1q_f32(src_row_1 + (8 * x) + 4));
+                vst1q_f32(dst_row + (4 * x), vmulq_n_f32(vaddq_f32(sum_0, sum_1), 0.25f));
+            }
+        }
+#endif
+        for (; x < p_job->dst_width; ++x) {
+            const float* src_pixel_0 = src_row_0 + (x * src_pixel_stride);
+            const float* src_pixel_1 = src_row_1 + (x * src_pixel_stride);
+            float* dst_pixel = dst_row + (x * channel_count);
+            for (uint32_t c = 0; c < channel_count; ++c) {
+                float sum = (src_pixel_0[c] + src_pixel_0[channel_count + c]) +
+                            (src_pixel_1[c] + src_pixel_1[channel_count + c]);
+                dst_pixel[c] = 0.25f * sum;
+            }
+        }
+    }
+}
+
+void tr_internal_resize_separable_rows_float(const tr_internal_resize_job* p_job, uint32_t row_begin, uint32_t row_end)
+{
+    const uint32_t channel_count = p_job->channel_count;
+    const uint32_t row_element_count = p_job->src_width * channel_count;
+    float* p_row = (float*)calloc(row_element_count, sizeof(*p_row));
+    assert(NULL != p_row);
+
+    for (uint32_t y = row_begin; y < row_end; ++y) {
+        memset(p_row, 0, row_element_count * sizeof(*p_row));
+        const float* p_v_weights = p_job->v_weights + ((size_t)y * p_job->v_tap_count);
+        for (uint32_t t = 0; t < p_job->v_tap_count; ++t) {
+            if (0.0f == p_v_weights[t]) {
+                continue;
+            }
+            const float* p_src_row = (const float*)(p_job->p_src_data + ((size_t)(p_job->v_first[y] + t) * p_job->src_row_stride));
+            tr_internal_resize_accumulate_row_float(p_row, p_src_row, row_element_count, p_v_weights[t]);
+        }
+
+        float* p_dst_row = (float*)(p_job->p_dst_data + ((size_t)y * p_job->dst_row_stride));
+        for (uint32_t x = 0; x < p_job->dst_width; ++x) {
+            const float* p_h_weights = p_job->h_weights + ((size_t)x * p_job->h_tap_count);
+            const float* p_src = p_row + ((size_t)p_job->h_first[x] * channel_count);
+            float* p_dst_pixel = p_dst_row + (x * channel_count);
+#if defined(TINY_RENDERER_SSE2)
+            if (4 == channel_count) {
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t t = 0; t < p_job->h_tap_count; ++t) {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(p_h_weights[t]), _mm_loadu_ps(p_src + (4 * t))));
                 }
-                for (; c < dst_channel_count; ++c) {
-                    *(expanded_pixel + c) = 0xFF;
+                _mm_storeu_ps(p_dst_pixel, sum);
+                continue;
+            }
+#elif defined(TINY_RENDERER_NEON)
+            if (4 == channel_count) {
+                float32x4_t sum = vdupq_n_f32(0.0f);
+                for (uint32_t t = 0; t < p_job->h_tap_count; ++t) {
+                    sum = vmlaq_n_f32(sum, vld1q_f32(p_src + (4 * t)), p_h_weights[t]);
+                }
+                vst1q_f32(p_dst_pixel, sum);
+                continue;
+            }
+#endif
+            for (uint32_t c = 0; c < channel_count; ++c) {
+                float sum = 0.0f;
+                for (uint32_t t = 0; t < p_job->h_tap_count; ++t) {
+                    sum += p_h_weights[t] * p_src[(t * channel_count) + c];
                 }
-                src_pixel += src_pixel_stride;
-                expanded_pixel += expanded_pixel_stride;
+                p_dst_pixel[c] = sum;
             }
-            src_row += src_row_stride;
-            expanded_row += expanded_row_stride;
         }
-        src_row_stride = expanded_row_stride;
-        src_channel_count = dst_channel_count;
-        p_src_data = p_expanded_src_data;
     }
 
-    // Get memory requirements that covers all mip levels
-    TINY_RENDERER_DECLARE_ZERO(VkMemoryRequirements, mem_reqs);
-    vkGetImageMemoryRequirements(p_texture->renderer->vk_device, p_texture->vk_image, &mem_reqs);
-    // Create temporary buffer big enough to fit all mip levels
-    tr_buffer* buffer = NULL;
-    tr_create_buffer(p_texture->renderer, tr_buffer_usage_transfer_src, mem_reqs.size, true, &buffer);
-    //
-    // If you're coming from D3D12, you might want to do something like:
-    //
-    //   // Get resource layout for all mip levels
-    //   VkSubresourceLayout* subres_layouts = (VkSubresourceLayout*)calloc(p_texture->mip_levels, sizeof(*subres_layouts));
-    //   assert(NULL != subres_layouts);
-    //   VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_texture->format));
-    //   for (uint32_t i = 0; i < p_texture->mip_levels; ++i) {
-    //       TINY_RENDERER_DECLARE_ZERO(VkImageSubresource, img_sub_res);
-    //       img_sub_res.aspectMask = aspect_mask;
-    //       img_sub_res.mipLevel   = i;
-    //       img_sub_res.arrayLayer = 0;
-    //       vkGetImageSubresourceLayout(p_texture->renderer->vk_device, p_texture->vk_image, &img_sub_res, &(subres_layouts[i]));
-    //   } 
-    //
-    // ...unfortunately, in Vulkan this approach may be slightly 
-    // problematic, because you can only call vkGetImageSubresourceLayout on
-    // an image that was created with VK_IMAGE_TILING_LINEAR. The validation
-    // layers will issue an error if vkGetImageSubresourceLayout get called
-    // on an image created with VK_IMAGE_TILING_OPTIMAL. For now, since the
-    // total size of the memory is correct, we'll just calculate the row pitch
-    // and offset for each mip level manually.
-    // 
-    
-    // Use default simple resize if a resize function was not supplied
-    if (NULL == resize_fn) {
-        resize_fn = &tr_image_resize_uint8_t;
+    TINY_RENDERER_SAFE_FREE(p_row);
+}
+
+void tr_internal_resize_rows(const void* p_param, uint32_t row_begin, uint32_t row_end)
+{
+    const tr_internal_resize_job* p_job = (const tr_internal_resize_job*)p_param;
+    if (p_job->float_data) {
+        if (NULL == p_job->h_weights) {
+            tr_internal_resize_box_2x_rows_float(p_job, row_begin, row_end);
+        }
+        else {
+            tr_internal_resize_separable_rows_float(p_job, row_begin, row_end);
+        }
     }
-    // Resize image into appropriate mip level
-    uint32_t dst_width = p_texture->width;
-    uint32_t dst_height = p_texture->height;
-    VkDeviceSize buffer_offset = 0;
-    for (uint32_t mip_level = 0; mip_level < p_texture->mip_levels; ++mip_level) {
-        uint32_t dst_row_stride = src_row_stride >> mip_level;
-        uint8_t* p_dst_data = (uint8_t*)buffer->cpu_mapped_address + buffer_offset;
-        resize_fn(src_width, src_height, src_row_stride, p_src_data, dst_width, dst_height, dst_row_stride, p_dst_data, dst_channel_count, p_user_data);
-        buffer_offset += dst_row_stride * dst_height;
-        dst_width >>= 1;
-        dst_height >>= 1;
+    else if (NULL == p_job->h_weights) {
+        tr_internal_resize_box_2x_rows(p_job, row_begin, row_end);
+    }
+    else {
+        tr_internal_resize_separable_rows(p_job, row_begin, row_end);
     }
+}
 
-    // Copy buffer to texture
-    buffer_offset = 0;
-    VkFormat format = tr_util_to_vk_format(p_texture->format);
-    VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(format);
+uint32_t tr_internal_cpu_count()
+{
+    uint32_t result = 1;
+#if defined(TINY_RENDERER_LINUX)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    result = (count > 0) ? (uint32_t)count : 1;
+#elif defined(TINY_RENDERER_MSW)
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    result = (uint32_t)system_info.dwNumberOfProcessors;
+#endif
+    return result;
+}
+
+#if defined(TINY_RENDERER_LINUX)
+static void* tr_internal_rows_thread_proc(void* p_param)
+{
+    tr_internal_rows_worker* p_worker = (tr_internal_rows_worker*)p_param;
+    p_worker->rows_fn(p_worker->job, p_worker->row_begin, p_worker->row_end);
+    return NULL;
+}
+#elif defined(TINY_RENDERER_MSW)
+static DWORD WINAPI tr_internal_rows_thread_proc(LPVOID p_param)
+{
+    tr_internal_rows_worker* p_worker = (tr_internal_rows_worker*)p_param;
+    p_worker->rows_fn(p_worker->job, p_worker->row_begin, p_worker->row_end);
+    return 0;
+}
+#endif
+
+void tr_internal_run_rows(tr_internal_rows_fn rows_fn, const void* p_job, uint32_t row_count, uint32_t thread_count)
+{
+    // Each thread takes a contiguous band of rows
+    thread_count = tr_max(tr_min(thread_count, row_count), 1);
+#if defined(TINY_RENDERER_LINUX) || defined(TINY_RENDERER_MSW)
+    if (thread_count > 1) {
+        tr_internal_rows_worker* p_workers = (tr_internal_rows_worker*)calloc(thread_count, sizeof(*p_workers));
+        assert(NULL != p_workers);
+  #if defined(TINY_RENDERER_LINUX)
+        pthread_t* p_threads = (pthread_t*)calloc(thread_count, sizeof(*p_threads));
+  #else
+        HANDLE* p_threads = (HANDLE*)calloc(thread_count, sizeof(*p_threads));
+  #endif
+        assert(NULL != p_threads);
+
+        const uint32_t rows_per_thread = (row_count + thread_count - 1) / thread_count;
+        for (uint32_t i = 0; i < thread_count; ++i) {
+            p_workers[i].rows_fn   = rows_fn;
+            p_workers[i].job       = p_job;
+            p_workers[i].row_begin = tr_min(i * rows_per_thread, row_count);
+            p_workers[i].row_end   = tr_min((i + 1) * rows_per_thread, row_count);
+        }
+        // The calling thread does the first band itself
+        for (uint32_t i = 1; i < thread_count; ++i) {
+  #if defined(TINY_RENDERER_LINUX)
+            int res = pthread_create(&p_threads[i], NULL, tr_internal_rows_thread_proc, &p_workers[i]);
+            assert(0 == res);
+  #else
+            p_threads[i] = CreateThread(NULL, 0, tr_internal_rows_thread_proc, &p_workers[i], 0, NULL);
+            assert(NULL != p_threads[i]);
+  #endif
+        }
+        rows_fn(p_job, p_workers[0].row_begin, p_workers[0].row_end);
+        for (uint32_t i = 1; i < thread_count; ++i) {
+  #if defined(TINY_RENDERER_LINUX)
+            pthread_join(p_threads[i], NULL);
+  #else
+            WaitForSingleObject(p_threads[i], INFINITE);
+            CloseHandle(p_threads[i]);
+  #endif
+        }
+
+        TINY_RENDERER_SAFE_FREE(p_threads);
+        TINY_RENDERER_SAFE_FREE(p_workers);
+        return;
+    }
+#endif
+    rows_fn(p_job, 0, row_count);
+}
+
+void tr_internal_resize_run(tr_internal_resize_job* p_job, uint32_t thread_count)
+{
+    tr_internal_run_rows(tr_internal_resize_rows, p_job, p_job->dst_height, thread_count);
+}
+
+void tr_internal_mip_chain_barrier(tr_internal_mip_chain* p_chain)
+{
+#if defined(TINY_RENDERER_LINUX)
+    pthread_mutex_lock(&(p_chain->mutex));
+    const uint32_t generation = p_chain->generation;
+    if (++(p_chain->arrived) == p_chain->thread_count) {
+        p_chain->arrived = 0;
+        ++(p_chain->generation);
+        pthread_cond_broadcast(&(p_chain->cond));
+    }
+    while (generation == p_chain->generation) {
+        pthread_cond_wait(&(p_chain->cond), &(p_chain->mutex));
+    }
+    pthread_mutex_unlock(&(p_chain->mutex));
+#elif defined(TINY_RENDERER_MSW)
+    EnterCriticalSection(&(p_chain->mutex));
+    const uint32_t generation = p_chain->generation;
+    if (++(p_chain->arrived) == p_chain->thread_count) {
+        p_chain->arrived = 0;
+        ++(p_chain->generation);
+        WakeAllConditionVariable(&(p_chain->cond));
+    }
+    while (generation == p_chain->generation) {
+        SleepConditionVariableCS(&(p_chain->cond), &(p_chain->mutex), INFINITE);
+    }
+    LeaveCriticalSection(&(p_chain->mutex));
+#else
+    (void)p_chain;
+#endif
+}
+
+void tr_internal_mip_chain_work(tr_internal_mip_chain* p_chain, uint32_t worker_index)
+{
+    for (uint32_t level = 0; level < p_chain->level_count; ++level) {
+        const tr_internal_resize_job* p_job = &(p_chain->jobs[level]);
+        const tr_internal_mip_chain_level* p_level = &(p_chain->levels[level]);
+        const uint32_t level_thread_count = p_chain->level_thread_counts[level];
+        if (worker_index < level_thread_count) {
+            const uint32_t rows_per_thread = (p_job->dst_height + level_thread_count - 1) / level_thread_count;
+            const uint32_t row_begin = tr_min(worker_index * rows_per_thread, p_job->dst_height);
+            const uint32_t row_end = tr_min((worker_index + 1) * rows_per_thread, p_job->dst_height);
+            const size_t row_size = (size_t)p_job->dst_width * p_job->channel_count;
+            if (p_chain->copies[level]) {
+                for (uint32_t y = row_begin; y < row_end; ++y) {
+                    memcpy(p_job->p_dst_data + ((size_t)y * p_job->dst_row_stride), p_job->p_src_data + ((size_t)y * p_job->src_row_stride), row_size);
+                }
+            }
+            else if (tr_image_filter_point == p_job->filter) {
+                // Point filtered levels always run on a single worker
+                tr_image_resize_uint8_t(p_job->src_width, p_job->src_height, p_job->src_row_stride, p_job->p_src_data,
+                                        p_job->dst_width, p_job->dst_height, p_job->dst_row_stride, p_job->p_dst_data,
+                                        p_job->channel_count, NULL);
+            }
+            else {
+                tr_internal_resize_rows(p_job, row_begin, row_end);
+            }
+            // Levels built in scratch are copied out band by band
+            if (p_job->p_dst_data != p_level->p_data) {
+                for (uint32_t y = row_begin; y < row_end; ++y) {
+                    memcpy(p_level->p_data + ((size_t)y * p_level->row_stride), p_job->p_dst_data + ((size_t)y * p_job->dst_row_stride), row_size);
+                }
+            }
+        }
+        // The next level reads rows from every band of this one
+        if ((p_chain->thread_count > 1) && ((level + 1) < p_chain->level_count)) {
+            tr_internal_mip_chain_barrier(p_chain);
+        }
+    }
+}
+
+#if defined(TINY_RENDERER_LINUX)
+static void* tr_internal_mip_chain_thread_proc(void* p_param)
+{
+    tr_internal_mip_chain_worker* p_worker = (tr_internal_mip_chain_worker*)p_param;
+    tr_internal_mip_chain_work(p_worker->chain, p_worker->index);
+    return NULL;
+}
+#elif defined(TINY_RENDERER_MSW)
+static DWORD WINAPI tr_internal_mip_chain_thread_proc(LPVOID p_param)
+{
+    tr_internal_mip_chain_worker* p_worker = (tr_internal_mip_chain_worker*)p_param;
+    tr_internal_mip_chain_work(p_worker->chain, p_worker->index);
+    return 0;
+}
+#endif
+
+void tr_internal_resize_mip_chain_uint8(uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const uint8_t* p_src_data, uint32_t channel_count, uint32_t level_count, const tr_internal_mip_chain_level* p_levels, const tr_image_resize_settings* p_settings)
+{
+    assert(NULL != p_src_data);
+    assert(NULL != p_levels);
+    assert(channel_count > 0);
+
+    if ((0 == src_width) || (0 == src_height) || (0 == level_count)) {
+        return;
+    }
+
+    const tr_image_filter filter = (NULL != p_settings) ? p_settings->filter : tr_image_filter_auto;
+    const uint32_t thread_count = (NULL != p_settings) ? p_settings->thread_count : 0;
+    const uint32_t cpu_count = (0 != thread_count) ? thread_count : tr_internal_cpu_count();
+
+    TINY_RENDERER_DECLARE_ZERO(tr_internal_mip_chain, chain);
+    chain.level_count         = level_count;
+    chain.levels              = p_levels;
+    chain.jobs                = (tr_internal_resize_job*)calloc(level_count, sizeof(*(chain.jobs)));
+    chain.copies              = (bool*)calloc(level_count, sizeof(*(chain.copies)));
+    chain.level_thread_counts = (uint32_t*)calloc(level_count, sizeof(*(chain.level_thread_counts)));
+    chain.thread_count        = 1;
+    assert(NULL != chain.jobs);
+    assert(NULL != chain.copies);
+    assert(NULL != chain.level_thread_counts);
+
+    // Levels that feed another level ping-pong between two scratch buffers, the last
+    // level and straight copies of the source go directly to their destination.
+    size_t scratch_sizes[2] = { 0, 0 };
+    uint32_t level_src_width = src_width;
+    uint32_t level_src_height = src_height;
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const tr_internal_mip_chain_level* p_level = &(p_levels[level]);
+        chain.copies[level] = (level_src_width == p_level->width) && (level_src_height == p_level->height);
+        if ((! chain.copies[level]) && ((level + 1) < level_count)) {
+            const size_t size = (size_t)p_level->width * p_level->height * channel_count;
+            scratch_sizes[level & 1] = (size > scratch_sizes[level & 1]) ? size : scratch_sizes[level & 1];
+        }
+        level_src_width = p_level->width;
+        level_src_height = p_level->height;
+    }
+    uint8_t* p_scratch[2] = { NULL, NULL };
+    for (uint32_t i = 0; i < 2; ++i) {
+        if (scratch_sizes[i] > 0) {
+            p_scratch[i] = (uint8_t*)calloc(1, scratch_sizes[i]);
+            assert(NULL != p_scratch[i]);
+        }
+    }
+
+    level_src_width = src_width;
+    level_src_height = src_height;
+    uint32_t level_src_row_stride = src_row_stride;
+    const uint8_t* p_level_src_data = p_src_data;
+    for (uint32_t level = 0; level < level_count; ++level) {
+        const tr_internal_mip_chain_level* p_level = &(p_levels[level]);
+        const bool in_place = chain.copies[level] || ((level + 1) == level_count);
+        tr_internal_resize_job* p_job = &(chain.jobs[level]);
+        p_job->filter         = filter;
+        p_job->channel_count  = channel_count;
+        p_job->src_width      = level_src_width;
+        p_job->src_height     = level_src_height;
+        p_job->src_row_stride = level_src_row_stride;
+        p_job->p_src_data     = p_level_src_data;
+        p_job->dst_width      = p_level->width;
+        p_job->dst_height     = p_level->height;
+        p_job->dst_row_stride = in_place ? p_level->row_stride : (p_level->width * channel_count);
+        p_job->p_dst_data     = in_place ? p_level->p_data : p_scratch[level & 1];
+
+        if (! chain.copies[level]) {
+            const bool is_half = (level_src_width == (2 * p_level->width)) && (level_src_height == (2 * p_level->height));
+            if (tr_image_filter_auto == p_job->filter) {
+                p_job->filter = is_half ? tr_image_filter_box : tr_image_filter_lanczos3;
+            }
+            // Exact 2x box reductions have a dedicated path and don't need taps
+            if ((tr_image_filter_point != p_job->filter) && (! ((tr_image_filter_box == p_job->filter) && is_half))) {
+                tr_internal_resize_build_taps(p_job->filter, level_src_width, p_level->width, &p_job->h_tap_count, &p_job->h_first, &p_job->h_weights);
+                tr_internal_resize_build_taps(p_job->filter, level_src_height, p_level->height, &p_job->v_tap_count, &p_job->v_first, &p_job->v_weights);
+            }
+        }
+
+        // Thread start up isn't worth it for small mip levels, but the threads are shared by
+        // every level so only the levels that are large enough use them.
+        uint32_t level_thread_count = 1;
+        if (chain.copies[level] || (tr_image_filter_point != p_job->filter)) {
+            level_thread_count = ((0 != thread_count) || ((p_level->width * p_level->height) >= (128 * 128))) ? cpu_count : 1;
+        }
+        chain.level_thread_counts[level] = tr_max(tr_min(level_thread_count, p_level->height), 1);
+        chain.thread_count = tr_max(chain.thread_count, chain.level_thread_counts[level]);
+
+        // Straight copies leave the source as the next level's input
+        if (! chain.copies[level]) {
+            level_src_width = p_job->dst_width;
+            level_src_height = p_job->dst_height;
+            level_src_row_stride = p_job->dst_row_stride;
+            p_level_src_data = p_job->p_dst_data;
+        }
+    }
+
+#if defined(TINY_RENDERER_LINUX) || defined(TINY_RENDERER_MSW)
+    if (chain.thread_count > 1) {
+        tr_internal_mip_chain_worker* p_workers = (tr_internal_mip_chain_worker*)calloc(chain.thread_count, sizeof(*p_workers));
+        assert(NULL != p_workers);
+  #if defined(TINY_RENDERER_LINUX)
+        pthread_t* p_threads = (pthread_t*)calloc(chain.thread_count, sizeof(*p_threads));
+        pthread_mutex_init(&(chain.mutex), NULL);
+        pthread_cond_init(&(chain.cond), NULL);
+  #else
+        HANDLE* p_threads = (HANDLE*)calloc(chain.thread_count, sizeof(*p_threads));
+        InitializeCriticalSection(&(chain.mutex));
+        InitializeConditionVariable(&(chain.cond));
+  #endif
+        assert(NULL != p_threads);
+
+        // The calling thread is the first worker
+        for (uint32_t i = 1; i < chain.thread_count; ++i) {
+            p_workers[i].chain = &chain;
+            p_workers[i].index = i;
+  #if defined(TINY_RENDERER_LINUX)
+            int res = pthread_create(&p_threads[i], NULL, tr_internal_mip_chain_thread_proc, &p_workers[i]);
+            assert(0 == res);
+  #else
+            p_threads[i] = CreateThread(NULL, 0, tr_internal_mip_chain_thread_proc, &p_workers[i], 0, NULL);
+            assert(NULL != p_threads[i]);
+  #endif
+        }
+        tr_internal_mip_chain_work(&chain, 0);
+        for (uint32_t i = 1; i < chain.thread_count; ++i) {
+  #if defined(TINY_RENDERER_LINUX)
+            pthread_join(p_threads[i], NULL);
+  #else
+            WaitForSingleObject(p_threads[i], INFINITE);
+            CloseHandle(p_threads[i]);
+  #endif
+        }
+
+  #if defined(TINY_RENDERER_LINUX)
+        pthread_cond_destroy(&(chain.cond));
+        pthread_mutex_destroy(&(chain.mutex));
+  #else
+        DeleteCriticalSection(&(chain.mutex));
+  #endif
+        TINY_RENDERER_SAFE_FREE(p_threads);
+        TINY_RENDERER_SAFE_FREE(p_workers);
+    }
+    else
+#endif
     {
-        const uint32_t region_count = p_texture->mip_levels;
-        VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(region_count, sizeof(*regions));
-        assert(NULL != regions);
+        tr_internal_mip_chain_work(&chain, 0);
+    }
+
+    for (uint32_t level = 0; level < level_count; ++level) {
+        TINY_RENDERER_SAFE_FREE(chain.jobs[level].h_first);
+        TINY_RENDERER_SAFE_FREE(chain.jobs[level].h_weights);
+        TINY_RENDERER_SAFE_FREE(chain.jobs[level].v_first);
+        TINY_RENDERER_SAFE_FREE(chain.jobs[level].v_weights);
+    }
+    TINY_RENDERER_SAFE_FREE(p_scratch[0]);
+    TINY_RENDERER_SAFE_FREE(p_scratch[1]);
+    TINY_RENDERER_SAFE_FREE(chain.level_thread_counts);
+    TINY_RENDERER_SAFE_FREE(chain.copies);
+    TINY_RENDERER_SAFE_FREE(chain.jobs);
+}
+
+uint16_t tr_internal_float_to_half(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    uint32_t result = 0;
+    if (magnitude >= 0x7F800000) {
+        // Inf stays inf, NaN keeps its top payload bits and stays quiet
+        result = (magnitude > 0x7F800000) ? (0x7E00 | ((magnitude >> 13) & 0x3FF)) : 0x7C00;
+    }
+    else if (magnitude >= 0x477FF000) {
+        // 65520 and up round to inf
+        result = 0x7C00;
+    }
+    else if (magnitude < 0x38800000) {
+        // Half denormals, everything up to 2^-25 rounds to zero
+        if (magnitude > 0x33000000) {
+            const uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+            const uint32_t shift = 126 - (magnitude >> 23);
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+            result = mantissa >> shift;
+            result += ((remainder > halfway) || ((remainder == halfway) && (result & 1))) ? 1 : 0;
+        }
+    }
+    else {
+        // Rebias the exponent, a rounding carry correctly moves into the exponent
+        const uint32_t remainder = magnitude & 0x1FFF;
+        result = (magnitude - 0x38000000) >> 13;
+        result += ((remainder > 0x1000) || ((remainder == 0x1000) && (result & 1))) ? 1 : 0;
+    }
+    return (uint16_t)(sign | result);
+}
+
+void tr_internal_float_to_half_row(uint16_t* p_dst, const float* p_src, uint32_t count)
+{
+    uint32_t i = 0;
+#if defined(TINY_RENDERER_F16C)
+    for (; (i + 8) <= count; i += 8) {
+        __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(p_src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(p_dst + i), half);
+    }
+#elif defined(TINY_RENDERER_NEON_FP16)
+    for (; (i + 8) <= count; i += 8) {
+        float16x4_t lo = vcvt_f16_f32(vld1q_f32(p_src + i));
+        float16x4_t hi = vcvt_f16_f32(vld1q_f32(p_src + i + 4));
+        vst1q_u16(p_dst + i, vcombine_u16(vreinterpret_u16_f16(lo), vreinterpret_u16_f16(hi)));
+    }
+#endif
+    for (; i < count; ++i) {
+        p_dst[i] = tr_internal_float_to_half(p_src[i]);
+    }
+}
+
+void tr_internal_expand_channels_row(uint8_t* p_dst, const uint8_t* p_src, uint32_t pixel_count, uint32_t src_channel_count, uint32_t dst_channel_count)
+{
+    uint32_t x = 0;
+    // RGB and grey sources into RGBA are the common cases
+    if (4 == dst_channel_count) {
+#if defined(TINY_RENDERER_SSSE3)
+        if (3 == src_channel_count) {
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+            // 16 byte loads for 12 bytes of pixels, stop early enough to stay inside the row
+            for (; (x + 6) <= pixel_count; x += 4) {
+                __m128i rgb = _mm_loadu_si128((const __m128i*)(p_src + (3 * x)));
+                _mm_storeu_si128((__m128i*)(p_dst + (4 * x)), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+            }
+        }
+#elif defined(TINY_RENDERER_NEON)
+        if (3 == src_channel_count) {
+            for (; (x + 16) <= pixel_count; x += 16) {
+                uint8x16x3_t rgb = vld3q_u8(p_src + (3 * x));
+                uint8x16x4_t rgba;
+                rgba.val[0] = rgb.val[0];
+                rgba.val[1] = rgb.val[1];
+                rgba.val[2] = rgb.val[2];
+                rgba.val[3] = vdupq_n_u8(0xFF);
+                vst4q_u8(p_dst + (4 * x), rgba);
+            }
+        }
+#endif
+#if defined(TINY_RENDERER_SSE2)
+        if (1 == src_channel_count) {
+            const __m128i ones = _mm_set1_epi8((char)0xFF);
+            for (; (x + 16) <= pixel_count; x += 16) {
+                __m128i grey = _mm_loadu_si128((const __m128i*)(p_src + x));
+                __m128i lo = _mm_unpacklo_epi8(grey, ones);
+                __m128i hi = _mm_unpackhi_epi8(grey, ones);
+                _mm_storeu_si128((__m128i*)(p_dst + (4 * x)),      _mm_unpacklo_epi16(lo, ones));
+                _mm_storeu_si128((__m128i*)(p_dst + (4 * x) + 16), _mm_unpackhi_epi16(lo, ones));
+                _mm_storeu_si128((__m128i*)(p_dst + (4 * x) + 32), _mm_unpacklo_epi16(hi, ones));
+                _mm_storeu_si128((__m128i*)(p_dst + (4 * x) + 48), _mm_unpackhi_epi16(hi, ones));
+            }
+        }
+#elif defined(TINY_RENDERER_NEON)
+        if (1 == src_channel_count) {
+            for (; (x + 16) <= pixel_count; x += 16) {
+                uint8x16x4_t rgba;
+                rgba.val[0] = vld1q_u8(p_src + x);
+                rgba.val[1] = vdupq_n_u8(0xFF);
+                rgba.val[2] = vdupq_n_u8(0xFF);
+                rgba.val[3] = vdupq_n_u8(0xFF);
+                vst4q_u8(p_dst + (4 * x), rgba);
+            }
+        }
+#endif
+    }
+
+    const uint8_t* src_pixel = p_src + (x * src_channel_count);
+    uint8_t* dst_pixel = p_dst + (x * dst_channel_count);
+    for (; x < pixel_count; ++x) {
+        uint32_t c = 0;
+        for (; c < src_channel_count; ++c) {
+            dst_pixel[c] = src_pixel[c];
+        }
+        for (; c < dst_channel_count; ++c) {
+            dst_pixel[c] = 0xFF;
+        }
+        src_pixel += src_channel_count;
+        dst_pixel += dst_channel_count;
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Internal block compression functions
+// -------------------------------------------------------------------------------------------------
+void tr_internal_bc_load_block(const tr_internal_bc_job* p_job, uint32_t block_x, uint32_t block_y, uint8_t* p_rgba)
+{
+    const uint32_t x0 = 4 * block_x;
+    const uint32_t y0 = 4 * block_y;
+    const bool full_width = (x0 + 4) <= p_job->width;
+    for (uint32_t y = 0; y < 4; ++y) {
+        // Edge blocks repeat the last row/column
+        uint32_t src_y = tr_min(y0 + y, p_job->height - 1);
+        const uint8_t* p_src_row = p_job->p_src_data + ((size_t)src_y * p_job->src_row_stride);
+        if (full_width) {
+            memcpy(p_rgba + (16 * y), p_src_row + (4 * x0), 16);
+            continue;
+        }
+        for (uint32_t x = 0; x < 4; ++x) {
+            uint32_t src_x = tr_min(x0 + x, p_job->width - 1);
+            memcpy(p_rgba + (16 * y) + (4 * x), p_src_row + (4 * src_x), 4);
+        }
+    }
+}
+
+uint16_t tr_internal_bc_pack_565(const float* p_rgb)
+{
+    const float k_scales[3] = { 31.0f, 63.0f, 31.0f };
+    uint32_t packed[3];
+    for (uint32_t c = 0; c < 3; ++c) {
+        float value = (p_rgb[c] < 0.0f) ? 0.0f : ((p_rgb[c] > 255.0f) ? 255.0f : p_rgb[c]);
+        packed[c] = (uint32_t)((value * k_scales[c] / 255.0f) + 0.5f);
+    }
+    uint16_t result = (uint16_t)((packed[0] << 11) | (packed[1] << 5) | packed[2]);
+    return result;
+}
+
+void tr_internal_bc_unpack_565(uint16_t color, int32_t* p_rgb)
+{
+    int32_t r = (color >> 11) & 0x1F;
+    int32_t g = (color >> 5) & 0x3F;
+    int32_t b = color & 0x1F;
+    p_rgb[0] = (r << 3) | (r >> 2);
+    p_rgb[1] = (g << 2) | (g >> 4);
+    p_rgb[2] = (b << 3) | (b >> 2);
+}
+
+uint32_t tr_internal_bc1_indices(const uint8_t* p_rgba, uint16_t color_0, uint16_t color_1, bool three_color, uint32_t* p_indices)
+{
+    int32_t palette[4][3];
+    tr_internal_bc_unpack_565(color_0, palette[0]);
+    tr_internal_bc_unpack_565(color_1, palette[1]);
+    for (uint32_t c = 0; c < 3; ++c) {
+        if (three_color) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        else {
+            palette[2][c] = ((2 * palette[0][c]) + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + (2 * palette[1][c])) / 3;
+        }
+    }
+
+    // Index 3 is transparent black in three color mode
+    const uint32_t color_count = three_color ? 3 : 4;
+    uint32_t indices = 0;
+    uint32_t error = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+        const uint8_t* p_pixel = p_rgba + (4 * i);
+        uint32_t best_index = 3;
+        uint32_t best_error = 0;
+        if ((! three_color) || (p_pixel[3] >= 128)) {
+            best_error = UINT32_MAX;
+            for (uint32_t j = 0; j < color_count; ++j) {
+                int32_t dr = (int32_t)p_pixel[0] - palette[j][0];
+                int32_t dg = (int32_t)p_pixel[1] - palette[j][1];
+                int32_t db = (int32_t)p_pixel[2] - palette[j][2];
+                uint32_t pixel_error = (uint32_t)((dr * dr) + (dg * dg) + (db * db));
+                if (pixel_error < best_error) {
+                    best_error = pixel_error;
+                    best_index = j;
+                }
+            }
+        }
+        indices |= best_index << (2 * i);
+        error += best_error;
+    }
+
+    *p_indices = indices;
+    return error;
+}
 
-        dst_width = p_texture->width;
-        dst_height = p_texture->height;
-        for (uint32_t mip_level = 0; mip_level < p_texture->mip_levels; ++mip_level) {
-            regions[mip_level].bufferOffset                    = buffer_offset;
-            regions[mip_level].bufferRowLength                 = dst_width;
-            regions[mip_level].bufferImageHeight               = dst_height;
-            regions[mip_level].imageSubresource.aspectMask     = aspect_mask;
-            regions[mip_level].imageSubresource.mipLevel       = mip_level;
-            regions[mip_level].imageSubresource.baseArrayLayer = 0;
-            regions[mip_level].imageSubresource.layerCount     = 1;
-            regions[mip_level].imageOffset.x                   = 0;
-            regions[mip_level].imageOffset.y                   = 0;
-            regions[mip_level].imageOffset.z                   = 0;
-            regions[mip_level].imageExtent.width               = dst_width;
-            regions[mip_level].imageExtent.height              = dst_height;
-            regions[mip_level].imageExtent.depth               = 1;
-            buffer_offset += (src_row_stride >> mip_level) * dst_height;
-            dst_width >>= 1;
-            dst_height >>= 1;
+void tr_internal_bc1_encode_block(const uint8_t* p_rgba, bool allow_transparent, uint8_t* p_dst)
+{
+    // Mean and covariance of the opaque pixels
+    bool three_color = false;
+    uint32_t count = 0;
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t i = 0; i < 16; ++i) {
+        const uint8_t* p_pixel = p_rgba + (4 * i);
+        if (allow_transparent && (p_pixel[3] < 128)) {
+            three_color = true;
+            continue;
         }
-        
-        tr_cmd_pool* p_cmd_pool = NULL;
-        tr_create_cmd_pool(p_queue->renderer, p_queue, true, &p_cmd_pool);
-
-        tr_cmd* p_cmd = NULL;
-        tr_create_cmd(p_cmd_pool, false, &p_cmd);
+        mean[0] += p_pixel[0];
+        mean[1] += p_pixel[1];
+        mean[2] += p_pixel[2];
+        ++count;
+    }
+
+    uint16_t color_0 = 0;
+    uint16_t color_1 = 0;
+    uint32_t indices = 0xFFFFFFFF;
+    if (count > 0) {
+        mean[0] /= (float)count;
+        mean[1] /= (float)count;
+        mean[2] /= (float)count;
+
+        float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t i = 0; i < 16; ++i) {
+            const uint8_t* p_pixel = p_rgba + (4 * i);
+            if (three_color && (p_pixel[3] < 128)) {
+                continue;
+            }
+            float r = p_pixel[0] - mean[0];
+            float g = p_pixel[1] - mean[1];
+            float b = p_pixel[2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+
+        // Principal axis by power iteration, starting from the covariance row of the
+        // channel with the most variance so anti-correlated channels still converge
+        float axis[3] = { cov[0], cov[1], cov[2] };
+        if ((cov[3] >= cov[0]) && (cov[3] >= cov[5])) {
+            axis[0] = cov[1]; axis[1] = cov[3]; axis[2] = cov[4];
+        }
+        else if ((cov[5] >= cov[0]) && (cov[5] >= cov[3])) {
+            axis[0] = cov[2]; axis[1] = cov[4]; axis[2] = cov[5];
+        }
+        for (uint32_t iteration = 0; iteration < 4; ++iteration) {
+            float r = (axis[0] * cov[0]) + (axis[1] * cov[1]) + (axis[2] * cov[2]);
+            float g = (axis[0] * cov[1]) + (axis[1] * cov[3]) + (axis[2] * cov[4]);
+            float b = (axis[0] * cov[2]) + (axis[1] * cov[4]) + (axis[2] * cov[5]);
+            float scale = fmaxf(fabsf(r), fmaxf(fabsf(g), fabsf(b)));
+            if (scale <= 0.0f) {
+                break;
+            }
+            axis[0] = r / scale;
+            axis[1] = g / scale;
+            axis[2] = b / scale;
+        }
+
+        // Endpoints are the opaque pixels furthest along the axis
+        float min_dot = FLT_MAX;
+        float max_dot = -FLT_MAX;
+        float end_0[3] = { mean[0], mean[1], mean[2] };
+        float end_1[3] = { mean[0], mean[1], mean[2] };
+        for (uint32_t i = 0; i < 16; ++i) {
+            const uint8_t* p_pixel = p_rgba + (4 * i);
+            if (three_color && (p_pixel[3] < 128)) {
+                continue;
+            }
+            float dot = (p_pixel[0] * axis[0]) + (p_pixel[1] * axis[1]) + (p_pixel[2] * axis[2]);
+            if (dot < min_dot) {
+                min_dot = dot;
+                end_1[0] = p_pixel[0]; end_1[1] = p_pixel[1]; end_1[2] = p_pixel[2];
+            }
+            if (dot > max_dot) {
+                max_dot = dot;
+                end_0[0] = p_pixel[0]; end_0[1] = p_pixel[1]; end_0[2] = p_pixel[2];
+            }
+        }
+        color_0 = tr_internal_bc_pack_565(end_0);
+        color_1 = tr_internal_bc_pack_565(end_1);
 
-        tr_begin_cmd(p_cmd);
-        //
-        // Vulkan textures are created with VK_IMAGE_LAYOUT_UNDEFFINED (tr_texture_usage_undefined)
-        //
-        tr_internal_vk_cmd_image_transition(p_cmd, p_texture, tr_texture_usage_undefined, tr_texture_usage_transfer_dst);
-        vkCmdCopyBufferToImage(p_cmd->vk_cmd_buf, buffer->vk_buffer, p_texture->vk_image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region_count, regions);
-        tr_internal_vk_cmd_image_transition(p_cmd, p_texture, tr_texture_usage_transfer_dst, tr_texture_usage_sampled_image);
-        tr_end_cmd(p_cmd);
+        if (three_color) {
+            // Three color mode needs color_0 <= color_1
+            if (color_0 > color_1) {
+                uint16_t tmp = color_0; color_0 = color_1; color_1 = tmp;
+            }
+            tr_internal_bc1_indices(p_rgba, color_0, color_1, true, &indices);
+        }
+        else {
+            // Four color mode needs color_0 > color_1, equal endpoints encode a solid block
+            if (color_0 < color_1) {
+                uint16_t tmp = color_0; color_0 = color_1; color_1 = tmp;
+            }
+            uint32_t error = 0;
+            indices = 0;
+            if (color_0 != color_1) {
+                error = tr_internal_bc1_indices(p_rgba, color_0, color_1, false, &indices);
+            }
 
-        tr_queue_submit(p_queue, 1, &p_cmd, 0, NULL, 0, NULL);
-        tr_queue_wait_idle(p_queue);
+            // One least squares refit of the endpoints for the chosen indices
+            if (error > 0) {
+                const float k_weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+                float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+                float ax[3] = { 0.0f, 0.0f, 0.0f };
+                float bx[3] = { 0.0f, 0.0f, 0.0f };
+                for (uint32_t i = 0; i < 16; ++i) {
+                    float a = k_weights[(indices >> (2 * i)) & 3];
+                    float b = 1.0f - a;
+                    aa += a * a; ab += a * b; bb += b * b;
+                    for (uint32_t c = 0; c < 3; ++c) {
+                        ax[c] += a * p_rgba[(4 * i) + c];
+                        bx[c] += b * p_rgba[(4 * i) + c];
+                    }
+                }
+                float det = (aa * bb) - (ab * ab);
+                if (fabsf(det) > 1e-6f) {
+                    float refit_0[3];
+                    float refit_1[3];
+                    for (uint32_t c = 0; c < 3; ++c) {
+                        refit_0[c] = ((ax[c] * bb) - (bx[c] * ab)) / det;
+                        refit_1[c] = ((bx[c] * aa) - (ax[c] * ab)) / det;
+                    }
+                    uint16_t refit_color_0 = tr_internal_bc_pack_565(refit_0);
+                    uint16_t refit_color_1 = tr_internal_bc_pack_565(refit_1);
+                    if (refit_color_0 < refit_color_1) {
+                        uint16_t tmp = refit_color_0; refit_color_0 = refit_color_1; refit_color_1 = tmp;
+                    }
+                    if (refit_color_0 != refit_color_1) {
+                        uint32_t refit_indices = 0;
+                        uint32_t refit_error = tr_internal_bc1_indices(p_rgba, refit_color_0, refit_color_1, false, &refit_indices);
+                        if (refit_error < error) {
+                            color_0 = refit_color_0;
+                            color_1 = refit_color_1;
+                            indices = refit_indices;
+                        }
+                    }
+                }
+            }
+        }
+    }
 
-        tr_destroy_cmd(p_cmd_pool, p_cmd);
-        tr_destroy_cmd_pool(p_queue->renderer, p_cmd_pool);
+    p_dst[0] = (uint8_t)(color_0 & 0xFF);
+    p_dst[1] = (uint8_t)(color_0 >> 8);
+    p_dst[2] = (uint8_t)(color_1 & 0xFF);
+    p_dst[3] = (uint8_t)(color_1 >> 8);
+    p_dst[4] = (uint8_t)(indices & 0xFF);
+    p_dst[5] = (uint8_t)((indices >> 8) & 0xFF);
+    p_dst[6] = (uint8_t)((indices >> 16) & 0xFF);
+    p_dst[7] = (uint8_t)(indices >> 24);
+}
 
-        tr_destroy_buffer(p_texture->renderer, buffer);
+void tr_internal_bc4_encode_block(const uint8_t* p_rgba, uint32_t channel, uint8_t* p_dst)
+{
+    uint32_t min_value = 255;
+    uint32_t max_value = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+        min_value = tr_min(min_value, (uint32_t)p_rgba[(4 * i) + channel]);
+        max_value = tr_max(max_value, (uint32_t)p_rgba[(4 * i) + channel]);
+    }
 
-        TINY_RENDERER_SAFE_FREE(regions);
+    // max > min selects the eight value mode, equal endpoints leave all indices at 0.
+    // The palette is evenly spaced from max to min, so the nearest entry is a rounded
+    // division and only needs remapping to the index order (max, min, 6 interpolants).
+    const uint64_t k_index_map[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+    uint64_t bits = 0;
+    if (max_value > min_value) {
+        const uint32_t range = max_value - min_value;
+        for (uint32_t i = 0; i < 16; ++i) {
+            uint32_t value = p_rgba[(4 * i) + channel];
+            uint32_t step = (((max_value - value) * 14) + range) / (2 * range);
+            bits |= k_index_map[step] << (3 * i);
+        }
     }
 
-    TINY_RENDERER_SAFE_FREE(p_expanded_src_data);
+    p_dst[0] = (uint8_t)max_value;
+    p_dst[1] = (uint8_t)min_value;
+    for (uint32_t i = 0; i < 6; ++i) {
+        p_dst[2 + i] = (uint8_t)((bits >> (8 * i)) & 0xFF);
+    }
 }
 
-void tr_util_update_texture_float(tr_queue* p_queue, uint32_t src_width, uint32_t src_height, uint32_t src_row_stride, const float* p_src_data, uint32_t channels, tr_texture* p_texture, tr_image_resize_float_fn resize_fn, void* p_user_data)
+void tr_internal_bc_encode_rows(const void* p_param, uint32_t row_begin, uint32_t row_end)
 {
+    const tr_internal_bc_job* p_job = (const tr_internal_bc_job*)p_param;
+    const uint32_t block_size = tr_util_format_stride(p_job->format);
+    const uint32_t block_count_x = (p_job->width + 3) / 4;
+    uint8_t rgba[64];
+    for (uint32_t block_y = row_begin; block_y < row_end; ++block_y) {
+        uint8_t* p_dst = p_job->p_dst_data + ((size_t)block_y * p_job->dst_row_pitch);
+        for (uint32_t block_x = 0; block_x < block_count_x; ++block_x) {
+            tr_internal_bc_load_block(p_job, block_x, block_y, rgba);
+            switch (p_job->format) {
+                case tr_format_bc1_rgba_unorm: {
+                    tr_internal_bc1_encode_block(rgba, true, p_dst);
+                }
+                break;
+                case tr_format_bc3_unorm: {
+                    tr_internal_bc4_encode_block(rgba, 3, p_dst);
+                    tr_internal_bc1_encode_block(rgba, false, p_dst + 8);
+                }
+                break;
+                case tr_format_bc4_unorm: {
+                    tr_internal_bc4_encode_block(rgba, 0, p_dst);
+                }
+                break;
+                case tr_format_bc5_unorm: {
+                    tr_internal_bc4_encode_block(rgba, 0, p_dst);
+                    tr_internal_bc4_encode_block(rgba, 1, p_dst + 8);
+                }
+                break;
+                default: break;
+            }
+            p_dst += block_size;
+        }
+    }
 }
 
 // -------------------------------------------------------------------------------------------------
-// Internal utility functions
+// Internal texture file functions
 // -------------------------------------------------------------------------------------------------
-VkSampleCountFlagBits tr_util_to_vk_sample_count(tr_sample_count sample_count) 
-{
-    VkSampleCountFlagBits result = VK_SAMPLE_COUNT_1_BIT;
-    switch (sample_count) {
-        case tr_sample_count_1  : result = VK_SAMPLE_COUNT_1_BIT;  break;
-        case tr_sample_count_2  : result = VK_SAMPLE_COUNT_2_BIT;  break;
-        case tr_sample_count_4  : result = VK_SAMPLE_COUNT_4_BIT;  break;
-        case tr_sample_count_8  : result = VK_SAMPLE_COUNT_8_BIT;  break;
-        case tr_sample_count_16 : result = VK_SAMPLE_COUNT_16_BIT; break;
-    }
-    return result;
-}
-
-VkBufferUsageFlags tr_util_to_vk_buffer_usage(tr_buffer_usage usage)
+bool tr_internal_map_file(const char* file_path, tr_internal_mapped_file* p_file)
 {
-    VkBufferUsageFlags result = 0;
-    if (tr_buffer_usage_index == (usage & tr_buffer_usage_index)) {
-        result |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-    }
-    if (tr_buffer_usage_vertex == (usage & tr_buffer_usage_vertex)) {
-        result |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    }
-    if (tr_buffer_usage_indirect == (usage & tr_buffer_usage_indirect)) {
-        result |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
-    }
-    if (tr_buffer_usage_transfer_src == (usage & tr_buffer_usage_transfer_src)) {
-        result |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    memset(p_file, 0, sizeof(*p_file));
+#if defined(TINY_RENDERER_LINUX)
+    int fd = open(file_path, O_RDONLY);
+    if (fd < 0) {
+        return false;
     }
-    if (tr_buffer_usage_transfer_dst == (usage & tr_buffer_usage_transfer_dst)) {
-        result |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    struct stat info;
+    void* p_mapped = MAP_FAILED;
+    if ((0 == fstat(fd, &info)) && (info.st_size > 0)) {
+        p_mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
     }
-    if (tr_buffer_usage_uniform_cbv == (usage & tr_buffer_usage_uniform_cbv)) {
-        result |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (MAP_FAILED == p_mapped) {
+        return false;
     }
-    if (tr_buffer_usage_storage_srv == (usage & tr_buffer_usage_storage_srv)) {
-        result |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    madvise(p_mapped, (size_t)info.st_size, MADV_SEQUENTIAL);
+    p_file->p_data = (const uint8_t*)p_mapped;
+    p_file->size = (uint64_t)info.st_size;
+    return true;
+#elif defined(TINY_RENDERER_MSW)
+    p_file->file = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (INVALID_HANDLE_VALUE == p_file->file) {
+        return false;
     }
-    if (tr_buffer_usage_storage_uav == (usage & tr_buffer_usage_storage_uav)) {
-        result |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    LARGE_INTEGER file_size;
+    if ((! GetFileSizeEx(p_file->file, &file_size)) || (file_size.QuadPart <= 0)) {
+        CloseHandle(p_file->file);
+        return false;
     }
-    if (tr_buffer_usage_uniform_texel_srv == (usage & tr_buffer_usage_uniform_texel_srv)) {
-        result |= VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+    p_file->mapping = CreateFileMappingA(p_file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (NULL == p_file->mapping) {
+        CloseHandle(p_file->file);
+        return false;
     }
-    if (tr_buffer_usage_storage_texel_uav == (usage & tr_buffer_usage_storage_texel_uav)) {
-        result |= VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+    p_file->p_data = (const uint8_t*)MapViewOfFile(p_file->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (NULL == p_file->p_data) {
+        CloseHandle(p_file->mapping);
+        CloseHandle(p_file->file);
+        return false;
     }
-    return result;
+    p_file->size = (uint64_t)file_size.QuadPart;
+    return true;
+#else
+    (void)file_path;
+    return false;
+#endif
 }
 
-VkImageUsageFlags tr_util_to_vk_image_usage(tr_texture_usage_flags usage)
+void tr_internal_unmap_file(tr_internal_mapped_file* p_file)
 {
-    VkImageUsageFlags result = 0;
-    if (tr_texture_usage_transfer_src == (usage & tr_texture_usage_transfer_src)) {
-        result |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-    }
-    if (tr_texture_usage_transfer_dst == (usage & tr_texture_usage_transfer_dst)) {
-        result |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    }
-    if (tr_texture_usage_sampled_image == (usage & tr_texture_usage_sampled_image)) {
-        result |= VK_IMAGE_USAGE_SAMPLED_BIT;
-    }
-    if (tr_texture_usage_storage_image == (usage & tr_texture_usage_storage_image)) {
-        result |= VK_IMAGE_USAGE_STORAGE_BIT;
-    }
-    if (tr_texture_usage_color_attachment == (usage & tr_texture_usage_color_attachment)) {
-        result |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+#if defined(TINY_RENDERER_LINUX)
+    if (NULL != p_file->p_data) {
+        munmap((void*)p_file->p_data, (size_t)p_file->size);
     }
-    if (tr_texture_usage_depth_stencil_attachment == (usage & tr_texture_usage_depth_stencil_attachment)) {
-        result |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+#elif defined(TINY_RENDERER_MSW)
+    if (NULL != p_file->p_data) {
+        UnmapViewOfFile(p_file->p_data);
+        CloseHandle(p_file->mapping);
+        CloseHandle(p_file->file);
     }
-    return result;
+#endif
+    memset(p_file, 0, sizeof(*p_file));
 }
 
-
-VkImageLayout tr_util_to_vk_image_layout(tr_texture_usage usage)
+tr_format tr_internal_dds_dxgi_format(uint32_t dxgi_format)
 {
-    VkImageLayout result = VK_IMAGE_LAYOUT_UNDEFINED;
-    switch(usage) {
-        case tr_texture_usage_transfer_src             : result = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; break;
-        case tr_texture_usage_transfer_dst             : result = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL; break;
-        case tr_texture_usage_sampled_image            : result = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; break;
-        case tr_texture_usage_storage_image            : result = VK_IMAGE_LAYOUT_GENERAL; break;
-        case tr_texture_usage_color_attachment         : result = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; break;
-        case tr_texture_usage_depth_stencil_attachment : result = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; break;
-        case tr_texture_usage_present                  : result = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; break;
+    tr_format result = tr_format_undefined;
+    switch (dxgi_format) {
+        case  2: result = tr_format_r32g32b32a32_float; break;
+        case 10: result = tr_format_r16g16b16a16_float; break;
+        case 11: result = tr_format_r16g16b16a16_unorm; break;
+        case 16: result = tr_format_r32g32_float; break;
+        case 28: result = tr_format_r8g8b8a8_unorm; break;
+        case 34: result = tr_format_r16g16_float; break;
+        case 35: result = tr_format_r16g16_unorm; break;
+        case 41: result = tr_format_r32_float; break;
+        case 49: result = tr_format_r8g8_unorm; break;
+        case 54: result = tr_format_r16_float; break;
+        case 56: result = tr_format_r16_unorm; break;
+        case 61: result = tr_format_r8_unorm; break;
+        case 71: result = tr_format_bc1_rgba_unorm; break;
+        case 77: result = tr_format_bc3_unorm; break;
+        case 80: result = tr_format_bc4_unorm; break;
+        case 83: result = tr_format_bc5_unorm; break;
+        case 87: result = tr_format_b8g8r8a8_unorm; break;
+        case 98: result = tr_format_bc7_unorm; break;
+        default: break;
     }
     return result;
 }
 
-VkImageAspectFlags tr_util_vk_determine_aspect_mask(VkFormat format)
+bool tr_internal_dds_parse(const uint8_t* p_data, uint64_t size, tr_internal_dds_image* p_image)
 {
-    VkImageAspectFlags result = 0;
-    switch( format ) {
-        // Depth
-        case VK_FORMAT_D16_UNORM:
-        case VK_FORMAT_X8_D24_UNORM_PACK32:
-        case VK_FORMAT_D32_SFLOAT:
-            result = VK_IMAGE_ASPECT_DEPTH_BIT;
-        break;
-        // Stencil
-        case VK_FORMAT_S8_UINT:
-            result = VK_IMAGE_ASPECT_STENCIL_BIT;
-        break;
-        // Depth/stencil
-        case VK_FORMAT_D16_UNORM_S8_UINT:
-        case VK_FORMAT_D24_UNORM_S8_UINT:
-        case VK_FORMAT_D32_SFLOAT_S8_UINT:
-            result = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
-        break;
-        // Assume everything else is Color
-        default:
-            result = VK_IMAGE_ASPECT_COLOR_BIT;
-        break;
+    memset(p_image, 0, sizeof(*p_image));
+
+    // "DDS " followed by the 124 byte DDS_HEADER, fields are little endian
+    const uint64_t k_header_size = 4 + 124;
+    if ((size < k_header_size) || (0 != memcmp(p_data, "DDS ", 4))) {
+        return false;
+    }
+    uint32_t header[31];
+    memcpy(header, p_data + 4, sizeof(header));
+    const uint32_t flags        = header[1];
+    const uint32_t height       = header[2];
+    const uint32_t width        = header[3];
+    const uint32_t mip_count    = header[6];
+    const uint32_t pf_flags     = header[19];
+    const uint32_t bit_count    = header[21];
+    const uint32_t r_mask       = header[22];
+    const uint32_t g_mask       = header[23];
+    const uint32_t b_mask       = header[24];
+    const uint32_t a_mask       = header[25];
+    const uint32_t caps2        = header[27];
+    const uint8_t* p_fourcc     = p_data + 4 + 80;
+    if ((124 != header[0]) || (0 == width) || (0 == height)) {
+        return false;
+    }
+    // Cube maps and volumes aren't supported
+    if (0 != (caps2 & (0x200 | 0x200000))) {
+        return false;
     }
-    return result;
-}
 
-bool tr_util_vk_get_memory_type(const VkPhysicalDeviceMemoryProperties* mem_props, uint32_t type_bits, VkMemoryPropertyFlags flags, uint32_t* p_index)
-{
-    bool found = false; 
-    for (uint32_t i = 0; i < mem_props->memoryTypeCount; ++i) {
-        if (type_bits & 1) {
-            if (flags == (mem_props->memoryTypes[i].propertyFlags & flags)) {
-                if (p_index) {
-                    *p_index = i;
-                }
-                found = true;
-                break;
+    tr_format format = tr_format_undefined;
+    uint64_t data_offset = k_header_size;
+    if (0 != (pf_flags & 0x4)) {
+        if (0 == memcmp(p_fourcc, "DX10", 4)) {
+            // DDS_HEADER_DXT10: format, dimension, misc flags, array size, misc flags 2
+            if (size < (k_header_size + 20)) {
+                return false;
+            }
+            uint32_t dx10[5];
+            memcpy(dx10, p_data + k_header_size, sizeof(dx10));
+            if ((3 != dx10[1]) || (0 != (dx10[2] & 0x4)) || (dx10[3] > 1)) {
+                return false;
+            }
+            format = tr_internal_dds_dxgi_format(dx10[0]);
+            data_offset += 20;
+        }
+        else if (0 == memcmp(p_fourcc, "DXT1", 4)) {
+            format = tr_format_bc1_rgba_unorm;
+        }
+        else if (0 == memcmp(p_fourcc, "DXT5", 4)) {
+            format = tr_format_bc3_unorm;
+        }
+        else if ((0 == memcmp(p_fourcc, "ATI1", 4)) || (0 == memcmp(p_fourcc, "BC4U", 4))) {
+            format = tr_format_bc4_unorm;
+        }
+        else if ((0 == memcmp(p_fourcc, "ATI2", 4)) || (0 == memcmp(p_fourcc, "BC5U", 4))) {
+            format = tr_format_bc5_unorm;
+        }
+        else {
+            // D3DFMT values stored in the FourCC field
+            uint32_t d3d_format = 0;
+            memcpy(&d3d_format, p_fourcc, sizeof(d3d_format));
+            if (113 == d3d_format) {
+                format = tr_format_r16g16b16a16_float;
+            }
+            else if (116 == d3d_format) {
+                format = tr_format_r32g32b32a32_float;
             }
         }
-        type_bits >>= 1;
     }
-    return found;
-}
-
-VkFormatFeatureFlags tr_util_vk_image_usage_to_format_features(VkImageUsageFlags usage)
-{
-    VkFormatFeatureFlags result = (VkFormatFeatureFlags)0;
-    if (VK_IMAGE_USAGE_SAMPLED_BIT== (usage & VK_IMAGE_USAGE_SAMPLED_BIT)) {
-        result |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    else if ((0 != (pf_flags & (0x40 | 0x20000))) && (32 == bit_count)) {
+        if ((0x000000FF == r_mask) && (0x0000FF00 == g_mask) && (0x00FF0000 == b_mask) && (0xFF000000 == a_mask)) {
+            format = tr_format_r8g8b8a8_unorm;
+        }
+        else if ((0x00FF0000 == r_mask) && (0x0000FF00 == g_mask) && (0x000000FF == b_mask) && (0xFF000000 == a_mask)) {
+            format = tr_format_b8g8r8a8_unorm;
+        }
     }
-    if (VK_IMAGE_USAGE_STORAGE_BIT== (usage & VK_IMAGE_USAGE_STORAGE_BIT)) {
-        result |= VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+    else if ((0 != (pf_flags & (0x40 | 0x20000))) && (8 == bit_count) && (0xFF == r_mask)) {
+        format = tr_format_r8_unorm;
     }
-    if (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT== (usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)) {
-        result |= VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT;
+    if (tr_format_undefined == format) {
+        return false;
     }
-    if (VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT== (usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) {
-        result |= VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+    uint32_t mip_levels = (0 != (flags & 0x20000)) ? tr_max(mip_count, 1) : 1;
+    mip_levels = tr_min(mip_levels, tr_util_calc_mip_levels(width, height));
+    uint64_t data_size = 0;
+    for (uint32_t mip_level = 0; mip_level < mip_levels; ++mip_level) {
+        data_size += tr_util_format_level_size(format, tr_max(width >> mip_level, 1), tr_max(height >> mip_level, 1));
     }
-    return result;
+    if ((data_offset + data_size) > size) {
+        return false;
+    }
+
+    p_image->format     = format;
+    p_image->width      = width;
+    p_image->height     = height;
+    p_image->mip_levels = mip_levels;
+    p_image->p_data     = p_data + data_offset;
+    p_image->data_size  = data_size;
+    return true;
 }
 
+#if ! defined(TINY_RENDERER_IMAGE_ONLY)
 // -------------------------------------------------------------------------------------------------
 // Internal init functions
 // -------------------------------------------------------------------------------------------------
@@ -2987,7 +7574,7 @@ void tr_internal_vk_create_instance(const char* app_name, tr_renderer* p_rendere
             extensions[extension_count] = p_renderer->settings.instance_extensions.names[extension_count];
           }
         }
-        else {
+        else if (! p_renderer->settings.headless) {
           // Use default extensions
           extensions[extension_count++] = VK_KHR_SURFACE_EXTENSION_NAME;
 #if defined(TINY_RENDERER_LINUX)
@@ -3089,7 +7676,7 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
     vk_res = vkEnumeratePhysicalDevices(p_renderer->vk_instance, &(p_renderer->vk_gpu_count), p_renderer->vk_gpus);
     assert(VK_SUCCESS == vk_res);
 
-    // Find gpu that supports both graphics and present
+    // Find gpu that supports both graphics and present, headless only needs graphics
     p_renderer->vk_active_gpu_index = UINT32_MAX;
     for (uint32_t gpu_index = 0; gpu_index < p_renderer->vk_gpu_count; ++gpu_index) {
         VkPhysicalDevice gpu = p_renderer->vk_gpus[gpu_index];
@@ -3102,7 +7689,10 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
 
         // Make sure GPU supports present
         uint32_t present_queue_family_index = UINT32_MAX;
-        if (! tr_internal_vk_find_present_queue_family(gpu, p_renderer->vk_surface, &present_queue_family_index)) {
+        if (p_renderer->settings.headless) {
+            present_queue_family_index = graphics_queue_family_index;
+        }
+        else if (! tr_internal_vk_find_present_queue_family(gpu, p_renderer->vk_surface, &present_queue_family_index)) {
             continue;
         }
             
@@ -3163,7 +7753,9 @@ void tr_internal_vk_create_device(tr_renderer* p_renderer)
     }
     else {
       // Use default extensions
-      extensions[extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+      if (! p_renderer->settings.headless) {
+          extensions[extension_count++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+      }
       extensions[extension_count++] = VK_KHR_MAINTENANCE1_EXTENSION_NAME;
     }
 
@@ -3352,6 +7944,45 @@ void tr_internal_create_swapchain_renderpass(tr_renderer* p_renderer)
     p_renderer->swapchain_render_targets = (tr_render_target**)calloc(p_renderer->settings.swapchain.image_count, sizeof(*p_renderer->swapchain_render_targets));
     assert(NULL != p_renderer->swapchain_render_targets);
 
+    // The multisample color and the depth/stencil attachments are resolved or discarded 
+    // within the render pass, so every swapchain image shares one set of transient 
+    // attachments. With multisampling the depth/stencil attachment is the multisample one.
+    tr_texture* color_attachment_multisample = NULL;
+    if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
+        color_attachment_multisample = (tr_texture*)calloc(1, sizeof(*color_attachment_multisample));
+        assert(NULL != color_attachment_multisample);
+
+        color_attachment_multisample->type          = tr_texture_type_2d;
+        color_attachment_multisample->usage         = (tr_texture_usage)(tr_texture_usage_color_attachment | tr_texture_usage_transient_attachment);
+        color_attachment_multisample->width         = p_renderer->settings.width;
+        color_attachment_multisample->height        = p_renderer->settings.height;
+        color_attachment_multisample->depth         = 1;
+        color_attachment_multisample->format        = p_renderer->settings.swapchain.color_format;
+        color_attachment_multisample->mip_levels    = 1;
+        color_attachment_multisample->clear_value.r = p_renderer->settings.swapchain.color_clear_value.r;
+        color_attachment_multisample->clear_value.g = p_renderer->settings.swapchain.color_clear_value.g;
+        color_attachment_multisample->clear_value.b = p_renderer->settings.swapchain.color_clear_value.b;
+        color_attachment_multisample->clear_value.a = p_renderer->settings.swapchain.color_clear_value.a;
+        color_attachment_multisample->sample_count  = (tr_sample_count)p_renderer->settings.swapchain.sample_count;
+    }
+
+    tr_texture* depth_stencil_attachment = NULL;
+    if (tr_format_undefined != p_renderer->settings.swapchain.depth_stencil_format) {
+        depth_stencil_attachment = (tr_texture*)calloc(1, sizeof(*depth_stencil_attachment));
+        assert(NULL != depth_stencil_attachment);
+
+        depth_stencil_attachment->type                = tr_texture_type_2d;
+        depth_stencil_attachment->usage               = (tr_texture_usage)(tr_texture_usage_depth_stencil_attachment | tr_texture_usage_transient_attachment);
+        depth_stencil_attachment->width               = p_renderer->settings.width;
+        depth_stencil_attachment->height              = p_renderer->settings.height;
+        depth_stencil_attachment->depth               = 1;
+        depth_stencil_attachment->format              = p_renderer->settings.swapchain.depth_stencil_format;
+        depth_stencil_attachment->mip_levels          = 1;
+        depth_stencil_attachment->clear_value.depth   = p_renderer->settings.swapchain.depth_stencil_clear_value.depth;
+        depth_stencil_attachment->clear_value.stencil = p_renderer->settings.swapchain.depth_stencil_clear_value.stencil;
+        depth_stencil_attachment->sample_count        = (tr_sample_count)p_renderer->settings.swapchain.sample_count;
+    }
+
     for (size_t i = 0; i < p_renderer->settings.swapchain.image_count; ++i) {
         p_renderer->swapchain_render_targets[i] = (tr_render_target*)calloc(1, sizeof(*(p_renderer->swapchain_render_targets[i])));
         tr_render_target* render_target = p_renderer->swapchain_render_targets[i];
@@ -3362,30 +7993,16 @@ void tr_internal_create_swapchain_renderpass(tr_renderer* p_renderer)
         render_target->color_format           = p_renderer->settings.swapchain.color_format;
         render_target->color_attachment_count = 1;
         render_target->depth_stencil_format   = p_renderer->settings.swapchain.depth_stencil_format;
+        // Nothing reads the swapchain's depth/stencil after the frame
+        render_target->depth_store_op         = tr_attachment_store_op_dont_care;
+        render_target->stencil_store_op       = tr_attachment_store_op_dont_care;
 
         render_target->color_attachments[0] = (tr_texture*)calloc(1, sizeof(*render_target->color_attachments[0]));
         assert(NULL != render_target->color_attachments[0]);
 
-        if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
-            render_target->color_attachments_multisample[0] = (tr_texture*)calloc(1, sizeof(*render_target->color_attachments_multisample[0]));
-            assert(NULL != render_target->color_attachments_multisample[0]);
-        }
-
-        if (tr_format_undefined != p_renderer->settings.swapchain.depth_stencil_format) {
-            render_target->depth_stencil_attachment = (tr_texture*)calloc(1, sizeof(*render_target->depth_stencil_attachment));
-            assert(NULL != render_target->depth_stencil_attachment);
-
-            if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
-                render_target->depth_stencil_attachment_multisample = (tr_texture*)calloc(1, sizeof(*render_target->depth_stencil_attachment_multisample));
-                assert(NULL != render_target->depth_stencil_attachment_multisample);
-            }
-        }
-    }
-
-    for (size_t i = 0; i < p_renderer->settings.swapchain.image_count; ++i) {
-        tr_render_target* render_target = p_renderer->swapchain_render_targets[i];
         render_target->color_attachments[0]->type          = tr_texture_type_2d;
-        render_target->color_attachments[0]->usage         = (tr_texture_usage)(tr_texture_usage_color_attachment | tr_texture_usage_present);
+        render_target->color_attachments[0]->usage         = p_renderer->settings.headless ? (tr_texture_usage)(tr_texture_usage_color_attachment | tr_texture_usage_sampled_image) 
+                                                                                            : (tr_texture_usage)(tr_texture_usage_color_attachment | tr_texture_usage_present);
         render_target->color_attachments[0]->width         = p_renderer->settings.width;
         render_target->color_attachments[0]->height        = p_renderer->settings.height;
         render_target->color_attachments[0]->depth         = 1;
@@ -3397,45 +8014,10 @@ void tr_internal_create_swapchain_renderpass(tr_renderer* p_renderer)
         render_target->color_attachments[0]->clear_value.a = p_renderer->settings.swapchain.color_clear_value.a;
         render_target->color_attachments[0]->sample_count  = tr_sample_count_1;
 
+        render_target->color_attachments_multisample[0] = color_attachment_multisample;
+        render_target->depth_stencil_attachment = depth_stencil_attachment;
         if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
-            render_target->color_attachments_multisample[0]->type          = tr_texture_type_2d;
-            render_target->color_attachments_multisample[0]->usage         = (tr_texture_usage)(tr_texture_usage_color_attachment | tr_texture_usage_sampled_image);
-            render_target->color_attachments_multisample[0]->width         = p_renderer->settings.width;
-            render_target->color_attachments_multisample[0]->height        = p_renderer->settings.height;
-            render_target->color_attachments_multisample[0]->depth         = 1;
-            render_target->color_attachments_multisample[0]->format        = p_renderer->settings.swapchain.color_format;
-            render_target->color_attachments_multisample[0]->mip_levels    = 1;
-            render_target->color_attachments_multisample[0]->clear_value.r = p_renderer->settings.swapchain.color_clear_value.r;
-            render_target->color_attachments_multisample[0]->clear_value.g = p_renderer->settings.swapchain.color_clear_value.g;
-            render_target->color_attachments_multisample[0]->clear_value.b = p_renderer->settings.swapchain.color_clear_value.b;
-            render_target->color_attachments_multisample[0]->clear_value.a = p_renderer->settings.swapchain.color_clear_value.a;
-            render_target->color_attachments_multisample[0]->sample_count  = render_target->sample_count;
-        }
-
-        if (tr_format_undefined != p_renderer->settings.swapchain.depth_stencil_format) {
-            render_target->depth_stencil_attachment->type                = tr_texture_type_2d;
-            render_target->depth_stencil_attachment->usage               = (tr_texture_usage)(tr_texture_usage_depth_stencil_attachment | tr_texture_usage_sampled_image);
-            render_target->depth_stencil_attachment->width               = p_renderer->settings.width;
-            render_target->depth_stencil_attachment->height              = p_renderer->settings.height;
-            render_target->depth_stencil_attachment->depth               = 1;
-            render_target->depth_stencil_attachment->format              = p_renderer->settings.swapchain.depth_stencil_format;
-            render_target->depth_stencil_attachment->mip_levels          = 1;
-            render_target->depth_stencil_attachment->clear_value.depth   = p_renderer->settings.swapchain.depth_stencil_clear_value.depth;
-            render_target->depth_stencil_attachment->clear_value.stencil = p_renderer->settings.swapchain.depth_stencil_clear_value.stencil;
-            render_target->depth_stencil_attachment->sample_count        = tr_sample_count_1;
-            
-            if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
-              render_target->depth_stencil_attachment_multisample->type                = tr_texture_type_2d;
-              render_target->depth_stencil_attachment_multisample->usage               = (tr_texture_usage)(tr_texture_usage_depth_stencil_attachment | tr_texture_usage_sampled_image);
-              render_target->depth_stencil_attachment_multisample->width               = p_renderer->settings.width;
-              render_target->depth_stencil_attachment_multisample->height              = p_renderer->settings.height;
-              render_target->depth_stencil_attachment_multisample->depth               = 1;
-              render_target->depth_stencil_attachment_multisample->format              = p_renderer->settings.swapchain.depth_stencil_format;
-              render_target->depth_stencil_attachment_multisample->mip_levels          = 1;
-              render_target->depth_stencil_attachment_multisample->clear_value.depth   = p_renderer->settings.swapchain.depth_stencil_clear_value.depth;
-              render_target->depth_stencil_attachment_multisample->clear_value.stencil = p_renderer->settings.swapchain.depth_stencil_clear_value.stencil;
-              render_target->depth_stencil_attachment_multisample->sample_count        = render_target->sample_count;            
-            }
+            render_target->depth_stencil_attachment_multisample = depth_stencil_attachment;
         }
     }
 }
@@ -3444,41 +8026,44 @@ void tr_internal_vk_create_swapchain_renderpass(tr_renderer* p_renderer)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
-    uint32_t image_count = 0;
-    VkResult vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, NULL);
-    assert(VK_SUCCESS == vk_res);
-
-    assert(image_count == p_renderer->settings.swapchain.image_count);
-
+    // Headless render targets get their own images
+    uint32_t image_count = p_renderer->settings.swapchain.image_count;
     VkImage* swapchain_images = (VkImage*)calloc(image_count, sizeof(*swapchain_images));
     assert(NULL != swapchain_images);
 
-    vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, swapchain_images);
-    assert(VK_SUCCESS == vk_res);
+    if (! p_renderer->settings.headless) {
+        VkResult vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, NULL);
+        assert(VK_SUCCESS == vk_res);
+
+        assert(image_count == p_renderer->settings.swapchain.image_count);
+
+        vk_res = vkGetSwapchainImagesKHR(p_renderer->vk_device, p_renderer->vk_swapchain, &image_count, swapchain_images);
+        assert(VK_SUCCESS == vk_res);
+    }
 
     // Populate the vk_image field and create the Vulkan texture objects
     for (size_t i = 0; i < p_renderer->settings.swapchain.image_count; ++i) {
         tr_render_target* render_target = p_renderer->swapchain_render_targets[i];
         render_target->color_attachments[0]->vk_image = swapchain_images[i];
         tr_internal_vk_create_texture(p_renderer, render_target->color_attachments[0]);
+    }
 
-        if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
+    // Shared attachments only need to be created once
+    {
+        tr_render_target* render_target = p_renderer->swapchain_render_targets[0];
+        if (NULL != render_target->color_attachments_multisample[0]) {
             tr_internal_vk_create_texture(p_renderer, render_target->color_attachments_multisample[0]);
         }
 
         if (NULL != render_target->depth_stencil_attachment) {
             tr_internal_vk_create_texture(p_renderer, render_target->depth_stencil_attachment);
-            
-            if (p_renderer->settings.swapchain.sample_count > tr_sample_count_1) {
-                tr_internal_vk_create_texture(p_renderer, render_target->depth_stencil_attachment_multisample);
-            }
         }
     }
 
     // Initialize Vulkan render target objects
     for (uint32_t i = 0; i < p_renderer->settings.swapchain.image_count; ++i) {
         tr_render_target* render_target = p_renderer->swapchain_render_targets[i];
-        tr_internal_vk_create_render_target(p_renderer, true, render_target);
+        tr_internal_vk_create_render_target(p_renderer, ! p_renderer->settings.headless, render_target);
     }
 
     TINY_RENDERER_SAFE_FREE(swapchain_images);
@@ -3504,7 +8089,7 @@ void tr_internal_vk_destroy_surface(tr_renderer* p_renderer)
 
 void tr_internal_vk_destroy_device(tr_renderer* p_renderer)
 {
-    assert(VK_NULL_HANDLE != p_renderer->vk_surface);
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
     vkDestroyDevice(p_renderer->vk_device, NULL);
 }
@@ -3630,6 +8215,7 @@ void tr_internal_vk_create_descriptor_set(tr_renderer* p_renderer, tr_descriptor
         create_info.pPoolSizes    = pool_sizes;
         VkResult vk_res = vkCreateDescriptorPool(p_renderer->vk_device, &create_info, NULL, &(p_descriptor_set->vk_descriptor_pool));
         assert(VK_SUCCESS == vk_res);
+        ++p_renderer->frame_stats.descriptor_pool_count;
     }
 
     // Descriptor set layout
@@ -3760,7 +8346,15 @@ void tr_internal_vk_create_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
     }
 
     uint32_t memory_type_index = UINT32_MAX;
-    bool found_memmory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, mem_flags, &memory_type_index);
+    bool found_memmory = false;
+    // Uncached reads are very slow, coherency isn't required since readbacks invalidate
+    if (p_buffer->host_visible && p_buffer->host_cached) {
+        found_memmory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, 
+                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, &memory_type_index);
+    }
+    if (! found_memmory) {
+        found_memmory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, mem_flags, &memory_type_index);
+    }
     assert(found_memmory);
 
     TINY_RENDERER_DECLARE_ZERO(VkMemoryAllocateInfo, alloc_info);
@@ -3770,6 +8364,7 @@ void tr_internal_vk_create_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
     alloc_info.memoryTypeIndex = memory_type_index;
     vk_res = vkAllocateMemory(p_renderer->vk_device, &alloc_info, NULL, &(p_buffer->vk_memory));
     assert(VK_SUCCESS == vk_res);
+    ++p_renderer->frame_stats.memory_allocation_count;
 
     vk_res = vkBindBufferMemory(p_renderer->vk_device, p_buffer->vk_buffer, p_buffer->vk_memory, 0);
     assert(VK_SUCCESS == vk_res);
@@ -3809,7 +8404,13 @@ void tr_internal_vk_destroy_buffer(tr_renderer* p_renderer, tr_buffer* p_buffer)
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
     assert(VK_NULL_HANDLE != p_buffer->vk_buffer);
     
+    if (VK_NULL_HANDLE != p_buffer->vk_buffer_view) {
+        vkDestroyBufferView(p_renderer->vk_device, p_buffer->vk_buffer_view, NULL);
+    }
     vkDestroyBuffer(p_renderer->vk_device, p_buffer->vk_buffer, NULL);
+    if (VK_NULL_HANDLE != p_buffer->vk_memory) {
+        vkFreeMemory(p_renderer->vk_device, p_buffer->vk_memory, NULL);
+    }
 }
 
 void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_texture)
@@ -3817,6 +8418,11 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
     p_texture->renderer = p_renderer;
+    // Render target and swapchain textures are filled in directly
+    if (0 == p_texture->array_layers) {
+        p_texture->array_layers = 1;
+    }
+    assert((tr_texture_type_cube != p_texture->type) || ((0 == (p_texture->array_layers % 6)) && (p_texture->width == p_texture->height)));
 
     if (VK_NULL_HANDLE == p_texture->vk_image) {
         VkImageType image_type = VK_IMAGE_TYPE_2D;
@@ -3830,25 +8436,34 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
         TINY_RENDERER_DECLARE_ZERO(VkImageCreateInfo, create_info);
         create_info.sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         create_info.pNext                 = NULL;
-        create_info.flags                 = 0;
+        create_info.flags                 = (tr_texture_type_cube == p_texture->type) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
         create_info.imageType             = image_type;
         create_info.format                = tr_util_to_vk_format(p_texture->format);
         create_info.extent.width          = p_texture->width;
         create_info.extent.height         = p_texture->height;
         create_info.extent.depth          = p_texture->depth;
         create_info.mipLevels             = p_texture->mip_levels;
-        create_info.arrayLayers           = p_texture->host_visible ? 1 : 1;
+        create_info.arrayLayers           = p_texture->array_layers;
         create_info.samples               = tr_util_to_vk_sample_count(p_texture->sample_count);
         create_info.tiling                = (0 != p_texture->host_visible) ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
         create_info.usage                 = tr_util_to_vk_image_usage(p_texture->usage);
         create_info.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
         create_info.queueFamilyIndexCount = 0;
         create_info.pQueueFamilyIndices   = NULL;
-        create_info.initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED;
+        // Host writes made before the first transition have to survive it
+        create_info.initialLayout         = (0 != p_texture->host_visible) ? VK_IMAGE_LAYOUT_PREINITIALIZED : VK_IMAGE_LAYOUT_UNDEFINED;
         if (VK_IMAGE_USAGE_SAMPLED_BIT & create_info.usage) {
             // Make it easy to copy to and from textures
             create_info.usage |= (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
         }
+        const bool is_transient = (0 != (VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT & create_info.usage));
+        if (is_transient) {
+            VkImageUsageFlags attachment_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | 
+                                                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | 
+                                                 VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+            assert((0 == (create_info.usage & ~(attachment_usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT))) && "Transient attachments can only be used as attachments");
+            assert((0 == p_texture->host_visible) && "Transient attachments can't be host visible");
+        }
         // Verify that GPU supports this format
         TINY_RENDERER_DECLARE_ZERO(VkFormatProperties, format_props);
         vkGetPhysicalDeviceFormatProperties(p_renderer->vk_active_gpu, create_info.format, &format_props);
@@ -3883,7 +8498,14 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
         }
 
         uint32_t memory_type_index = UINT32_MAX;
-        bool found_memory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, mem_flags, &memory_type_index);
+        bool found_memory = false;
+        // Tilers can keep transient attachments in tile memory and never back them
+        if (is_transient) {
+            found_memory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, mem_flags | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, &memory_type_index);
+        }
+        if (!found_memory) {
+            found_memory = tr_util_vk_get_memory_type(&p_renderer->vk_memory_properties, mem_reqs.memoryTypeBits, mem_flags, &memory_type_index);
+        }
         assert(found_memory);
 
         TINY_RENDERER_DECLARE_ZERO(VkMemoryAllocateInfo, alloc_info);
@@ -3893,6 +8515,7 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
         alloc_info.memoryTypeIndex = memory_type_index;
         vk_res = vkAllocateMemory(p_renderer->vk_device, &alloc_info, NULL, &(p_texture->vk_memory));
         assert(VK_SUCCESS == vk_res);
+        ++p_renderer->frame_stats.memory_allocation_count;
 
         vk_res = vkBindImageMemory(p_renderer->vk_device, p_texture->vk_image, p_texture->vk_memory, 0);
         assert(VK_SUCCESS == vk_res);
@@ -3900,46 +8523,46 @@ void tr_internal_vk_create_texture(tr_renderer* p_renderer, tr_texture* p_textur
         if (p_texture->host_visible) {
             vk_res = vkMapMemory(p_renderer->vk_device, p_texture->vk_memory, 0, VK_WHOLE_SIZE, 0, &(p_texture->cpu_mapped_address));
             assert(VK_SUCCESS == vk_res);
-        }
-
-        p_texture->owns_image = true;
-    }
 
-    // Create image view
-    {
-        VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
-        switch (p_texture->type) {
-            case tr_texture_type_1d   : view_type = VK_IMAGE_VIEW_TYPE_1D;   break;
-            case tr_texture_type_2d   : view_type = VK_IMAGE_VIEW_TYPE_2D;   break;
-            case tr_texture_type_3d   : view_type = VK_IMAGE_VIEW_TYPE_3D;   break;
-            case tr_texture_type_cube : view_type = VK_IMAGE_VIEW_TYPE_CUBE; break;
+            // Linear images have driver chosen row pitches, so callers need these to write in place
+            VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(create_info.format);
+            if (aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT) {
+                aspect_mask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            }
+            const uint32_t subresource_count = p_texture->mip_levels * p_texture->array_layers;
+            p_texture->subresource_layouts = (tr_subresource_layout*)calloc(subresource_count, sizeof(*(p_texture->subresource_layouts)));
+            assert(NULL != p_texture->subresource_layouts);
+            for (uint32_t array_layer = 0; array_layer < p_texture->array_layers; ++array_layer) {
+                for (uint32_t mip_level = 0; mip_level < p_texture->mip_levels; ++mip_level) {
+                    TINY_RENDERER_DECLARE_ZERO(VkImageSubresource, subresource);
+                    subresource.aspectMask = aspect_mask;
+                    subresource.mipLevel   = mip_level;
+                    subresource.arrayLayer = array_layer;
+                    TINY_RENDERER_DECLARE_ZERO(VkSubresourceLayout, vk_layout);
+                    vkGetImageSubresourceLayout(p_renderer->vk_device, p_texture->vk_image, &subresource, &vk_layout);
+
+                    tr_subresource_layout* p_layout = &(p_texture->subresource_layouts[(array_layer * p_texture->mip_levels) + mip_level]);
+                    p_layout->offset      = vk_layout.offset;
+                    p_layout->size        = vk_layout.size;
+                    p_layout->row_pitch   = vk_layout.rowPitch;
+                    p_layout->array_pitch = vk_layout.arrayPitch;
+                    p_layout->depth_pitch = vk_layout.depthPitch;
+                }
+            }
         }
 
-        TINY_RENDERER_DECLARE_ZERO(VkImageViewCreateInfo, create_info);
-        create_info.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        create_info.pNext                           = NULL;
-        create_info.flags                           = 0;
-        create_info.image                           = p_texture->vk_image;
-        create_info.viewType                        = view_type;
-        create_info.format                          = tr_util_to_vk_format(p_texture->format);
-        create_info.components.r                    = VK_COMPONENT_SWIZZLE_R;
-        create_info.components.g                    = VK_COMPONENT_SWIZZLE_G;
-        create_info.components.b                    = VK_COMPONENT_SWIZZLE_B;
-        create_info.components.a                    = VK_COMPONENT_SWIZZLE_A;
-        create_info.subresourceRange.aspectMask     = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_texture->format));
-        create_info.subresourceRange.baseMipLevel   = 0;
-        create_info.subresourceRange.levelCount     = p_texture->mip_levels;
-        create_info.subresourceRange.baseArrayLayer = 0;
-        create_info.subresourceRange.layerCount     = 1;
-        VkResult vk_res = vkCreateImageView(p_renderer->vk_device, &create_info, NULL, &(p_texture->vk_image_view));
-        assert(VK_SUCCESS == vk_res);
-
-        p_texture->vk_aspect_mask = create_info.subresourceRange.aspectMask;
+        p_texture->owns_image = true;
     }
 
+    p_texture->vk_image_view = tr_internal_vk_create_texture_view(p_renderer, p_texture, p_texture->min_lod);
+    p_texture->vk_aspect_mask = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_texture->format));
+
     p_texture->vk_texture_view.imageView = p_texture->vk_image_view;
-    p_texture->vk_texture_view.imageLayout = (p_texture->usage & tr_texture_usage_storage_image) ? VK_IMAGE_LAYOUT_GENERAL
-                                                                                                 : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    p_texture->vk_texture_view.imageLayout = tr_util_to_vk_texture_layout(p_texture, tr_texture_usage_sampled_image);
+
+    // Every mip level starts out as tr_texture_usage_undefined
+    p_texture->current_mip_usages = (tr_texture_usage*)calloc(p_texture->mip_levels, sizeof(*(p_texture->current_mip_usages)));
+    assert(NULL != p_texture->current_mip_usages);
 }
 
 void tr_internal_vk_destroy_texture(tr_renderer* p_renderer, tr_texture* p_texture)
@@ -3960,8 +8583,62 @@ void tr_internal_vk_destroy_texture(tr_renderer* p_renderer, tr_texture* p_textu
     }
 
     if (VK_NULL_HANDLE != p_texture->vk_image_view) {
+        // Framebuffers can't outlive their attachments
+        if (p_texture->usage & (tr_texture_usage_color_attachment | tr_texture_usage_depth_stencil_attachment)) {
+            tr_internal_vk_evict_framebuffers(p_renderer, p_texture->vk_image_view);
+        }
         vkDestroyImageView(p_renderer->vk_device, p_texture->vk_image_view, NULL);
     }
+
+    TINY_RENDERER_SAFE_FREE(p_texture->current_mip_usages);
+    TINY_RENDERER_SAFE_FREE(p_texture->subresource_layouts);
+}
+
+VkImageView tr_internal_vk_create_texture_view(tr_renderer* p_renderer, tr_texture* p_texture, uint32_t base_mip_level)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(base_mip_level < p_texture->mip_levels);
+
+    const bool is_array = (tr_texture_type_cube == p_texture->type) ? (p_texture->array_layers > 6) : (p_texture->array_layers > 1);
+    VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
+    switch (p_texture->type) {
+        case tr_texture_type_1d   : view_type = is_array ? VK_IMAGE_VIEW_TYPE_1D_ARRAY   : VK_IMAGE_VIEW_TYPE_1D;   break;
+        case tr_texture_type_2d   : view_type = is_array ? VK_IMAGE_VIEW_TYPE_2D_ARRAY   : VK_IMAGE_VIEW_TYPE_2D;   break;
+        case tr_texture_type_3d   : view_type = VK_IMAGE_VIEW_TYPE_3D;   break;
+        case tr_texture_type_cube : view_type = is_array ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE; break;
+    }
+
+    // Cube array views are an optional feature, fail instead of creating an invalid view
+    if (VK_IMAGE_VIEW_TYPE_CUBE_ARRAY == view_type) {
+        VkPhysicalDeviceFeatures gpu_features = { 0 };
+        vkGetPhysicalDeviceFeatures(p_renderer->vk_active_gpu, &gpu_features);
+        assert((VK_TRUE == gpu_features.imageCubeArray) && "Cube arrays need the imageCubeArray feature");
+        if (VK_TRUE != gpu_features.imageCubeArray) {
+            return VK_NULL_HANDLE;
+        }
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(VkImageViewCreateInfo, create_info);
+    create_info.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    create_info.pNext                           = NULL;
+    create_info.flags                           = 0;
+    create_info.image                           = p_texture->vk_image;
+    create_info.viewType                        = view_type;
+    create_info.format                          = tr_util_to_vk_format(p_texture->format);
+    create_info.components.r                    = VK_COMPONENT_SWIZZLE_R;
+    create_info.components.g                    = VK_COMPONENT_SWIZZLE_G;
+    create_info.components.b                    = VK_COMPONENT_SWIZZLE_B;
+    create_info.components.a                    = VK_COMPONENT_SWIZZLE_A;
+    create_info.subresourceRange.aspectMask     = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_texture->format));
+    create_info.subresourceRange.baseMipLevel   = base_mip_level;
+    create_info.subresourceRange.levelCount     = p_texture->mip_levels - base_mip_level;
+    create_info.subresourceRange.baseArrayLayer = 0;
+    create_info.subresourceRange.layerCount     = p_texture->array_layers;
+    VkImageView image_view = VK_NULL_HANDLE;
+    VkResult vk_res = vkCreateImageView(p_renderer->vk_device, &create_info, NULL, &image_view);
+    assert(VK_SUCCESS == vk_res);
+
+    return image_view;
 }
 
 void tr_internal_vk_create_sampler(tr_renderer* p_renderer, tr_sampler* p_sampler)
@@ -4402,9 +9079,48 @@ void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchai
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
 
+    // Look for a render pass with the same attachments
+    TINY_RENDERER_DECLARE_ZERO(tr_vk_render_pass_key, key);
+    key.color_format           = p_render_target->color_format;
+    key.color_attachment_count = p_render_target->color_attachment_count;
+    key.sample_count           = p_render_target->sample_count;
+    key.depth_stencil_format   = p_render_target->depth_stencil_format;
+    key.is_swapchain           = is_swapchain ? 1 : 0;
+    for (uint32_t i = 0; i < p_render_target->color_attachment_count; ++i) {
+        key.color_load_ops[i]  = p_render_target->color_load_ops[i];
+        key.color_store_ops[i] = p_render_target->color_store_ops[i];
+    }
+    if (tr_format_undefined != p_render_target->depth_stencil_format) {
+        key.depth_load_op    = p_render_target->depth_load_op;
+        key.depth_store_op   = p_render_target->depth_store_op;
+        key.stencil_load_op  = p_render_target->stencil_load_op;
+        key.stencil_store_op = p_render_target->stencil_store_op;
+    }
+    uint64_t hash = tr_util_hash_bytes(&key, sizeof(key));
+
+    for (uint32_t i = 0; i < p_renderer->vk_render_pass_cache_count; ++i) {
+        const tr_vk_render_pass_cache_entry* p_entry = &(p_renderer->vk_render_pass_cache[i]);
+        if ((hash == p_entry->hash) && (0 == memcmp(&key, &(p_entry->key), sizeof(key)))) {
+            p_render_target->vk_render_pass = p_entry->vk_render_pass;
+            return;
+        }
+    }
+
     uint32_t color_attachment_count = p_render_target->color_attachment_count;
     uint32_t depth_stencil_attachment_count = (tr_format_undefined != p_render_target->depth_stencil_format) ? 1 : 0;
 
+    // Stencil ops are ignored for formats without a stencil aspect
+    bool has_stencil = false;
+    bool load_depth_stencil = false;
+    if (depth_stencil_attachment_count > 0) {
+        VkImageAspectFlags aspect_mask = tr_util_vk_determine_aspect_mask(tr_util_to_vk_format(p_render_target->depth_stencil_format));
+        has_stencil = (0 != (aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT));
+        load_depth_stencil = (tr_attachment_load_op_load == p_render_target->depth_load_op) ||
+                             (has_stencil && (tr_attachment_load_op_load == p_render_target->stencil_load_op));
+    }
+    VkAttachmentLoadOp  stencil_load_op  = has_stencil ? tr_util_to_vk_load_op(p_render_target->stencil_load_op) : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    VkAttachmentStoreOp stencil_store_op = has_stencil ? tr_util_to_vk_store_op(p_render_target->stencil_store_op) : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
     VkAttachmentDescription* attachments = NULL;
     VkAttachmentReference* color_attachment_refs = NULL;
     VkAttachmentReference* depth_stencil_attachment_ref = NULL;
@@ -4434,26 +9150,28 @@ void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchai
         for (uint32_t i = 0; i < color_attachment_count; ++i) {
             const uint32_t ssidx = 2*i;
             const uint32_t msidx = ssidx + 1;
+            const bool load_color = (tr_attachment_load_op_load == p_render_target->color_load_ops[i]);
 
-            // descriptions
+            // descriptions - the resolve overwrites the single sample attachment, 
+            // the multisample attachment is only stored if it's going to be loaded.
             attachments[ssidx].flags          = 0;
             attachments[ssidx].format         = tr_util_to_vk_format(p_render_target->color_format);
             attachments[ssidx].samples        = tr_util_to_vk_sample_count(tr_sample_count_1);
-            attachments[ssidx].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[ssidx].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[ssidx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[ssidx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+            attachments[ssidx].loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachments[ssidx].storeOp        = tr_util_to_vk_store_op(p_render_target->color_store_ops[i]);
+            attachments[ssidx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachments[ssidx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
             attachments[ssidx].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
             attachments[ssidx].finalLayout    = is_swapchain ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
             attachments[msidx].flags          = 0;
             attachments[msidx].format         = tr_util_to_vk_format(p_render_target->color_format);
             attachments[msidx].samples        = tr_util_to_vk_sample_count(p_render_target->sample_count);
-            attachments[msidx].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[msidx].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[msidx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[msidx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[msidx].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[msidx].loadOp         = tr_util_to_vk_load_op(p_render_target->color_load_ops[i]);
+            attachments[msidx].storeOp        = load_color ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachments[msidx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachments[msidx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachments[msidx].initialLayout  = load_color ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
             attachments[msidx].finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
             // references
@@ -4471,11 +9189,11 @@ void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchai
             attachments[idx].flags          = 0;
             attachments[idx].format         = tr_util_to_vk_format(p_render_target->depth_stencil_format);
             attachments[idx].samples        = tr_util_to_vk_sample_count(p_render_target->sample_count);
-            attachments[idx].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[idx].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[idx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[idx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[idx].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[idx].loadOp         = tr_util_to_vk_load_op(p_render_target->depth_load_op);
+            attachments[idx].storeOp        = tr_util_to_vk_store_op(p_render_target->depth_store_op);
+            attachments[idx].stencilLoadOp  = stencil_load_op;
+            attachments[idx].stencilStoreOp = stencil_store_op;
+            attachments[idx].initialLayout  = load_depth_stencil ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
             attachments[idx].finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
             // References
@@ -4505,11 +9223,11 @@ void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchai
             attachments[ssidx].flags          = 0;
             attachments[ssidx].format         = tr_util_to_vk_format(p_render_target->color_format);
             attachments[ssidx].samples        = tr_util_to_vk_sample_count(tr_sample_count_1);
-            attachments[ssidx].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[ssidx].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[ssidx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[ssidx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[ssidx].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[ssidx].loadOp         = tr_util_to_vk_load_op(p_render_target->color_load_ops[i]);
+            attachments[ssidx].storeOp        = tr_util_to_vk_store_op(p_render_target->color_store_ops[i]);
+            attachments[ssidx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachments[ssidx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachments[ssidx].initialLayout  = (tr_attachment_load_op_load == p_render_target->color_load_ops[i]) ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
             attachments[ssidx].finalLayout    = is_swapchain ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
             // references
@@ -4523,11 +9241,11 @@ void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchai
             attachments[idx].flags          = 0;
             attachments[idx].format         = tr_util_to_vk_format(p_render_target->depth_stencil_format);
             attachments[idx].samples        = tr_util_to_vk_sample_count(p_render_target->sample_count);
-            attachments[idx].loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[idx].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[idx].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            attachments[idx].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-            attachments[idx].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[idx].loadOp         = tr_util_to_vk_load_op(p_render_target->depth_load_op);
+            attachments[idx].storeOp        = tr_util_to_vk_store_op(p_render_target->depth_store_op);
+            attachments[idx].stencilLoadOp  = stencil_load_op;
+            attachments[idx].stencilStoreOp = stencil_store_op;
+            attachments[idx].initialLayout  = load_depth_stencil ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
             attachments[idx].finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
             depth_stencil_attachment_ref[0].attachment = idx;
             depth_stencil_attachment_ref[0].layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -4546,15 +9264,25 @@ void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchai
     subpass.preserveAttachmentCount = 0;
     subpass.pPreserveAttachments    = NULL;
 
+    TINY_RENDERER_DECLARE_ZERO(VkSubpassDependency, subpass_dependencies[2]);
     // Create self-dependency in case image or memory barrier is issued within subpass
-    TINY_RENDERER_DECLARE_ZERO(VkSubpassDependency, subpass_dependency);
-    subpass_dependency.srcSubpass      = 0;
-    subpass_dependency.dstSubpass      = 0;
-    subpass_dependency.srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpass_dependency.dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpass_dependency.srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    subpass_dependency.dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    subpass_dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+    subpass_dependencies[0].srcSubpass      = 0;
+    subpass_dependencies[0].dstSubpass      = 0;
+    subpass_dependencies[0].srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpass_dependencies[0].dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpass_dependencies[0].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpass_dependencies[0].dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpass_dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+    // Order attachment writes against earlier passes, attachments that start out 
+    // undefined (e.g. shared swapchain attachments) don't get a barrier otherwise.
+    subpass_dependencies[1].srcSubpass      = VK_SUBPASS_EXTERNAL;
+    subpass_dependencies[1].dstSubpass      = 0;
+    subpass_dependencies[1].srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    subpass_dependencies[1].dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    subpass_dependencies[1].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    subpass_dependencies[1].dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | 
+                                              VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    subpass_dependencies[1].dependencyFlags = 0;
 
     uint32_t attachment_count = (p_render_target->sample_count > tr_sample_count_1) ?  (2 * color_attachment_count) : color_attachment_count;
     attachment_count += depth_stencil_attachment_count;
@@ -4567,12 +9295,21 @@ void tr_internal_vk_create_render_pass(tr_renderer* p_renderer, bool is_swapchai
     create_info.pAttachments    = attachments;
     create_info.subpassCount    = 1;
     create_info.pSubpasses      = &subpass;
-    create_info.dependencyCount = 1;
-    create_info.pDependencies   = &subpass_dependency;
+    create_info.dependencyCount = 2;
+    create_info.pDependencies   = subpass_dependencies;
     
     VkResult vk_res = vkCreateRenderPass(p_renderer->vk_device, &create_info, NULL, &(p_render_target->vk_render_pass));
     assert(VK_SUCCESS == vk_res);
 
+    uint32_t entry_count = p_renderer->vk_render_pass_cache_count + 1;
+    p_renderer->vk_render_pass_cache = (tr_vk_render_pass_cache_entry*)realloc(p_renderer->vk_render_pass_cache, entry_count * sizeof(*(p_renderer->vk_render_pass_cache)));
+    assert(NULL != p_renderer->vk_render_pass_cache);
+    tr_vk_render_pass_cache_entry* p_entry = &(p_renderer->vk_render_pass_cache[entry_count - 1]);
+    p_entry->hash           = hash;
+    p_entry->key            = key;
+    p_entry->vk_render_pass = p_render_target->vk_render_pass;
+    p_renderer->vk_render_pass_cache_count = entry_count;
+
     TINY_RENDERER_SAFE_FREE(attachments);
     TINY_RENDERER_SAFE_FREE(color_attachment_refs);
     TINY_RENDERER_SAFE_FREE(resolve_attachment_refs);
@@ -4624,6 +9361,24 @@ void tr_internal_vk_create_framebuffer(tr_renderer* p_renderer, tr_render_target
             ++iter_attachments;
         }
     }
+
+    // Look for a framebuffer with the same render pass and attachments
+    TINY_RENDERER_DECLARE_ZERO(tr_vk_framebuffer_key, key);
+    key.vk_render_pass   = p_render_target->vk_render_pass;
+    key.width            = p_render_target->width;
+    key.height           = p_render_target->height;
+    key.attachment_count = attachment_count;
+    memcpy(key.attachments, attachments, attachment_count * sizeof(*attachments));
+    uint64_t hash = tr_util_hash_bytes(&key, sizeof(key));
+
+    for (uint32_t i = 0; i < p_renderer->vk_framebuffer_cache_count; ++i) {
+        const tr_vk_framebuffer_cache_entry* p_entry = &(p_renderer->vk_framebuffer_cache[i]);
+        if ((hash == p_entry->hash) && (0 == memcmp(&key, &(p_entry->key), sizeof(key)))) {
+            p_render_target->vk_framebuffer = p_entry->vk_framebuffer;
+            TINY_RENDERER_SAFE_FREE(attachments);
+            return;
+        }
+    }
     
     TINY_RENDERER_DECLARE_ZERO(VkFramebufferCreateInfo, create_info);
     create_info.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -4638,6 +9393,15 @@ void tr_internal_vk_create_framebuffer(tr_renderer* p_renderer, tr_render_target
     VkResult vk_res = vkCreateFramebuffer(p_renderer->vk_device, &create_info, NULL, &(p_render_target->vk_framebuffer));
     assert(VK_SUCCESS == vk_res);
 
+    uint32_t entry_count = p_renderer->vk_framebuffer_cache_count + 1;
+    p_renderer->vk_framebuffer_cache = (tr_vk_framebuffer_cache_entry*)realloc(p_renderer->vk_framebuffer_cache, entry_count * sizeof(*(p_renderer->vk_framebuffer_cache)));
+    assert(NULL != p_renderer->vk_framebuffer_cache);
+    tr_vk_framebuffer_cache_entry* p_entry = &(p_renderer->vk_framebuffer_cache[entry_count - 1]);
+    p_entry->hash           = hash;
+    p_entry->key            = key;
+    p_entry->vk_framebuffer = p_render_target->vk_framebuffer;
+    p_renderer->vk_framebuffer_cache_count = entry_count;
+
     TINY_RENDERER_SAFE_FREE(attachments);
 }
 
@@ -4650,10 +9414,141 @@ void tr_internal_vk_create_render_target(tr_renderer* p_renderer, bool is_swapch
 void tr_internal_vk_destroy_render_target(tr_renderer* p_renderer, tr_render_target* p_render_target)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
-    assert(VK_NULL_HANDLE != p_render_target->vk_render_pass);
 
-    vkDestroyFramebuffer(p_renderer->vk_device, p_render_target->vk_framebuffer, NULL);
-    vkDestroyRenderPass(p_renderer->vk_device, p_render_target->vk_render_pass, NULL);
+    // Render passes and framebuffers belong to the renderer's caches
+    p_render_target->vk_render_pass = VK_NULL_HANDLE;
+    p_render_target->vk_framebuffer = VK_NULL_HANDLE;
+}
+
+void tr_internal_vk_evict_framebuffers(tr_renderer* p_renderer, VkImageView image_view)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    uint32_t i = 0;
+    while (i < p_renderer->vk_framebuffer_cache_count) {
+        tr_vk_framebuffer_cache_entry* p_entry = &(p_renderer->vk_framebuffer_cache[i]);
+        bool uses_image_view = false;
+        for (uint32_t j = 0; j < p_entry->key.attachment_count; ++j) {
+            if (image_view == p_entry->key.attachments[j]) {
+                uses_image_view = true;
+                break;
+            }
+        }
+
+        if (uses_image_view) {
+            vkDestroyFramebuffer(p_renderer->vk_device, p_entry->vk_framebuffer, NULL);
+            // Swap in the last entry
+            p_renderer->vk_framebuffer_cache_count -= 1;
+            *p_entry = p_renderer->vk_framebuffer_cache[p_renderer->vk_framebuffer_cache_count];
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+void tr_internal_vk_destroy_render_target_caches(tr_renderer* p_renderer)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    for (uint32_t i = 0; i < p_renderer->vk_framebuffer_cache_count; ++i) {
+        vkDestroyFramebuffer(p_renderer->vk_device, p_renderer->vk_framebuffer_cache[i].vk_framebuffer, NULL);
+    }
+    for (uint32_t i = 0; i < p_renderer->vk_render_pass_cache_count; ++i) {
+        vkDestroyRenderPass(p_renderer->vk_device, p_renderer->vk_render_pass_cache[i].vk_render_pass, NULL);
+    }
+
+    p_renderer->vk_framebuffer_cache_count = 0;
+    p_renderer->vk_render_pass_cache_count = 0;
+    TINY_RENDERER_SAFE_FREE(p_renderer->vk_framebuffer_cache);
+    TINY_RENDERER_SAFE_FREE(p_renderer->vk_render_pass_cache);
+}
+
+void tr_internal_vk_create_query_pool(tr_renderer* p_renderer, tr_query_pool* p_query_pool)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+
+    VkPhysicalDeviceFeatures gpu_features = { 0 };
+    vkGetPhysicalDeviceFeatures(p_renderer->vk_active_gpu, &gpu_features);
+
+    VkQueryType query_type = VK_QUERY_TYPE_TIMESTAMP;
+    VkQueryPipelineStatisticFlags pipeline_statistics = 0;
+    p_query_pool->value_count = 1;
+    p_query_pool->vk_query_control_flags = 0;
+    switch (p_query_pool->type) {
+        case tr_query_type_timestamp: {
+            // Timers are only written on the graphics queue
+            assert(VK_TRUE == p_renderer->vk_active_gpu_properties.limits.timestampComputeAndGraphics);
+
+            uint32_t count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(p_renderer->vk_active_gpu, &count, NULL);
+            VkQueueFamilyProperties* properties = (VkQueueFamilyProperties*)calloc(count, sizeof(*properties));
+            assert(NULL != properties);
+            vkGetPhysicalDeviceQueueFamilyProperties(p_renderer->vk_active_gpu, &count, properties);
+            uint32_t valid_bits = properties[p_renderer->graphics_queue->vk_queue_family_index].timestampValidBits;
+            TINY_RENDERER_SAFE_FREE(properties);
+
+            assert(valid_bits > 0);
+            p_query_pool->timestamp_mask = (valid_bits >= 64) ? UINT64_MAX : ((((uint64_t)1) << valid_bits) - 1);
+            query_type = VK_QUERY_TYPE_TIMESTAMP;
+        }
+        break;
+
+        case tr_query_type_pipeline_statistics: {
+            assert(VK_TRUE == gpu_features.pipelineStatisticsQuery);
+
+            // Geometry and tessellation statistics are only valid if the GPU supports those stages
+            pipeline_statistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+                                  VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+                                  VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                                  VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+                                  VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                                  VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+                                  VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+            if (VK_TRUE == gpu_features.geometryShader) {
+                pipeline_statistics |= VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT |
+                                       VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT;
+            }
+            if (VK_TRUE == gpu_features.tessellationShader) {
+                pipeline_statistics |= VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT |
+                                       VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+            }
+            p_query_pool->value_count = 0;
+            for (uint32_t bits = pipeline_statistics; 0 != bits; bits &= (bits - 1)) {
+                ++p_query_pool->value_count;
+            }
+            query_type = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        }
+        break;
+
+        case tr_query_type_occlusion: {
+            // Precise queries are only enabled on the device if the GPU supports them
+            if (VK_TRUE == gpu_features.occlusionQueryPrecise) {
+                p_query_pool->vk_query_control_flags = VK_QUERY_CONTROL_PRECISE_BIT;
+            }
+            query_type = VK_QUERY_TYPE_OCCLUSION;
+        }
+        break;
+    }
+
+    TINY_RENDERER_DECLARE_ZERO(VkQueryPoolCreateInfo, create_info);
+    create_info.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    create_info.pNext              = NULL;
+    create_info.flags              = 0;
+    create_info.queryType          = query_type;
+    create_info.queryCount         = p_query_pool->query_count;
+    create_info.pipelineStatistics = pipeline_statistics;
+    p_query_pool->vk_pipeline_statistics = pipeline_statistics;
+    VkResult vk_res = vkCreateQueryPool(p_renderer->vk_device, &create_info, NULL, &(p_query_pool->vk_query_pool));
+    assert(VK_SUCCESS == vk_res);
+}
+
+void tr_internal_vk_destroy_query_pool(tr_renderer* p_renderer, tr_query_pool* p_query_pool)
+{
+    assert(VK_NULL_HANDLE != p_renderer->vk_device);
+    assert(VK_NULL_HANDLE != p_query_pool->vk_query_pool);
+
+    vkDestroyQueryPool(p_renderer->vk_device, p_query_pool->vk_query_pool, NULL);
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -4891,31 +9786,45 @@ void tr_internal_vk_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_t
     render_area.extent.width = p_render_target->width;
     render_area.extent.height = p_render_target->height;
 
-    // Multiply by 2 in case there's multisampling
+    // Attachments that get loaded have to be in the render pass' initial layout
+    const bool is_multisample = (p_render_target->sample_count > tr_sample_count_1);
+    for (uint32_t i = 0; i < p_render_target->color_attachment_count; ++i) {
+        if (tr_attachment_load_op_load == p_render_target->color_load_ops[i]) {
+            tr_texture* p_attachment = is_multisample ? p_render_target->color_attachments_multisample[i] : p_render_target->color_attachments[i];
+            tr_internal_vk_cmd_image_transition(p_cmd, p_attachment, 0, p_attachment->mip_levels, tr_texture_usage_color_attachment);
+        }
+    }
+    if ((tr_format_undefined != p_render_target->depth_stencil_format) && 
+        ((tr_attachment_load_op_load == p_render_target->depth_load_op) || (tr_attachment_load_op_load == p_render_target->stencil_load_op))) 
+    {
+        tr_internal_vk_cmd_depth_stencil_transition(p_cmd, p_render_target, tr_texture_usage_depth_stencil_attachment);
+    }
+
+    // Multiply by 2 in case there's multisampling, clear values are indexed
+    // the same way as the attachments in tr_internal_vk_create_render_pass.
     TINY_RENDERER_DECLARE_ZERO(VkClearValue, clear_values[(2 * tr_max_render_target_attachments) + 1]);
     
     uint32_t color_count = p_render_target->color_attachment_count;
     for (uint32_t i = 0; i < color_count; ++i) {
-        clear_values[i].color.float32[0] = p_render_target->color_attachments[i]->clear_value.r;
-        clear_values[i].color.float32[1] = p_render_target->color_attachments[i]->clear_value.g;
-        clear_values[i].color.float32[2] = p_render_target->color_attachments[i]->clear_value.b;
-        clear_values[i].color.float32[3] = p_render_target->color_attachments[i]->clear_value.a;
-        if (p_render_target->sample_count > tr_sample_count_1) {
-            clear_values[i].color.float32[0] = p_render_target->color_attachments_multisample[i]->clear_value.r;
-            clear_values[i].color.float32[1] = p_render_target->color_attachments_multisample[i]->clear_value.g;
-            clear_values[i].color.float32[2] = p_render_target->color_attachments_multisample[i]->clear_value.b;
-            clear_values[i].color.float32[3] = p_render_target->color_attachments_multisample[i]->clear_value.a;
+        uint32_t ssidx = is_multisample ? (2 * i) : i;
+        clear_values[ssidx].color.float32[0] = p_render_target->color_attachments[i]->clear_value.r;
+        clear_values[ssidx].color.float32[1] = p_render_target->color_attachments[i]->clear_value.g;
+        clear_values[ssidx].color.float32[2] = p_render_target->color_attachments[i]->clear_value.b;
+        clear_values[ssidx].color.float32[3] = p_render_target->color_attachments[i]->clear_value.a;
+        if (is_multisample) {
+            uint32_t msidx = ssidx + 1;
+            clear_values[msidx].color.float32[0] = p_render_target->color_attachments_multisample[i]->clear_value.r;
+            clear_values[msidx].color.float32[1] = p_render_target->color_attachments_multisample[i]->clear_value.g;
+            clear_values[msidx].color.float32[2] = p_render_target->color_attachments_multisample[i]->clear_value.b;
+            clear_values[msidx].color.float32[3] = p_render_target->color_attachments_multisample[i]->clear_value.a;
         }
     }
+
+    uint32_t clear_value_count = is_multisample ? (2 * color_count) : color_count;
     uint32_t depth_stencil_count = (tr_format_undefined != p_render_target->depth_stencil_format) ? 1 : 0;
     if (depth_stencil_count > 0) {
-        clear_values[color_count].depthStencil.depth = p_render_target->depth_stencil_attachment->clear_value.depth;
-        clear_values[color_count].depthStencil.stencil = p_render_target->depth_stencil_attachment->clear_value.stencil;
-    }
-
-    uint32_t clear_value_count = color_count;
-    if (p_render_target->sample_count > tr_sample_count_1) {
-        clear_value_count *= 2;
+        clear_values[clear_value_count].depthStencil.depth = p_render_target->depth_stencil_attachment->clear_value.depth;
+        clear_values[clear_value_count].depthStencil.stencil = p_render_target->depth_stencil_attachment->clear_value.stencil;
     }
     clear_value_count += depth_stencil_count;
 
@@ -4934,8 +9843,25 @@ void tr_internal_vk_cmd_begin_render(tr_cmd* p_cmd, tr_render_target* p_render_t
 void tr_internal_vk_cmd_end_render(tr_cmd* p_cmd)
 {
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
+    assert(NULL != s_tr_internal->bound_render_target);
 
     vkCmdEndRenderPass(p_cmd->vk_cmd_buf);
+
+    // The render pass leaves the attachments in their final layouts, see tr_internal_vk_create_render_pass
+    tr_render_target* p_render_target = s_tr_internal->bound_render_target;
+    for (uint32_t i = 0; i < p_render_target->color_attachment_count; ++i) {
+        tr_texture* p_attachment = p_render_target->color_attachments[i];
+        bool is_swapchain = (tr_texture_usage_present == (p_attachment->usage & tr_texture_usage_present));
+        tr_util_set_texture_usage(p_attachment, is_swapchain ? tr_texture_usage_present : tr_texture_usage_color_attachment);
+        if (p_render_target->sample_count > tr_sample_count_1) {
+            tr_util_set_texture_usage(p_render_target->color_attachments_multisample[i], tr_texture_usage_color_attachment);
+        }
+    }
+    if (tr_format_undefined != p_render_target->depth_stencil_format) {
+        tr_texture* p_attachment = (p_render_target->sample_count > tr_sample_count_1) ? p_render_target->depth_stencil_attachment_multisample
+                                                                                       : p_render_target->depth_stencil_attachment;
+        tr_util_set_texture_usage(p_attachment, tr_texture_usage_depth_stencil_attachment);
+    }
 }
 
 void tr_internal_vk_cmd_set_viewport(tr_cmd* p_cmd, float x, float y, float width, float height, float min_depth, float max_depth)
@@ -5040,6 +9966,7 @@ void tr_internal_vk_cmd_bind_pipeline(tr_cmd* p_cmd, tr_pipeline* p_pipeline)
                                                          : VK_PIPELINE_BIND_POINT_GRAPHICS;
 
     vkCmdBindPipeline(p_cmd->vk_cmd_buf, pipeline_bind_point, p_pipeline->vk_pipeline);
+    ++p_cmd->cmd_pool->renderer->frame_stats.pipeline_bind_count;
 
     //switch (p_pipeline->type) {
     //  case tr_pipeline_type_compute:
@@ -5069,6 +9996,7 @@ void tr_internal_vk_cmd_bind_descriptor_sets(tr_cmd* p_cmd, tr_pipeline* p_pipel
     vkCmdBindDescriptorSets(p_cmd->vk_cmd_buf, pipeline_bind_point, 
                             p_pipeline->vk_pipeline_layout, 0, 
                             1, &(p_descriptor_set->vk_descriptor_set), 0, NULL);
+    ++p_cmd->cmd_pool->renderer->frame_stats.descriptor_set_bind_count;
 }
 
 void tr_internal_vk_cmd_bind_index_buffer(tr_cmd* p_cmd, tr_buffer* p_buffer)
@@ -5104,6 +10032,7 @@ void tr_internal_vk_cmd_draw(tr_cmd* p_cmd, uint32_t vertex_count, uint32_t firs
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
 
     vkCmdDraw(p_cmd->vk_cmd_buf, vertex_count, 1, first_vertex, 0);
+    ++p_cmd->cmd_pool->renderer->frame_stats.draw_count;
 }
 
 void tr_internal_vk_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32_t first_index)
@@ -5111,9 +10040,10 @@ void tr_internal_vk_cmd_draw_indexed(tr_cmd* p_cmd, uint32_t index_count, uint32
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
 
     vkCmdDrawIndexed(p_cmd->vk_cmd_buf, index_count, 1, first_index, 0, 0);
+    ++p_cmd->cmd_pool->renderer->frame_stats.draw_count;
 }
 
-void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
+void tr_internal_vk_cmd_buffer_barrier(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage old_usage, tr_buffer_usage new_usage)
 {
     assert(p_cmd != NULL);
     assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
@@ -5244,33 +10174,34 @@ void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr
                          &barrier,
                          0,
                          NULL);
+    ++p_cmd->cmd_pool->renderer->frame_stats.barrier_count;
 }
 
-void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage old_usage, tr_texture_usage new_usage)
+void tr_internal_vk_cmd_image_barrier(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t base_mip_level, uint32_t mip_level_count, tr_texture_usage old_usage, tr_texture_usage new_usage)
 {
     assert(VK_NULL_HANDLE != p_cmd->vk_cmd_buf);
     assert(VK_NULL_HANDLE != p_texture->vk_image);
 
-    VkPipelineStageFlags src_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    VkPipelineStageFlags dst_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkPipelineStageFlags src_stage_mask = tr_util_to_vk_texture_stages(old_usage);
+    VkPipelineStageFlags dst_stage_mask = tr_util_to_vk_texture_stages(new_usage);
+    // Leaving VK_IMAGE_LAYOUT_PREINITIALIZED waits on host writes
+    if ((tr_texture_usage_undefined == old_usage) && p_texture->host_visible) {
+        src_stage_mask = VK_PIPELINE_STAGE_HOST_BIT;
+    }
     VkDependencyFlags dependency_flags = 0;
     TINY_RENDERER_DECLARE_ZERO(VkImageMemoryBarrier, barrier);
-
-    barrier.oldLayout = tr_util_to_vk_image_layout(old_usage);
-    barrier.newLayout = tr_util_to_vk_image_layout(new_usage);
-
     barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.pNext                           = NULL;
-    barrier.oldLayout                       = tr_util_to_vk_image_layout(old_usage);
-    barrier.newLayout                       = tr_util_to_vk_image_layout(new_usage);
+    barrier.oldLayout                       = tr_util_to_vk_texture_layout(p_texture, old_usage);
+    barrier.newLayout                       = tr_util_to_vk_texture_layout(p_texture, new_usage);
     barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
     barrier.image                           = p_texture->vk_image;
     barrier.subresourceRange.aspectMask     = p_texture->vk_aspect_mask;
-    barrier.subresourceRange.baseMipLevel   = 0;
-    barrier.subresourceRange.levelCount     = p_texture->mip_levels;
+    barrier.subresourceRange.baseMipLevel   = base_mip_level;
+    barrier.subresourceRange.levelCount     = mip_level_count;
     barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount     = 1;
+    barrier.subresourceRange.layerCount     = p_texture->array_layers;
 
     // oldLayout
     switch (barrier.oldLayout) 
@@ -5290,6 +10221,11 @@ void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, t
         }
         break;
 
+        case VK_IMAGE_LAYOUT_GENERAL: {
+            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        }
+        break;
+
         case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: {
             barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
         }
@@ -5329,9 +10265,15 @@ void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, t
         }
         break;
 
+        case VK_IMAGE_LAYOUT_GENERAL: {
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        }
+        break;
+
         case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: {
             barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
         }
+        break;
 
         case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: {
             barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
@@ -5354,44 +10296,97 @@ void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, t
                          NULL,
                          1,
                          &barrier);
+    ++p_cmd->cmd_pool->renderer->frame_stats.barrier_count;
 }
 
-void tr_internal_vk_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage old_usage, tr_texture_usage new_usage)
+void tr_internal_vk_cmd_buffer_transition(tr_cmd* p_cmd, tr_buffer* p_buffer, tr_buffer_usage new_usage)
 {
-    assert(NULL != p_cmd->vk_cmd_buf);
-    
-    if (p_render_target->sample_count > tr_sample_count_1) {
-        if (1 == p_render_target->color_attachment_count) {
-            tr_texture* ss_attachment = p_render_target->color_attachments[0];
-            tr_texture* ms_attachment = p_render_target->color_attachments_multisample[0];
-
-            // This means we're dealing with a multisample swapchain
-            if (tr_texture_usage_present == (ss_attachment->usage & tr_texture_usage_present)) {
-                if ((tr_texture_usage_present == old_usage) && (tr_texture_usage_color_attachment == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, ss_attachment, tr_texture_usage_present, tr_texture_usage_color_attachment);
-                }
+    assert(NULL != p_cmd);
+    assert(NULL != p_buffer);
 
-                if ((tr_texture_usage_color_attachment == old_usage) && (tr_texture_usage_present == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, ss_attachment, tr_texture_usage_color_attachment, tr_texture_usage_present);
-                }
-            }
+    tr_buffer_usage old_usage = p_buffer->current_usage;
+    // Storage writes still need to be ordered against each other
+    bool is_storage = (tr_buffer_usage_storage_uav == new_usage) || (tr_buffer_usage_storage_texel_uav == new_usage);
+    if ((old_usage == new_usage) && (! is_storage)) {
+        return;
+    }
+
+    tr_internal_vk_cmd_buffer_barrier(p_cmd, p_buffer, old_usage, new_usage);
+    p_buffer->current_usage = new_usage;
+}
+
+void tr_internal_vk_cmd_image_transition(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t base_mip_level, uint32_t mip_level_count, tr_texture_usage new_usage)
+{
+    assert(NULL != p_cmd);
+    assert(NULL != p_texture);
+    assert(NULL != p_texture->current_mip_usages);
+    assert((base_mip_level + mip_level_count) <= p_texture->mip_levels);
+
+    // Vulkan can't transition an image into VK_IMAGE_LAYOUT_UNDEFINED, so
+    // tr_texture_usage_undefined just marks the contents as discardable.
+    // Host visible textures own their contents and never go back to it.
+    if (tr_texture_usage_undefined == new_usage) {
+        if (p_texture->host_visible) {
+            return;
+        }
+        for (uint32_t i = base_mip_level; i < (base_mip_level + mip_level_count); ++i) {
+            p_texture->current_mip_usages[i] = new_usage;
         }
+        return;
     }
-    else {
-        if (1 == p_render_target->color_attachment_count) {
-            tr_texture* attachment = p_render_target->color_attachments[0];
-            // This means we're dealing with a single sample swapchain
-            if (tr_texture_usage_present == (attachment->usage & tr_texture_usage_present)) {
-                if ((tr_texture_usage_present == old_usage) && (tr_texture_usage_color_attachment == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, attachment, tr_texture_usage_present, tr_texture_usage_color_attachment);
-                }
 
-                if ((tr_texture_usage_color_attachment == old_usage) && (tr_texture_usage_present == new_usage)) {
-                    tr_internal_vk_cmd_image_transition(p_cmd, attachment, tr_texture_usage_color_attachment, tr_texture_usage_present);
-                }
-            }
+    // Emit one barrier for each run of mip levels that share the same usage
+    const uint32_t end_mip_level = base_mip_level + mip_level_count;
+    uint32_t run_begin = base_mip_level;
+    while (run_begin < end_mip_level) {
+        tr_texture_usage old_usage = p_texture->current_mip_usages[run_begin];
+        uint32_t run_end = run_begin + 1;
+        while ((run_end < end_mip_level) && (old_usage == p_texture->current_mip_usages[run_end])) {
+            ++run_end;
+        }
+
+        // Storage writes still need to be ordered against each other
+        bool is_storage = (tr_texture_usage_storage_image == new_usage);
+        if ((old_usage != new_usage) || is_storage) {
+            tr_internal_vk_cmd_image_barrier(p_cmd, p_texture, run_begin, run_end - run_begin, old_usage, new_usage);
+        }
+
+        for (uint32_t i = run_begin; i < run_end; ++i) {
+            p_texture->current_mip_usages[i] = new_usage;
+        }
+        run_begin = run_end;
+    }
+}
+
+void tr_internal_vk_cmd_render_target_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage)
+{
+    assert(NULL != p_cmd->vk_cmd_buf);
+
+    // Only the single sample attachments are visible outside of the render pass,
+    // multisample attachments are resolved into them.
+    for (uint32_t i = 0; i < p_render_target->color_attachment_count; ++i) {
+        tr_texture* p_attachment = p_render_target->color_attachments[i];
+        if ((tr_texture_usage_present == new_usage) && (0 == (p_attachment->usage & tr_texture_usage_present))) {
+            continue;
         }
+        tr_internal_vk_cmd_image_transition(p_cmd, p_attachment, 0, p_attachment->mip_levels, new_usage);
+    }
+}
+
+void tr_internal_vk_cmd_depth_stencil_transition(tr_cmd* p_cmd, tr_render_target* p_render_target, tr_texture_usage new_usage)
+{
+    assert(NULL != p_cmd->vk_cmd_buf);
+
+    tr_texture* p_attachment = (p_render_target->sample_count > tr_sample_count_1) ? p_render_target->depth_stencil_attachment_multisample
+                                                                                   : p_render_target->depth_stencil_attachment;
+    if (NULL == p_attachment) {
+        return;
     }
+    // Transient attachments can't leave the attachment layout
+    if ((p_attachment->usage & tr_texture_usage_transient_attachment) && (tr_texture_usage_depth_stencil_attachment != new_usage)) {
+        return;
+    }
+    tr_internal_vk_cmd_image_transition(p_cmd, p_attachment, 0, p_attachment->mip_levels, new_usage);
 }
 
 void tr_internal_vk_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
@@ -5400,6 +10395,42 @@ void tr_internal_vk_cmd_dispatch(tr_cmd* p_cmd, uint32_t group_count_x, uint32_t
     assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
 
     vkCmdDispatch(p_cmd->vk_cmd_buf, group_count_x, group_count_y, group_count_z);
+    ++p_cmd->cmd_pool->renderer->frame_stats.dispatch_count;
+}
+
+void tr_internal_vk_cmd_copy_buffer_to_texture_region(tr_cmd* p_cmd, tr_buffer* p_buffer, uint64_t buffer_offset, uint32_t buffer_row_length, tr_texture* p_texture, uint32_t mip_level, uint32_t array_layer, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+
+    // Compressed rectangles start on a block and cover whole blocks unless they reach the
+    // level's edge, bufferRowLength is still in texels
+    if (tr_util_format_is_compressed(p_texture->format)) {
+        assert((0 == (x % 4)) && (0 == (y % 4)));
+        assert((0 == (width % 4)) || ((x + width) == tr_max(p_texture->width >> mip_level, 1)));
+        assert((0 == (height % 4)) || ((y + height) == tr_max(p_texture->height >> mip_level, 1)));
+        if (0 == buffer_row_length) {
+            buffer_row_length = tr_round_up(width, 4);
+        }
+    }
+
+    VkBufferImageCopy region = { 0 };
+    region.bufferOffset                    = buffer_offset;
+    region.bufferRowLength                 = buffer_row_length;
+    region.bufferImageHeight               = 0;
+    region.imageSubresource.aspectMask     = p_texture->vk_aspect_mask;
+    region.imageSubresource.mipLevel       = mip_level;
+    region.imageSubresource.baseArrayLayer = array_layer;
+    region.imageSubresource.layerCount     = 1;
+    region.imageOffset.x                   = (int32_t)x;
+    region.imageOffset.y                   = (int32_t)y;
+    region.imageOffset.z                   = 0;
+    region.imageExtent.width               = width;
+    region.imageExtent.height              = height;
+    region.imageExtent.depth               = 1;
+
+    vkCmdCopyBufferToImage(p_cmd->vk_cmd_buf, p_buffer->vk_buffer, p_texture->vk_image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 }
 
 void tr_internal_vk_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width, uint32_t height, uint32_t row_pitch, uint64_t buffer_offset, uint32_t mip_level, tr_buffer* p_buffer, tr_texture* p_texture)
@@ -5426,24 +10457,205 @@ void tr_internal_vk_cmd_copy_buffer_to_texture2d(tr_cmd* p_cmd, uint32_t width,
         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &regions);
 }
 
+void tr_internal_vk_cmd_copy_texture_to_buffer(tr_cmd* p_cmd, tr_texture* p_texture, uint32_t mip_level, uint64_t buffer_offset, tr_buffer* p_buffer)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+
+    uint32_t width = tr_max(p_texture->width >> mip_level, 1);
+    uint32_t height = tr_max(p_texture->height >> mip_level, 1);
+    uint32_t depth = tr_max(p_texture->depth >> mip_level, 1);
+
+    tr_texture_usage texture_usage = p_texture->current_mip_usages[mip_level];
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, mip_level, 1, tr_texture_usage_transfer_src);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_buffer, tr_buffer_usage_transfer_dst);
+
+    // Only one aspect can be copied at a time, depth/stencil formats copy depth
+    VkImageAspectFlags aspect_mask = p_texture->vk_aspect_mask;
+    if (aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT) {
+        aspect_mask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    }
+
+    VkBufferImageCopy regions = { 0 };
+    regions.bufferOffset                    = buffer_offset;
+    regions.bufferRowLength                 = 0;
+    regions.bufferImageHeight               = 0;
+    regions.imageSubresource.aspectMask     = aspect_mask;
+    regions.imageSubresource.mipLevel       = mip_level;
+    regions.imageSubresource.baseArrayLayer = 0;
+    regions.imageSubresource.layerCount     = 1;
+    regions.imageOffset.x                   = 0;
+    regions.imageOffset.y                   = 0;
+    regions.imageOffset.z                   = 0;
+    regions.imageExtent.width               = width;
+    regions.imageExtent.height              = height;
+    regions.imageExtent.depth               = depth;
+
+    vkCmdCopyImageToBuffer(p_cmd->vk_cmd_buf, p_texture->vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 
+        p_buffer->vk_buffer, 1, &regions);
+
+    // Put the texture back the way it was, there's nothing to restore if it was undefined
+    if (tr_texture_usage_undefined != texture_usage) {
+        tr_internal_vk_cmd_image_transition(p_cmd, p_texture, mip_level, 1, texture_usage);
+    }
+}
+
+void tr_internal_vk_cmd_copy_buffer(tr_cmd* p_cmd, tr_buffer* p_src_buffer, uint64_t src_offset, tr_buffer* p_dst_buffer, uint64_t dst_offset, uint64_t size)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+
+    tr_buffer_usage src_usage = p_src_buffer->current_usage;
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_src_buffer, tr_buffer_usage_transfer_src);
+    tr_internal_vk_cmd_buffer_transition(p_cmd, p_dst_buffer, tr_buffer_usage_transfer_dst);
+
+    TINY_RENDERER_DECLARE_ZERO(VkBufferCopy, region);
+    region.srcOffset = src_offset;
+    region.dstOffset = dst_offset;
+    region.size      = size;
+    vkCmdCopyBuffer(p_cmd->vk_cmd_buf, p_src_buffer->vk_buffer, p_dst_buffer->vk_buffer, 1, &region);
+
+    if ((tr_buffer_usage_transfer_src != src_usage) && (0 != src_usage)) {
+        tr_internal_vk_cmd_buffer_transition(p_cmd, p_src_buffer, src_usage);
+    }
+}
+
+void tr_internal_vk_cmd_generate_mipmaps(tr_cmd* p_cmd, tr_texture* p_texture, tr_texture_usage new_usage)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+    assert(VK_NULL_HANDLE != p_texture->vk_image);
+
+    uint32_t src_width = p_texture->width;
+    uint32_t src_height = p_texture->height;
+    for (uint32_t mip_level = 1; mip_level < p_texture->mip_levels; ++mip_level) {
+        uint32_t dst_width = tr_max(src_width >> 1, 1);
+        uint32_t dst_height = tr_max(src_height >> 1, 1);
+
+        // The previous level has to finish being written before it's read
+        tr_internal_vk_cmd_image_transition(p_cmd, p_texture, mip_level - 1, 1, tr_texture_usage_transfer_src);
+        tr_internal_vk_cmd_image_transition(p_cmd, p_texture, mip_level, 1, tr_texture_usage_transfer_dst);
+
+        TINY_RENDERER_DECLARE_ZERO(VkImageBlit, region);
+        region.srcSubresource.aspectMask     = p_texture->vk_aspect_mask;
+        region.srcSubresource.mipLevel       = mip_level - 1;
+        region.srcSubresource.baseArrayLayer = 0;
+        region.srcSubresource.layerCount     = p_texture->array_layers;
+        region.srcOffsets[1].x               = (int32_t)src_width;
+        region.srcOffsets[1].y               = (int32_t)src_height;
+        region.srcOffsets[1].z               = 1;
+        region.dstSubresource.aspectMask     = p_texture->vk_aspect_mask;
+        region.dstSubresource.mipLevel       = mip_level;
+        region.dstSubresource.baseArrayLayer = 0;
+        region.dstSubresource.layerCount     = p_texture->array_layers;
+        region.dstOffsets[1].x               = (int32_t)dst_width;
+        region.dstOffsets[1].y               = (int32_t)dst_height;
+        region.dstOffsets[1].z               = 1;
+        vkCmdBlitImage(p_cmd->vk_cmd_buf, 
+                       p_texture->vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       p_texture->vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &region, VK_FILTER_LINEAR);
+
+        src_width = dst_width;
+        src_height = dst_height;
+    }
+
+    tr_internal_vk_cmd_image_transition(p_cmd, p_texture, 0, p_texture->mip_levels, new_usage);
+}
+
+void tr_internal_vk_cmd_host_read_barrier(tr_cmd* p_cmd, tr_buffer* p_buffer)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+
+    // Fences don't make transfer writes visible to the host on their own
+    TINY_RENDERER_DECLARE_ZERO(VkBufferMemoryBarrier, barrier);
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext               = NULL;
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = p_buffer->vk_buffer;
+    barrier.offset              = 0;
+    barrier.size                = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(p_cmd->vk_cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 
+                         0, NULL, 1, &barrier, 0, NULL);
+    ++p_cmd->cmd_pool->renderer->frame_stats.barrier_count;
+}
+
+void tr_internal_vk_cmd_reset_query_pool(tr_cmd* p_cmd, tr_query_pool* p_query_pool)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+    assert(VK_NULL_HANDLE != p_query_pool->vk_query_pool);
+
+    vkCmdResetQueryPool(p_cmd->vk_cmd_buf, p_query_pool->vk_query_pool, 0, p_query_pool->query_count);
+    p_query_pool->reset = true;
+    p_query_pool->traced = false;
+}
+
+void tr_internal_vk_cmd_write_timestamp(tr_cmd* p_cmd, tr_query_pool* p_query_pool, VkPipelineStageFlagBits stage, uint32_t query_index)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+    assert(VK_NULL_HANDLE != p_query_pool->vk_query_pool);
+
+    vkCmdWriteTimestamp(p_cmd->vk_cmd_buf, stage, p_query_pool->vk_query_pool, query_index);
+}
+
+void tr_internal_vk_cmd_begin_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+    assert(VK_NULL_HANDLE != p_query_pool->vk_query_pool);
+
+    vkCmdBeginQuery(p_cmd->vk_cmd_buf, p_query_pool->vk_query_pool, query_index, p_query_pool->vk_query_control_flags);
+}
+
+void tr_internal_vk_cmd_end_query(tr_cmd* p_cmd, tr_query_pool* p_query_pool, uint32_t query_index)
+{
+    assert(p_cmd != NULL);
+    assert(p_cmd->vk_cmd_buf != VK_NULL_HANDLE);
+    assert(VK_NULL_HANDLE != p_query_pool->vk_query_pool);
+
+    vkCmdEndQuery(p_cmd->vk_cmd_buf, p_query_pool->vk_query_pool, query_index);
+}
+
 // -------------------------------------------------------------------------------------------------
 // Internal queue functions
 // -------------------------------------------------------------------------------------------------
 void tr_internal_vk_acquire_next_image(tr_renderer* p_renderer, tr_semaphore* p_signal_semaphore, tr_fence* p_fence)
 {
     assert(VK_NULL_HANDLE != p_renderer->vk_device);
-    assert(VK_NULL_HANDLE != p_renderer->vk_swapchain);
+    assert((VK_NULL_HANDLE != p_renderer->vk_swapchain) || p_renderer->settings.headless);
 
     VkSemaphore semaphore = (NULL != p_signal_semaphore) ? p_signal_semaphore->vk_semaphore : VK_NULL_HANDLE;
     VkFence fence = (NULL != p_fence) ? p_fence->vk_fence : VK_NULL_HANDLE;
 
-    VkResult vk_res = vkAcquireNextImageKHR(p_renderer->vk_device, 
-                                            p_renderer->vk_swapchain, 
-                                            UINT64_MAX, 
-                                            semaphore, 
-                                            fence, 
-                                            &(p_renderer->swapchain_image_index));
-    assert(VK_SUCCESS == vk_res);
+    VkResult vk_res = VK_SUCCESS;
+    if (p_renderer->settings.headless) {
+        // Cycle through the offscreen render targets, an empty submit 
+        // signals the semaphore and fence like an acquire would.
+        p_renderer->swapchain_image_index = (p_renderer->swapchain_image_index + 1) % p_renderer->settings.swapchain.image_count;
+
+        TINY_RENDERER_DECLARE_ZERO(VkSubmitInfo, submit_info);
+        submit_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext                = NULL;
+        submit_info.signalSemaphoreCount = (VK_NULL_HANDLE != semaphore) ? 1 : 0;
+        submit_info.pSignalSemaphores    = &semaphore;
+        vk_res = vkQueueSubmit(p_renderer->graphics_queue->vk_queue, 1, &submit_info, fence);
+        assert(VK_SUCCESS == vk_res);
+    }
+    else {
+        vk_res = vkAcquireNextImageKHR(p_renderer->vk_device, 
+                                       p_renderer->vk_swapchain, 
+                                       UINT64_MAX, 
+                                       semaphore, 
+                                       fence, 
+                                       &(p_renderer->swapchain_image_index));
+        assert(VK_SUCCESS == vk_res);
+    }
 
     vk_res = vkWaitForFences(p_renderer->vk_device, 1, &fence, VK_TRUE, UINT64_MAX);
     assert(VK_SUCCESS == vk_res);
@@ -5459,7 +10671,8 @@ void tr_internal_vk_queue_submit(
     uint32_t       wait_semaphore_count,
     tr_semaphore** pp_wait_semaphores,
     uint32_t       signal_semaphore_count,
-    tr_semaphore** pp_signal_semaphores
+    tr_semaphore** pp_signal_semaphores,
+    tr_fence*      p_fence
 )
 {
     assert(VK_NULL_HANDLE != p_queue->vk_queue);
@@ -5480,7 +10693,7 @@ void tr_internal_vk_queue_submit(
 
     TINY_RENDERER_DECLARE_ZERO(VkSemaphore, signal_semaphores[tr_max_submit_signal_semaphores]);
     signal_semaphore_count = signal_semaphore_count > tr_max_submit_signal_semaphores ? tr_max_submit_signal_semaphores : signal_semaphore_count;
-    for (uint32_t i = 0; i < wait_semaphore_count; ++i) {
+    for (uint32_t i = 0; i < signal_semaphore_count; ++i) {
         signal_semaphores[i] = pp_signal_semaphores[i]->vk_semaphore;
     }
 
@@ -5494,7 +10707,8 @@ void tr_internal_vk_queue_submit(
     submit_info.pCommandBuffers      = cmds;
     submit_info.signalSemaphoreCount = signal_semaphore_count;
     submit_info.pSignalSemaphores    = signal_semaphores;
-    VkResult vk_res = vkQueueSubmit(p_queue->vk_queue, 1, &submit_info, VK_NULL_HANDLE);
+    VkFence fence = (NULL != p_fence) ? p_fence->vk_fence : VK_NULL_HANDLE;
+    VkResult vk_res = vkQueueSubmit(p_queue->vk_queue, 1, &submit_info, fence);
     assert(VK_SUCCESS == vk_res);
 }
 
@@ -5510,6 +10724,24 @@ void tr_internal_vk_queue_present(tr_queue* p_queue, uint32_t wait_semaphore_cou
         wait_semaphores[i] = pp_wait_semaphores[i]->vk_semaphore;
     }
 
+    // Nothing to present, but the semaphores still need to be waited on
+    if (renderer->settings.headless) {
+        TINY_RENDERER_DECLARE_ZERO(VkPipelineStageFlags, wait_masks[tr_max_present_wait_semaphores]);
+        for (uint32_t i = 0; i < wait_semaphore_count; ++i) {
+            wait_masks[i] = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+
+        TINY_RENDERER_DECLARE_ZERO(VkSubmitInfo, submit_info);
+        submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext              = NULL;
+        submit_info.waitSemaphoreCount = wait_semaphore_count;
+        submit_info.pWaitSemaphores    = wait_semaphores;
+        submit_info.pWaitDstStageMask  = wait_masks;
+        VkResult vk_res = vkQueueSubmit(renderer->present_queue->vk_queue, 1, &submit_info, VK_NULL_HANDLE);
+        assert(VK_SUCCESS == vk_res);
+        return;
+    }
+
     TINY_RENDERER_DECLARE_ZERO(VkPresentInfoKHR, present_info);
     present_info.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     present_info.pNext              = NULL;
@@ -5532,6 +10764,8 @@ void tr_internal_vk_queue_wait_idle(tr_queue* p_queue)
     assert(VK_SUCCESS == vk_res);
 }
 
+#endif // ! defined(TINY_RENDERER_IMAGE_ONLY)
+
 #endif // TINY_RENDERER_IMPLEMENTATION
 
 #if defined(__cplusplus) && defined(TINY_RENDERER_CPP_NAMESPACE)